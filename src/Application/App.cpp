@@ -33,6 +33,7 @@
 #include "Main.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "BatchMode.h"
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/ColourConfiguration.h"
@@ -59,6 +60,7 @@
 #include "UI/SBrush.h"
 #include "UI/WxUtils.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include "Utility/Tokenizer.h"
 #include "thirdparty/dumb/dumb.h"
 #include <filesystem>
@@ -79,6 +81,13 @@ bool            init_ok         = false;
 bool            exiting         = false;
 std::thread::id main_thread_id;
 
+// Batch mode
+bool           batch_mode = false;
+string         batch_script;
+vector<string> batch_archives;
+unsigned       batch_jobs = 0;
+bool           batch_save = true;
+
 // Version
 Version version_num{ 3, 2, 0, 2 };
 
@@ -105,6 +114,7 @@ ResourceManager resource_manager;
 CVAR(Int, temp_location, 0, CVar::Flag::Save)
 CVAR(String, temp_location_custom, "", CVar::Flag::Save)
 CVAR(Bool, setup_wizard_run, false, CVar::Flag::Save)
+CVAR(Int, max_worker_threads, 0, CVar::Flag::Save)
 
 
 // -----------------------------------------------------------------------------
@@ -323,12 +333,30 @@ vector<string> processCommandLine(vector<string>& args)
 	vector<string> to_open;
 
 	// Process command line args (except the first as it is normally the executable name)
-	for (auto& arg : args)
+	for (unsigned a = 0; a < args.size(); a++)
 	{
+		auto& arg = args[a];
+
 		// -nosplash: Disable splash window
 		if (strutil::equalCI(arg, "-nosplash"))
 			ui::enableSplash(false);
 
+		// -batch <script>: Run [script] on all given archives without the UI
+		else if (strutil::equalCI(arg, "-batch") && a + 1 < args.size())
+		{
+			batch_mode   = true;
+			batch_script = args[++a];
+			ui::enableSplash(false);
+		}
+
+		// -jobs <count>: Max number of archives to process at once in batch mode
+		else if (strutil::equalCI(arg, "-jobs") && a + 1 < args.size())
+			batch_jobs = std::max(strutil::asInt(args[++a]), 0);
+
+		// -nosave: Don't save archives modified by the script in batch mode
+		else if (strutil::equalCI(arg, "-nosave"))
+			batch_save = false;
+
 		// -debug: Enable debug mode
 		else if (strutil::equalCI(arg, "-debug"))
 		{
@@ -397,6 +425,16 @@ ResourceManager& app::resources()
 	return resource_manager;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the shared worker thread pool (created on first use, with
+// max_worker_threads threads or one per hardware thread if 0)
+// -----------------------------------------------------------------------------
+ThreadPool& app::threadPool()
+{
+	static ThreadPool thread_pool{ static_cast<unsigned>(std::max<int>(max_worker_threads, 0)) };
+	return thread_pool;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the number of ms elapsed since the application was started
 // -----------------------------------------------------------------------------
@@ -413,6 +451,14 @@ bool app::isExiting()
 	return exiting;
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if the application was started in batch mode (no UI)
+// -----------------------------------------------------------------------------
+bool app::isBatchMode()
+{
+	return batch_mode;
+}
+
 // -----------------------------------------------------------------------------
 // Application initialisation
 // -----------------------------------------------------------------------------
@@ -454,11 +500,14 @@ bool app::init(vector<string>& args, double ui_scale)
 	archive_manager.init();
 	if (!archive_manager.resArchiveOK())
 	{
-		wxMessageBox(
-			"Unable to find slade.pk3, make sure it exists in the same directory as the "
-			"SLADE executable",
-			"Error",
-			wxICON_ERROR);
+		if (batch_mode)
+			log::error("Unable to find slade.pk3, make sure it exists in the same directory as the SLADE executable");
+		else
+			wxMessageBox(
+				"Unable to find slade.pk3, make sure it exists in the same directory as the "
+				"SLADE executable",
+				"Error",
+				wxICON_ERROR);
 		return false;
 	}
 
@@ -487,15 +536,16 @@ bool app::init(vector<string>& args, double ui_scale)
 	// Init SImage formats
 	SIFormat::initFormats();
 
-	// Init brushes
-	SBrush::initBrushes();
+	// Init UI resources (brushes, icons, fonts)
+	if (!batch_mode)
+	{
+		SBrush::initBrushes();
 
-	// Load program icons
-	log::info("Loading icons");
-	icons::loadIcons();
+		log::info("Loading icons");
+		icons::loadIcons();
 
-	// Load program fonts
-	drawing::initFonts();
+		drawing::initFonts();
+	}
 
 	// Load entry types
 	log::info("Loading entry types");
@@ -506,9 +556,12 @@ bool app::init(vector<string>& args, double ui_scale)
 	TextLanguage::loadLanguages();
 
 	// Init text stylesets
-	log::info("Loading text style sets");
-	StyleSet::loadResourceStyles();
-	StyleSet::loadCustomStyles();
+	if (!batch_mode)
+	{
+		log::info("Loading text style sets");
+		StyleSet::loadResourceStyles();
+		StyleSet::loadCustomStyles();
+	}
 
 	// Init colour configuration
 	log::info("Loading colour configuration");
@@ -521,7 +574,8 @@ bool app::init(vector<string>& args, double ui_scale)
 	executables::init();
 
 	// Init main editor
-	maineditor::init();
+	if (!batch_mode)
+		maineditor::init();
 
 	// Init base resource
 	log::info("Loading base resource");
@@ -532,6 +586,16 @@ bool app::init(vector<string>& args, double ui_scale)
 	log::info("Loading game configurations");
 	game::init();
 
+	// Nothing else to do in batch mode, the archives will be processed by
+	// runBatch
+	if (batch_mode)
+	{
+		batch_archives = paths_to_open;
+		init_ok        = true;
+		log::info("SLADE Initialisation OK (batch mode)");
+		return true;
+	}
+
 #ifdef USE_LUA
 	// Init script manager
 	scriptmanager::init();
@@ -565,6 +629,18 @@ bool app::init(vector<string>& args, double ui_scale)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Runs the batch mode script on all archives given on the command line, see
+// batchmode::run. Returns the process exit code
+// -----------------------------------------------------------------------------
+int app::runBatch()
+{
+	if (!batch_mode || !init_ok)
+		return 1;
+
+	return batchmode::run(batch_script, batch_archives, batch_jobs, batch_save);
+}
+
 // -----------------------------------------------------------------------------
 // Saves the SLADE configuration file
 // -----------------------------------------------------------------------------
@@ -669,8 +745,11 @@ void app::exit(bool save_config)
 	archive_manager.closeAll();
 
 	// Clean up
-	drawing::cleanupFonts();
-	gl::Texture::clearAll();
+	if (!batch_mode)
+	{
+		drawing::cleanupFonts();
+		gl::Texture::clearAll();
+	}
 
 	// Clear temp folder
 	std::error_code error;
@@ -691,8 +770,9 @@ void app::exit(bool save_config)
 	// Close DUMB
 	dumb_exit();
 
-	// Exit wx Application
-	wxGetApp().Exit();
+	// Exit wx Application (batch mode doesn't run the wx event loop)
+	if (!batch_mode)
+		wxGetApp().Exit();
 }
 
 
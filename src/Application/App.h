@@ -9,6 +9,7 @@ class Console;
 class PaletteManager;
 class Clipboard;
 class ResourceManager;
+class ThreadPool;
 
 namespace app
 {
@@ -17,11 +18,14 @@ namespace app
 	PaletteManager*  paletteManager();
 	long             runTimer();
 	bool             isExiting();
+	bool             isBatchMode();
 	ArchiveManager&  archiveManager();
 	Clipboard&       clipboard();
 	ResourceManager& resources();
+	ThreadPool&      threadPool();
 
 	bool init(vector<string>& args, double ui_scale = 1.);
+	int  runBatch();
 	void saveConfigFile();
 	void exit(bool save_config);
 
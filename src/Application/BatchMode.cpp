@@ -0,0 +1,199 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    BatchMode.cpp
+// Description: Headless batch processing of archives - runs a lua script on a
+//              list of archives given on the command line and saves them,
+//              without any UI
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "BatchMode.h"
+#include "App.h"
+#include "Archive/ArchiveManager.h"
+#include "Scripting/Lua.h"
+#include "Utility/FileUtils.h"
+#include "Utility/ThreadPool.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// An archive being processed
+struct Job
+{
+	string              path;
+	shared_ptr<Archive> archive;
+	bool                ok    = true;
+	bool                saved = false;
+	string              error; // Error from opening/saving on a worker thread
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// BatchMode Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Runs the 'Execute(archive)' function in the lua script [script_file] on each
+// archive in [archive_paths] and saves any archives it modifies (if [save] is
+// true).
+//
+// Archives are processed in groups of [jobs] (or one per thread if 0): each
+// group is opened and saved on the thread pool, while the script is run on
+// each archive in turn on this thread, since lua can only run one script at a
+// time. Returns the process exit code, 0 if all archives were processed
+// successfully
+// -----------------------------------------------------------------------------
+int batchmode::run(const string& script_file, const vector<string>& archive_paths, unsigned jobs, bool save)
+{
+#ifndef USE_LUA
+	log::error("Batch mode requires SLADE to be built with lua scripting support");
+	return 1;
+#else
+	// Load script
+	string script;
+	if (!fileutil::readFileToString(script_file, script))
+	{
+		log::error("Unable to read batch script \"{}\"", script_file);
+		return 1;
+	}
+
+	if (archive_paths.empty())
+	{
+		log::warning("No archives given to process");
+		return 0;
+	}
+
+	auto& archive_manager = app::archiveManager();
+	auto& thread_pool     = app::threadPool();
+	if (jobs == 0)
+		jobs = thread_pool.numThreads() + 1;
+
+	unsigned failed = 0;
+	auto     time   = app::runTimer();
+	for (size_t start = 0; start < archive_paths.size(); start += jobs)
+	{
+		vector<Job> group(std::min<size_t>(jobs, archive_paths.size() - start));
+
+		// Open archives
+		thread_pool.parallelFor(
+			group.size(),
+			[&](size_t a)
+			{
+				auto& job   = group[a];
+				job.path    = archive_paths[start + a];
+				job.archive = archive_manager.openArchive(job.path, false, true);
+				if (!job.archive)
+				{
+					job.error = global::error;
+					job.ok    = false;
+				}
+			},
+			1);
+
+		// Run script
+		for (auto& job : group)
+		{
+			if (!job.ok)
+			{
+				log::error("Unable to open archive \"{}\": {}", job.path, job.error);
+				continue;
+			}
+
+			archive_manager.addArchive(job.archive);
+
+			log::info("Running batch script on \"{}\"", job.path);
+			if (!lua::runArchiveScript(script, job.archive.get()))
+				job.ok = false;
+		}
+
+		// Save modified archives
+		if (save)
+		{
+			// Archive signals can't be handled on worker threads, so block the saved
+			// signal while saving and emit it here afterwards
+			for (auto& job : group)
+				if (job.ok)
+					job.archive->signals().saved.block();
+
+			thread_pool.parallelFor(
+				group.size(),
+				[&](size_t a)
+				{
+					auto& job = group[a];
+					if (!job.ok || !job.archive->isModified())
+						return;
+
+					job.saved = job.archive->save();
+					if (!job.saved)
+					{
+						job.error = global::error;
+						job.ok    = false;
+					}
+				},
+				1);
+
+			for (auto& job : group)
+			{
+				if (!job.archive)
+					continue;
+
+				job.archive->signals().saved.unblock();
+				if (job.saved)
+					job.archive->signals().saved(*job.archive);
+				else if (!job.ok && !job.error.empty())
+					log::error("Unable to save archive \"{}\": {}", job.path, job.error);
+			}
+		}
+
+		// Close archives
+		for (auto& job : group)
+		{
+			if (job.archive)
+				archive_manager.closeArchive(job.archive.get());
+			if (!job.ok)
+				++failed;
+		}
+	}
+
+	log::info(
+		"Batch processed {} archives in {}ms ({} failed)", archive_paths.size(), app::runTimer() - time, failed);
+
+	return failed > 0 ? 1 : 0;
+#endif
+}
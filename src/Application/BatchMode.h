@@ -0,0 +1,6 @@
+#pragma once
+
+namespace slade::batchmode
+{
+int run(const string& script_file, const vector<string>& archive_paths, unsigned jobs, bool save);
+} // namespace slade::batchmode
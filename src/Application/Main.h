@@ -50,8 +50,8 @@ using std::weak_ptr;
 // Namespace to hold 'global' variables
 namespace slade::global
 {
-extern string error;
-extern string sc_rev;
+extern thread_local string error; // Per-thread, since archives can be opened/saved on worker threads
+extern string              sc_rev;
 extern bool   debug;
 extern int    win_version_major;
 extern int    win_version_minor;
@@ -60,7 +60,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 namespace slade::global
 {
-string error;
+thread_local string error;
 
 #ifdef GIT_DESCRIPTION
 string sc_rev = GIT_DESCRIPTION;
@@ -246,9 +246,9 @@ public:
 
 		// Last 10 log lines
 		trace_ += "\nLast Log Messages:\n";
-		auto& log = log::history();
-		for (auto a = log.size() - 10; a < log.size(); a++)
-			trace_ += log[a].message + "\n";
+		auto num_messages = log::historySize();
+		for (const auto& msg : log::history(num_messages > 10 ? num_messages - 10 : 0))
+			trace_ += msg.message + "\n";
 
 		// Add stack trace text area
 		text_stack_ = new wxTextCtrl(
@@ -454,7 +454,53 @@ public:
 // SLADEWxApp Class Functions
 //
 // -----------------------------------------------------------------------------
+#ifdef __WXMSW__
 IMPLEMENT_APP(SLADEWxApp)
+#else
+wxIMPLEMENT_APP_NO_MAIN(SLADEWxApp);
+
+namespace
+{
+// -----------------------------------------------------------------------------
+// Runs SLADE in batch mode as a console application (so no display is needed)
+// -----------------------------------------------------------------------------
+int runHeadless(int argc, char** argv)
+{
+	wxApp::SetInstance(new wxAppConsole);
+	if (!wxEntryStart(argc, argv))
+		return 1;
+
+	wxTheApp->SetAppName("slade3");
+	wxLog::SetActiveTarget(new SLADELog());
+
+	vector<string> args;
+	for (int a = 1; a < argc; a++)
+		args.emplace_back(argv[a]);
+
+	auto exit_code = 1;
+	if (app::init(args))
+		exit_code = app::runBatch();
+	app::exit(false);
+
+	wxEntryCleanup();
+
+	return exit_code;
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Program entry point - runs headless if started in batch mode, otherwise
+// starts the wx application as normal
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	for (int a = 1; a < argc; a++)
+		if (strutil::equalCI(argv[a], "-batch"))
+			return runHeadless(argc, argv);
+
+	return wxEntry(argc, argv);
+}
+#endif
 
 
 // -----------------------------------------------------------------------------
@@ -498,6 +544,22 @@ bool SLADEWxApp::singleInstanceCheck()
 // -----------------------------------------------------------------------------
 bool SLADEWxApp::OnInit()
 {
+	// Get command line arguments
+	vector<string> args;
+	for (int a = 1; a < argc; a++)
+		args.push_back(argv[a].ToStdString());
+
+	// Batch mode - just run the batch script without any UI and exit
+	for (const auto& arg : args)
+		if (strutil::equalCI(arg, "-batch"))
+		{
+			wxApp::SetAppName("SLADE3");
+			wxLog::SetActiveTarget(new SLADELog());
+			batch_exit_code_ = app::init(args) ? app::runBatch() : 1;
+			app::exit(false);
+			return true;
+		}
+
 	// Check if an instance of SLADE is already running
 	if (!singleInstanceCheck())
 	{
@@ -550,11 +612,6 @@ bool SLADEWxApp::OnInit()
 	// Reroute wx log messages
 	wxLog::SetActiveTarget(new SLADELog());
 
-	// Get command line arguments
-	vector<string> args;
-	for (int a = 1; a < argc; a++)
-		args.push_back(argv[a].ToStdString());
-
 	// Init application
 	if (!app::init(args, ui_scale))
 		return false;
@@ -574,12 +631,25 @@ bool SLADEWxApp::OnInit()
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Runs the application main loop, or just returns the exit code if SLADE was
+// run in batch mode (which has already finished by this point)
+// -----------------------------------------------------------------------------
+int SLADEWxApp::OnRun()
+{
+	if (app::isBatchMode())
+		return batch_exit_code_;
+
+	return wxApp::OnRun();
+}
+
 // -----------------------------------------------------------------------------
 // Application shutdown, run when program is closed
 // -----------------------------------------------------------------------------
 int SLADEWxApp::OnExit()
 {
-	wxSocketBase::Shutdown();
+	if (!app::isBatchMode())
+		wxSocketBase::Shutdown();
 	delete single_instance_checker_;
 	delete file_listener_;
 
@@ -31,9 +31,14 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Archive.h"
+#include "App.h"
+#include "ArchiveIndex.h"
+#include "General/UI.h"
 #include "General/UndoRedo.h"
+#include "Utility/MappedFile.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include <filesystem>
 
 using namespace slade;
@@ -46,6 +51,8 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 CVAR(Bool, archive_load_data, false, CVar::Flag::Save)
 CVAR(Bool, backup_archives, true, CVar::Flag::Save)
+CVAR(Int, archive_detect_batch_size, 1024, CVar::Flag::Save)
+CVAR(Bool, archive_map_files, true, CVar::Flag::Save)
 bool                  Archive::save_backup = true;
 vector<ArchiveFormat> Archive::formats_;
 
@@ -209,6 +216,8 @@ public:
 
 	bool doRedo() override { return !created_ ? deleteEntry() : createEntry(); }
 
+	unsigned memUsage() const override { return sizeof(EntryCreateDeleteUS) + entry_copy_->size(); }
+
 private:
 	bool                     created_;
 	Archive*                 archive_;
@@ -407,9 +416,19 @@ string Archive::filename(bool full) const
 // -----------------------------------------------------------------------------
 bool Archive::open(string_view filename)
 {
-	// Read the file into a MemChunk
 	MemChunk mc;
-	if (!mc.importFile(filename))
+
+	// Memory-map the file if enabled, entry data will be a view of the mapped
+	// file until it is modified (the mapping is released once no entries use it)
+	auto mapped = archive_map_files ? std::make_shared<MappedFile>() : nullptr;
+	if (mapped && mapped->open(filename))
+	{
+		mc.setView(mapped->data(), mapped->size(), mapped);
+		mapped_file_ = mapped;
+	}
+
+	// Otherwise read the file into a MemChunk
+	else if (!mc.importFile(filename))
 	{
 		global::error = "Unable to open file. Make sure it isn't in use by another program.";
 		return false;
@@ -419,17 +438,31 @@ bool Archive::open(string_view filename)
 	auto backupname = filename_;
 	filename_       = filename;
 
+	// Get the archive index, if it is valid the indexed entry types are used
+	// rather than detecting them (see detectEntryTypes)
+	index_ = ArchiveIndex::forFile(filename, mc);
+
 	// Load from MemChunk
 	sf::Clock timer;
 	if (open(mc))
 	{
 		log::info(2, "Archive::open took {}ms", timer.getElapsedTime().asMilliseconds());
 		on_disk_ = true;
+
+		// Write the index if it wasn't valid, the indexed entry info isn't
+		// needed after this
+		if (index_)
+		{
+			index_->update(*this);
+			index_->release();
+		}
+
 		return true;
 	}
 	else
 	{
 		filename_ = backupname;
+		index_.reset();
 		return false;
 	}
 }
@@ -440,9 +473,11 @@ bool Archive::open(string_view filename)
 // -----------------------------------------------------------------------------
 bool Archive::open(ArchiveEntry* entry)
 {
-	// Load from entry's data
-	auto sp_entry = entry->getShared();
-	if (sp_entry && open(sp_entry->data()))
+	// Load from a view of the entry's data, so that it (and any entries in the
+	// opened archive) can share the data rather than copying it
+	auto     sp_entry = entry->getShared();
+	MemChunk data;
+	if (sp_entry && sp_entry->shareData(data) && open(data))
 	{
 		// Update variables and return success
 		parent_ = sp_entry;
@@ -577,12 +612,34 @@ shared_ptr<ArchiveEntry> Archive::entryAtPathShared(string_view path) const
 // -----------------------------------------------------------------------------
 bool Archive::write(string_view filename, bool update)
 {
-	// Write to a MemChunk, then export it to a file
+	// Write to a MemChunk
 	MemChunk mc;
-	if (write(mc, true))
-		return mc.exportFile(filename);
-	else
+	if (!write(mc, true))
 		return false;
+
+	// If entries may still be viewing a memory-mapped copy of the file being
+	// written to (via this or any other archive), write to a temp file and
+	// replace the original with it, so the mapped data isn't modified out from
+	// under them
+	if (MappedFile::isFileMapped(filename))
+	{
+		auto temp_file = fmt::format("{}.tmp", filename);
+		if (!mc.exportFile(temp_file))
+			return false;
+
+		if (!wxRenameFile(temp_file, wxString{ filename.data(), filename.size() }, true))
+		{
+			log::error("Unable to replace file {}", filename);
+			global::error = "Unable to replace file";
+			wxRemoveFile(temp_file);
+			return false;
+		}
+
+		return true;
+	}
+
+	// Otherwise, just export it to the file
+	return mc.exportFile(filename);
 }
 
 // -----------------------------------------------------------------------------
@@ -647,6 +704,9 @@ bool Archive::save(string_view filename)
 	// If saving was successful, update variables and announce save
 	if (success)
 	{
+		// The file has changed so the index (if any) is no longer valid
+		index_.reset();
+
 		setModified(false);
 		signals_.saved(*this);
 	}
@@ -1298,6 +1358,183 @@ string Archive::detectNamespace(ArchiveEntry* entry)
 		return "global"; // Error, just return global
 }
 
+// -----------------------------------------------------------------------------
+// Detects the types of all [entries] (which must be in this archive).
+// Entry data is read via [read_data] and type detection is done in parallel on
+// the app thread pool, the results (type and data) are then applied to the
+// entries on the calling thread.
+// If the archive index is valid, the indexed types are used instead and entry
+// data is only read if it is to be kept loaded
+// -----------------------------------------------------------------------------
+void Archive::detectEntryTypes(const vector<ArchiveEntry*>& entries, const EntryDataReader& read_data)
+{
+	struct DetectResult
+	{
+		bool                       detect      = false;
+		const ArchiveIndex::Entry* indexed     = nullptr;
+		EntryType*                 type        = nullptr;
+		int                        reliability = 0;
+		MemChunk                   data;
+	};
+
+	ui::setSplashProgressMessage("Detecting entry types");
+	auto      stats_start = EntryType::detectStats();
+	sf::Clock timer;
+
+	// Get indexed entry types
+	std::unordered_map<const ArchiveEntry*, const ArchiveIndex::Entry*> indexed;
+	if (index_)
+		index_->putEntryTypes(*this, indexed);
+
+	// Entries are processed in batches so that progress can be updated and
+	// the amount of entry data held at once is limited
+	auto   entry_format = formatDesc().entry_format;
+	size_t batch_size   = std::max<int>(archive_detect_batch_size, 1);
+
+	vector<string>                namespaces;
+	vector<EntryType::DetectInfo> infos;
+	vector<DetectResult>          results;
+	for (size_t start = 0; start < entries.size(); start += batch_size)
+	{
+		// Update splash window progress
+		ui::setSplashProgress((float)start / (float)entries.size());
+
+		auto count = std::min(batch_size, entries.size() - start);
+
+		// Setup detection info for the batch (namespace detection needs the
+		// archive so it has to be done here)
+		namespaces.resize(count);
+		infos.resize(count);
+		results.clear();
+		results.resize(count);
+		for (size_t a = 0; a < count; a++)
+		{
+			auto entry = entries[start + a];
+			if (entry->type() == EntryType::folderType() || entry->type() == EntryType::mapMarkerType())
+				continue;
+
+			// Use indexed type if any
+			results[a].detect = true;
+			if (auto i = indexed.find(entry); i != indexed.end())
+			{
+				results[a].indexed = i->second;
+				infos[a].size      = entry->size();
+				continue;
+			}
+
+			namespaces[a]           = detectNamespace(entry);
+			infos[a].upper_name     = entry->upperName();
+			infos[a].size           = entry->size();
+			infos[a].in_archive     = true;
+			infos[a].archive_format = entry_format;
+			infos[a].section        = namespaces[a];
+		}
+
+		// Read data and detect types on worker threads
+		app::threadPool().parallelFor(
+			count,
+			[&](size_t index)
+			{
+				auto& result = results[index];
+				if (!result.detect || (result.indexed && !archive_load_data))
+					return;
+
+				// Read entry data if it isn't zero-sized
+				auto info = infos[index];
+				if (info.size > 0)
+				{
+					if (!read_data(*entries[start + index], result.data))
+						result.data.clear();
+
+					// Some formats (eg. encrypted lumps) can read a different
+					// amount of data than the listed entry size
+					info.size = result.data.size();
+				}
+
+				if (!result.indexed)
+					result.type = EntryType::detectEntryType(result.data, info, result.reliability);
+			});
+
+		// Apply results
+		for (size_t a = 0; a < count; a++)
+		{
+			auto  entry  = entries[start + a];
+			auto& result = results[a];
+			if (!result.detect)
+			{
+				entry->setState(ArchiveEntry::State::Unmodified);
+				continue;
+			}
+
+			if (result.data.hasData())
+				entry->importMemChunk(result.data);
+
+			if (result.indexed)
+				entry->setType(result.indexed->type, result.indexed->reliability);
+			else
+				entry->setType(result.type, result.reliability);
+
+			// Unload entry data if needed
+			if (!archive_load_data)
+				entry->unloadData();
+
+			// Set entry to unchanged
+			entry->setState(ArchiveEntry::State::Unmodified);
+		}
+	}
+
+	ui::setSplashProgress(1.0f);
+
+	// Log detection stats
+	auto stats = EntryType::detectStats();
+	auto num   = stats.entries - stats_start.entries;
+	if (!indexed.empty())
+		log::info(
+			2,
+			"Set types of {} entries from archive index in {}ms",
+			entries.size(),
+			timer.getElapsedTime().asMilliseconds());
+	else
+		log::info(
+			2,
+			"Detected types of {} entries in {}ms ({:.2f} candidate types tested per entry)",
+			num,
+			timer.getElapsedTime().asMilliseconds(),
+			num > 0 ? (double)(stats.candidates - stats_start.candidates) / num : 0.);
+}
+
+// -----------------------------------------------------------------------------
+// Detects the types of all [entries] (which must be in this archive), reading
+// their data from [source] at each entry's "Offset" property
+// -----------------------------------------------------------------------------
+void Archive::detectEntryTypes(const vector<ArchiveEntry*>& entries, const MemChunk& source)
+{
+	detectEntryTypes(
+		entries,
+		[&source](ArchiveEntry& entry, MemChunk& data)
+		{ return source.shareMemChunk(data, entry.exProps().get<int>("Offset"), entry.size()); });
+}
+
+// -----------------------------------------------------------------------------
+// Adds the maps cached in the archive index to [maps].
+// Returns false if there are none, or the archive has been modified since it
+// was opened
+// -----------------------------------------------------------------------------
+bool Archive::indexedMaps(vector<MapDesc>& maps) const
+{
+	return index_ && index_->putMaps(*this, maps);
+}
+
+// -----------------------------------------------------------------------------
+// Caches the detected [maps] in the archive index, if the archive hasn't been
+// modified since it was opened
+// -----------------------------------------------------------------------------
+void Archive::updateIndexedMaps(const vector<MapDesc>& maps)
+{
+	if (index_)
+		index_->updateMaps(*this, maps);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the first entry matching the search criteria in [options], or null if
 // no matching entry was found
@@ -1313,9 +1550,10 @@ ArchiveEntry* Archive::findFirst(SearchOptions& options)
 	// Begin search
 
 	// Search entries
-	for (unsigned a = 0; a < dir->numEntries(); a++)
+	auto candidates = searchCandidates(*dir, options.match_name, options.ignore_ext);
+	for (unsigned c = 0; c < candidates.size(); ++c)
 	{
-		auto entry = dir->entryAt(a);
+		auto entry = dir->entryAt(candidates[c]);
 
 		// Check type
 		if (options.match_type)
@@ -1329,8 +1567,8 @@ ArchiveEntry* Archive::findFirst(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
+		// Check name (if not already matched via the name index)
+		if (!candidates.name_matched && !options.match_name.empty())
 		{
 			// Cut extension if ignoring
 			auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
@@ -1383,9 +1621,10 @@ ArchiveEntry* Archive::findLast(SearchOptions& options)
 	// Begin search
 
 	// Search entries (bottom-up)
-	for (int a = dir->numEntries() - 1; a >= 0; a--)
+	auto candidates = searchCandidates(*dir, options.match_name, options.ignore_ext);
+	for (int c = static_cast<int>(candidates.size()) - 1; c >= 0; --c)
 	{
-		auto entry = dir->entryAt(a);
+		auto entry = dir->entryAt(candidates[c]);
 
 		// Check type
 		if (options.match_type)
@@ -1399,8 +1638,8 @@ ArchiveEntry* Archive::findLast(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
+		// Check name (if not already matched via the name index)
+		if (!candidates.name_matched && !options.match_name.empty())
 		{
 			// Cut extension if ignoring
 			auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
@@ -1453,9 +1692,10 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 	// Begin search
 
 	// Search entries
-	for (unsigned a = 0; a < dir->numEntries(); a++)
+	auto candidates = searchCandidates(*dir, options.match_name, options.ignore_ext);
+	for (unsigned c = 0; c < candidates.size(); ++c)
 	{
-		auto entry = dir->entryAt(a);
+		auto entry = dir->entryAt(candidates[c]);
 
 		// Check type
 		if (options.match_type)
@@ -1469,8 +1709,8 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
+		// Check name (if not already matched via the name index)
+		if (!candidates.name_matched && !options.match_name.empty())
 		{
 			// Cut extension if ignoring
 			auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
@@ -1507,6 +1747,41 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 	return ret;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the indices (in order) of the entries in [dir] between [start] and
+// [end] to check when searching for entries matching [match_name]. If the
+// entries with matching names could be looked up from the dir's name index,
+// name_matched is set and only those entries are candidates, otherwise all
+// entries in the range are
+// -----------------------------------------------------------------------------
+Archive::SearchCandidates Archive::searchCandidates(
+	const ArchiveDir& dir,
+	string_view       match_name,
+	bool              ignore_ext,
+	unsigned          start,
+	unsigned          end)
+{
+	SearchCandidates candidates;
+	candidates.end          = std::min(end, dir.numEntries());
+	candidates.start        = std::min(start, candidates.end);
+	candidates.name_matched = !match_name.empty()
+							  && dir.matchingEntryIndices(match_name, ignore_ext, candidates.indices);
+
+	// Remove matches outside the range
+	if (candidates.name_matched && (candidates.start > 0 || candidates.end < dir.numEntries()))
+	{
+		auto& indices = candidates.indices;
+		indices.erase(
+			std::remove_if(
+				indices.begin(),
+				indices.end(),
+				[&candidates](unsigned index) { return index < candidates.start || index >= candidates.end; }),
+			indices.end());
+	}
+
+	return candidates;
+}
+
 // -----------------------------------------------------------------------------
 // Returns a list of modified entries, and set archive to unmodified status if
 // the list is empty
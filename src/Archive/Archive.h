@@ -6,6 +6,9 @@
 
 namespace slade
 {
+class ArchiveIndex;
+class MappedFile;
+
 struct ArchiveFormat
 {
 	string             id;
@@ -180,11 +183,42 @@ public:
 	static vector<ArchiveFormat>& allFormats() { return formats_; }
 
 protected:
-	string                 format_;
-	string                 filename_;
-	weak_ptr<ArchiveEntry> parent_;
-	bool                   on_disk_; // Specifies whether the archive exists on disk (as opposed to being newly created)
-	bool                   read_only_; // If true, the archive cannot be modified
+	string                   format_;
+	string                   filename_;
+	weak_ptr<ArchiveEntry>   parent_;
+	bool                     on_disk_; // Specifies whether the archive exists on disk (as opposed to being newly created)
+	bool                     read_only_;   // If true, the archive cannot be modified
+	weak_ptr<MappedFile>     mapped_file_; // The memory-mapped file entry data views (if any) refer to
+	unique_ptr<ArchiveIndex> index_;       // Persistent index of the archive file (if opened from one)
+
+	// Entry type detection (for use when opening).
+	// The data reader is called from worker threads, so it must not modify the
+	// archive or the entry
+	typedef std::function<bool(ArchiveEntry& entry, MemChunk& data)> EntryDataReader;
+	void detectEntryTypes(const vector<ArchiveEntry*>& entries, const EntryDataReader& read_data);
+	void detectEntryTypes(const vector<ArchiveEntry*>& entries, const MemChunk& source);
+
+	// Map detection results cached in the archive index (if any)
+	bool indexedMaps(vector<MapDesc>& maps) const;
+	void updateIndexedMaps(const vector<MapDesc>& maps);
+
+	// Search
+	struct SearchCandidates
+	{
+		vector<unsigned> indices;            // Entries matched via the name index (if name_matched)
+		unsigned         start        = 0;   // Otherwise all entries from start to end are candidates
+		unsigned         end          = 0;
+		bool             name_matched = false;
+
+		unsigned size() const { return name_matched ? indices.size() : end - start; }
+		unsigned operator[](unsigned i) const { return name_matched ? indices[i] : start + i; }
+	};
+	static SearchCandidates searchCandidates(
+		const ArchiveDir& dir,
+		string_view       match_name,
+		bool              ignore_ext,
+		unsigned          start = 0,
+		unsigned          end   = 0xFFFFFFFF);
 
 private:
 	bool                   modified_;
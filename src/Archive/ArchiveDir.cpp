@@ -110,34 +110,37 @@ int ArchiveDir::entryIndex(ArchiveEntry* entry, size_t startfrom) const
 	if (!entry)
 		return -1;
 
-	// Search for it
-	const size_t size = entries_.size();
-	if (entry->index_guess_ < startfrom || entry->index_guess_ >= size)
+	// Search for it, starting from the last known index.
+	// This can be called from multiple threads at once (eg. during parallel type
+	// detection), so the guess is only ever read or written atomically
+	const size_t size  = entries_.size();
+	const size_t guess = entry->index_guess_.load(std::memory_order_relaxed);
+	if (guess < startfrom || guess >= size)
 	{
 		for (auto a = startfrom; a < size; a++)
 		{
 			if (entries_[a].get() == entry)
 			{
-				entry->index_guess_ = a;
+				entry->index_guess_.store(a, std::memory_order_relaxed);
 				return (int)a;
 			}
 		}
 	}
 	else
 	{
-		for (auto a = entry->index_guess_; a < size; a++)
+		for (auto a = guess; a < size; a++)
 		{
 			if (entries_[a].get() == entry)
 			{
-				entry->index_guess_ = a;
+				entry->index_guess_.store(a, std::memory_order_relaxed);
 				return (int)a;
 			}
 		}
-		for (auto a = startfrom; a < entry->index_guess_; a++)
+		for (auto a = startfrom; a < guess; a++)
 		{
 			if (entries_[a].get() == entry)
 			{
-				entry->index_guess_ = a;
+				entry->index_guess_.store(a, std::memory_order_relaxed);
 				return (int)a;
 			}
 		}
@@ -170,6 +173,60 @@ vector<shared_ptr<ArchiveEntry>> ArchiveDir::allEntries() const
 	return entries;
 }
 
+// -----------------------------------------------------------------------------
+// Adds the indices of all entries in this directory with names matching [match]
+// (non-case-sensitive, can contain * and ? wildcards) to [indices], in order.
+// If [cut_ext] is true, entry names are checked without their extensions.
+// Returns false if the matching entries can't be looked up from the name index
+// (ie. [match] begins with a wildcard), in which case all entries need to be
+// checked
+// -----------------------------------------------------------------------------
+bool ArchiveDir::matchingEntryIndices(string_view match, bool cut_ext, vector<unsigned>& indices) const
+{
+	auto wildcard = match.find_first_of("*?");
+
+	// No wildcards, just look up the name
+	if (wildcard == string_view::npos)
+	{
+		if (auto entries = indexedEntries(match, cut_ext))
+			for (auto entry : *entries)
+				indices.push_back(entryIndex(entry));
+
+		return true;
+	}
+
+	// Can't narrow down the search if [match] begins with a wildcard
+	if (wildcard == 0)
+		return false;
+
+	if (!sorted_built_)
+		buildSortedIndex();
+
+	// Check all entries with names beginning with the part of [match] before the
+	// first wildcard (an entry's name without extension can only begin with the
+	// prefix if its full name does too)
+	auto  prefix      = strutil::upper(match.substr(0, wildcard));
+	auto  upper_match = strutil::upper(match);
+	auto& sorted      = name_index_.sorted;
+	auto  start       = indices.size();
+	auto  first       = std::lower_bound(
+        sorted.begin(),
+        sorted.end(),
+        prefix,
+        [](const std::pair<string_view, unsigned>& item, const string& p) { return item.first < p; });
+	for (auto i = first; i != sorted.end() && strutil::startsWith(i->first, prefix); ++i)
+	{
+		auto entry = entries_[i->second].get();
+		if (strutil::matches(cut_ext ? entry->upperNameNoExt() : entry->upperName(), upper_match))
+			indices.push_back(i->second);
+	}
+
+	// Put matches back in dir order
+	std::sort(indices.begin() + start, indices.end());
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the entry at [index] in this directory, or null if [index] is out of
 // bounds
@@ -206,16 +263,9 @@ ArchiveEntry* ArchiveDir::entry(string_view name, bool cut_ext) const
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (strutil::equalCI(cut_ext ? entry->nameNoExt() : entry->name(), name))
-			return entry.get();
-	}
-
-	// Not found
-	return nullptr;
+	// Look up (non-case-sensitive) name, first match is the first in the dir
+	auto entries = indexedEntries(name, cut_ext);
+	return entries ? entries->front() : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -224,20 +274,12 @@ ArchiveEntry* ArchiveDir::entry(string_view name, bool cut_ext) const
 // -----------------------------------------------------------------------------
 shared_ptr<ArchiveEntry> ArchiveDir::sharedEntry(string_view name, bool cut_ext) const
 {
-	// Check name was given
-	if (name.empty())
+	// Find entry
+	auto index = entryIndex(entry(name, cut_ext));
+	if (index < 0)
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (strutil::equalCI(cut_ext ? entry->nameNoExt() : entry->name(), name))
-			return entry;
-	}
-
-	// Not found
-	return nullptr;
+	return entries_[index];
 }
 
 // -----------------------------------------------------------------------------
@@ -289,9 +331,16 @@ bool ArchiveDir::addEntry(shared_ptr<ArchiveEntry> entry, unsigned index)
 
 	// Check index
 	if (index >= entries_.size())
+	{
 		entries_.push_back(entry); // 'Invalid' index, add to end of list
+		entry->index_guess_.store(entries_.size() - 1, std::memory_order_relaxed);
+	}
 	else
+	{
 		entries_.insert(entries_.begin() + index, entry); // Add it at index
+		entry->index_guess_.store(index, std::memory_order_relaxed);
+	}
+	indexEntryName(entry.get());
 
 	// Check entry name if duplicate names aren't allowed
 	if (!allow_duplicate_names_)
@@ -311,6 +360,7 @@ bool ArchiveDir::removeEntry(unsigned index)
 		return false;
 
 	// De-parent entry
+	unindexEntryName(entries_[index].get());
 	entries_[index]->parent_ = nullptr;
 
 	// Remove it from the entry list
@@ -332,6 +382,17 @@ bool ArchiveDir::swapEntries(unsigned index1, unsigned index2)
 	// Swap entries
 	entries_[index1].swap(entries_[index2]);
 
+	// Update name index - the order of entries sharing a name may have changed
+	sorted_built_ = false;
+	if (name_index_built_)
+		for (auto entry : { entries_[index1].get(), entries_[index2].get() })
+			if (name_index_.names[entry->upperName()].size() > 1
+				|| name_index_.names_no_ext[string{ entry->upperNameNoExt() }].size() > 1)
+			{
+				invalidateNameIndex();
+				break;
+			}
+
 	return true;
 }
 
@@ -435,6 +496,7 @@ void ArchiveDir::clear()
 {
 	entries_.clear();
 	subdirs_.clear();
+	invalidateNameIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -498,34 +560,149 @@ bool ArchiveDir::exportTo(string_view path)
 // -----------------------------------------------------------------------------
 void ArchiveDir::ensureUniqueName(ArchiveEntry* entry)
 {
-	unsigned      index     = 0;
-	unsigned      number    = 0;
-	const auto    n_entries = entries_.size();
+	unsigned      number = 0;
 	strutil::Path fn(entry->name());
 	auto          name = fn.fileName();
-	while (index < n_entries)
-	{
-		if (entries_[index].get() == entry)
-		{
-			index++;
-			continue;
-		}
 
-		if (strutil::equalCI(entries_[index]->name(), name))
-		{
-			fn.setFileName(fmt::format("{}{}", entry->nameNoExt(), ++number));
-			name  = fn.fileName();
-			index = 0;
-			continue;
-		}
+	// Returns true if any other entry has [name]
+	auto name_taken = [&]()
+	{
+		auto entries = indexedEntries(name, false);
+		return entries && std::any_of(entries->begin(), entries->end(), [entry](ArchiveEntry* e) { return e != entry; });
+	};
 
-		index++;
+	while (name_taken())
+	{
+		fn.setFileName(fmt::format("{}{}", entry->nameNoExt(), ++number));
+		name = fn.fileName();
 	}
 
 	if (number > 0)
 		entry->rename(name);
 }
 
+// -----------------------------------------------------------------------------
+// Returns the list of entries (in dir order) with [name] (non-case-sensitive),
+// or null if there are none. If [cut_ext] is true, entry names are checked
+// without their extensions
+// -----------------------------------------------------------------------------
+const vector<ArchiveEntry*>* ArchiveDir::indexedEntries(string_view name, bool cut_ext) const
+{
+	if (!name_index_built_)
+		buildNameIndex();
+
+	auto& map = cut_ext ? name_index_.names_no_ext : name_index_.names;
+	auto  i   = map.find(strutil::upper(name));
+	return i != map.end() ? &i->second : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Builds the entry name lookup index.
+// Lookups can happen from multiple threads at once (eg. during parallel type
+// detection), so this is done with the index locked
+// -----------------------------------------------------------------------------
+void ArchiveDir::buildNameIndex() const
+{
+	std::lock_guard<std::mutex> lock(name_index_mutex_);
+	if (name_index_built_)
+		return; // Built by another thread while waiting for the lock
+
+	name_index_.names.clear();
+	name_index_.names_no_ext.clear();
+	name_index_.names.reserve(entries_.size());
+	name_index_.names_no_ext.reserve(entries_.size());
+	for (unsigned a = 0; a < entries_.size(); ++a)
+	{
+		auto entry = entries_[a].get();
+		entry->index_guess_.store(a, std::memory_order_relaxed);
+		name_index_.names[entry->upperName()].push_back(entry);
+		name_index_.names_no_ext[string{ entry->upperNameNoExt() }].push_back(entry);
+	}
+
+	name_index_built_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Builds the list of entry names sorted alphabetically, used to find entries
+// with names beginning with a prefix
+// -----------------------------------------------------------------------------
+void ArchiveDir::buildSortedIndex() const
+{
+	std::lock_guard<std::mutex> lock(name_index_mutex_);
+	if (sorted_built_)
+		return;
+
+	auto& sorted = name_index_.sorted;
+	sorted.clear();
+	sorted.reserve(entries_.size());
+	for (unsigned a = 0; a < entries_.size(); ++a)
+		sorted.emplace_back(entries_[a]->upperName(), a);
+	std::sort(sorted.begin(), sorted.end());
+
+	sorted_built_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entry] (which must be in this directory) to the name index, keeping
+// the entry lists in dir order
+// -----------------------------------------------------------------------------
+void ArchiveDir::indexEntryName(ArchiveEntry* entry)
+{
+	sorted_built_ = false;
+	if (!name_index_built_)
+		return;
+
+	auto index  = entryIndex(entry);
+	auto insert = [this, entry, index](vector<ArchiveEntry*>& list)
+	{
+		// Entries are usually added at the end, so search back from there
+		auto pos = list.end();
+		while (pos != list.begin() && entryIndex(*(pos - 1)) > index)
+			--pos;
+		list.insert(pos, entry);
+	};
+
+	insert(name_index_.names[entry->upperName()]);
+	insert(name_index_.names_no_ext[string{ entry->upperNameNoExt() }]);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [entry] from the name index
+// -----------------------------------------------------------------------------
+void ArchiveDir::unindexEntryName(ArchiveEntry* entry)
+{
+	sorted_built_ = false;
+	if (!name_index_built_)
+		return;
+
+	auto remove = [entry](NameIndex::Map& map, const string& name)
+	{
+		auto i = map.find(name);
+		if (i == map.end())
+			return;
+
+		auto& list = i->second;
+		list.erase(std::remove(list.begin(), list.end(), entry), list.end());
+		if (list.empty())
+			map.erase(i);
+	};
+
+	remove(name_index_.names, entry->upperName());
+	remove(name_index_.names_no_ext, string{ entry->upperNameNoExt() });
+}
+
+// -----------------------------------------------------------------------------
+// Clears the name index, it will be rebuilt next time it is needed
+// -----------------------------------------------------------------------------
+void ArchiveDir::invalidateNameIndex()
+{
+	name_index_built_ = false;
+	sorted_built_     = false;
+	name_index_.names.clear();
+	name_index_.names_no_ext.clear();
+	name_index_.sorted.clear();
+}
+
 
 // -----------------------------------------------------------------------------
 //
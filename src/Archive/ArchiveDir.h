@@ -1,12 +1,16 @@
 #pragma once
 
 #include "ArchiveEntry.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace slade
 {
 class ArchiveDir
 {
 	friend class Archive;
+	friend class ArchiveEntry;
 
 public:
 	ArchiveDir(string_view name, const shared_ptr<ArchiveDir>& parent = nullptr, Archive* archive = nullptr);
@@ -34,6 +38,7 @@ public:
 	unsigned                         numEntries(bool inc_subdirs = false) const;
 	int                              entryIndex(ArchiveEntry* entry, size_t startfrom = 0) const;
 	vector<shared_ptr<ArchiveEntry>> allEntries() const;
+	bool matchingEntryIndices(string_view match, bool cut_ext, vector<unsigned>& indices) const;
 
 	// Entry Operations
 	bool addEntry(shared_ptr<ArchiveEntry> entry, unsigned index = 0xFFFFFFFF);
@@ -84,6 +89,27 @@ private:
 	vector<shared_ptr<ArchiveDir>>   subdirs_;
 	bool                             allow_duplicate_names_ = true;
 
-	void ensureUniqueName(ArchiveEntry* entry);
+	// Case-insensitive entry name lookup index, built on first use and then kept
+	// up to date as entries are added, removed and renamed
+	struct NameIndex
+	{
+		using Map = std::unordered_map<string, vector<ArchiveEntry*>>; // Entries are in dir order
+
+		Map                                      names;        // Uppercase name -> entries
+		Map                                      names_no_ext; // Uppercase name without extension -> entries
+		vector<std::pair<string_view, unsigned>> sorted;       // (Uppercase name, index) sorted by name
+	};
+	mutable NameIndex         name_index_;
+	mutable std::atomic<bool> name_index_built_{ false };
+	mutable std::atomic<bool> sorted_built_{ false };
+	mutable std::mutex        name_index_mutex_;
+
+	void                         ensureUniqueName(ArchiveEntry* entry);
+	const vector<ArchiveEntry*>* indexedEntries(string_view name, bool cut_ext) const;
+	void                         buildNameIndex() const;
+	void                         buildSortedIndex() const;
+	void                         indexEntryName(ArchiveEntry* entry);
+	void                         unindexEntryName(ArchiveEntry* entry);
+	void                         invalidateNameIndex();
 };
 } // namespace slade
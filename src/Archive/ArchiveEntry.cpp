@@ -35,8 +35,10 @@
 #include "Main.h"
 #include "ArchiveEntry.h"
 #include "Archive.h"
+#include "App.h"
 #include "General/Misc.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 
 using namespace slade;
 
@@ -48,6 +50,13 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 CVAR(Bool, wad_force_uppercase, true, CVar::Flag::Save)
 
+namespace
+{
+// Maximum amount of entry data to hold at once when computing content hashes
+// for multiple entries
+const uint32_t content_hash_batch_size = 64 * 1024 * 1024;
+} // namespace
+
 
 // -----------------------------------------------------------------------------
 //
@@ -160,19 +169,12 @@ string ArchiveEntry::path(bool include_name) const
 
 // -----------------------------------------------------------------------------
 // Returns a pointer to the entry data. If no entry data exists and [allow_load]
-// is true, entry data will be loaded from its parent archive (if it exists)
+// is true, entry data will be loaded from its parent archive (if it exists).
+//
+// Unlike data(), this will not copy the data if it is a view of the archive
+// file, so should be used where the data only needs to be read
 // -----------------------------------------------------------------------------
 const uint8_t* ArchiveEntry::rawData(bool allow_load)
-{
-	// Return entry data
-	return data(allow_load).data();
-}
-
-// -----------------------------------------------------------------------------
-// Returns the entry data MemChunk. If no entry data exists and [allow_load]
-// is true, entry data will be loaded from its parent archive (if it exists)
-// -----------------------------------------------------------------------------
-MemChunk& ArchiveEntry::data(bool allow_load)
 {
 	// Get parent archive
 	auto parent_archive = parent();
@@ -184,6 +186,39 @@ MemChunk& ArchiveEntry::data(bool allow_load)
 		setState(State::Unmodified);
 	}
 
+	// Return entry data
+	return std::as_const(data_).data();
+}
+
+// -----------------------------------------------------------------------------
+// Sets [mc] to a read-only view of the entry data, loading it first if needed
+// and [allow_load] is true. The data is shared between the entry and [mc]
+// rather than copied (until either of them is modified, see MemChunk views).
+// Returns false if the entry has no data
+// -----------------------------------------------------------------------------
+bool ArchiveEntry::shareData(MemChunk& mc, bool allow_load)
+{
+	rawData(allow_load);
+	data_.makeShareable();
+
+	return data_.shareMemChunk(mc);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry data MemChunk. If no entry data exists and [allow_load]
+// is true, entry data will be loaded from its parent archive (if it exists).
+//
+// Since the returned MemChunk can be modified, if the entry data is currently
+// a view of the (memory-mapped) archive file it will be copied first
+// -----------------------------------------------------------------------------
+MemChunk& ArchiveEntry::data(bool allow_load)
+{
+	rawData(allow_load);
+	data_.detach();
+
+	// The data can be modified via the returned MemChunk
+	content_hash_valid_ = false;
+
 	return data_;
 }
 
@@ -228,8 +263,16 @@ int ArchiveEntry::index()
 // -----------------------------------------------------------------------------
 void ArchiveEntry::setName(string_view name)
 {
+	// Keep the parent dir's name index up to date
+	auto dir = indexedParentDir();
+	if (dir)
+		dir->unindexEntryName(this);
+
 	name_       = name;
 	upper_name_ = strutil::upper(name);
+
+	if (dir)
+		dir->indexEntryName(this);
 }
 
 // -----------------------------------------------------------------------------
@@ -238,6 +281,10 @@ void ArchiveEntry::setName(string_view name)
 // -----------------------------------------------------------------------------
 void ArchiveEntry::setState(State state, bool silent)
 {
+	// Modified, the data may have changed
+	if (state != State::Unmodified)
+		content_hash_valid_ = false;
+
 	if (state_locked_ || (state == State::Unmodified && state_ == State::Unmodified))
 		return;
 
@@ -300,17 +347,17 @@ void ArchiveEntry::unlock()
 // -----------------------------------------------------------------------------
 void ArchiveEntry::formatName(const ArchiveFormat& format)
 {
-	bool changed = false;
+	// Keep the parent dir's name index up to date
+	auto dir = indexedParentDir();
+	if (dir)
+		dir->unindexEntryName(this);
 
 	// Perform character substitution if needed
 	name_ = misc::fileNameToLumpName(name_);
 
 	// Max length
 	if (format.max_name_length > 0 && static_cast<int>(name_.size()) > format.max_name_length)
-	{
 		strutil::truncateIP(name_, format.max_name_length);
-		changed = true;
-	}
 
 	// Uppercase
 	if (format.prefer_uppercase && wad_force_uppercase)
@@ -318,19 +365,28 @@ void ArchiveEntry::formatName(const ArchiveFormat& format)
 
 	// Remove \ or / if the format supports folders
 	if (format.supports_dirs && (name_.find('/') != string::npos || name_.find('\\') != string::npos))
-	{
-		name_   = misc::lumpNameToFileName(name_);
-		changed = true;
-	}
+		name_ = misc::lumpNameToFileName(name_);
 
 	// Remove extension if the format doesn't have them
 	if (!format.names_extensions)
 		if (const auto pos = name_.find('.'); pos != string::npos)
 			strutil::truncateIP(name_, pos);
 
-	// Update upper name
-	if (changed)
-		upper_name_ = strutil::upper(name_);
+	// Update upper name (character substitution above can change it too)
+	upper_name_ = strutil::upper(name_);
+
+	if (dir)
+		dir->indexEntryName(this);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry's parent dir if the entry is in its list of entries (a
+// directory's own entry has the parent dir set but isn't in it), or null
+// otherwise
+// -----------------------------------------------------------------------------
+ArchiveDir* ArchiveEntry::indexedParentDir() const
+{
+	return parent_ && parent_->entryIndex(const_cast<ArchiveEntry*>(this)) >= 0 ? parent_ : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -367,6 +423,7 @@ bool ArchiveEntry::resize(uint32_t new_size, bool preserve_data)
 
 	// Update attributes
 	setState(State::Modified);
+	content_hash_valid_ = false;
 
 	return data_.reSize(new_size, preserve_data);
 }
@@ -387,8 +444,9 @@ void ArchiveEntry::clearData()
 	data_.clear();
 
 	// Reset attributes
-	size_        = 0;
-	data_loaded_ = false;
+	size_               = 0;
+	data_loaded_        = false;
+	content_hash_valid_ = false;
 }
 
 // -----------------------------------------------------------------------------
@@ -432,13 +490,34 @@ bool ArchiveEntry::importMem(const void* data, uint32_t size)
 bool ArchiveEntry::importMemChunk(MemChunk& mc)
 {
 	// Check that the given MemChunk has data
-	if (mc.hasData())
+	if (!mc.hasData())
+		return false;
+
+	// If the MemChunk is a view (eg. of a memory-mapped archive file), share
+	// it rather than copying the data
+	if (mc.isView())
 	{
-		// Copy the data from the MemChunk into the entry
-		return importMem(mc.data(), mc.size());
+		// Check if locked
+		if (locked_)
+		{
+			global::error = "Entry is locked";
+			return false;
+		}
+
+		clearData();
+		mc.shareMemChunk(data_);
+
+		// Update attributes
+		size_ = data_.size();
+		setLoaded();
+		setType(EntryType::unknownType());
+		setState(State::Modified);
+
+		return true;
 	}
 
-	return false;
+	// Copy the data from the MemChunk into the entry
+	return importMem(std::as_const(mc).data(), mc.size());
 }
 
 // -----------------------------------------------------------------------------
@@ -578,6 +657,7 @@ bool ArchiveEntry::write(const void* data, uint32_t size)
 		rawData(true);
 
 	// Perform the write
+	content_hash_valid_ = false;
 	if (data_.write(data, size))
 	{
 		// Update attributes
@@ -681,3 +761,71 @@ ArchiveEntry* ArchiveEntry::relativeEntry(string_view at_path, bool allow_absolu
 
 	return include;
 }
+
+// -----------------------------------------------------------------------------
+// Returns a hash of the entry's data (see misc::contentHash), for quickly
+// checking if entries have the same data. The hash is cached until the entry
+// is modified
+// -----------------------------------------------------------------------------
+uint64_t ArchiveEntry::contentHash()
+{
+	if (!content_hash_valid_)
+	{
+		auto data           = rawData();
+		content_hash_       = misc::contentHash(data, size());
+		content_hash_valid_ = true;
+	}
+
+	return content_hash_;
+}
+
+// -----------------------------------------------------------------------------
+// Computes (and caches) content hashes for all [entries] that don't already
+// have one. Entry data is read on the calling thread and hashed in parallel on
+// the app thread pool, in batches to limit the amount of data held at once.
+// Entries that weren't loaded beforehand are unloaded again afterwards
+// -----------------------------------------------------------------------------
+void ArchiveEntry::computeContentHashes(const vector<ArchiveEntry*>& entries)
+{
+	vector<ArchiveEntry*> batch;
+	vector<uint64_t>      hashes;
+	size_t                next = 0;
+	while (next < entries.size())
+	{
+		// Get the next batch of entries to hash
+		batch.clear();
+		uint64_t batch_data_size = 0;
+		for (; next < entries.size() && batch_data_size < content_hash_batch_size; ++next)
+		{
+			auto entry = entries[next];
+			if (entry && !entry->content_hash_valid_)
+			{
+				batch.push_back(entry);
+				batch_data_size += entry->size();
+			}
+		}
+
+		// Get views of the entry data
+		vector<MemChunk> data(batch.size());
+		for (unsigned a = 0; a < batch.size(); a++)
+		{
+			auto was_loaded = batch[a]->isLoaded();
+			batch[a]->shareData(data[a]);
+			if (!was_loaded)
+				batch[a]->unloadData();
+		}
+
+		// Hash the data
+		hashes.resize(batch.size());
+		app::threadPool().parallelFor(
+			batch.size(),
+			[&](size_t index) { hashes[index] = misc::contentHash(data[index].data(), data[index].size()); });
+
+		// Apply
+		for (unsigned a = 0; a < batch.size(); a++)
+		{
+			batch[a]->content_hash_       = hashes[a];
+			batch[a]->content_hash_valid_ = true;
+		}
+	}
+}
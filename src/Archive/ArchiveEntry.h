@@ -2,6 +2,7 @@
 
 #include "EntryType/EntryType.h"
 #include "Utility/Property.h"
+#include <atomic>
 
 namespace slade
 {
@@ -43,11 +44,13 @@ public:
 	uint32_t                 size() const { return data_loaded_ ? data_.size() : size_; }
 	MemChunk&                data(bool allow_load = true);
 	const uint8_t*           rawData(bool allow_load = true);
+	bool                     shareData(MemChunk& mc, bool allow_load = true);
 	ArchiveDir*              parentDir() const { return parent_; }
 	Archive*                 parent() const;
 	Archive*                 topParent() const;
 	string                   path(bool name = false) const;
 	EntryType*               type() const { return type_; }
+	int                      reliability() const { return reliability_; }
 	PropertyList&            exProps() { return ex_props_; }
 	const PropertyList&      exProps() const { return ex_props_; }
 	Property&                exProp(const string& key) { return ex_props_[key]; }
@@ -111,6 +114,11 @@ public:
 	bool          isInNamespace(string_view ns);
 	ArchiveEntry* relativeEntry(string_view path, bool allow_absolute_path = true) const;
 
+	// Content hash
+	uint64_t    contentHash();
+	bool        hasContentHash() const { return content_hash_valid_; }
+	static void computeContentHashes(const vector<ArchiveEntry*>& entries);
+
 private:
 	// Entry Info
 	string       name_;
@@ -129,7 +137,13 @@ private:
 	Encryption encrypted_    = Encryption::None; // Is there some encrypting on the archive?
 
 	// Misc stuff
-	int    reliability_ = 0; // The reliability of the entry's identification
-	size_t index_guess_ = 0; // for speed
+	int                 reliability_ = 0;  // The reliability of the entry's identification
+	std::atomic<size_t> index_guess_{ 0 }; // for speed
+
+	// Cached hash of the entry data (see contentHash), cleared when modified
+	uint64_t content_hash_       = 0;
+	bool     content_hash_valid_ = false;
+
+	ArchiveDir* indexedParentDir() const;
 };
 } // namespace slade
@@ -0,0 +1,586 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ArchiveIndex.cpp
+// Description: ArchiveIndex class - a persistent index of an archive file's
+//              entries (with their detected types) and maps, used to skip
+//              entry type detection when reopening an unchanged archive
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ArchiveIndex.h"
+#include "App.h"
+#include "EntryType/EntryType.h"
+#include "General/Misc.h"
+#include "Utility/FileUtils.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, archive_index_cache, true, CVar::Flag::Save)
+
+namespace
+{
+// Index files are made up of:
+// char[4] "SAI1", uint32 version, key (see ArchiveIndex::Key),
+// uint32 entry count, [entry count] * (path, uint32 size, type id, uint32 reliability),
+// uint32 has maps, uint32 map count,
+// [map count] * (name, uint32 head, uint32 end, uint32 format, uint32 archive, uint32 unk count, [unk count] * uint32)
+// Strings are written as uint32 length followed by the characters
+const char     index_magic[4] = { 'S', 'A', 'I', '1' };
+const uint32_t index_version  = 1;
+
+// Size of the data at the start and end of the archive file that is hashed
+// (archive directories are generally at one end or the other)
+const uint32_t hash_size = 65536;
+
+std::mutex index_file_mutex;
+
+// Simple binary writer/reader for index data
+class Writer
+{
+public:
+	const string& data() const { return data_; }
+
+	void write(uint32_t value) { data_.append(reinterpret_cast<const char*>(&value), 4); }
+	void write(uint64_t value) { data_.append(reinterpret_cast<const char*>(&value), 8); }
+	void write(string_view str)
+	{
+		write(static_cast<uint32_t>(str.size()));
+		data_.append(str);
+	}
+
+private:
+	string data_;
+};
+
+class Reader
+{
+public:
+	Reader(const MemChunk& mc) : data_{ mc.data() }, size_{ mc.size() } {}
+
+	template<typename T> bool read(T& value)
+	{
+		if (pos_ + sizeof(T) > size_)
+			return false;
+
+		memcpy(&value, data_ + pos_, sizeof(T));
+		pos_ += sizeof(T);
+
+		return true;
+	}
+
+	bool read(string& str)
+	{
+		uint32_t length;
+		if (!read(length) || pos_ + length > size_)
+			return false;
+
+		str.assign(reinterpret_cast<const char*>(data_ + pos_), length);
+		pos_ += length;
+
+		return true;
+	}
+
+	uint32_t remaining() const { return size_ - pos_; }
+
+private:
+	const uint8_t* data_;
+	uint32_t       size_;
+	uint32_t       pos_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+// Returns a hash of all currently defined entry type ids, so that indexes are
+// invalidated if the entry type definitions change
+// -----------------------------------------------------------------------------
+uint64_t entryTypesHash()
+{
+	string ids;
+	for (auto type : EntryType::allTypes())
+		ids.append(type->id()).push_back('\n');
+
+	return misc::contentHash(reinterpret_cast<const uint8_t*>(ids.data()), ids.size());
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// ArchiveIndex::Key Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns true if this key is the same as [rhs]
+// -----------------------------------------------------------------------------
+bool ArchiveIndex::Key::operator==(const Key& rhs) const
+{
+	return file_size == rhs.file_size && modified == rhs.modified && head_hash == rhs.head_hash
+		   && tail_hash == rhs.tail_hash && types_hash == rhs.types_hash && app_version == rhs.app_version;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// ArchiveIndex Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// ArchiveIndex class constructor. Opens the index for the archive file at
+// [filename], which is [size] bytes long. [head] and [tail] are the data at the
+// start and end of the file (hash_size bytes, or the whole file if smaller).
+// The index is only valid if it was written for the file as it currently is
+// -----------------------------------------------------------------------------
+ArchiveIndex::ArchiveIndex(string_view filename, uint64_t size, const uint8_t* head, const uint8_t* tail)
+{
+	auto path_hash = misc::contentHash(reinterpret_cast<const uint8_t*>(filename.data()), filename.size());
+	path_          = fmt::format("{}/index_{:016x}.dat", app::path("cache", app::Dir::User), path_hash);
+
+	// Build key for the current file
+	auto hashed      = std::min<uint64_t>(size, hash_size);
+	key_.file_size   = size;
+	key_.modified    = static_cast<uint64_t>(fileutil::fileModifiedTime(filename));
+	key_.head_hash   = misc::contentHash(head, hashed);
+	key_.tail_hash   = misc::contentHash(tail, hashed);
+	key_.types_hash  = entryTypesHash();
+	key_.app_version = app::version().toString();
+
+	valid_ = load();
+}
+
+// -----------------------------------------------------------------------------
+// Adds the indexed info for each entry in [archive] to [types], if the index
+// is valid and its entries match the archive's (same paths and sizes).
+// If they don't match, the index is invalidated
+// -----------------------------------------------------------------------------
+void ArchiveIndex::putEntryTypes(const Archive& archive, std::unordered_map<const ArchiveEntry*, const Entry*>& types)
+{
+	checked_ = true;
+	if (!valid_)
+		return;
+
+	vector<shared_ptr<ArchiveEntry>> entries;
+	archive.putEntryTreeAsList(entries);
+	if (!matches(entries))
+	{
+		log::info(2, "Archive index {} doesn't match archive entries, ignoring", path_);
+		valid_    = false;
+		has_maps_ = false;
+		entries_.clear();
+		maps_.clear();
+		return;
+	}
+
+	types.reserve(entries.size());
+	for (unsigned a = 0; a < entries.size(); a++)
+		types[entries[a].get()] = &entries_[a];
+}
+
+// -----------------------------------------------------------------------------
+// Adds the indexed maps in [archive] to [maps].
+// Returns false if there are no indexed maps, or the archive has been modified
+// since it was opened (in which case the maps need to be detected again)
+// -----------------------------------------------------------------------------
+bool ArchiveIndex::putMaps(const Archive& archive, vector<Archive::MapDesc>& maps) const
+{
+	if (!valid_ || !has_maps_ || archive.isModified())
+		return false;
+
+	vector<shared_ptr<ArchiveEntry>> entries;
+	archive.putEntryTreeAsList(entries);
+	if (entries.size() != num_entries_)
+		return false;
+
+	for (const auto& map : maps_)
+	{
+		if (map.head >= entries.size() || map.end >= entries.size())
+			return false;
+
+		Archive::MapDesc md;
+		md.name    = map.name;
+		md.head    = entries[map.head];
+		md.end     = entries[map.end];
+		md.format  = map.format;
+		md.archive = map.archive;
+		for (auto index : map.unk)
+			if (index < entries.size())
+				md.unk.push_back(entries[index].get());
+
+		maps.push_back(md);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the index from the entries (and their detected types) in [archive]
+// if it wasn't valid when the archive was opened, and writes it to disk.
+// Any indexed maps are cleared
+// -----------------------------------------------------------------------------
+void ArchiveIndex::update(const Archive& archive)
+{
+	// Don't bother if the index wasn't used for type detection (eg. the format
+	// doesn't detect entry types on open), or it is already up to date
+	if (!checked_ || valid_)
+		return;
+
+	vector<shared_ptr<ArchiveEntry>> entries;
+	archive.putEntryTreeAsList(entries);
+	setEntries(entries);
+	maps_.clear();
+	has_maps_ = false;
+
+	valid_ = save();
+}
+
+// -----------------------------------------------------------------------------
+// Sets the indexed [maps] in [archive] and writes the index to disk, if the
+// index is valid and the archive hasn't been modified since it was opened
+// -----------------------------------------------------------------------------
+void ArchiveIndex::updateMaps(const Archive& archive, const vector<Archive::MapDesc>& maps)
+{
+	if (!valid_ || archive.isModified())
+		return;
+
+	vector<shared_ptr<ArchiveEntry>> entries;
+	archive.putEntryTreeAsList(entries);
+	setEntries(entries);
+
+	std::unordered_map<const ArchiveEntry*, unsigned> entry_index;
+	entry_index.reserve(entries.size());
+	for (unsigned a = 0; a < entries.size(); a++)
+		entry_index[entries[a].get()] = a;
+
+	// Add maps
+	maps_.clear();
+	for (const auto& md : maps)
+	{
+		auto head = entry_index.find(md.head.lock().get());
+		auto end  = entry_index.find(md.end.lock().get());
+		if (head == entry_index.end() || end == entry_index.end())
+			continue;
+
+		Map map;
+		map.name    = md.name;
+		map.head    = head->second;
+		map.end     = end->second;
+		map.format  = md.format;
+		map.archive = md.archive;
+		for (auto unk : md.unk)
+		{
+			auto i = entry_index.find(unk);
+			if (i != entry_index.end())
+				map.unk.push_back(i->second);
+		}
+		maps_.push_back(map);
+	}
+	has_maps_ = true;
+
+	save();
+	release();
+}
+
+// -----------------------------------------------------------------------------
+// Frees the indexed entry info (once the archive has been opened it is no
+// longer needed, and will be rebuilt from the archive if the index is updated)
+// -----------------------------------------------------------------------------
+void ArchiveIndex::release()
+{
+	entries_.clear();
+	entries_.shrink_to_fit();
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the indexed entries match [entries]
+// -----------------------------------------------------------------------------
+bool ArchiveIndex::matches(const vector<shared_ptr<ArchiveEntry>>& entries) const
+{
+	if (entries.size() != entries_.size())
+		return false;
+
+	for (unsigned a = 0; a < entries.size(); a++)
+		if (entries[a]->size() != entries_[a].size || entries[a]->path(true) != entries_[a].path)
+			return false;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Sets the indexed entries to [entries] (with their current types)
+// -----------------------------------------------------------------------------
+void ArchiveIndex::setEntries(const vector<shared_ptr<ArchiveEntry>>& entries)
+{
+	entries_.resize(entries.size());
+	for (unsigned a = 0; a < entries.size(); a++)
+	{
+		auto& entry       = entries_[a];
+		entry.path        = entries[a]->path(true);
+		entry.size        = entries[a]->size();
+		entry.type        = entries[a]->type();
+		entry.reliability = entries[a]->reliability();
+	}
+	num_entries_ = static_cast<unsigned>(entries.size());
+}
+
+// -----------------------------------------------------------------------------
+// Reads the index from disk.
+// Returns false if the index file doesn't exist, is invalid or was written for
+// a different version of the archive file
+// -----------------------------------------------------------------------------
+bool ArchiveIndex::load()
+{
+	entries_.clear();
+	maps_.clear();
+	has_maps_ = false;
+
+	// Read file
+	MemChunk mc;
+	{
+		std::lock_guard<std::mutex> lock(index_file_mutex);
+		if (!fileutil::fileExists(path_) || !mc.importFile(path_))
+			return false;
+	}
+
+	// Check header
+	Reader   reader(mc);
+	char     magic[4];
+	uint32_t version = 0;
+	if (!reader.read(magic) || memcmp(magic, index_magic, 4) != 0 || !reader.read(version)
+		|| version != index_version)
+		return false;
+
+	// Check key
+	Key key;
+	if (!reader.read(key.file_size) || !reader.read(key.modified) || !reader.read(key.head_hash)
+		|| !reader.read(key.tail_hash) || !reader.read(key.types_hash) || !reader.read(key.app_version))
+		return false;
+	if (!(key == key_))
+		return false;
+
+	// Read entries (each is at least 16 bytes, so the count can be checked
+	// against the remaining data before allocating for them)
+	uint32_t count = 0;
+	if (!reader.read(count) || count > reader.remaining() / 16)
+		return false;
+	string type_id;
+	entries_.resize(count);
+	for (auto& entry : entries_)
+	{
+		uint32_t reliability;
+		if (!reader.read(entry.path) || !reader.read(entry.size) || !reader.read(type_id)
+			|| !reader.read(reliability))
+		{
+			entries_.clear();
+			return false;
+		}
+
+		entry.type        = EntryType::fromId(type_id);
+		entry.reliability = static_cast<int>(reliability);
+	}
+	num_entries_ = count;
+
+	// Read maps
+	uint32_t has_maps = 0;
+	if (!reader.read(has_maps) || !reader.read(count))
+		return true;
+	if (count > reader.remaining() / 24) // Each map is at least 24 bytes
+	{
+		entries_.clear();
+		return false;
+	}
+	maps_.resize(count);
+	for (auto& map : maps_)
+	{
+		uint32_t format, archive, num_unk;
+		if (!reader.read(map.name) || !reader.read(map.head) || !reader.read(map.end) || !reader.read(format)
+			|| !reader.read(archive) || !reader.read(num_unk))
+		{
+			maps_.clear();
+			return true;
+		}
+
+		map.format  = static_cast<MapFormat>(format);
+		map.archive = archive > 0;
+		if (num_unk > reader.remaining() / 4)
+		{
+			entries_.clear();
+			maps_.clear();
+			return false;
+		}
+		map.unk.resize(num_unk);
+		for (auto& index : map.unk)
+			if (!reader.read(index))
+			{
+				maps_.clear();
+				return true;
+			}
+	}
+	has_maps_ = has_maps > 0;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the index to disk. Returns false if the file couldn't be written
+// -----------------------------------------------------------------------------
+bool ArchiveIndex::save() const
+{
+	// Build index data
+	Writer writer;
+	writer.write(index_version);
+	writer.write(key_.file_size);
+	writer.write(key_.modified);
+	writer.write(key_.head_hash);
+	writer.write(key_.tail_hash);
+	writer.write(key_.types_hash);
+	writer.write(key_.app_version);
+
+	writer.write(static_cast<uint32_t>(entries_.size()));
+	for (const auto& entry : entries_)
+	{
+		writer.write(entry.path);
+		writer.write(entry.size);
+		writer.write(entry.type ? string_view{ entry.type->id() } : string_view{});
+		writer.write(static_cast<uint32_t>(entry.reliability));
+	}
+
+	writer.write(static_cast<uint32_t>(has_maps_ ? 1 : 0));
+	writer.write(static_cast<uint32_t>(maps_.size()));
+	for (const auto& map : maps_)
+	{
+		writer.write(map.name);
+		writer.write(map.head);
+		writer.write(map.end);
+		writer.write(static_cast<uint32_t>(map.format));
+		writer.write(static_cast<uint32_t>(map.archive ? 1 : 0));
+		writer.write(static_cast<uint32_t>(map.unk.size()));
+		for (auto index : map.unk)
+			writer.write(index);
+	}
+
+	// Write to file
+	std::lock_guard<std::mutex> lock(index_file_mutex);
+
+	auto cache_dir = app::path("cache", app::Dir::User);
+	if (!fileutil::dirExists(cache_dir) && !fileutil::createDir(cache_dir))
+		return false;
+
+	SFile file(path_, SFile::Mode::Write);
+	if (!file.isOpen())
+	{
+		log::warning("Unable to write archive index file {}", path_);
+		return false;
+	}
+
+	file.write(index_magic, 4);
+	file.write(writer.data().data(), writer.data().size());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index for the archive file at [filename] (read into [data]), or
+// nullptr if archive indexing is disabled
+// -----------------------------------------------------------------------------
+unique_ptr<ArchiveIndex> ArchiveIndex::forFile(string_view filename, const MemChunk& data)
+{
+	if (!archive_index_cache || filename.empty() || !data.hasData())
+		return nullptr;
+
+	auto hashed = std::min(data.size(), hash_size);
+	return std::make_unique<ArchiveIndex>(filename, data.size(), data.data(), data.data() + data.size() - hashed);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index for the archive file at [filename] (open as [file], when
+// it isn't read into memory), or nullptr if archive indexing is disabled or
+// the file couldn't be read
+// -----------------------------------------------------------------------------
+unique_ptr<ArchiveIndex> ArchiveIndex::forFile(string_view filename, SFile& file)
+{
+	if (!archive_index_cache || filename.empty() || file.size() == 0)
+		return nullptr;
+
+	// Read the start and end of the file to hash
+	auto     hashed = std::min(file.size(), hash_size);
+	MemChunk head, tail;
+	if (!file.seekFromStart(0) || !file.read(head, hashed) || !file.seekFromStart(file.size() - hashed)
+		|| !file.read(tail, hashed))
+		return nullptr;
+
+	return std::make_unique<ArchiveIndex>(filename, file.size(), head.data(), tail.data());
+}
+
+
+// Testing
+
+#include "Archive/ArchiveManager.h"
+#include "General/Console.h"
+
+// -----------------------------------------------------------------------------
+// Benchmarks opening the archive file [filename] without its index (cold),
+// then with the index being built, then with the index (warm)
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_archive_index, 1, false)
+{
+	const auto& filename = args[0];
+	if (app::archiveManager().getArchive(filename))
+	{
+		log::warning("Archive {} is already open, close it first", filename);
+		return;
+	}
+
+	auto open_archive = [&filename](string_view desc)
+	{
+		auto time    = app::runTimer();
+		auto archive = app::archiveManager().openArchive(filename, false, true);
+		if (!archive)
+		{
+			log::error("Unable to open {}: {}", filename, global::error);
+			return false;
+		}
+		log::info("Opening {} ({}) took {}ms", filename, desc, app::runTimer() - time);
+		return true;
+	};
+
+	bool enabled        = archive_index_cache;
+	archive_index_cache = false;
+	bool ok             = open_archive("cold, no index");
+	archive_index_cache = true;
+	if (ok && open_archive("building index"))
+		open_archive("warm, using index");
+	archive_index_cache = enabled;
+}
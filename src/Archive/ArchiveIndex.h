@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Archive.h"
+
+namespace slade
+{
+class SFile;
+
+// A persistent index of an archive file's entries (path, size and detected
+// type) and maps, so that when the archive is opened again unchanged, entry
+// type detection (which has to read every entry's data) can be skipped.
+//
+// The index is keyed by the archive's path, and is only used if the file's
+// size, modified time and a hash of its start and end (where archive
+// directories are) match those it was written with
+class ArchiveIndex
+{
+public:
+	struct Entry
+	{
+		string     path;
+		uint32_t   size        = 0;
+		EntryType* type        = nullptr;
+		int        reliability = 0;
+	};
+
+	struct Map
+	{
+		string           name;
+		unsigned         head    = 0; // Index of the map's first/last entries in the entry list
+		unsigned         end     = 0;
+		MapFormat        format  = MapFormat::Unknown;
+		bool             archive = false;
+		vector<unsigned> unk;
+	};
+
+	ArchiveIndex(string_view filename, uint64_t size, const uint8_t* head, const uint8_t* tail);
+	~ArchiveIndex() = default;
+
+	bool isValid() const { return valid_; }
+	bool hasMaps() const { return has_maps_; }
+
+	void putEntryTypes(const Archive& archive, std::unordered_map<const ArchiveEntry*, const Entry*>& types);
+	bool putMaps(const Archive& archive, vector<Archive::MapDesc>& maps) const;
+
+	void update(const Archive& archive);
+	void updateMaps(const Archive& archive, const vector<Archive::MapDesc>& maps);
+	void release();
+
+	static unique_ptr<ArchiveIndex> forFile(string_view filename, const MemChunk& data);
+	static unique_ptr<ArchiveIndex> forFile(string_view filename, SFile& file);
+
+private:
+	// The index file is only valid if all of these match the archive file
+	struct Key
+	{
+		uint64_t file_size  = 0;
+		uint64_t modified   = 0;
+		uint64_t head_hash  = 0;
+		uint64_t tail_hash  = 0;
+		uint64_t types_hash = 0;
+		string   app_version;
+
+		bool operator==(const Key& rhs) const;
+	};
+
+	string        path_;
+	Key           key_;
+	bool          valid_       = false; // True if the index matches the archive file
+	bool          checked_     = false; // True if the index was checked for entry types
+	bool          has_maps_    = false;
+	vector<Entry> entries_;
+	unsigned      num_entries_ = 0;
+	vector<Map>   maps_;
+
+	bool matches(const vector<shared_ptr<ArchiveEntry>>& entries) const;
+	void setEntries(const vector<shared_ptr<ArchiveEntry>>& entries);
+	bool load();
+	bool save() const;
+};
+} // namespace slade
@@ -393,53 +393,55 @@ shared_ptr<Archive> ArchiveManager::openArchive(ArchiveEntry* entry, bool manage
 		}
 	}
 
-	// Check entry type
+	// Check entry type (using a view of the entry data, so it isn't copied)
+	MemChunk data;
+	entry->shareData(data);
 	shared_ptr<Archive> new_archive;
-	if (WadArchive::isWadArchive(entry->data()))
+	if (WadArchive::isWadArchive(data))
 		new_archive = std::make_shared<WadArchive>();
-	else if (ZipArchive::isZipArchive(entry->data()))
+	else if (ZipArchive::isZipArchive(data))
 		new_archive = std::make_shared<ZipArchive>();
-	else if (ResArchive::isResArchive(entry->data()))
+	else if (ResArchive::isResArchive(data))
 		new_archive = std::make_shared<ResArchive>();
-	else if (LibArchive::isLibArchive(entry->data()))
+	else if (LibArchive::isLibArchive(data))
 		new_archive = std::make_shared<LibArchive>();
-	else if (DatArchive::isDatArchive(entry->data()))
+	else if (DatArchive::isDatArchive(data))
 		new_archive = std::make_shared<DatArchive>();
-	else if (PakArchive::isPakArchive(entry->data()))
+	else if (PakArchive::isPakArchive(data))
 		new_archive = std::make_shared<PakArchive>();
-	else if (BSPArchive::isBSPArchive(entry->data()))
+	else if (BSPArchive::isBSPArchive(data))
 		new_archive = std::make_shared<BSPArchive>();
-	else if (GrpArchive::isGrpArchive(entry->data()))
+	else if (GrpArchive::isGrpArchive(data))
 		new_archive = std::make_shared<GrpArchive>();
-	else if (RffArchive::isRffArchive(entry->data()))
+	else if (RffArchive::isRffArchive(data))
 		new_archive = std::make_shared<RffArchive>();
-	else if (GobArchive::isGobArchive(entry->data()))
+	else if (GobArchive::isGobArchive(data))
 		new_archive = std::make_shared<GobArchive>();
-	else if (LfdArchive::isLfdArchive(entry->data()))
+	else if (LfdArchive::isLfdArchive(data))
 		new_archive = std::make_shared<LfdArchive>();
-	else if (HogArchive::isHogArchive(entry->data()))
+	else if (HogArchive::isHogArchive(data))
 		new_archive = std::make_shared<HogArchive>();
-	else if (ADatArchive::isADatArchive(entry->data()))
+	else if (ADatArchive::isADatArchive(data))
 		new_archive = std::make_shared<ADatArchive>();
-	else if (Wad2Archive::isWad2Archive(entry->data()))
+	else if (Wad2Archive::isWad2Archive(data))
 		new_archive = std::make_shared<Wad2Archive>();
-	else if (WadJArchive::isWadJArchive(entry->data()))
+	else if (WadJArchive::isWadJArchive(data))
 		new_archive = std::make_shared<WadJArchive>();
-	else if (WolfArchive::isWolfArchive(entry->data()))
+	else if (WolfArchive::isWolfArchive(data))
 		new_archive = std::make_shared<WolfArchive>();
-	else if (GZipArchive::isGZipArchive(entry->data()))
+	else if (GZipArchive::isGZipArchive(data))
 		new_archive = std::make_shared<GZipArchive>();
-	else if (BZip2Archive::isBZip2Archive(entry->data()))
+	else if (BZip2Archive::isBZip2Archive(data))
 		new_archive = std::make_shared<BZip2Archive>();
-	else if (TarArchive::isTarArchive(entry->data()))
+	else if (TarArchive::isTarArchive(data))
 		new_archive = std::make_shared<TarArchive>();
-	else if (DiskArchive::isDiskArchive(entry->data()))
+	else if (DiskArchive::isDiskArchive(data))
 		new_archive = std::make_shared<DiskArchive>();
-	else if (strutil::endsWithCI(entry->name(), ".pod") && PodArchive::isPodArchive(entry->data()))
+	else if (strutil::endsWithCI(entry->name(), ".pod") && PodArchive::isPodArchive(data))
 		new_archive = std::make_shared<PodArchive>();
-	else if (ChasmBinArchive::isChasmBinArchive(entry->data()))
+	else if (ChasmBinArchive::isChasmBinArchive(data))
 		new_archive = std::make_shared<ChasmBinArchive>();
-	else if (SiNArchive::isSiNArchive(entry->data()))
+	else if (SiNArchive::isSiNArchive(data))
 		new_archive = std::make_shared<SiNArchive>();
 	else
 	{
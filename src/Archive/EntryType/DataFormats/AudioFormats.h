@@ -190,7 +190,7 @@ public:
 		{
 			// Check for mod header
 			char temp[18] = "";
-			memcpy(temp, mc.data(), 18);
+			memcpy(temp, std::as_const(mc).data(), 18);
 			temp[17] = 0;
 			if (temp[9] == 'M')
 				temp[9] = 'm';
@@ -724,7 +724,7 @@ public:
 				if ((mc[24] + (mc[25] << 8)) == validity)
 				{
 					// Lastly, check for header text
-					auto header(wxString::FromAscii(mc.data(), 19));
+					auto header(wxString::FromAscii(std::as_const(mc).data(), 19));
 					if (header == "Creative Voice File")
 						return MATCH_TRUE;
 				}
@@ -931,7 +931,7 @@ public:
 		if (mc.size() > 20)
 		{
 			// Check for header text using official signature string
-			if (memcmp(mc.data(), "ZXAYEMUL", 8) == 0)
+			if (memcmp(std::as_const(mc).data(), "ZXAYEMUL", 8) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -950,7 +950,7 @@ public:
 		if (mc.size() > 112)
 		{
 			// Talk about a weak signature...
-			if (memcmp(mc.data(), "GBS\x01", 4) == 0)
+			if (memcmp(std::as_const(mc).data(), "GBS\x01", 4) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -969,7 +969,7 @@ public:
 		if (mc.size() > 428)
 		{
 			// Talk about a weak signature... And some GYM files don't even have that...
-			if (memcmp(mc.data(), "GYMX", 4) == 0)
+			if (memcmp(std::as_const(mc).data(), "GYMX", 4) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -988,7 +988,7 @@ public:
 		if (mc.size() > 32)
 		{
 			// Another weak signature
-			if (memcmp(mc.data(), "HESM", 4) == 0)
+			if (memcmp(std::as_const(mc).data(), "HESM", 4) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -1008,7 +1008,7 @@ public:
 		{
 			// Weak signatures for the weak signature god!
 			// Unreliable identifications for his throne!
-			if (memcmp(mc.data(), "KSCC", 4) == 0 || memcmp(mc.data(), "KSSX", 4) == 0)
+			if (memcmp(std::as_const(mc).data(), "KSCC", 4) == 0 || memcmp(std::as_const(mc).data(), "KSSX", 4) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -1027,7 +1027,7 @@ public:
 		if (mc.size() > 128)
 		{
 			// Check for header text using official signature string
-			if (memcmp(mc.data(), "NESM\x1A", 5) == 0)
+			if (memcmp(std::as_const(mc).data(), "NESM\x1A", 5) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -1046,7 +1046,7 @@ public:
 		if (mc.size() > 5)
 		{
 			// Check for header text using official signature string
-			if (memcmp(mc.data(), "NESM\x1A", 5) == 0)
+			if (memcmp(std::as_const(mc).data(), "NESM\x1A", 5) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -1065,7 +1065,7 @@ public:
 		if (mc.size() > 16)
 		{
 			// Check for header text using official signature string
-			if (memcmp(mc.data(), "SAP\x0D\x0A", 5) == 0)
+			if (memcmp(std::as_const(mc).data(), "SAP\x0D\x0A", 5) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -1085,7 +1085,7 @@ public:
 		if (mc.size() > 256)
 		{
 			// Check for header text using official signature string
-			if (memcmp(mc.data(), "SNES-SPC700 Sound File Data", 27) == 0)
+			if (memcmp(std::as_const(mc).data(), "SNES-SPC700 Sound File Data", 27) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
@@ -1104,7 +1104,7 @@ public:
 		if (mc.size() > 64)
 		{
 			// Check for header text (kind of a weak test)
-			if (memcmp(mc.data(), "Vgm ", 4) == 0)
+			if (memcmp(std::as_const(mc).data(), "Vgm ", 4) == 0)
 				return MATCH_TRUE;
 		}
 		return MATCH_FALSE;
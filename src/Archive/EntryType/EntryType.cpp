@@ -38,7 +38,9 @@
 #include "MainEditor/MainEditor.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
+#include <atomic>
 #include <filesystem>
+#include <unordered_map>
 
 using namespace slade;
 
@@ -58,6 +60,36 @@ EntryType* etype_unknown = nullptr; // The default, 'unknown' entry type
 EntryType* etype_folder  = nullptr; // Folder entry type
 EntryType* etype_marker  = nullptr; // Marker entry type
 EntryType* etype_map     = nullptr; // Map marker type
+
+// Index of detectable entry types by their name/extension/size criteria, so
+// only types that could possibly match an entry need to be tested against it.
+// Each type is indexed under one of its required criteria (or under both its
+// names and extensions if it only needs to match either), types without any
+// name/extension/size criteria are always tested
+struct EntryTypeIndex
+{
+	vector<EntryType*>                               any;
+	std::unordered_map<uint32_t, vector<EntryType*>> size;
+	std::unordered_map<string, vector<EntryType*>>   extension;
+	std::unordered_map<string, vector<EntryType*>>   name;
+	std::unordered_map<char, vector<EntryType*>>     name_prefix; // Wildcard names, by first character
+	vector<EntryType*>                               name_wildcard; // Wildcard names starting with a wildcard
+
+	void clear()
+	{
+		any.clear();
+		size.clear();
+		extension.clear();
+		name.clear();
+		name_prefix.clear();
+		name_wildcard.clear();
+	}
+};
+EntryTypeIndex type_index;
+
+// Detection statistics
+std::atomic<uint64_t> detect_entries{ 0 };
+std::atomic<uint64_t> detect_candidates{ 0 };
 } // namespace
 
 
@@ -141,28 +173,83 @@ int EntryType::isThisType(ArchiveEntry& entry)
 	if (!detectable_)
 		return EntryDataFormat::MATCH_FALSE;
 
-	// Check min size
-	if (size_limit_[0] >= 0 && entry.size() < (unsigned)size_limit_[0])
+	// Setup detection info from the entry
+	DetectInfo info;
+	string     archive_format, section;
+	info.upper_name = entry.upperName();
+	info.size       = entry.size();
+	if (auto archive = entry.parent())
+	{
+		info.in_archive = true;
+		if (!match_archive_.empty())
+		{
+			archive_format      = archive->formatDesc().entry_format;
+			info.archive_format = archive_format;
+		}
+		if (!section_.empty())
+		{
+			section      = archive->detectNamespace(&entry);
+			info.section = section;
+		}
+	}
+
+	// Check everything but the data first, so that the entry data is only
+	// loaded if needed
+	if (!matchesInfo(info))
 		return EntryDataFormat::MATCH_FALSE;
 
-	// Check max size
-	if (size_limit_[1] >= 0 && entry.size() > (unsigned)size_limit_[1])
+	return matchData(entry.data(), info);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [data] and its entry [info] match the EntryType's criteria,
+// false otherwise.
+// This doesn't modify the EntryType or access any entry/archive, so it is safe
+// to call from multiple threads at once (as long as [data] isn't shared)
+// -----------------------------------------------------------------------------
+int EntryType::isThisType(MemChunk& data, const DetectInfo& info) const
+{
+	// Check type is detectable
+	if (!detectable_)
+		return EntryDataFormat::MATCH_FALSE;
+
+	if (!matchesInfo(info))
 		return EntryDataFormat::MATCH_FALSE;
 
+	return matchData(data, info);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the entry [info] (size, name, archive, section) matches the
+// EntryType's criteria
+// -----------------------------------------------------------------------------
+bool EntryType::matchesInfo(const DetectInfo& info) const
+{
+	// Check min size
+	if (size_limit_[0] >= 0 && info.size < (unsigned)size_limit_[0])
+		return false;
+
+	// Check max size
+	if (size_limit_[1] >= 0 && info.size > (unsigned)size_limit_[1])
+		return false;
+
 	// Check for archive match if needed
 	if (!match_archive_.empty())
 	{
 		bool match = false;
-		for (const auto& a : match_archive_)
+		if (info.in_archive)
 		{
-			if (entry.parent() && entry.parent()->formatDesc().entry_format == a)
+			for (const auto& a : match_archive_)
 			{
-				match = true;
-				break;
+				if (info.archive_format == a)
+				{
+					match = true;
+					break;
+				}
 			}
 		}
 		if (!match)
-			return EntryDataFormat::MATCH_FALSE;
+			return false;
 	}
 
 	// Check for size match if needed
@@ -171,7 +258,7 @@ int EntryType::isThisType(ArchiveEntry& entry)
 		bool match = false;
 		for (unsigned a : match_size_)
 		{
-			if (entry.size() == a)
+			if (info.size == a)
 			{
 				match = true;
 				break;
@@ -179,38 +266,16 @@ int EntryType::isThisType(ArchiveEntry& entry)
 		}
 
 		if (!match)
-			return EntryDataFormat::MATCH_FALSE;
-	}
-
-	// Check for data format match if needed
-	int r = EntryDataFormat::MATCH_TRUE;
-	if (format_ == EntryDataFormat::textFormat())
-	{
-		// Hack for identifying ACS script sources despite DB2 apparently appending
-		// two null bytes to them, which make the memchr test fail.
-		size_t end = entry.size() - 1;
-		if (end > 3)
-			end -= 2;
-		// Text is a special case, as other data formats can sometimes be detected as 'text',
-		// we'll only check for it if text data is specified in the entry type
-		if (entry.size() > 0 && memchr(entry.rawData(), 0, end) != nullptr)
-			return EntryDataFormat::MATCH_FALSE;
-	}
-	else if (format_ != EntryDataFormat::anyFormat() && entry.size() > 0)
-	{
-		r = format_->isThisFormat(entry.data());
-		if (r == EntryDataFormat::MATCH_FALSE)
-			return EntryDataFormat::MATCH_FALSE;
+			return false;
 	}
 
 	// Check for size multiple match if needed
 	if (!size_multiple_.empty())
 	{
-		bool   match              = false;
-		size_t size_multiple_size = size_multiple_.size();
-		for (size_t a = 0; a < size_multiple_size; a++)
+		bool match = false;
+		for (int multiple : size_multiple_)
 		{
-			if (entry.size() % size_multiple_[a] == 0)
+			if (info.size % multiple == 0)
 			{
 				match = true;
 				break;
@@ -218,7 +283,7 @@ int EntryType::isThisType(ArchiveEntry& entry)
 		}
 
 		if (!match)
-			return EntryDataFormat::MATCH_FALSE;
+			return false;
 	}
 
 	// If both names and extensions are defined, and the type only needs one
@@ -231,8 +296,8 @@ int EntryType::isThisType(ArchiveEntry& entry)
 	// Entry name related stuff
 	if (!match_name_.empty() || !match_extension_.empty())
 	{
-		// Get entry name (lowercase), find extension separator
-		string_view fn      = entry.upperName();
+		// Get entry name (uppercase), find extension separator
+		string_view fn      = info.upper_name;
 		size_t      ext_sep = fn.find_first_of('.', 0);
 
 		// Check for name match if needed
@@ -253,7 +318,7 @@ int EntryType::isThisType(ArchiveEntry& entry)
 			}
 
 			if (!match && !extorname)
-				return EntryDataFormat::MATCH_FALSE;
+				return false;
 			else
 				matchedname = match;
 		}
@@ -276,7 +341,7 @@ int EntryType::isThisType(ArchiveEntry& entry)
 			}
 
 			if (!match && !(extorname && matchedname))
-				return EntryDataFormat::MATCH_FALSE;
+				return false;
 		}
 	}
 
@@ -284,18 +349,73 @@ int EntryType::isThisType(ArchiveEntry& entry)
 	if (!section_.empty())
 	{
 		// Check entry is part of an archive (if not it can't be in a section)
-		if (!entry.parent())
-			return EntryDataFormat::MATCH_FALSE;
+		if (!info.in_archive)
+			return false;
 
-		auto e_section = entry.parent()->detectNamespace(&entry);
-
-		r = EntryDataFormat::MATCH_FALSE;
+		bool match = false;
 		for (const auto& ns : section_)
-			if (strutil::equalCI(ns, e_section))
-				r = EntryDataFormat::MATCH_TRUE;
+			if (strutil::equalCI(ns, info.section))
+			{
+				match = true;
+				break;
+			}
+
+		if (!match)
+			return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Checks [data] against the EntryType's data format, returns the format match
+// reliability (see EntryDataFormat::MATCH_*).
+// Assumes the entry [info] has already been checked with matchesInfo
+// -----------------------------------------------------------------------------
+int EntryType::matchData(MemChunk& data, const DetectInfo& info, FormatMatchCache* format_cache) const
+{
+	int r = EntryDataFormat::MATCH_TRUE;
+	if (format_ == EntryDataFormat::textFormat())
+	{
+		// Hack for identifying ACS script sources despite DB2 apparently appending
+		// two null bytes to them, which make the memchr test fail.
+		size_t end = info.size - 1;
+		if (end > 3)
+			end -= 2;
+		// Text is a special case, as other data formats can sometimes be detected as 'text',
+		// we'll only check for it if text data is specified in the entry type
+		if (info.size > 0 && memchr(data.data(), 0, end) != nullptr)
+			return EntryDataFormat::MATCH_FALSE;
 	}
+	else if (format_ != EntryDataFormat::anyFormat() && info.size > 0)
+	{
+		// Check the format, reusing the result if it was already checked for
+		// this data (many types share the same format)
+		r = -1;
+		if (format_cache)
+		{
+			for (const auto& result : *format_cache)
+				if (result.first == format_)
+				{
+					r = result.second;
+					break;
+				}
+		}
+		if (r < 0)
+		{
+			r = format_->isThisFormat(data);
+			if (format_cache)
+				format_cache->emplace_back(format_, r);
+		}
+
+		if (r == EntryDataFormat::MATCH_FALSE)
+			return EntryDataFormat::MATCH_FALSE;
+	}
+
+	// A section match is always a 'true' match
+	if (!section_.empty())
+		r = EntryDataFormat::MATCH_TRUE;
 
-	// Passed all checks, so we have a match
 	return r;
 }
 
@@ -515,6 +635,9 @@ bool EntryType::readEntryTypeDefinition(MemChunk& mc, string_view source)
 		entry_types.push_back(std::move(ntype));
 	}
 
+	// Update type index with the new types
+	buildTypeIndex();
+
 	return true;
 }
 
@@ -590,39 +713,188 @@ bool EntryType::detectEntryType(ArchiveEntry& entry)
 	if (entry.type() == etype_folder || entry.type() == etype_map)
 		return false;
 
-	// If the entry's size is zero, set it to marker type
-	if (entry.size() == 0)
+	// Setup detection info from the entry
+	DetectInfo info;
+	string     archive_format, section;
+	info.upper_name = entry.upperName();
+	info.size       = entry.size();
+	if (auto archive = entry.parent())
 	{
-		entry.setType(etype_marker);
-		return true;
+		archive_format      = archive->formatDesc().entry_format;
+		section             = archive->detectNamespace(&entry);
+		info.in_archive     = true;
+		info.archive_format = archive_format;
+		info.section        = section;
 	}
 
-	// Reset entry type
-	entry.setType(etype_unknown);
+	// Detect type
+	int  reliability = 0;
+	auto type        = detectEntryType(info.size > 0 ? entry.data() : entry.data(false), info, reliability);
+	entry.setType(type, reliability);
 
-	// Go through all registered types
-	size_t entry_types_size = entry_types.size();
-	for (size_t a = 0; a < entry_types_size; a++)
+	// Return t/f depending on if a matching type was found
+	return type != etype_unknown;
+}
+
+// -----------------------------------------------------------------------------
+// Attempts to detect the type of entry [data] with the given entry [info].
+// Returns the detected type, and sets [reliability] to the match reliability
+// (see EntryDataFormat::MATCH_*).
+// Safe to call from multiple threads at once, as long as [data] isn't shared
+// -----------------------------------------------------------------------------
+EntryType* EntryType::detectEntryType(MemChunk& data, const DetectInfo& info, int& reliability)
+{
+	// If the entry's size is zero, it's a marker
+	if (info.size == 0)
+	{
+		reliability = 0;
+		return etype_marker;
+	}
+
+	// Get entry name and extension
+	auto name    = info.upper_name;
+	auto ext_sep = name.find_first_of('.', 0);
+	auto ext     = ext_sep == string::npos ? string_view{} : name.substr(ext_sep + 1);
+	if (ext_sep != string::npos)
+		name = name.substr(0, ext_sep);
+
+	// Gather candidate types from the type index
+	vector<EntryType*> candidates;
+	auto               add_candidates = [&candidates](const vector<EntryType*>& types)
+	{ candidates.insert(candidates.end(), types.begin(), types.end()); };
+	add_candidates(type_index.any);
+	add_candidates(type_index.name_wildcard);
+	if (auto i = type_index.size.find(info.size); i != type_index.size.end())
+		add_candidates(i->second);
+	if (!ext.empty())
+		if (auto i = type_index.extension.find(string{ ext }); i != type_index.extension.end())
+			add_candidates(i->second);
+	if (auto i = type_index.name.find(string{ name }); i != type_index.name.end())
+		add_candidates(i->second);
+	if (!name.empty())
+		if (auto i = type_index.name_prefix.find(name[0]); i != type_index.name_prefix.end())
+			add_candidates(i->second);
+
+	// Test candidates in the order the types were defined (the same order they
+	// would be tested in without the index)
+	std::sort(candidates.begin(), candidates.end(), [](EntryType* l, EntryType* r) { return l->index_ < r->index_; });
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	// Go through candidate types
+	auto             type             = etype_unknown;
+	int              type_reliability = 0;
+	unsigned         tested           = 0;
+	FormatMatchCache format_cache;
+	reliability = 0;
+	for (auto candidate : candidates)
 	{
 		// If the current type is more 'reliable' than this one, skip it
-		if (entry.typeReliability() >= entry_types[a]->reliability())
+		if (type_reliability >= candidate->reliability())
 			continue;
 
 		// Check for possible type match
-		int r = entry_types[a]->isThisType(entry);
+		++tested;
+		int r = candidate->matchesInfo(info) ? candidate->matchData(data, info, &format_cache) :
+											   EntryDataFormat::MATCH_FALSE;
 		if (r > 0)
 		{
 			// Type matches, set it
-			entry.setType(entry_types[a].get(), r);
+			type             = candidate;
+			reliability      = r;
+			type_reliability = type->reliability() * r / 255;
 
 			// No need to continue if the identification is 100% reliable
-			if (entry.typeReliability() >= 255)
-				return true;
+			if (type_reliability >= 255)
+				break;
 		}
 	}
 
-	// Return t/f depending on if a matching type was found
-	return entry.type() != etype_unknown;
+	// Update stats
+	++detect_entries;
+	detect_candidates += tested;
+
+	return type;
+}
+
+// -----------------------------------------------------------------------------
+// Returns type detection statistics, resetting them afterwards if [reset] is
+// true
+// -----------------------------------------------------------------------------
+EntryType::DetectStats EntryType::detectStats(bool reset)
+{
+	DetectStats stats;
+	stats.entries    = reset ? detect_entries.exchange(0) : detect_entries.load();
+	stats.candidates = reset ? detect_candidates.exchange(0) : detect_candidates.load();
+	return stats;
+}
+
+// -----------------------------------------------------------------------------
+// (Re)builds the type index used to narrow down the types that need to be
+// tested when detecting an entry's type (see EntryTypeIndex)
+// -----------------------------------------------------------------------------
+void EntryType::buildTypeIndex()
+{
+	type_index.clear();
+
+	auto add = [](vector<EntryType*>& list, EntryType* type)
+	{
+		if (list.empty() || list.back() != type)
+			list.push_back(type);
+	};
+
+	auto index_names = [&add](EntryType* type)
+	{
+		for (const auto& name : type->match_name_)
+		{
+			if (name.find_first_of("*?") == string::npos)
+				add(type_index.name[name], type);
+			else if (name[0] != '*' && name[0] != '?')
+				add(type_index.name_prefix[name[0]], type);
+			else
+				add(type_index.name_wildcard, type);
+		}
+	};
+
+	auto index_extensions = [&add](EntryType* type)
+	{
+		for (const auto& ext : type->match_extension_)
+			add(type_index.extension[ext], type);
+	};
+
+	for (const auto& type : entry_types)
+	{
+		if (!type->detectable_)
+			continue;
+
+		bool ext_or_name = type->match_ext_or_name_ && !type->match_name_.empty()
+						   && !type->match_extension_.empty();
+
+		// Size(s) must match
+		if (!type->match_size_.empty())
+		{
+			for (auto size : type->match_size_)
+				add(type_index.size[size], type.get());
+		}
+
+		// Name or extension must match
+		else if (ext_or_name)
+		{
+			index_names(type.get());
+			index_extensions(type.get());
+		}
+
+		// Extension must match
+		else if (!type->match_extension_.empty())
+			index_extensions(type.get());
+
+		// Name must match
+		else if (!type->match_name_.empty())
+			index_names(type.get());
+
+		// No indexable criteria
+		else
+			type_index.any.push_back(type.get());
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -802,6 +1074,22 @@ CONSOLE_COMMAND(type, 0, true)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Command to show entry type detection statistics, use 'etype_stats reset' to
+// reset them
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(etype_stats, 0, false)
+{
+	auto reset = !args.empty() && strutil::equalCI(args[0], "reset");
+	auto stats = EntryType::detectStats(reset);
+	log::info(
+		"Detected {} entries, tested {} candidate types ({:.2f} per entry, out of {} types)",
+		stats.entries,
+		stats.candidates,
+		stats.entries > 0 ? (double)stats.candidates / stats.entries : 0.,
+		EntryType::allTypes().size());
+}
+
 CONSOLE_COMMAND(size, 0, true)
 {
 	auto meep = maineditor::currentEntry();
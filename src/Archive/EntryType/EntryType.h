@@ -10,6 +10,24 @@ class ArchiveEntry;
 class EntryType
 {
 public:
+	// Entry info needed for type detection, allows detection to be done on data
+	// that isn't (yet) in the entry itself, eg. on a worker thread
+	struct DetectInfo
+	{
+		string_view upper_name;
+		uint32_t    size = 0;
+		bool        in_archive = false;
+		string_view archive_format; // Entry format of the parent archive
+		string_view section;        // Namespace of the entry within the parent archive
+	};
+
+	// Type detection statistics, for checking how well the type index works
+	struct DetectStats
+	{
+		uint64_t entries    = 0; // Number of entries detected
+		uint64_t candidates = 0; // Number of candidate types tested (across all entries)
+	};
+
 	EntryType(string_view id = "Unknown") : id_{ id }, format_{ EntryDataFormat::anyFormat() } {}
 	~EntryType() = default;
 
@@ -33,12 +51,14 @@ public:
 
 	// Magic goes here
 	int isThisType(ArchiveEntry& entry);
+	int isThisType(MemChunk& data, const DetectInfo& info) const;
 
 	// Static functions
 	static void               initTypes();
 	static bool               readEntryTypeDefinition(MemChunk& mc, string_view source);
 	static bool               loadEntryTypes();
 	static bool               detectEntryType(ArchiveEntry& entry);
+	static EntryType*         detectEntryType(MemChunk& data, const DetectInfo& info, int& reliability);
 	static EntryType*         fromId(string_view id);
 	static EntryType*         unknownType();
 	static EntryType*         folderType();
@@ -46,6 +66,7 @@ public:
 	static vector<string>     iconList();
 	static vector<EntryType*> allTypes();
 	static vector<string>     allCategories();
+	static DetectStats        detectStats(bool reset = false);
 
 private:
 	// Type info
@@ -80,5 +101,13 @@ private:
 	vector<string> section_;       // The 'section' of the archive the entry must be in, eg "sprites" for entries
 								   // between SS_START/SS_END in a wad, or the 'sprites' folder in a zip
 	vector<string> match_archive_; // The types of archive the entry can be found in (e.g., wad or zip)
+
+	// Results of data format checks already done for an entry
+	typedef vector<std::pair<EntryDataFormat*, int>> FormatMatchCache;
+
+	bool matchesInfo(const DetectInfo& info) const;
+	int  matchData(MemChunk& data, const DetectInfo& info, FormatMatchCache* format_cache = nullptr) const;
+
+	static void buildTypeIndex();
 };
 } // namespace slade
@@ -38,14 +38,6 @@
 using namespace slade;
 
 
-// -----------------------------------------------------------------------------
-//
-// External Variables
-//
-// -----------------------------------------------------------------------------
-EXTERN_CVAR(Bool, archive_load_data)
-
-
 // -----------------------------------------------------------------------------
 //
 // ADatArchive Class Functions
@@ -132,43 +124,24 @@ bool ADatArchive::open(MemChunk& mc)
 	}
 
 	// Detect all entry types
-	MemChunk              edata;
 	vector<ArchiveEntry*> all_entries;
 	putEntryTreeAsList(all_entries);
-	ui::setSplashProgressMessage("Detecting entry types");
-	for (size_t a = 0; a < all_entries.size(); a++)
-	{
-		// Update splash window progress
-		ui::setSplashProgress((float)a / (float)num_entries);
-
-		// Get entry
-		auto entry = all_entries[a];
-
-		// Read entry data if it isn't zero-sized
-		if (entry->size() > 0)
+	detectEntryTypes(
+		all_entries,
+		[&mc](ArchiveEntry& entry, MemChunk& data)
 		{
-			// Read the entry data
-			mc.exportMemChunk(edata, entry->exProp<int>("Offset"), entry->size());
-			MemChunk xdata;
-			if (compression::zlibInflate(edata, xdata, entry->exProp<int>("FullSize")))
-				entry->importMemChunk(xdata);
-			else
+			// Read the entry data and inflate it
+			MemChunk edata;
+			if (!mc.shareMemChunk(edata, entry.exProps().get<int>("Offset"), entry.size()))
+				return false;
+			if (!compression::zlibInflate(edata, data, entry.exProps().get<int>("FullSize")))
 			{
-				log::warning("Entry {} couldn't be inflated", entry->name());
-				entry->importMemChunk(edata);
+				log::warning("Entry {} couldn't be inflated", entry.name());
+				data.importMem(edata);
 			}
-		}
-
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
 
-		// Unload entry data if needed
-		if (!archive_load_data)
-			entry->unloadData();
-
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
-	}
+			return true;
+		});
 
 	// Setup variables
 	sig_blocker.unblock();
@@ -71,7 +71,7 @@ bool DatArchive::open(MemChunk& mc)
 	if (!mc.hasData())
 		return false;
 
-	const uint8_t* mcdata = mc.data();
+	const uint8_t* mcdata = std::as_const(mc).data();
 
 	// Read dat header
 	mc.seek(0, SEEK_SET);
@@ -169,30 +169,9 @@ bool DatArchive::open(MemChunk& mc)
 	}
 
 	// Detect all entry types
-	MemChunk edata;
-	ui::setSplashProgressMessage("Detecting entry types");
-	for (size_t a = 0; a < numEntries(); a++)
-	{
-		// Update splash window progress
-		ui::setSplashProgress((((float)a / (float)num_lumps)));
-
-		// Get entry
-		auto entry = entryAt(a);
-
-		// Read entry data if it isn't zero-sized
-		if (entry->size() > 0)
-		{
-			// Read the entry data
-			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
-			entry->importMemChunk(edata);
-		}
-
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
-
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
-	}
+	vector<ArchiveEntry*> all_entries;
+	putEntryTreeAsList(all_entries);
+	detectEntryTypes(all_entries, mc);
 
 	// Detect maps (will detect map entry types)
 	// UI::setSplashProgressMessage("Detecting maps");
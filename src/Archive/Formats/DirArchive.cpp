@@ -496,7 +496,9 @@ vector<Archive::MapDesc> DirArchive::detectMaps()
 		// Detect map format (probably kinda slow but whatever, no better way to do it really)
 		auto       format = MapFormat::Unknown;
 		WadArchive tempwad;
-		tempwad.open(entry->data());
+		MemChunk   wad_data;
+		entry->shareData(wad_data);
+		tempwad.open(wad_data);
 		auto emaps = tempwad.detectMaps();
 		if (!emaps.empty())
 			format = emaps[0].format;
@@ -40,14 +40,6 @@
 using namespace slade;
 
 
-// -----------------------------------------------------------------------------
-//
-// External Variables
-//
-// -----------------------------------------------------------------------------
-EXTERN_CVAR(Bool, archive_load_data)
-
-
 // -----------------------------------------------------------------------------
 //
 // DiskArchive Class Functions
@@ -127,36 +119,9 @@ bool DiskArchive::open(MemChunk& mc)
 	}
 
 	// Detect all entry types
-	MemChunk              edata;
 	vector<ArchiveEntry*> all_entries;
 	putEntryTreeAsList(all_entries);
-	ui::setSplashProgressMessage("Detecting entry types");
-	for (size_t a = 0; a < all_entries.size(); a++)
-	{
-		// Update splash window progress
-		ui::setSplashProgress((((float)a / (float)num_entries)));
-
-		// Get entry
-		auto entry = all_entries[a];
-
-		// Read entry data if it isn't zero-sized
-		if (entry->size() > 0)
-		{
-			// Read the entry data
-			mc.exportMemChunk(edata, entry->exProp<int>("Offset"), entry->size());
-			entry->importMemChunk(edata);
-		}
-
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
-
-		// Unload entry data if needed
-		if (!archive_load_data)
-			entry->unloadData();
-
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
-	}
+	detectEntryTypes(all_entries, mc);
 
 	// Setup variables
 	sig_blocker.unblock();
@@ -135,7 +135,7 @@ bool GZipArchive::open(MemChunk& mc)
 	if (fhcrc)
 	{
 		uint8_t* crcbuffer = new uint8_t[mc.currentPos()];
-		memcpy(crcbuffer, mc.data(), mc.currentPos());
+		memcpy(crcbuffer, std::as_const(mc).data(), mc.currentPos());
 		uint32_t fullcrc = misc::crc(crcbuffer, mc.currentPos());
 		delete[] crcbuffer;
 		uint16_t hcrc;
@@ -38,14 +38,6 @@
 using namespace slade;
 
 
-// -----------------------------------------------------------------------------
-//
-// External Variables
-//
-// -----------------------------------------------------------------------------
-EXTERN_CVAR(Bool, archive_load_data)
-
-
 // -----------------------------------------------------------------------------
 //
 // Functions
@@ -62,7 +54,7 @@ namespace
 // -----------------------------------------------------------------------------
 void decodeTxb(MemChunk& mc)
 {
-	const uint8_t*       data    = mc.data();
+	const uint8_t*       data    = std::as_const(mc).data();
 	const uint8_t* const dataend = data + mc.size();
 	uint8_t*             odata   = new uint8_t[mc.size()];
 	uint8_t* const       ostart  = odata;
@@ -85,7 +77,7 @@ void decodeTxb(MemChunk& mc)
 // -----------------------------------------------------------------------------
 uint8_t* encodeTxb(MemChunk& mc)
 {
-	const uint8_t*       data    = mc.data();
+	const uint8_t*       data    = std::as_const(mc).data();
 	const uint8_t* const dataend = data + mc.size();
 	uint8_t*             odata   = new uint8_t[mc.size()];
 	uint8_t* const       ostart  = odata;
@@ -212,36 +204,20 @@ bool HogArchive::open(MemChunk& mc)
 	}
 
 	// Detect all entry types
-	MemChunk edata;
-	ui::setSplashProgressMessage("Detecting entry types");
-	for (size_t a = 0; a < numEntries(); a++)
-	{
-		// Update splash window progress
-		ui::setSplashProgress((((float)a / (float)num_lumps)));
-
-		// Get entry
-		auto entry = entryAt(a);
-
-		// Read entry data if it isn't zero-sized
-		if (entry->size() > 0)
+	vector<ArchiveEntry*> all_entries;
+	putEntryTreeAsList(all_entries);
+	detectEntryTypes(
+		all_entries,
+		[&mc](ArchiveEntry& entry, MemChunk& data)
 		{
-			// Read the entry data
-			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
-			if (entry->encryption() == ArchiveEntry::Encryption::TXB)
-				decodeTxb(edata);
-			entry->importMemChunk(edata);
-		}
-
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
-
-		// Unload entry data if needed
-		if (!archive_load_data)
-			entry->unloadData();
-
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
-	}
+			auto offset = entry.exProps().get<int>("Offset");
+			if (entry.encryption() != ArchiveEntry::Encryption::TXB)
+				return mc.shareMemChunk(data, offset, entry.size());
+			if (!mc.exportMemChunk(data, offset, entry.size()))
+				return false;
+			decodeTxb(data);
+			return true;
+		});
 
 	// Setup variables
 	sig_blocker.unblock();
@@ -134,7 +134,7 @@ bool PodArchive::open(MemChunk& mc)
 
 		// Read data
 		MemChunk edata;
-		mc.exportMemChunk(edata, all_entries[a]->exProp<int>("Offset"), all_entries[a]->size());
+		mc.shareMemChunk(edata, all_entries[a]->exProp<int>("Offset"), all_entries[a]->size());
 		all_entries[a]->importMemChunk(edata);
 
 		// Detect entry type
@@ -156,7 +156,7 @@ bool ResArchive::readDirectory(MemChunk& mc, size_t dir_offset, size_t num_lumps
 		{
 			// Read the entry data
 			MemChunk edata;
-			mc.exportMemChunk(edata, offset, size);
+			mc.shareMemChunk(edata, offset, size);
 			nlump->importMemChunk(edata);
 		}
 
@@ -249,13 +249,13 @@ bool RffArchive::open(MemChunk& mc)
 		if (entry->size() > 0)
 		{
 			// Read the entry data
-			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
+			mc.shareMemChunk(edata, getEntryOffset(entry), entry->size());
 
 			// If the entry is encrypted, decrypt it
 			if (entry->encryption() != ArchiveEntry::Encryption::None)
 			{
 				uint8_t* cdata = new uint8_t[entry->size()];
-				memcpy(cdata, edata.data(), entry->size());
+				memcpy(cdata, std::as_const(edata).data(), entry->size());
 				int cryptlen = entry->size() < 256 ? entry->size() : 256;
 				bloodCrypt(cdata, 0, cryptlen);
 				edata.importMem(cdata, entry->size());
@@ -36,6 +36,7 @@
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
 #include "WadJArchive.h"
+#include <unordered_set>
 
 using namespace slade;
 
@@ -97,14 +98,6 @@ vector<SpecialNS> special_namespaces = {
 } // namespace
 
 
-// -----------------------------------------------------------------------------
-//
-// External Variables
-//
-// -----------------------------------------------------------------------------
-EXTERN_CVAR(Bool, archive_load_data)
-
-
 // -----------------------------------------------------------------------------
 //
 // Functions
@@ -351,108 +344,30 @@ bool WadArchive::open(MemChunk& mc)
 	// Stop announcements (don't want to be announcing modification due to entries being added etc)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 
-	vector<uint32_t> offsets;
-
 	// Read the directory
-	mc.seek(dir_offset, SEEK_SET);
 	ui::setSplashProgressMessage("Reading wad archive data");
-	for (uint32_t d = 0; d < num_lumps; d++)
+	vector<DirEntry> lumps;
+	if (!parseDirectory(mc, num_lumps, dir_offset, lumps))
+		return false;
+
+	// Create lumps
+	for (unsigned d = 0; d < lumps.size(); d++)
 	{
 		// Update splash window progress
-		ui::setSplashProgress(((float)d / (float)num_lumps));
-
-		// Read lump info
-		char     name[9] = "";
-		uint32_t offset  = 0;
-		uint32_t size    = 0;
-
-		mc.read(&offset, 4); // Offset
-		mc.read(&size, 4);   // Size
-		mc.read(name, 8);    // Name
-		name[8] = '\0';
-
-		// Byteswap values for big endian if needed
-		offset = wxINT32_SWAP_ON_BE(offset);
-		size   = wxINT32_SWAP_ON_BE(size);
-
-		// Check to catch stupid shit
-		if (size > 0)
-		{
-			if (offset == 0)
-			{
-				log::info(2, "No.");
-				continue;
-			}
-			if (VECTOR_EXISTS(offsets, offset))
-			{
-				log::warning("Ignoring entry {}: {}, is a clone of a previous entry", d, name);
-				continue;
-			}
-			offsets.push_back(offset);
-		}
-
-		// Hack to open Operation: Rheingold WAD files
-		if (size == 0 && offset > mc.size())
-			offset = 0;
-
-		// Is there a compression/encryption thing going on?
-		bool jaguarencrypt = !!(name[0] & 0x80); // look at high bit
-		name[0]            = name[0] & 0x7F;     // then strip it away
-
-		// Look for encryption shenanigans
-		size_t actualsize = size;
-		if (jaguarencrypt)
-		{
-			if (d < num_lumps - 1)
-			{
-				size_t   pos        = mc.currentPos();
-				uint32_t nextoffset = 0;
-				for (int i = 0; i + d < num_lumps; ++i)
-				{
-					mc.read(&nextoffset, 4);
-					if (nextoffset != 0)
-						break;
-					mc.seek(12, SEEK_CUR);
-				}
-				nextoffset = wxINT32_SWAP_ON_BE(nextoffset);
-				if (nextoffset == 0)
-					nextoffset = dir_offset;
-				mc.seek(pos, SEEK_SET);
-				actualsize = nextoffset - offset;
-			}
-			else
-			{
-				if (offset > dir_offset)
-				{
-					actualsize = mc.size() - offset;
-				}
-				else
-				{
-					actualsize = dir_offset - offset;
-				}
-			}
-		}
-
-		// If the lump data goes past the end of the file,
-		// the wadfile is invalid
-		if (offset + actualsize > mc.size())
-		{
-			log::error("WadArchive::open: Wad archive is invalid or corrupt");
-			global::error = fmt::format(
-				"Archive is invalid and/or corrupt (lump {}: {} data goes past end of file)", d, name);
-			return false;
-		}
+		if (d % 1000 == 0)
+			ui::setSplashProgress(((float)d / (float)lumps.size()));
 
 		// Create & setup lump
-		auto nlump = std::make_shared<ArchiveEntry>(name, size);
+		const auto& lump  = lumps[d];
+		auto        nlump = std::make_shared<ArchiveEntry>(lump.name, lump.size);
 		nlump->setLoaded(false);
-		nlump->exProp("Offset") = (int)offset;
+		nlump->exProp("Offset") = (int)lump.offset;
 		nlump->setState(ArchiveEntry::State::Unmodified);
 
-		if (jaguarencrypt)
+		if (lump.jaguar)
 		{
 			nlump->setEncryption(ArchiveEntry::Encryption::Jaguar);
-			nlump->exProp("FullSize") = (int)size;
+			nlump->exProp("FullSize") = (int)lump.size;
 		}
 
 		// Add to entry list
@@ -464,46 +379,28 @@ bool WadArchive::open(MemChunk& mc)
 	updateNamespaces();
 
 	// Detect all entry types
-	MemChunk edata;
-	ui::setSplashProgressMessage("Detecting entry types");
-	for (size_t a = 0; a < numEntries(); a++)
-	{
-		// Update splash window progress
-		ui::setSplashProgress((((float)a / (float)numEntries())));
-
-		// Get entry
-		auto entry = entryAt(a);
-
-		// Read entry data if it isn't zero-sized
-		if (entry->size() > 0)
+	vector<ArchiveEntry*> all_entries;
+	putEntryTreeAsList(all_entries);
+	detectEntryTypes(
+		all_entries,
+		[&mc](ArchiveEntry& entry, MemChunk& data)
 		{
-			// Read the entry data
-			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
-			if (entry->encryption() != ArchiveEntry::Encryption::None)
-			{
-				if (entry->exProps().contains("FullSize")
-					&& (unsigned)(entry->exProp<int>("FullSize")) > entry->size())
-					edata.reSize((entry->exProp<int>("FullSize")), true);
-				if (!WadJArchive::jaguarDecode(edata))
-					log::warning(
-						"{}: {} (following {}), did not decode properly",
-						a,
-						entry->name(),
-						a > 0 ? entryAt(a - 1)->name() : "nothing");
-			}
-			entry->importMemChunk(edata);
-		}
-
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
-
-		// Unload entry data if needed
-		if (!archive_load_data)
-			entry->unloadData();
-
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
-	}
+			// Read the entry data (copy it if it needs decoding)
+			auto offset = entry.exProps().get<int>("Offset");
+			if (entry.encryption() == ArchiveEntry::Encryption::None)
+				return mc.shareMemChunk(data, offset, entry.size());
+			if (!mc.exportMemChunk(data, offset, entry.size()))
+				return false;
+
+			// Decode
+			auto full_size = entry.exProps().getOr<int>("FullSize", 0);
+			if ((unsigned)full_size > entry.size())
+				data.reSize(full_size, true);
+			if (!WadJArchive::jaguarDecode(data))
+				log::warning("{} did not decode properly", entry.name());
+
+			return true;
+		});
 
 	// Identify #included lumps (DECORATE, GLDEFS, etc.)
 	detectIncludes();
@@ -1136,7 +1033,9 @@ vector<Archive::MapDesc> WadArchive::detectMaps()
 		{
 			// Detect map format (probably kinda slow but whatever, no better way to do it really)
 			WadArchive tempwad;
-			tempwad.open(entry->data());
+			MemChunk   wad_data;
+			entry->shareData(wad_data);
+			tempwad.open(wad_data);
 			auto emaps = tempwad.detectMaps();
 			if (!emaps.empty())
 			{
@@ -1280,8 +1179,8 @@ void WadArchive::detectIncludes()
 ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 {
 	// Init search variables
-	unsigned index     = 0;
-	auto     index_end = numEntries();
+	unsigned index_start = 0;
+	auto     index_end   = numEntries();
 	strutil::upperIP(options.match_name);
 
 	// "graphics" namespace is the global namespace in a wad
@@ -1297,9 +1196,9 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 		{
 			if (ns.name == options.match_namespace)
 			{
-				index     = ns.start_index + 1;
-				index_end = ns.end_index + 1;
-				ns_found  = true;
+				index_start = ns.start_index + 1;
+				index_end   = ns.end_index + 1;
+				ns_found    = true;
 				break;
 			}
 		}
@@ -1310,10 +1209,10 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 	}
 
 	// Begin search
-	ArchiveEntry* entry;
-	for (; index < index_end; ++index)
+	auto candidates = searchCandidates(*rootDir(), options.match_name, false, index_start, index_end);
+	for (unsigned c = 0; c < candidates.size(); ++c)
 	{
-		entry = entryAt(index);
+		auto entry = entryAt(candidates[c]);
 
 		// Check type
 		if (options.match_type)
@@ -1327,10 +1226,10 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
+		// Check name (if not already matched via the name index)
+		if (!candidates.name_matched && !options.match_name.empty())
 		{
-			if (!strutil::matches(options.match_name, entry->upperName()))
+			if (!strutil::matches(entry->upperName(), options.match_name))
 				continue;
 		}
 
@@ -1349,7 +1248,7 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 {
 	// Init search variables
-	int index       = numEntries() - 1;
+	int index_last  = numEntries() - 1;
 	int index_start = 0;
 	strutil::upperIP(options.match_name);
 
@@ -1370,7 +1269,7 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 		{
 			if (ns.name == options.match_namespace)
 			{
-				index       = ns.end_index - 1;
+				index_last  = ns.end_index - 1;
 				index_start = ns.start_index + 1;
 				ns_found    = true;
 				break;
@@ -1382,11 +1281,11 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 			return nullptr;
 	}
 
-	// Begin search
-	ArchiveEntry* entry;
-	for (; index >= index_start; --index)
+	// Begin search (bottom-up)
+	auto candidates = searchCandidates(*rootDir(), options.match_name, false, index_start, index_last + 1);
+	for (int c = static_cast<int>(candidates.size()) - 1; c >= 0; --c)
 	{
-		entry = entryAt(index);
+		auto entry = entryAt(candidates[c]);
 
 		// Check type
 		if (options.match_type)
@@ -1400,8 +1299,8 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
+		// Check name (if not already matched via the name index)
+		if (!candidates.name_matched && !options.match_name.empty())
 		{
 			if (!strutil::matches(entry->upperName(), options.match_name))
 				continue;
@@ -1421,8 +1320,8 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 {
 	// Init search variables
-	unsigned index     = 0;
-	auto     index_end = numEntries();
+	unsigned index_start = 0;
+	auto     index_end   = numEntries();
 	strutil::upperIP(options.match_name);
 	vector<ArchiveEntry*> ret;
 
@@ -1440,9 +1339,9 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 		{
 			if (namespaces_[a].name == options.match_namespace)
 			{
-				index     = namespaces_[a].start_index + 1;
-				index_end = namespaces_[a].end_index + 1;
-				ns_found  = true;
+				index_start = namespaces_[a].start_index + 1;
+				index_end   = namespaces_[a].end_index + 1;
+				ns_found    = true;
 				break;
 			}
 		}
@@ -1452,10 +1351,10 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 			return ret;
 	}
 
-	ArchiveEntry* entry;
-	for (; index < index_end; ++index)
+	auto candidates = searchCandidates(*rootDir(), options.match_name, false, index_start, index_end);
+	for (unsigned c = 0; c < candidates.size(); ++c)
 	{
-		entry = entryAt(index);
+		auto entry = entryAt(candidates[c]);
 
 		// Check type
 		if (options.match_type)
@@ -1469,8 +1368,8 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
+		// Check name (if not already matched via the name index)
+		if (!candidates.name_matched && !options.match_name.empty())
 		{
 			if (!strutil::matches(entry->upperName(), options.match_name))
 				continue;
@@ -1492,6 +1391,110 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// Reads the [num_lumps] lump definitions from the wad directory at
+// [dir_offset] in [mc] into [lumps]. Lumps that can't be used (eg. duplicates
+// of a previous lump) are skipped.
+// Returns false if the wad is invalid or corrupt
+// -----------------------------------------------------------------------------
+bool WadArchive::parseDirectory(const MemChunk& mc, uint32_t num_lumps, uint32_t dir_offset, vector<DirEntry>& lumps)
+{
+	// Check the directory is within the data
+	if (dir_offset > mc.size() || (mc.size() - dir_offset) / 16 < num_lumps)
+	{
+		auto available = dir_offset > mc.size() ? 0 : (mc.size() - dir_offset) / 16;
+		log::warning("Wad directory is truncated, only reading {} of {} lumps", available, num_lumps);
+		num_lumps = available;
+	}
+
+	// Offsets of lumps read so far, to detect lumps that are clones of others
+	std::unordered_set<uint32_t> offsets;
+	offsets.reserve(num_lumps);
+
+	lumps.clear();
+	lumps.reserve(num_lumps);
+
+	// The whole directory is read directly from the data, each lump
+	// definition is 16 bytes: offset (4), size (4), name (8)
+	auto     read_offset = [&mc, dir_offset](uint32_t index) { return mc.readL32(dir_offset + index * 16); };
+	uint32_t next_index  = 0; // Index of the next lump with a non-zero offset (for jaguar lumps)
+	for (uint32_t d = 0; d < num_lumps; d++)
+	{
+		// Read lump info
+		auto     lump_def = dir_offset + d * 16;
+		DirEntry lump;
+		lump.offset = mc.readL32(lump_def);
+		lump.size   = mc.readL32(lump_def + 4);
+		memcpy(lump.name, mc.data() + lump_def + 8, 8);
+		lump.name[8] = '\0';
+
+		// Check to catch stupid shit
+		if (lump.size > 0)
+		{
+			if (lump.offset == 0)
+			{
+				log::info(2, "No.");
+				continue;
+			}
+			if (!offsets.insert(lump.offset).second)
+			{
+				log::warning("Ignoring entry {}: {}, is a clone of a previous entry", d, lump.name);
+				continue;
+			}
+		}
+
+		// Hack to open Operation: Rheingold WAD files
+		if (lump.size == 0 && lump.offset > mc.size())
+			lump.offset = 0;
+
+		// Is there a compression/encryption thing going on?
+		lump.jaguar  = !!(lump.name[0] & 0x80); // look at high bit
+		lump.name[0] = lump.name[0] & 0x7F;     // then strip it away
+
+		// Look for encryption shenanigans
+		size_t actualsize = lump.size;
+		if (lump.jaguar)
+		{
+			if (d < num_lumps - 1)
+			{
+				// Find the next lump with data
+				if (next_index <= d)
+				{
+					next_index = d + 1;
+					while (next_index < num_lumps && read_offset(next_index) == 0)
+						++next_index;
+				}
+
+				uint32_t nextoffset = next_index < num_lumps ? read_offset(next_index) : 0;
+				if (nextoffset == 0)
+					nextoffset = dir_offset;
+				actualsize = nextoffset - lump.offset;
+			}
+			else
+			{
+				if (lump.offset > dir_offset)
+					actualsize = mc.size() - lump.offset;
+				else
+					actualsize = dir_offset - lump.offset;
+			}
+		}
+
+		// If the lump data goes past the end of the file,
+		// the wadfile is invalid
+		if (lump.offset + actualsize > mc.size())
+		{
+			log::error("WadArchive::open: Wad archive is invalid or corrupt");
+			global::error = fmt::format(
+				"Archive is invalid and/or corrupt (lump {}: {} data goes past end of file)", d, lump.name);
+			return false;
+		}
+
+		lumps.push_back(lump);
+	}
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Checks if the given data is a valid Doom wad archive
 // -----------------------------------------------------------------------------
@@ -1564,3 +1567,51 @@ bool WadArchive::isWadArchive(const string& filename)
 	// If it's passed to here it's probably a wad file
 	return true;
 }
+
+
+// Testing
+
+#include "App.h"
+#include "General/Console.h"
+
+// -----------------------------------------------------------------------------
+// Benchmarks reading the directory of a synthetic wad with [lumps] lumps
+// (100,000 by default), then opening it as a WadArchive
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_wad_dir, 0, false)
+{
+	uint32_t num_lumps = 100000;
+	if (!args.empty())
+		num_lumps = strutil::asInt(args[0]);
+
+	// Build the wad, each lump has 4 bytes of data, with a marker every 100 lumps
+	uint32_t dir_offset = 12 + num_lumps * 4;
+	MemChunk mc(dir_offset + num_lumps * 16);
+	mc.write("PWAD", 4, 0);
+	mc.write(&num_lumps, 4);
+	mc.write(&dir_offset, 4);
+	for (uint32_t a = 0; a < num_lumps; a++)
+		mc.write(&a, 4);
+	for (uint32_t a = 0; a < num_lumps; a++)
+	{
+		uint32_t offset = 12 + a * 4;
+		uint32_t size   = a % 100 == 0 ? 0 : 4;
+		char     name[8]{};
+		strncpy(name, fmt::format("L{}", a).c_str(), 8);
+		mc.write(&offset, 4);
+		mc.write(&size, 4);
+		mc.write(name, 8);
+	}
+
+	// Parse directory
+	vector<WadArchive::DirEntry> lumps;
+	auto                         time = app::runTimer();
+	WadArchive::parseDirectory(mc, num_lumps, dir_offset, lumps);
+	log::info("Parsing directory of {} lumps took {}ms", num_lumps, app::runTimer() - time);
+
+	// Open wad
+	WadArchive wad;
+	time = app::runTimer();
+	wad.open(mc);
+	log::info("Opening wad with {} lumps took {}ms", wad.numEntries(), app::runTimer() - time);
+}
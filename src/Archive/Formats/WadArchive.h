@@ -7,6 +7,15 @@ namespace slade
 class WadArchive : public TreelessArchive
 {
 public:
+	// A lump read from a wad directory
+	struct DirEntry
+	{
+		char     name[9] = "";
+		uint32_t offset  = 0;
+		uint32_t size    = 0;
+		bool     jaguar  = false; // Jaguar compressed/encrypted lump
+	};
+
 	WadArchive() : TreelessArchive("wad") {}
 	~WadArchive() = default;
 
@@ -56,6 +65,7 @@ public:
 	vector<ArchiveEntry*> findAll(SearchOptions& options) override;
 
 	// Static functions
+	static bool parseDirectory(const MemChunk& mc, uint32_t num_lumps, uint32_t dir_offset, vector<DirEntry>& lumps);
 	static bool isWadArchive(MemChunk& mc);
 	static bool isWadArchive(const string& filename);
 
@@ -197,7 +197,7 @@ bool WadJArchive::open(MemChunk& mc)
 		{
 			// Read the entry data
 			edata.clear();
-			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
+			mc.shareMemChunk(edata, getEntryOffset(entry), entry->size());
 			if (entry->encryption() != ArchiveEntry::Encryption::None)
 			{
 				if (entry->exProps().contains("FullSize")
@@ -415,7 +415,7 @@ bool WadJArchive::jaguarDecode(MemChunk& mc)
 
 	// Get data
 	size_t         isize  = mc.size();
-	const uint8_t* istart = mc.data();
+	const uint8_t* istart = std::as_const(mc).data();
 	const uint8_t* input  = istart;
 	const uint8_t* iend   = input + isize;
 
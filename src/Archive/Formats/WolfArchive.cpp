@@ -579,7 +579,7 @@ bool WolfArchive::open(MemChunk& mc)
 		if (entry->size() > 0)
 		{
 			// Read the entry data
-			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
+			mc.shareMemChunk(edata, getEntryOffset(entry), entry->size());
 			entry->importMemChunk(edata);
 		}
 
@@ -642,7 +642,7 @@ bool WolfArchive::openAudio(MemChunk& head, MemChunk& data)
 		// Read entry data if it isn't zero-sized
 		if (size >= 4)
 		{
-			data.exportMemChunk(edata, offset, size);
+			data.shareMemChunk(edata, offset, size);
 
 			if (strncmp((const char*)&edata[size - 4], "!ID!", 4) == 0)
 				seg_ends[current_seg++] = d;
@@ -663,7 +663,7 @@ bool WolfArchive::openAudio(MemChunk& head, MemChunk& data)
 				break;
 
 			// Look to see if we have an IMF
-			data.exportMemChunk(edata, offset, size);
+			data.shareMemChunk(edata, offset, size);
 
 			auto name = searchIMFName(edata);
 			if (name.empty())
@@ -711,7 +711,7 @@ bool WolfArchive::openAudio(MemChunk& head, MemChunk& data)
 		if (size > 0)
 		{
 			// Read the entry data
-			data.exportMemChunk(edata, offset, size);
+			data.shareMemChunk(edata, offset, size);
 		}
 
 		// Wolf chunks have no names, so just give them a number
@@ -837,7 +837,7 @@ bool WolfArchive::openMaps(MemChunk& head, MemChunk& data)
 		if (entry->size() > 0)
 		{
 			// Read the entry data
-			data.exportMemChunk(edata, getEntryOffset(entry), entry->size());
+			data.shareMemChunk(edata, getEntryOffset(entry), entry->size());
 			entry->importMemChunk(edata);
 		}
 
@@ -960,7 +960,7 @@ bool WolfArchive::openGraph(MemChunk& head, MemChunk& data, MemChunk& dict)
 		if (entry->size() > 0)
 		{
 			// Read the entry data
-			data.exportMemChunk(edata, getEntryOffset(entry), entry->size());
+			data.shareMemChunk(edata, getEntryOffset(entry), entry->size());
 			entry->importMemChunk(edata);
 		}
 		expandWolfGraphLump(entry, a, num_lumps, nodes);
@@ -32,13 +32,19 @@
 #include "Main.h"
 #include "ZipArchive.h"
 #include "App.h"
+#include "Archive/ArchiveIndex.h"
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "UI/WxUtils.h"
+#include "Utility/Compression.h"
 #include "Utility/FileUtils.h"
+#include "Utility/MappedFile.h"
+#include "Utility/Memory.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include "WadArchive.h"
 #include <fstream>
+#include <zlib.h>
 
 using namespace slade;
 
@@ -49,6 +55,7 @@ using namespace slade;
 //
 // -----------------------------------------------------------------------------
 EXTERN_CVAR(Bool, archive_load_data)
+EXTERN_CVAR(Bool, archive_map_files)
 
 
 // -----------------------------------------------------------------------------
@@ -73,25 +80,303 @@ struct ZipFileHeader
 	uint16_t len_fn;
 	uint16_t len_extra;
 };
+
+// Zip record signatures
+constexpr uint32_t ZIP_SIG_LOCAL        = 0x04034b50;
+constexpr uint32_t ZIP_SIG_CENTRAL      = 0x02014b50;
+constexpr uint32_t ZIP_SIG_END          = 0x06054b50;
+constexpr uint32_t ZIP_SIG_END64        = 0x06064b50;
+constexpr uint32_t ZIP_SIG_END64_LOCATE = 0x07064b50;
+
+// Zip entry general purpose flags
+constexpr uint16_t ZIP_FLAG_DESCRIPTOR = 0x0008; // Sizes+crc follow the data in a data descriptor
+constexpr uint16_t ZIP_FLAG_UTF8       = 0x0800; // Name is UTF-8
+
+// Zip compression methods
+constexpr uint16_t ZIP_METHOD_STORE   = 0;
+constexpr uint16_t ZIP_METHOD_DEFLATE = 8;
+
+using ZipDirEntry = ZipArchive::DirEntry;
+
+// An entry to write to a zip file
+struct ZipWriteEntry
+{
+	string         name;
+	bool           dir    = false;
+	ArchiveEntry*  source     = nullptr; // Entry to compress, if not copied from the old zip
+	int            copy_index = -1;      // Index of the entry to copy from the old zip file, if read from it
+	const uint8_t* data       = nullptr; // Data to write (compressed, unless stored)
+	MemChunk       compressed;           // Compressed data, or the entry as read from the old zip file
+	ZipDirEntry    info;
+};
 } // namespace
 
 
 // -----------------------------------------------------------------------------
 //
-// ZipArchive Class Functions
+// Functions
 //
 // -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Appends [value] to [buf] as [bytes] little-endian bytes
+// -----------------------------------------------------------------------------
+void writeL(vector<uint8_t>& buf, uint64_t value, int bytes)
+{
+	for (int a = 0; a < bytes; ++a)
+		buf.push_back(static_cast<uint8_t>(value >> (a * 8)));
+}
+
+// -----------------------------------------------------------------------------
+// Reads the central directory of the zip data in [zip] into [entries], and the
+// entry names into [names] if given.
+// [zip] can contain only the end of the zip data, from offset [base]. If the
+// central directory starts before that, [dir_start] is set to its offset (if
+// given) so it can be read again from there.
+// Returns false if the central directory couldn't be found or is invalid
+// -----------------------------------------------------------------------------
+bool readCentralDirectory(
+	const MemChunk&      zip,
+	vector<ZipDirEntry>& entries,
+	vector<string>*      names     = nullptr,
+	uint64_t             base      = 0,
+	uint64_t*            dir_start = nullptr)
+{
+	// Offsets are within the whole zip data
+	auto read16 = [&zip, base](uint64_t pos) { return zip.readL16(pos - base); };
+	auto read32 = [&zip, base](uint64_t pos) { return zip.readL32(pos - base); };
+
+	// Find the end of central directory record (searching back from the end of
+	// the file, since it can be followed by a comment of up to 64kb)
+	uint64_t size = base + zip.size();
+	if (zip.size() < 22)
+		return false;
+	uint64_t end     = size - 22;
+	uint64_t end_min = std::max(end > 0xFFFF ? end - 0xFFFF : 0, base);
+	while (read32(end) != ZIP_SIG_END)
+	{
+		if (end == end_min)
+			return false;
+		--end;
+	}
+
+	uint64_t num_entries = read16(end + 10);
+	uint64_t dir_size    = read32(end + 12);
+	uint64_t dir_offset  = read32(end + 16);
+	uint64_t start       = dir_offset;
+
+	// Zip64 end of central directory record, if any
+	if (end >= base + 20 && read32(end - 20) == ZIP_SIG_END64_LOCATE)
+	{
+		uint64_t end64 = read32(end - 12) | (static_cast<uint64_t>(read32(end - 8)) << 32);
+		if (end64 < base)
+		{
+			if (dir_start)
+				*dir_start = end64;
+			return false;
+		}
+		if (end64 + 56 > size || read32(end64) != ZIP_SIG_END64)
+			return false;
 
+		num_entries = read32(end64 + 32) | (static_cast<uint64_t>(read32(end64 + 36)) << 32);
+		dir_size    = read32(end64 + 40) | (static_cast<uint64_t>(read32(end64 + 44)) << 32);
+		dir_offset  = read32(end64 + 48) | (static_cast<uint64_t>(read32(end64 + 52)) << 32);
+		start       = std::min(dir_offset, end64);
+	}
+
+	if (dir_offset > size || dir_size > size - dir_offset)
+		return false;
+
+	// Check the central directory is in [zip]
+	if (dir_offset < base)
+	{
+		if (dir_start)
+			*dir_start = start;
+		return false;
+	}
+
+	// Each entry record is at least 46 bytes, check the entry count fits in the
+	// directory before allocating for it (it could be invalid)
+	if (num_entries > dir_size / 46)
+		return false;
+
+	// Read entries
+	entries.resize(num_entries);
+	if (names)
+		names->resize(num_entries);
+	uint64_t pos = dir_offset;
+	for (uint64_t a = 0; a < num_entries; ++a)
+	{
+		if (pos + 46 > size || read32(pos) != ZIP_SIG_CENTRAL)
+			return false;
+
+		auto& entry     = entries[a];
+		entry.flags     = read16(pos + 8);
+		entry.method    = read16(pos + 10);
+		entry.mod_time  = read16(pos + 12);
+		entry.mod_date  = read16(pos + 14);
+		entry.crc       = read32(pos + 16);
+		entry.size_comp = read32(pos + 20);
+		entry.size_orig = read32(pos + 24);
+		entry.offset    = read32(pos + 42);
+
+		uint64_t len_name  = read16(pos + 28);
+		uint64_t len_extra = read16(pos + 30);
+		if (pos + 46 + len_name + len_extra > size)
+			return false;
+
+		if (names)
+			(*names)[a].assign(reinterpret_cast<const char*>(zip.data() + (pos - base) + 46), len_name);
+
+		// Sizes/offset of 0xFFFFFFFF mean the real value is in a zip64 extra
+		// field. Some zip tools write these even when the values would fit in
+		// 32 bits, so read them if they do (otherwise they are left as
+		// 0xFFFFFFFF and the entry can't be read)
+		if (entry.size_orig == 0xFFFFFFFF || entry.size_comp == 0xFFFFFFFF || entry.offset == 0xFFFFFFFF)
+		{
+			uint64_t extra     = pos + 46 + len_name;
+			uint64_t extra_end = extra + len_extra;
+			while (extra + 4 <= extra_end)
+			{
+				uint64_t field_id   = read16(extra);
+				uint64_t field_size = read16(extra + 2);
+				extra += 4;
+				if (field_id == 0x0001)
+				{
+					// Values are in this order, but only present if needed
+					auto field_end = std::min(extra + field_size, extra_end);
+					for (auto value : { &entry.size_orig, &entry.size_comp, &entry.offset })
+					{
+						if (*value != 0xFFFFFFFF || extra + 8 > field_end)
+							continue;
+
+						if (read32(extra + 4) == 0)
+							*value = read32(extra);
+						extra += 8;
+					}
+					break;
+				}
+				extra += field_size;
+			}
+		}
+
+		pos += 46 + len_name + len_extra + read16(pos + 32);
+	}
+
+	return true;
+}
 
 // -----------------------------------------------------------------------------
-// ZipArchive class destructor
+// Returns true if the data of [entry] can be copied as-is from its zip
 // -----------------------------------------------------------------------------
-ZipArchive::~ZipArchive()
+bool canCopyZipEntry(const ZipDirEntry& entry)
 {
-	if (fileutil::fileExists(temp_file_))
-		fileutil::removeFile(temp_file_);
+	// Only stored/deflated entries can be copied (others can't be opened anyway)
+	if (entry.method != ZIP_METHOD_STORE && entry.method != ZIP_METHOD_DEFLATE)
+		return false;
+
+	// Sizes of 0xFFFFFFFF mean the real sizes are in a zip64 extra field
+	return entry.size_comp != 0xFFFFFFFF && entry.size_orig != 0xFFFFFFFF && entry.offset != 0xFFFFFFFF;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a pointer to the (compressed) data of [entry] in the zip data [zip],
+// or null if the entry's data can't be copied as-is
+// -----------------------------------------------------------------------------
+const uint8_t* zipEntryData(const MemChunk& zip, const ZipDirEntry& entry)
+{
+	if (!canCopyZipEntry(entry))
+		return nullptr;
+
+	// Check local header
+	uint64_t pos = entry.offset;
+	if (pos + 30 > zip.size() || zip.readL32(pos) != ZIP_SIG_LOCAL)
+		return nullptr;
+
+	// Get data position (after the local header, name and extra field)
+	pos += 30 + zip.readL16(pos + 26) + zip.readL16(pos + 28);
+	if (pos + entry.size_comp > zip.size())
+		return nullptr;
+
+	return zip.data() + pos;
 }
 
+// -----------------------------------------------------------------------------
+// Deflates the data of [entry]'s source entry into its compressed data.
+// The data is stored uncompressed instead if it doesn't compress
+// -----------------------------------------------------------------------------
+void compressZipEntry(ZipWriteEntry& entry)
+{
+	auto data = entry.data;
+	auto size = entry.info.size_orig;
+
+	entry.info.crc       = crc32(0, data, size);
+	entry.info.method    = ZIP_METHOD_STORE;
+	entry.info.size_comp = size;
+	if (size == 0)
+		return;
+
+	MemChunk in;
+	in.setView(data, size);
+	if (compression::zipDeflate(in, entry.compressed, 9) && entry.compressed.size() < size)
+	{
+		entry.data           = entry.compressed.data();
+		entry.info.method    = ZIP_METHOD_DEFLATE;
+		entry.info.size_comp = entry.compressed.size();
+	}
+	else
+		entry.compressed.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Reads the data of [entry] from the zip data [zip] into [out], inflating it
+// if needed. The data of stored entries is shared if [zip] is a view.
+// Returns false if the entry couldn't be read or is corrupt
+// -----------------------------------------------------------------------------
+bool readZipEntry(const MemChunk& zip, const ZipDirEntry& entry, MemChunk& out)
+{
+	auto data = zipEntryData(zip, entry);
+	if (!data)
+		return false;
+
+	if (entry.size_orig == 0)
+	{
+		out.clear();
+		return true;
+	}
+
+	// Stored
+	if (entry.method == ZIP_METHOD_STORE)
+		return entry.size_comp == entry.size_orig && zip.shareMemChunk(out, data - zip.data(), entry.size_orig);
+
+	// Deflated, the inflated size is known so it can be done in one go
+	if (!out.reSize(entry.size_orig, false))
+		return false;
+
+	z_stream stream{};
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		return false;
+	stream.next_in   = const_cast<uint8_t*>(data);
+	stream.avail_in  = entry.size_comp;
+	stream.next_out  = out.data();
+	stream.avail_out = entry.size_orig;
+	auto result      = inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+
+	return result == Z_STREAM_END && stream.total_out == entry.size_orig
+		   && crc32(0, out.data(), entry.size_orig) == entry.crc;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// ZipArchive Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
 // -----------------------------------------------------------------------------
 // Reads zip data from a file
 // Returns true if successful, false otherwise
@@ -105,98 +390,132 @@ bool ZipArchive::open(string_view filename)
 		return false;
 	}
 
-	// Copy the zip to a temp file (for use when saving)
-	generateTempFileName(filename);
-	fileutil::copyFile(filename, temp_file_);
+	// Read the central directory, entry data is read from the file (or its
+	// memory-mapping) when needed
+	vector<string> names;
+	if (!readZipData(filename, &names))
+		return false;
 
-	// Open the file
-	wxFFileInputStream in(wxutil::strFromView(filename));
-	if (!in.IsOk())
+	// Update filename before opening
+	auto backupname = filename_;
+	filename_       = filename;
+
+	// Get the archive index (see Archive::open)
+	index_ = zip_file_.isOpen() ? ArchiveIndex::forFile(filename, zip_file_) :
+								  ArchiveIndex::forFile(filename, zip_data_);
+
+	// Open entries
+	auto time = app::runTimer();
+	if (!openZip(names))
 	{
-		global::error = "Unable to open file";
+		filename_ = backupname;
+		index_.reset();
 		return false;
 	}
+	log::info(2, "ZipArchive::open took {}ms", app::runTimer() - time);
+	on_disk_ = true;
+
+	// Write the index if it wasn't valid
+	if (index_)
+	{
+		index_->update(*this);
+		index_->release();
+	}
 
-	// Create zip stream
-	wxZipInputStream zip(in);
-	if (!zip.IsOk())
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads zip format data from a MemChunk
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::open(MemChunk& mc)
+{
+	// Read the central directory
+	vector<ZipDirEntry> zip_dir;
+	vector<string>      names;
+	if (!readCentralDirectory(mc, zip_dir, &names))
 	{
 		global::error = "Invalid zip file";
 		return false;
 	}
 
+	// Keep the zip data for reading entry data later (shares it if it is a
+	// view of a memory-mapped file)
+	closeZipFile();
+	if (!mc.shareMemChunk(zip_data_))
+	{
+		global::error = "Unable to read zip data";
+		return false;
+	}
+	zip_dir_ = std::move(zip_dir);
+
+	return openZip(names);
+}
+
+// -----------------------------------------------------------------------------
+// Creates the archive's entries and directories from the zip central
+// directory (read from the zip data/file), with entry [names] from it.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::openZip(vector<string>& names)
+{
 	// Stop announcements (don't want to be announcing modification due to entries being added etc)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 
 	// Go through all zip entries
-	int  entry_index = 0;
-	auto zip_entry   = zip.GetNextEntry();
+	vector<ArchiveEntry*> file_entries;
 	ui::setSplashProgressMessage("Reading zip data");
-	while (zip_entry)
+	for (unsigned a = 0; a < zip_dir_.size(); a++)
 	{
-		ui::setSplashProgress(-1.0f);
-		if (zip_entry->GetMethod() != wxZIP_METHOD_DEFLATE && zip_entry->GetMethod() != wxZIP_METHOD_STORE)
-		{
-			global::error = "Unsupported zip compression method";
-			return false;
-		}
+		if (a % 1000 == 0)
+			ui::setSplashProgress(-1.0f);
 
-		if (!zip_entry->IsDir())
+		// Names are in the local codepage unless flagged as UTF-8
+		auto& name = names[a];
+		if (!(zip_dir_[a].flags & ZIP_FLAG_UTF8)
+			&& std::any_of(name.begin(), name.end(), [](char c) { return static_cast<uint8_t>(c) >= 0x80; }))
 		{
-			// Get the entry name as a Path (so we can break it up)
-			strutil::Path fn(wxutil::strToView(zip_entry->GetName(wxPATH_UNIX)));
-
-			// Create entry
-			auto new_entry = std::make_shared<ArchiveEntry>(
-				misc::fileNameToLumpName(fn.fileName()), zip_entry->GetSize());
-
-			// Setup entry info
-			new_entry->setLoaded(false);
-			new_entry->exProp("ZipIndex") = entry_index;
-
-			// Add entry and directory to directory tree
-			auto ndir = createDir(fn.path(true));
-			ndir->addEntry(new_entry);
-
-			// Read the data, if possible
-			auto ze_size = zip_entry->GetSize();
-			if (ze_size < 250 * 1024 * 1024)
-			{
-				if (ze_size > 0)
-				{
-					vector<uint8_t> data(ze_size);
-					zip.Read(data.data(), ze_size); // Note: this is where exceedingly large files cause an exception.
-					new_entry->importMem(data.data(), ze_size);
-				}
-				new_entry->setLoaded(true);
+			wxString converted(name.c_str(), wxConvLocal);
+			name = wxutil::strToView(converted);
+		}
 
-				// Determine its type
-				EntryType::detectEntryType(*new_entry);
+		// Get the entry name as a Path (so we can break it up)
+		strutil::Path fn(name);
 
-				// Unload data if needed
-				if (!archive_load_data)
-					new_entry->unloadData();
-			}
-			else
-			{
-				global::error = fmt::format("Entry too large: {} is {} mb", fn.fullPath(), ze_size / (1 << 20));
-				return false;
-			}
-		}
-		else
+		// Zip entry is a directory, add it to the directory tree
+		if (strutil::endsWith(name, '/'))
 		{
-			// Zip entry is a directory, add it to the directory tree
-			strutil::Path fn(wxutil::strToView(zip_entry->GetName(wxPATH_UNIX)));
 			createDir(fn.path(true));
+			continue;
 		}
 
-		// Go to next entry in the zip file
-		delete zip_entry;
-		zip_entry = zip.GetNextEntry();
-		entry_index++;
+		if (zip_dir_[a].method != ZIP_METHOD_STORE && zip_dir_[a].method != ZIP_METHOD_DEFLATE)
+		{
+			global::error = "Unsupported zip compression method";
+			return false;
+		}
+
+		// Create entry
+		auto new_entry = std::make_shared<ArchiveEntry>(misc::fileNameToLumpName(fn.fileName()), zip_dir_[a].size_orig);
+
+		// Setup entry info
+		new_entry->setLoaded(false);
+		new_entry->exProp("ZipIndex") = static_cast<int>(a);
+
+		// Add entry and directory to directory tree
+		auto ndir = createDir(fn.path(true));
+		ndir->addEntry(new_entry);
+		file_entries.push_back(new_entry.get());
 	}
 	ui::updateSplash();
 
+	// Detect all entry types, inflating entries as needed (in parallel)
+	detectEntryTypes(
+		file_entries,
+		[this](ArchiveEntry& entry, MemChunk& data)
+		{ return readEntryData(zip_dir_[entry.exProps().get<int>("ZipIndex")], data); });
+
 	// Set all entries/directories to unmodified
 	vector<ArchiveEntry*> entry_list;
 	putEntryTreeAsList(entry_list);
@@ -207,54 +526,45 @@ bool ZipArchive::open(string_view filename)
 	sig_blocker.unblock();
 
 	// Setup variables
-	filename_ = filename;
 	setModified(false);
-	on_disk_ = true;
 
 	ui::setSplashProgressMessage("");
 
 	return true;
 }
 
-// -----------------------------------------------------------------------------
-// Reads zip format data from a MemChunk
-// Returns true if successful, false otherwise
-// -----------------------------------------------------------------------------
-bool ZipArchive::open(MemChunk& mc)
-{
-	// Write the MemChunk to a temp file
-	auto tempfile = app::path("slade-temp-open.zip", app::Dir::Temp);
-	mc.exportFile(tempfile);
-
-	// Load the file
-	bool success = open(tempfile);
-
-	// Clean up
-	fileutil::removeFile(tempfile);
-
-	return success;
-}
-
 // -----------------------------------------------------------------------------
 // Writes the zip archive to a MemChunk
 // Returns true if successful, false otherwise
 // -----------------------------------------------------------------------------
 bool ZipArchive::write(MemChunk& mc, bool update)
 {
-	bool success = false;
+	vector<ArchiveEntry*> entries;
+	putEntryTreeAsList(entries);
 
-	// Write to a temporary file
-	auto tempfile = app::path("slade-temp-write.zip", app::Dir::Temp);
-	if (write(tempfile, true))
+	// Write
+	mc.clear();
+	if (!writeZip(mc, entries))
+		return false;
+
+	// Update entry info, entry data is read from the written zip from now on
+	// (sharing the data with [mc] rather than copying it)
+	if (update)
 	{
-		// Load file into MemChunk
-		success = mc.importFile(tempfile);
-	}
+		for (size_t a = 0; a < entries.size(); a++)
+		{
+			entries[a]->setState(ArchiveEntry::State::Unmodified);
+			entries[a]->exProp("ZipIndex") = (int)a;
+		}
 
-	// Clean up
-	wxRemoveFile(tempfile);
+		closeZipFile();
+		mc.makeShareable();
+		mc.shareMemChunk(zip_data_);
+		if (!readCentralDirectory(zip_data_, zip_dir_))
+			zip_dir_.clear();
+	}
 
-	return success;
+	return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -263,103 +573,334 @@ bool ZipArchive::write(MemChunk& mc, bool update)
 // -----------------------------------------------------------------------------
 bool ZipArchive::write(string_view filename, bool update)
 {
+	// If the zip data is a memory-mapped copy of (or read from) the file being
+	// written to, write to a temp file and replace the original with it
+	// afterwards, so the data isn't modified while it is being copied from
+	auto write_path = string{ filename };
+	auto reading    = zip_file_.isOpen() && fileutil::isSameFile(zip_file_path_, filename);
+	if (reading || MappedFile::isFileMapped(filename))
+		write_path += ".tmp";
+
 	// Open the file
-	wxFFileOutputStream out(wxutil::strFromView(filename));
-	if (!out.IsOk())
+	SFile file(write_path, SFile::Mode::Write);
+	if (!file.isOpen())
 	{
 		global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
 		return false;
 	}
 
-	// Open as zip for writing
-	wxZipOutputStream zip(out, 9);
-	if (!zip.IsOk())
+	// Write
+	vector<ArchiveEntry*> entries;
+	putEntryTreeAsList(entries);
+	auto success = writeZip(file, entries);
+	file.close();
+	if (!success)
 	{
-		global::error = "Unable to create zip for saving";
+		fileutil::removeFile(write_path);
 		return false;
 	}
 
-	// Open old zip for copying, from the temp file that was copied on opening.
-	// This is used to copy any entries that have been previously saved/compressed
-	// and are unmodified, to greatly speed up zip file saving by not having to
-	// recompress unchanged entries
-	unique_ptr<wxFFileInputStream> in;
-	unique_ptr<wxZipInputStream>   inzip;
-	vector<wxZipEntry*>            c_entries;
-	if (fileutil::fileExists(temp_file_))
+	// Replace the original file if a temp file was written (the original needs
+	// to be closed first if it is open, otherwise it can't be replaced on
+	// Windows)
+	if (reading)
+		closeZipFile();
+	if (write_path != filename && !wxRenameFile(write_path, wxString{ filename.data(), filename.size() }, true))
 	{
-		in    = std::make_unique<wxFFileInputStream>(temp_file_);
-		inzip = std::make_unique<wxZipInputStream>(*in);
+		log::error("Unable to replace file {}", filename);
+		global::error = "Unable to replace file";
+		wxRemoveFile(write_path);
+		if (reading && !readZipData(filename))
+			log::error("Unable to re-read zip file {}", filename);
+		return false;
+	}
 
-		if (inzip->IsOk())
-		{
-			// Get a list of all entries in the old zip
-			c_entries.resize(inzip->GetTotalEntries());
-			for (unsigned a = 0; a < c_entries.size(); a++)
-				c_entries[a] = inzip->GetNextEntry();
-		}
-		else
+	// Update entry info, entry data is read from the written zip from now on
+	// (this has to be done if the zip file was replaced, since entry data can't
+	// be read from the old one anymore)
+	if (update || reading)
+	{
+		for (size_t a = 0; a < entries.size(); a++)
 		{
-			in    = nullptr;
-			inzip = nullptr;
+			entries[a]->setState(ArchiveEntry::State::Unmodified);
+			entries[a]->exProp("ZipIndex") = (int)a;
 		}
+
+		if (!readZipData(filename))
+			log::error("Unable to re-read saved zip file {}", filename);
 	}
 
-	// Get a linear list of all entries in the archive
-	vector<ArchiveEntry*> entries;
-	putEntryTreeAsList(entries);
+	return true;
+}
 
-	// Go through all entries
+// -----------------------------------------------------------------------------
+// Writes [entries] (all entries in the archive, in order) as a zip to [out],
+// which is either an SFile or MemChunk.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+template<class T> bool ZipArchive::writeZip(T& out, const vector<ArchiveEntry*>& entries)
+{
+	auto time = app::runTimer();
+
+	// Any entries that have been previously saved/compressed and are unmodified
+	// are copied from the zip data as it was opened/last saved, to greatly speed
+	// up zip file saving by not having to recompress unchanged entries
+	const auto& old_zip     = zip_data_;
+	const auto& old_entries = zip_dir_;
+
+	// Get current time (for new/modified entries) in DOS format
+	auto     now      = std::time(nullptr);
+	auto     tm       = *std::localtime(&now);
+	uint16_t dos_time = (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2);
+	uint16_t dos_date = ((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday;
+
+	// Setup zip entries to write
+	vector<ZipWriteEntry> zip_entries(entries.size());
+	size_t                num_copied     = 0;
+	size_t                num_compressed = 0;
 	for (size_t a = 0; a < entries.size(); a++)
 	{
-		if (entries[a]->type() == EntryType::folderType())
+		auto  entry     = entries[a];
+		auto& zip_entry = zip_entries[a];
+
+		// Folder
+		if (entry->type() == EntryType::folderType())
 		{
-			// If the current entry is a folder, just write a directory entry and continue
-			zip.PutNextDirEntry(entries[a]->path(true));
-			if (update)
-				entries[a]->setState(ArchiveEntry::State::Unmodified);
-			continue;
+			zip_entry.name          = entry->path(true) + "/";
+			zip_entry.dir           = true;
+			zip_entry.info.mod_time = dos_time;
+			zip_entry.info.mod_date = dos_date;
 		}
+		else
+		{
+			zip_entry.name = entry->path() + misc::lumpNameToFileName(entry->name());
 
-		// Get entry zip index
-		int index = -1;
-		if (entries[a]->exProps().contains("ZipIndex"))
-			index = entries[a]->exProp<int>("ZipIndex");
+			// Get entry zip index
+			int index = -1;
+			if (entry->exProps().contains("ZipIndex"))
+				index = entry->exProp<int>("ZipIndex");
 
-		auto saname = misc::lumpNameToFileName(entries[a]->name());
-		if (!inzip || entries[a]->state() != ArchiveEntry::State::Unmodified || index < 0
-			|| index >= inzip->GetTotalEntries())
+			// If the entry is unmodified and exists in the old zip, just copy it over
+			// (if the old zip is read from its file, the entry is read when its
+			// batch is written, see below)
+			if (entry->state() == ArchiveEntry::State::Unmodified && index >= 0
+				&& index < static_cast<int>(old_entries.size()))
+			{
+				if (zip_file_.isOpen())
+					zip_entry.copy_index = canCopyZipEntry(old_entries[index]) ? index : -1;
+				else
+					zip_entry.data = zipEntryData(old_zip, old_entries[index]);
+				zip_entry.info = old_entries[index];
+			}
+
+			// Otherwise it will need to be (re)compressed
+			if (zip_entry.data || zip_entry.copy_index >= 0)
+				++num_copied;
+			else
+			{
+				zip_entry.source        = entry;
+				zip_entry.info          = {};
+				zip_entry.info.mod_time = dos_time;
+				zip_entry.info.mod_date = dos_date;
+			}
+		}
+
+		// Zip entry names don't begin with /
+		if (strutil::startsWith(zip_entry.name, '/'))
+			zip_entry.name.erase(0, 1);
+
+		// Set UTF-8 name flag if needed (and clear data descriptor flag, since the
+		// sizes will always be in the local header)
+		auto utf8 = std::any_of(
+			zip_entry.name.begin(), zip_entry.name.end(), [](char c) { return static_cast<uint8_t>(c) >= 0x80; });
+		zip_entry.info.flags &= ~(ZIP_FLAG_DESCRIPTOR | ZIP_FLAG_UTF8);
+		if (utf8)
+			zip_entry.info.flags |= ZIP_FLAG_UTF8;
+	}
+
+	// MemChunks are reallocated when written past the end, so allocate the
+	// largest size the zip could be up-front (entries are never stored larger
+	// than their uncompressed size) and trim it afterwards
+	if constexpr (std::is_same_v<T, MemChunk>)
+	{
+		uint64_t max_size = 98; // End of central directory records
+		for (auto& zip_entry : zip_entries)
+			max_size += 76 + zip_entry.name.size() * 2
+						+ (zip_entry.source ? zip_entry.source->size() : zip_entry.info.size_comp);
+		if (max_size > 0xFFFFFFFF || !out.reSize(max_size, false))
 		{
-			// If the current entry has been changed, or doesn't exist in the old zip,
-			// (re)compress its data and write it to the zip
-			auto zipentry = new wxZipEntry(entries[a]->path() + saname);
-			zip.PutNextEntry(zipentry);
-			zip.Write(entries[a]->rawData(), entries[a]->size());
+			global::error = "Zip data is too large";
+			return false;
 		}
-		else
+		out.seek(0, SEEK_SET);
+	}
+
+	// Writes [entry]'s local header and data to the output
+	uint64_t offset      = 0;
+	auto     write_ok    = true;
+	auto     write_entry = [&](ZipWriteEntry& entry)
+	{
+		vector<uint8_t> header;
+		writeL(header, ZIP_SIG_LOCAL, 4);
+		writeL(header, 20, 2); // Version needed to extract (2.0)
+		writeL(header, entry.info.flags, 2);
+		writeL(header, entry.info.method, 2);
+		writeL(header, entry.info.mod_time, 2);
+		writeL(header, entry.info.mod_date, 2);
+		writeL(header, entry.info.crc, 4);
+		writeL(header, entry.info.size_comp, 4);
+		writeL(header, entry.info.size_orig, 4);
+		writeL(header, entry.name.size(), 2);
+		writeL(header, 0, 2); // Extra field length
+		header.insert(header.end(), entry.name.begin(), entry.name.end());
+
+		entry.info.offset = offset;
+		write_ok          = write_ok && out.write(header.data(), header.size());
+		if (entry.info.size_comp > 0)
+			write_ok = write_ok && out.write(entry.data, entry.info.size_comp);
+		offset += header.size() + entry.info.size_comp;
+	};
+
+	// Write entries, in batches so that the entries needing to be compressed
+	// can be compressed in parallel (without having to keep all the compressed
+	// data in memory at once)
+	static constexpr uint64_t batch_max_size = 64 * 1024 * 1024;
+	size_t                    batch_start    = 0;
+	while (batch_start < zip_entries.size())
+	{
+		// Get batch, loading data for entries needing compression or to be copied
+		// from the old zip file (this can't be done in parallel as it may need to
+		// read from the archive file)
+		vector<ZipWriteEntry*> to_compress;
+		uint64_t               batch_size = 0;
+		auto                   batch_end  = batch_start;
+		while (batch_end < zip_entries.size() && (batch_size < batch_max_size || batch_end == batch_start))
 		{
-			// If the entry is unmodified and exists in the old zip, just copy it over
-			c_entries[index]->SetName(entries[a]->path() + saname);
-			zip.CopyEntry(c_entries[index], *inzip);
-			inzip->Reset();
+			auto& zip_entry = zip_entries[batch_end++];
+			if (zip_entry.copy_index >= 0)
+			{
+				auto info   = old_entries[zip_entry.copy_index];
+				info.offset = 0;
+				if (readLocalEntry(old_entries[zip_entry.copy_index], zip_entry.compressed))
+					zip_entry.data = zipEntryData(zip_entry.compressed, info);
+				if (!zip_entry.data)
+				{
+					global::error = fmt::format("Unable to read data for entry \"{}\"", zip_entry.name);
+					return false;
+				}
+
+				batch_size += zip_entry.info.size_comp;
+				continue;
+			}
+			if (!zip_entry.source)
+				continue;
+
+			zip_entry.data           = zip_entry.source->rawData();
+			zip_entry.info.size_orig = zip_entry.source->size();
+			if (!zip_entry.data && zip_entry.info.size_orig > 0)
+			{
+				global::error = fmt::format("Unable to read data for entry \"{}\"", zip_entry.name);
+				return false;
+			}
+
+			batch_size += zip_entry.info.size_orig;
+			to_compress.push_back(&zip_entry);
 		}
+		num_compressed += to_compress.size();
+
+		// Compress
+		app::threadPool().parallelFor(
+			to_compress.size(), [&to_compress](size_t index) { compressZipEntry(*to_compress[index]); }, 1);
 
-		// Update entry info
-		if (update)
+		// Write
+		for (auto a = batch_start; a < batch_end; ++a)
 		{
-			entries[a]->setState(ArchiveEntry::State::Unmodified);
-			entries[a]->exProp("ZipIndex") = (int)a;
+			write_entry(zip_entries[a]);
+			zip_entries[a].compressed.clear();
 		}
+
+		batch_start = batch_end;
 	}
 
-	// Clean up
-	zip.Close();
-	out.Close();
+	// Write central directory
+	auto            dir_offset = offset;
+	vector<uint8_t> dir;
+	for (auto& zip_entry : zip_entries)
+	{
+		writeL(dir, ZIP_SIG_CENTRAL, 4);
+		writeL(dir, 20, 2); // Version made by (2.0, MS-DOS)
+		writeL(dir, 20, 2); // Version needed to extract (2.0)
+		writeL(dir, zip_entry.info.flags, 2);
+		writeL(dir, zip_entry.info.method, 2);
+		writeL(dir, zip_entry.info.mod_time, 2);
+		writeL(dir, zip_entry.info.mod_date, 2);
+		writeL(dir, zip_entry.info.crc, 4);
+		writeL(dir, zip_entry.info.size_comp, 4);
+		writeL(dir, zip_entry.info.size_orig, 4);
+		writeL(dir, zip_entry.name.size(), 2);
+		writeL(dir, 0, 2);                        // Extra field length
+		writeL(dir, 0, 2);                        // Comment length
+		writeL(dir, 0, 2);                        // Disk number
+		writeL(dir, 0, 2);                        // Internal attributes
+		writeL(dir, zip_entry.dir ? 0x10 : 0, 4); // External attributes (MS-DOS directory flag)
+		writeL(dir, zip_entry.info.offset, 4);
+		dir.insert(dir.end(), zip_entry.name.begin(), zip_entry.name.end());
+	}
+	offset += dir.size();
+
+	// Zip64 end of central directory record + locator (only needed if there are
+	// too many entries to fit in the regular end record)
+	auto num_entries = zip_entries.size();
+	if (num_entries >= 0xFFFF)
+	{
+		auto end64 = offset;
+		writeL(dir, ZIP_SIG_END64, 4);
+		writeL(dir, 44, 8); // Size of the rest of the record
+		writeL(dir, 45, 2); // Version made by (4.5)
+		writeL(dir, 45, 2); // Version needed to extract (4.5)
+		writeL(dir, 0, 4);  // Disk number
+		writeL(dir, 0, 4);  // Disk with central directory
+		writeL(dir, num_entries, 8);
+		writeL(dir, num_entries, 8);
+		writeL(dir, offset - dir_offset, 8);
+		writeL(dir, dir_offset, 8);
+
+		writeL(dir, ZIP_SIG_END64_LOCATE, 4);
+		writeL(dir, 0, 4); // Disk with zip64 end record
+		writeL(dir, end64, 8);
+		writeL(dir, 1, 4); // Number of disks
+	}
+
+	// End of central directory record
+	writeL(dir, ZIP_SIG_END, 4);
+	writeL(dir, 0, 2); // Disk number
+	writeL(dir, 0, 2); // Disk with central directory
+	writeL(dir, std::min<size_t>(num_entries, 0xFFFF), 2);
+	writeL(dir, std::min<size_t>(num_entries, 0xFFFF), 2);
+	writeL(dir, offset - dir_offset, 4);
+	writeL(dir, dir_offset, 4);
+	writeL(dir, 0, 2); // Comment length
+	write_ok = write_ok && out.write(dir.data(), dir.size());
+
+	// Trim to the written size
+	if constexpr (std::is_same_v<T, MemChunk>)
+		out.reSize(dir_offset + dir.size(), true);
+
+	// Check for errors (zip64 entry sizes/offsets aren't supported when writing,
+	// but MemChunk sizes are 32bit anyway)
+	if (!write_ok || dir_offset > 0xFFFFFFFF)
+	{
+		global::error = write_ok ? "Zip file is too large (over 4GB)" : "Error writing zip data";
+		return false;
+	}
 
-	// Update the temp file
-	if (temp_file_.empty())
-		generateTempFileName(filename);
-	fileutil::copyFile(filename, temp_file_);
+	log::info(
+		2,
+		"Wrote zip \"{}\" in {}ms ({} entries copied, {} compressed)",
+		filename(false),
+		app::runTimer() - time,
+		num_copied,
+		num_compressed);
 
 	return true;
 }
@@ -387,61 +928,30 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 	}
 
 	// Check that the entry has a zip index
-	int zip_index;
-	if (entry->exProps().contains("ZipIndex"))
-		zip_index = entry->exProp<int>("ZipIndex");
-	else
+	auto zip_index = entry->exProps().getOr<int>("ZipIndex", -1);
+	if (zip_index < 0 || zip_index >= static_cast<int>(zip_dir_.size()))
 	{
 		log::error("ZipArchive::loadEntryData: Entry {} has no zip entry index!", entry->name());
 		return false;
 	}
 
-	// Open the file
-	wxFFileInputStream in(filename_);
-	if (!in.IsOk())
-	{
-		log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", filename_);
-		return false;
-	}
-
-	// Create zip stream
-	wxZipInputStream zip(in);
-	if (!zip.IsOk())
+	// Read the data
+	MemChunk data;
+	if (!readEntryData(zip_dir_[zip_index], data))
 	{
-		log::error("ZipArchive::loadEntryData: Invalid zip file \"{}\"!", filename_);
+		log::error("Error reading data for entry \"{}\" from zip", entry->name());
 		return false;
 	}
 
 	// Lock entry state
 	entry->lockState();
 
-	// Skip to correct entry in zip
-	auto zentry = zip.GetNextEntry();
-	for (long a = 0; a < zip_index; a++)
-	{
-		delete zentry;
-		zentry = zip.GetNextEntry();
-	}
-
-	// Abort if entry doesn't exist in zip (some kind of error)
-	if (!zentry)
-	{
-		log::error("Error: ZipEntry for entry \"{}\" does not exist in zip", entry->name());
-		return false;
-	}
-
-	// Read the data
-	vector<uint8_t> data(zentry->GetSize());
-	zip.Read(data.data(), zentry->GetSize());
-	entry->importMem(data.data(), zentry->GetSize());
+	entry->importMemChunk(data);
 
 	// Set the entry to loaded
 	entry->setLoaded();
 	entry->unlockState();
 
-	// Clean up
-	delete zentry;
-
 	return true;
 }
 
@@ -503,6 +1013,10 @@ vector<Archive::MapDesc> ZipArchive::detectMaps()
 {
 	vector<MapDesc> ret;
 
+	// Use maps from the archive index if possible (saves opening each map wad)
+	if (indexedMaps(ret))
+		return ret;
+
 	// Get the maps directory
 	auto mapdir = dirAtPath("maps");
 	if (!mapdir)
@@ -520,7 +1034,9 @@ vector<Archive::MapDesc> ZipArchive::detectMaps()
 		// Detect map format (probably kinda slow but whatever, no better way to do it really)
 		auto       format = MapFormat::Unknown;
 		WadArchive tempwad;
-		tempwad.open(entry->data());
+		MemChunk   wad_data;
+		entry->shareData(wad_data);
+		tempwad.open(wad_data);
 		auto emaps = tempwad.detectMaps();
 		if (!emaps.empty())
 			format = emaps[0].format;
@@ -535,6 +1051,8 @@ vector<Archive::MapDesc> ZipArchive::detectMaps()
 		ret.push_back(md);
 	}
 
+	updateIndexedMaps(ret);
+
 	return ret;
 }
 
@@ -638,27 +1156,123 @@ vector<ArchiveEntry*> ZipArchive::findAll(SearchOptions& options)
 }
 
 // -----------------------------------------------------------------------------
-// Generates the temp file path to use, from [filename].
-// The temp file will be in the configured temp folder
+// Reads the central directory of the zip file at [filename] (and the entry
+// names into [names] if given). Entry data is read from a memory-mapping of the
+// file if possible, otherwise the file is kept open to read it from as needed.
+// Returns false if the file couldn't be read or isn't a valid zip
 // -----------------------------------------------------------------------------
-void ZipArchive::generateTempFileName(string_view filename)
+bool ZipArchive::readZipData(string_view filename, vector<string>* names)
 {
-	strutil::Path tfn(filename);
-	temp_file_ = app::path(tfn.fileName(), app::Dir::Temp);
-	if (wxFileExists(temp_file_))
-	{
-		// Make sure we don't overwrite an existing temp file
-		// (in case there are multiple zips open with the same name)
-		int n = 1;
-		while (true)
+	zip_data_.clear();
+	zip_dir_.clear();
+	closeZipFile();
+
+	// Memory-map the file if enabled
+	if (archive_map_files && MappedFile::supported())
+	{
+		auto mapped = std::make_shared<MappedFile>();
+		if (mapped->open(filename))
 		{
-			temp_file_ = app::path(fmt::format("{}.{}", tfn.fileName(), n), app::Dir::Temp);
-			if (!wxFileExists(temp_file_))
-				break;
+			zip_data_.setView(mapped->data(), mapped->size(), mapped);
+			mapped_file_ = mapped;
+			if (!readCentralDirectory(zip_data_, zip_dir_, names))
+			{
+				global::error = "Invalid zip file";
+				zip_dir_.clear();
+				return false;
+			}
 
-			n++;
+			return true;
 		}
 	}
+
+	// Otherwise open it and read the central directory from the end of it
+	// (searching back up to 64kb for the end of central directory record)
+	if (!zip_file_.open(string{ filename }))
+	{
+		global::error = "Unable to open file. Make sure it isn't in use by another program.";
+		return false;
+	}
+	zip_file_path_ = filename;
+
+	uint64_t size      = zip_file_.size();
+	uint64_t base      = size - std::min<uint64_t>(size, 0xFFFF + 22 + 20);
+	uint64_t dir_start = base;
+	MemChunk dir_data;
+	while (true)
+	{
+		// Read from [base] to the end of the file
+		if (!dir_data.reSize(size - base, false) || !zip_file_.seekFromStart(base)
+			|| !zip_file_.read(dir_data.data(), size - base))
+			break;
+
+		// If the central directory starts before [base], read again from there
+		if (readCentralDirectory(dir_data, zip_dir_, names, base, &dir_start))
+			return true;
+		if (dir_start >= base)
+			break;
+		base = dir_start;
+	}
+
+	global::error = "Invalid zip file";
+	zip_dir_.clear();
+	closeZipFile();
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Closes the zip file if entry data is being read from it
+// -----------------------------------------------------------------------------
+void ZipArchive::closeZipFile()
+{
+	std::lock_guard<std::mutex> lock(zip_file_mutex_);
+	zip_file_.close();
+	zip_file_path_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Reads the data of zip [entry] from the zip data/file into [out], inflating
+// it if needed.
+// Returns false if the entry couldn't be read or is corrupt
+// -----------------------------------------------------------------------------
+bool ZipArchive::readEntryData(const DirEntry& entry, MemChunk& out)
+{
+	if (!zip_file_.isOpen())
+		return readZipEntry(zip_data_, entry, out);
+
+	// Read the entry from the file, it is then at the start of the read data
+	MemChunk local;
+	if (!readLocalEntry(entry, local))
+		return false;
+	local.makeShareable();
+	auto local_entry   = entry;
+	local_entry.offset = 0;
+
+	return readZipEntry(local, local_entry, out);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the local header and (compressed) data of zip [entry] from the zip
+// file into [out]. Can be called from multiple threads.
+// Returns false if it couldn't be read
+// -----------------------------------------------------------------------------
+bool ZipArchive::readLocalEntry(const DirEntry& entry, MemChunk& out)
+{
+	std::lock_guard<std::mutex> lock(zip_file_mutex_);
+
+	// Read local header
+	uint8_t  header[30];
+	uint64_t size = zip_file_.size();
+	if (entry.offset + 30ull > size || !zip_file_.seekFromStart(entry.offset) || !zip_file_.read(header, 30)
+		|| memory::readL32(header, 0) != ZIP_SIG_LOCAL)
+		return false;
+
+	// Read the header again along with the name, extra field and data
+	uint64_t length = 30ull + memory::readL16(header, 26) + memory::readL16(header, 28) + entry.size_comp;
+	if (entry.offset + length > size || !out.reSize(length, false) || !zip_file_.seekFromStart(entry.offset))
+		return false;
+
+	return zip_file_.read(out.data(), length);
 }
 
 
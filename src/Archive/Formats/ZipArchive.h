@@ -1,14 +1,27 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include "Utility/FileUtils.h"
 
 namespace slade
 {
 class ZipArchive : public Archive
 {
 public:
+	// Info about an entry, as stored in a zip's central directory
+	struct DirEntry
+	{
+		uint16_t flags     = 0;
+		uint16_t method    = 0;
+		uint16_t mod_time  = 0;
+		uint16_t mod_date  = 0;
+		uint32_t crc       = 0;
+		uint32_t size_comp = 0;
+		uint32_t size_orig = 0;
+		uint32_t offset    = 0; // Offset of the entry's local header
+	};
+
 	ZipArchive() : Archive("zip") {}
-	~ZipArchive();
 
 	// Opening
 	bool open(string_view filename) override; // Open from File
@@ -38,8 +51,22 @@ public:
 	static bool isZipArchive(const string& filename);
 
 private:
-	string temp_file_;
+	// The zip data as it was last opened/saved. Entry data is read from this
+	// when needed, and unmodified entries are copied from it when saving.
+	// If the zip file can't be memory-mapped, it is kept open instead and
+	// entry data read from it as needed (rather than reading the whole file
+	// into memory)
+	MemChunk         zip_data_;
+	SFile            zip_file_;
+	string           zip_file_path_;
+	std::mutex       zip_file_mutex_;
+	vector<DirEntry> zip_dir_; // Central directory of [zip_data_]/[zip_file_]
 
-	void generateTempFileName(string_view filename);
+	bool                   openZip(vector<string>& names);
+	bool                   readZipData(string_view filename, vector<string>* names = nullptr);
+	void                   closeZipFile();
+	bool                   readEntryData(const DirEntry& entry, MemChunk& out);
+	bool                   readLocalEntry(const DirEntry& entry, MemChunk& out);
+	template<class T> bool writeZip(T& out, const vector<ArchiveEntry*>& entries);
 };
 } // namespace slade
@@ -1773,15 +1773,15 @@ UDMFPropMap& Configuration::allUDMFProperties(MapObject::Type type)
 
 // -----------------------------------------------------------------------------
 // Removes any UDMF properties in [object] that have default values
-// (so they are not written to the UDMF map unnecessarily)
+// (so they are not written to the UDMF map unnecessarily).
+// This doesn't modify the configuration, so can be called for different
+// objects from multiple threads
 // -----------------------------------------------------------------------------
-void Configuration::cleanObjectUDMFProps(MapObject* object)
+void Configuration::cleanObjectUDMFProps(MapObject* object) const
 {
-	using namespace property;
-
 	// Get UDMF properties list for type
-	UDMFPropMap* map  = nullptr;
-	auto         type = object->objType();
+	const UDMFPropMap* map  = nullptr;
+	auto               type = object->objType();
 	if (type == MapObject::Type::Vertex)
 		map = &udmf_vertex_props_;
 	else if (type == MapObject::Type::Line)
@@ -1795,39 +1795,42 @@ void Configuration::cleanObjectUDMFProps(MapObject* object)
 	else
 		return;
 
-	// Go through properties
-	for (const auto& i : *map)
+	// Go through the object's properties
+	vector<string> remove;
+	for (const auto& prop : object->props().properties())
 	{
-		const auto& name      = i.first;
-		const auto& udmf_prop = i.second;
-
-		// Check if the object even has this property
-		if (!object->hasProp(name))
+		auto i = map->find(strutil::lower(prop.name));
+		if (i == map->end() || !i->second.hasDefaultValue())
 			continue;
 
-		// Remove the property from the object if it is the default value
-		const auto& default_val = udmf_prop.defaultValue();
-		switch (valueType(default_val))
+		// Remove the property from the object if it is the default value.
+		// The value is converted to the default's type to compare, since it
+		// can be read as a different type (eg. a float property with a whole
+		// number value is read from the map as an int). Numbers are compared
+		// as floats so that a fractional value doesn't match an int default
+		const auto& default_val = i->second.defaultValue();
+		auto        is_default  = false;
+		switch (property::valueType(default_val))
 		{
-		case ValueType::Bool:
-			if (udmf_prop.isDefault<bool>(object->boolProperty(name)))
-				object->props().remove(name);
-			break;
-		case ValueType::Int:
-			if (udmf_prop.isDefault<int>(object->intProperty(name)))
-				object->props().remove(name);
+		case property::ValueType::Bool:
+			is_default = property::asBool(prop.value) == property::asBool(default_val);
 			break;
-		case ValueType::Float:
-			if (udmf_prop.isDefault<double>(object->floatProperty(name)))
-				object->props().remove(name);
+		case property::ValueType::Int:
+		case property::ValueType::Float:
+			is_default = property::asFloat(prop.value) == property::asFloat(default_val);
 			break;
-		case ValueType::String:
-			if (udmf_prop.isDefault<string>(object->stringProperty(name)))
-				object->props().remove(name);
+		case property::ValueType::String:
+			is_default = property::asString(prop.value) == property::asString(default_val);
 			break;
 		default: break;
 		}
+
+		if (is_default)
+			remove.push_back(prop.name);
 	}
+
+	for (const auto& name : remove)
+		object->props().remove(name);
 }
 
 // -----------------------------------------------------------------------------
@@ -165,7 +165,7 @@ namespace game
 		// UDMF properties
 		UDMFProperty* getUDMFProperty(const string& name, MapObject::Type type);
 		UDMFPropMap&  allUDMFProperties(MapObject::Type type);
-		void          cleanObjectUDMFProps(MapObject* object);
+		void          cleanObjectUDMFProps(MapObject* object) const;
 
 		// Sector types
 		string sectorTypeName(int type);
@@ -31,8 +31,10 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Decorate.h"
+#include "App.h"
 #include "Archive/Archive.h"
 #include "Configuration.h"
+#include "DefinitionParser.h"
 #include "Game.h"
 #include "ThingType.h"
 #include "Utility/StringUtils.h"
@@ -50,7 +52,36 @@ using namespace game;
 namespace
 {
 EntryType* etype_decorate = nullptr;
-}
+
+// Increase this if the DecorateEntry cache format changes
+const uint32_t decorate_cache_version = 1;
+
+// A DECORATE definition parsed from an entry, added to the thing types once
+// all entries are parsed
+struct DecorateDef
+{
+	bool           actor = true; // False if an old-style (non-actor) definition
+	string         name;
+	string         class_name;
+	string         parent;
+	string         group;
+	int            ednum = -1;
+	vector<string> games; // Game filters
+	PropertyList   props;
+};
+
+// The definitions parsed from a single DECORATE entry
+class DecorateEntry : public ParsedEntry
+{
+public:
+	vector<DecorateDef> defs;
+
+	unsigned itemCount() const override { return defs.size(); }
+	bool     parse(const MemChunk& data, ArchiveEntry* entry) override;
+	void     write(DefinitionCache::Writer& writer) const override;
+	bool     read(DefinitionCache::Reader& reader, ArchiveEntry* entry) override;
+};
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -236,14 +267,15 @@ void parseStates(Tokenizer& tz, PropertyList& props)
 }
 
 // -----------------------------------------------------------------------------
-// Parses a DECORATE 'actor' definition
+// Parses a DECORATE 'actor' definition into [def]
 // -----------------------------------------------------------------------------
-void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+void parseDecorateActor(Tokenizer& tz, DecorateDef& def)
 {
 	// Get actor name
-	auto   name       = tz.next().text;
-	auto   actor_name = name;
-	string parent;
+	auto& name     = def.name;
+	auto& parent   = def.parent;
+	name           = tz.next().text;
+	def.class_name = name;
 
 	// Check for inheritance
 	// string next = tz.peekToken();
@@ -259,18 +291,16 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 		tz.adv();
 
 	// Check for no editor number (ie can't be placed in the map)
-	int ednum;
+	auto& ednum = def.ednum;
 	if (!tz.peek().isInteger())
 		ednum = -1;
 	else
 		tz.next().toInt(ednum);
 
-	PropertyList found_props;
-	bool         available       = false;
-	bool         filters_present = false;
-	bool         sprite_given    = false;
-	bool         title_given     = false;
-	string       group;
+	auto& found_props  = def.props;
+	auto& group        = def.group;
+	bool  sprite_given = false;
+	bool  title_given  = false;
 
 	// Skip "native" keyword if present
 	tz.advIfNextNC("native");
@@ -297,11 +327,7 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 
 			// Game filter
 			else if (tz.checkNC("game"))
-			{
-				filters_present = true;
-				if (gameDef(configuration().currentGame()).supportsFilter(tz.next().text))
-					available = true;
-			}
+				def.games.push_back(tz.next().text);
 
 			// Tag
 			else if (!title_given && tz.checkNC("tag"))
@@ -425,69 +451,23 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 	}
 	else
 		log::warning("Warning: Invalid actor definition for {}", name);
-
-	// Ignore actors filtered for other games,
-	// and actors with a negative or null type
-	if (available || !filters_present)
-	{
-		auto group_path = group.empty() ? "Decorate" : "Decorate/" + group;
-
-		// Find existing definition or create it
-		ThingType* def = nullptr;
-		if (ednum <= 0)
-		{
-			for (auto& ptype : parsed)
-				if (strutil::equalCI(ptype.className(), actor_name))
-				{
-					def = &ptype;
-					break;
-				}
-
-			if (!def)
-			{
-				parsed.emplace_back(name, group_path, actor_name);
-				def = &parsed.back();
-			}
-		}
-		else
-			def = &types[ednum];
-
-		// Add/update definition
-		def->define(ednum, name, group_path);
-
-		// Set group defaults (if any)
-		if (!group.empty())
-		{
-			auto& group_defaults = configuration().thingTypeGroupDefaults(group);
-			if (!group_defaults.group().empty())
-				def->copy(group_defaults);
-		}
-
-		// Inherit from parent
-		if (!parent.empty())
-			for (auto& ptype : parsed)
-				if (strutil::equalCI(ptype.className(), parent))
-				{
-					def->copy(ptype);
-					break;
-				}
-
-		// Set parsed properties
-		def->loadProps(found_props);
-	}
 }
 
 // -----------------------------------------------------------------------------
-// Parses an old-style (non-actor) DECORATE definition
+// Parses an old-style (non-actor) DECORATE definition into [def].
+// Returns false if the definition has no DoomEdNum (so shouldn't be added)
 // -----------------------------------------------------------------------------
-void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
+bool parseDecorateOld(Tokenizer& tz, DecorateDef& def)
 {
-	string       name, sprite, group;
-	bool         spritefound = false;
-	char         frame       = 'A';
-	bool         framefound  = false;
-	int          type        = -1;
-	PropertyList found_props;
+	auto&  name        = def.name;
+	auto&  group       = def.group;
+	auto&  type        = def.ednum;
+	auto&  found_props = def.props;
+	string sprite;
+	bool   spritefound = false;
+	char   frame       = 'A';
+	bool   framefound  = false;
+	def.actor          = false;
 	if (tz.checkNext("{"))
 		name = tz.current().text;
 	// DamageTypes aren't old DECORATE format, but we handle them here to skip over them
@@ -556,28 +536,231 @@ void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
 		if (spritefound && framefound)
 			found_props["sprite"] = sprite + frame + '?';
 
-		// Add type
-		types[type].define(type, name, group.empty() ? "Decorate" : "Decorate/" + group);
+		log::info(3, "Parsed {} {}: {}", group.length() ? group : "decoration", name, type);
+		return true;
+	}
 
-		// Set parsed properties
-		types[type].loadProps(found_props);
+	log::info(3, "Not adding {} {}, no editor number", group.length() ? group : "decoration", name);
+	return false;
+}
 
-		log::info(3, "Parsed {} {}: {}", group.length() ? group : "decoration", name, type);
+// -----------------------------------------------------------------------------
+// Adds the parsed DECORATE definition [def] to [types] (if it has an editor
+// number) or [parsed], or updates the existing definition
+// -----------------------------------------------------------------------------
+void addDecorateDef(const DecorateDef& def, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+{
+	// Old-style definition
+	if (!def.actor)
+	{
+		auto& type = types[def.ednum];
+		type.define(def.ednum, def.name, def.group.empty() ? "Decorate" : "Decorate/" + def.group);
+		type.loadProps(def.props);
+		return;
+	}
+
+	// Ignore actors filtered for other games
+	if (!def.games.empty())
+	{
+		auto& game      = gameDef(configuration().currentGame());
+		bool  available = false;
+		for (const auto& filter : def.games)
+			if (game.supportsFilter(filter))
+			{
+				available = true;
+				break;
+			}
+
+		if (!available)
+			return;
+	}
+
+	auto group_path = def.group.empty() ? "Decorate" : "Decorate/" + def.group;
+
+	// Find existing definition or create it
+	ThingType* type = nullptr;
+	if (def.ednum <= 0)
+	{
+		for (auto& ptype : parsed)
+			if (strutil::equalCI(ptype.className(), def.class_name))
+			{
+				type = &ptype;
+				break;
+			}
+
+		if (!type)
+		{
+			parsed.emplace_back(def.name, group_path, def.class_name);
+			type = &parsed.back();
+		}
 	}
 	else
-		log::info(3, "Not adding {} {}, no editor number", group.length() ? group : "decoration", name);
+		type = &types[def.ednum];
+
+	// Add/update definition
+	type->define(def.ednum, def.name, group_path);
+
+	// Set group defaults (if any)
+	if (!def.group.empty())
+	{
+		auto& group_defaults = configuration().thingTypeGroupDefaults(def.group);
+		if (!group_defaults.group().empty())
+			type->copy(group_defaults);
+	}
+
+	// Inherit from parent
+	if (!def.parent.empty())
+		for (auto& ptype : parsed)
+			if (strutil::equalCI(ptype.className(), def.parent))
+			{
+				type->copy(ptype);
+				break;
+			}
+
+	// Set parsed properties
+	type->loadProps(def.props);
 }
 
 // -----------------------------------------------------------------------------
-// Parses all DECORATE thing definitions in [entry] and adds them to [types]
+// Parses all DECORATE thing definitions in [entries] (and any entries they
+// #include) and adds them to [types]/[parsed]
 // -----------------------------------------------------------------------------
-void parseDecorateEntry(ArchiveEntry* entry, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+void parseDecorateEntries(
+	const vector<ArchiveEntry*>& entries,
+	std::map<int, ThingType>&    types,
+	vector<ThingType>&           parsed)
+{
+	if (entries.empty())
+		return;
+
+	// Parse entries concurrently (or get them from the cache if unchanged)
+	auto          start = app::runTimer();
+	ParsedEntries parsed_entries;
+	auto          cache = DefinitionCache::forArchive("decorate", decorate_cache_version, entries[0]->parent());
+	parseDefinitionEntries(
+		entries, []() { return std::make_unique<DecorateEntry>(); }, cache.get(), parsed_entries, "DECORATE");
+	if (cache)
+		cache->save();
+	log::debug(2, "Parse DECORATE: {}ms", app::runTimer() - start);
+
+	// Set entry types
+	for (auto& parsed_entry : parsed_entries)
+		if (etype_decorate && parsed_entry.first->type() != etype_decorate)
+			parsed_entry.first->setType(etype_decorate);
+
+	// Add parsed definitions, in order
+	for (auto entry : entries)
+		forEachParsedItem(
+			parsed_entries,
+			entry,
+			[&](ParsedEntry& parsed_entry, unsigned index)
+			{
+				addDecorateDef(static_cast<DecorateEntry&>(parsed_entry).defs[index], types, parsed);
+				return true;
+			},
+			"DECORATE");
+}
+
+// -----------------------------------------------------------------------------
+// Writes a PropertyList [props] to [writer]
+// -----------------------------------------------------------------------------
+void writeProps(DefinitionCache::Writer& writer, const PropertyList& props)
+{
+	writer.write(static_cast<uint32_t>(props.properties().size()));
+	for (const auto& prop : props.properties())
+	{
+		writer.write(prop.name);
+		writer.write(static_cast<uint32_t>(property::valueType(prop.value)));
+		switch (property::valueType(prop.value))
+		{
+		case property::ValueType::Bool:   writer.write(std::get<bool>(prop.value) ? 1 : 0); break;
+		case property::ValueType::Int:    writer.write(static_cast<uint32_t>(std::get<int>(prop.value))); break;
+		case property::ValueType::UInt:   writer.write(std::get<unsigned>(prop.value)); break;
+		case property::ValueType::String: writer.write(std::get<string>(prop.value)); break;
+		case property::ValueType::Float:
+		{
+			auto value = std::get<double>(prop.value);
+			writer.write(string_view{ reinterpret_cast<const char*>(&value), sizeof(double) });
+			break;
+		}
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads a PropertyList written by writeProps from [reader] into [props]
+// -----------------------------------------------------------------------------
+bool readProps(DefinitionCache::Reader& reader, PropertyList& props)
+{
+	uint32_t count;
+	if (!reader.read(count))
+		return false;
+
+	string   name, str_value;
+	uint32_t type, value;
+	for (unsigned a = 0; a < count; a++)
+	{
+		if (!reader.read(name) || !reader.read(type))
+			return false;
+
+		switch (static_cast<property::ValueType>(type))
+		{
+		case property::ValueType::Bool:
+			if (!reader.read(value))
+				return false;
+			props[name] = value != 0;
+			break;
+		case property::ValueType::Int:
+			if (!reader.read(value))
+				return false;
+			props[name] = static_cast<int>(value);
+			break;
+		case property::ValueType::UInt:
+			if (!reader.read(value))
+				return false;
+			props[name] = value;
+			break;
+		case property::ValueType::String:
+			if (!reader.read(str_value))
+				return false;
+			props[name] = str_value;
+			break;
+		case property::ValueType::Float:
+		{
+			if (!reader.read(str_value) || str_value.size() != sizeof(double))
+				return false;
+			double fvalue;
+			memcpy(&fvalue, str_value.data(), sizeof(double));
+			props[name] = fvalue;
+			break;
+		}
+		default: return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// DecorateEntry Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Parses all DECORATE definitions in [data] (from [entry])
+// -----------------------------------------------------------------------------
+bool DecorateEntry::parse(const MemChunk& data, ArchiveEntry* entry)
 {
 	// Init tokenizer
 	Tokenizer tz;
 	tz.setSpecialCharacters(":,{}");
 	tz.enableDecorate(true);
-	tz.openMem(entry->data(), entry->name());
+	tz.openMem(data, entry->name());
 
 	// --- Parse ---
 	while (!tz.atEnd())
@@ -585,39 +768,90 @@ void parseDecorateEntry(ArchiveEntry* entry, std::map<int, ThingType>& types, ve
 		// Check for #include
 		if (tz.checkNC("#include"))
 		{
-			auto inc_entry = entry->relativeEntry(tz.next().text);
-
-			// Check #include path could be resolved
-			if (!inc_entry)
-			{
-				log::warning(
-					"Warning parsing DECORATE entry {}: "
-					"Unable to find #included entry \"{}\" at line {}, skipping",
-					entry->name(),
-					tz.current().text,
-					tz.current().line_no);
-			}
-			else
-				parseDecorateEntry(inc_entry, types, parsed);
+			ParsedInclude include;
+			include.path     = tz.next().text;
+			include.line     = tz.current().line_no;
+			include.position = defs.size();
+			includes.push_back(include);
 
 			tz.adv();
 		}
 
 		// Check for actor definition
 		else if (tz.checkNC("actor"))
-			parseDecorateActor(tz, types, parsed);
+		{
+			defs.emplace_back();
+			parseDecorateActor(tz, defs.back());
+		}
 		else
-			parseDecorateOld(tz, types); // Old DECORATE definitions might be found
+		{
+			// Old DECORATE definitions might be found
+			defs.emplace_back();
+			if (!parseDecorateOld(tz, defs.back()))
+				defs.pop_back();
+		}
 
 		tz.advIf("}");
 	}
 
-	// Set entry type
-	if (etype_decorate && entry->type() != etype_decorate)
-		entry->setType(etype_decorate);
+	return true;
 }
 
-} // namespace
+// -----------------------------------------------------------------------------
+// Writes the parsed definitions to [writer]
+// -----------------------------------------------------------------------------
+void DecorateEntry::write(DefinitionCache::Writer& writer) const
+{
+	writeIncludes(writer);
+
+	writer.write(static_cast<uint32_t>(defs.size()));
+	for (const auto& def : defs)
+	{
+		writer.write(def.actor ? 1 : 0);
+		writer.write(def.name);
+		writer.write(def.class_name);
+		writer.write(def.parent);
+		writer.write(def.group);
+		writer.write(static_cast<uint32_t>(def.ednum));
+		writer.write(static_cast<uint32_t>(def.games.size()));
+		for (const auto& game : def.games)
+			writer.write(game);
+		writeProps(writer, def.props);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads parsed definitions written by DecorateEntry::write from [reader]
+// -----------------------------------------------------------------------------
+bool DecorateEntry::read(DefinitionCache::Reader& reader, ArchiveEntry* entry)
+{
+	if (!readIncludes(reader))
+		return false;
+
+	uint32_t count, actor, ednum, num_games;
+	if (!reader.read(count))
+		return false;
+
+	defs.resize(count);
+	for (auto& def : defs)
+	{
+		if (!reader.read(actor) || !reader.read(def.name) || !reader.read(def.class_name) || !reader.read(def.parent)
+			|| !reader.read(def.group) || !reader.read(ednum) || !reader.read(num_games))
+			return false;
+
+		def.actor = actor != 0;
+		def.ednum = static_cast<int>(ednum);
+		def.games.resize(num_games);
+		for (auto& game : def.games)
+			if (!reader.read(game))
+				return false;
+
+		if (!readProps(reader, def.props))
+			return false;
+	}
+
+	return true;
+}
 
 
 // -----------------------------------------------------------------------------
@@ -651,8 +885,7 @@ bool game::readDecorateDefs(Archive* archive, std::map<int, ThingType>& types, v
 		etype_decorate = nullptr;
 
 	// Parse DECORATE entries
-	for (auto entry : decorate_entries)
-		parseDecorateEntry(entry, types, parsed);
+	parseDecorateEntries(decorate_entries, types, parsed);
 
 	return true;
 }
@@ -682,7 +915,7 @@ CONSOLE_COMMAND(test_decorate, 0, false)
 	{
 		auto entry = archive->entryAtPath(args[0]);
 		if (entry)
-			parseDecorateEntry(entry, types, parsed);
+			parseDecorateEntries({ entry }, types, parsed);
 		else
 			log::console("Entry not found");
 	}
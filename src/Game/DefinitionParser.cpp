@@ -0,0 +1,509 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    DefinitionParser.cpp
+// Description: Functions for parsing definition entries (DECORATE, ZScript)
+//              and their #includes concurrently, with a persistent cache of
+//              parsed entries
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "DefinitionParser.h"
+#include "App.h"
+#include "Archive/Archive.h"
+#include "General/Misc.h"
+#include "Utility/FileUtils.h"
+#include "Utility/ThreadPool.h"
+
+using namespace slade;
+using namespace game;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, parse_cache_defs, true, CVar::Flag::Save)
+
+namespace
+{
+// Cache files are made up of a header followed by the cached items:
+// char[4] "SDC1", uint32 version, uint32 item count
+// [item count] * (uint64 hash, uint32 entry size, uint32 data size, data)
+const char cache_magic[4] = { 'S', 'D', 'C', '1' };
+
+// Caches for the same archive can be in use on different threads (eg. the
+// base resource and the zdoom.pk3 ZScript parsed in the background)
+std::mutex cache_file_mutex;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// DefinitionCache Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// DefinitionCache class constructor. Opens the cache of [type] definitions
+// for the archive at [archive_path]. Any cached data not written with the
+// current [version] is ignored
+// -----------------------------------------------------------------------------
+DefinitionCache::DefinitionCache(string_view type, uint32_t version, string_view archive_path) : version_{ version }
+{
+	auto path_hash = misc::contentHash(reinterpret_cast<const uint8_t*>(archive_path.data()), archive_path.size());
+	path_          = fmt::format("{}/{}_{:016x}.dat", app::path("cache", app::Dir::User), type, path_hash);
+
+	load();
+}
+
+// -----------------------------------------------------------------------------
+// Gets the cached data for an entry with content [hash] and [size] into
+// [data]. Returns false if it isn't in the cache.
+// This doesn't modify the cache so it can be called from multiple threads
+// -----------------------------------------------------------------------------
+bool DefinitionCache::get(uint64_t hash, uint32_t size, MemChunk& data) const
+{
+	auto i = items_.find({ hash, size });
+	if (i == items_.end())
+		return false;
+
+	return i->second->data.shareMemChunk(data);
+}
+
+// -----------------------------------------------------------------------------
+// Marks the cached data for an entry with content [hash] and [size] as used,
+// so that it is kept the next time the cache is saved
+// -----------------------------------------------------------------------------
+void DefinitionCache::keep(uint64_t hash, uint32_t size)
+{
+	auto i = items_.find({ hash, size });
+	if (i != items_.end())
+		i->second->used = true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds (or replaces) the cached [data] for an entry with content [hash] and
+// [size]
+// -----------------------------------------------------------------------------
+void DefinitionCache::put(uint64_t hash, uint32_t size, string_view data)
+{
+	auto& item = items_[{ hash, size }];
+	item       = std::make_unique<Item>();
+	item->data.importMem(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+	item->used = true;
+	modified_  = true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the cache to disk if anything was added to it or any cached items
+// weren't used (which are removed, so the cache only keeps what is currently
+// in the archive)
+// -----------------------------------------------------------------------------
+bool DefinitionCache::save()
+{
+	// Check if anything needs to be written
+	unsigned count = 0;
+	for (const auto& item : items_)
+		if (item.second->used)
+			++count;
+	if (!modified_ && count == items_.size())
+		return true;
+
+	// Build cache data
+	DefinitionCache::Writer writer;
+	for (const auto& i : items_)
+	{
+		if (!i.second->used)
+			continue;
+
+		const auto& data = i.second->data;
+		writer.write(static_cast<uint32_t>(i.first.first & 0xFFFFFFFF));
+		writer.write(static_cast<uint32_t>(i.first.first >> 32));
+		writer.write(i.first.second);
+		writer.write(string_view{ reinterpret_cast<const char*>(data.data()), data.size() });
+	}
+
+	// Write to file
+	std::lock_guard<std::mutex> lock(cache_file_mutex);
+
+	auto cache_dir = app::path("cache", app::Dir::User);
+	if (!fileutil::dirExists(cache_dir) && !fileutil::createDir(cache_dir))
+		return false;
+
+	SFile file(path_, SFile::Mode::Write);
+	if (!file.isOpen())
+	{
+		log::warning("Unable to write definitions cache file {}", path_);
+		return false;
+	}
+
+	file.write(cache_magic, 4);
+	file.write(&version_, 4);
+	file.write(&count, 4);
+	if (!writer.data().empty())
+		file.write(writer.data().data(), writer.data().size());
+
+	modified_ = false;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the cache from disk.
+// Returns false if the cache file doesn't exist or is invalid
+// -----------------------------------------------------------------------------
+bool DefinitionCache::load()
+{
+	items_.clear();
+
+	// Read file
+	MemChunk mc;
+	{
+		std::lock_guard<std::mutex> lock(cache_file_mutex);
+		if (!fileutil::fileExists(path_) || !mc.importFile(path_))
+			return false;
+	}
+
+	// Check header
+	uint32_t version = 0;
+	uint32_t count   = 0;
+	if (mc.size() < 12 || memcmp(mc.data(), cache_magic, 4) != 0)
+		return false;
+	mc.read(4, &version, 4);
+	mc.read(8, &count, 4);
+	if (version != version_)
+		return false;
+
+	// Read items (as views of the loaded file data)
+	mc.makeShareable();
+	uint32_t pos = 12;
+	for (unsigned a = 0; a < count; a++)
+	{
+		uint32_t hash_lo, hash_hi, entry_size, data_size;
+		if (!mc.read(pos, &hash_lo, 4) || !mc.read(pos + 4, &hash_hi, 4) || !mc.read(pos + 8, &entry_size, 4)
+			|| !mc.read(pos + 12, &data_size, 4))
+			break;
+		pos += 16;
+
+		auto item = std::make_unique<Item>();
+		if (data_size > 0 && !mc.shareMemChunk(item->data, pos, data_size))
+			break;
+		pos += data_size;
+
+		items_[{ (static_cast<uint64_t>(hash_hi) << 32) | hash_lo, entry_size }] = std::move(item);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the cache of [type] definitions (with [version]) for [archive], or
+// nullptr if definition caching is disabled or [archive] isn't a file on disk
+// -----------------------------------------------------------------------------
+unique_ptr<DefinitionCache> DefinitionCache::forArchive(string_view type, uint32_t version, const Archive* archive)
+{
+	if (!parse_cache_defs || !archive)
+		return nullptr;
+
+	auto filename = archive->filename();
+	if (filename.empty() || !fileutil::fileExists(filename))
+		return nullptr;
+
+	return std::make_unique<DefinitionCache>(type, version, filename);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// DefinitionCache::Reader Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Reads a uint32 into [value]. Returns false if at the end of the data
+// -----------------------------------------------------------------------------
+bool DefinitionCache::Reader::read(uint32_t& value)
+{
+	if (pos_ + 4 > size_)
+		return false;
+
+	memcpy(&value, data_ + pos_, 4);
+	pos_ += 4;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads a string into [str]. Returns false if at the end of the data
+// -----------------------------------------------------------------------------
+bool DefinitionCache::Reader::read(string& str)
+{
+	uint32_t length;
+	if (!read(length) || pos_ + length > size_)
+		return false;
+
+	str.assign(reinterpret_cast<const char*>(data_ + pos_), length);
+	pos_ += length;
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// ParsedEntry Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Writes the entry's #includes to [writer]
+// -----------------------------------------------------------------------------
+void ParsedEntry::writeIncludes(DefinitionCache::Writer& writer) const
+{
+	writer.write(static_cast<uint32_t>(includes.size()));
+	for (const auto& include : includes)
+	{
+		writer.write(include.path);
+		writer.write(include.line);
+		writer.write(include.position);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads the entry's #includes from [reader]
+// -----------------------------------------------------------------------------
+bool ParsedEntry::readIncludes(DefinitionCache::Reader& reader)
+{
+	uint32_t count;
+	if (!reader.read(count))
+		return false;
+
+	includes.resize(count);
+	for (auto& include : includes)
+		if (!reader.read(include.path) || !reader.read(include.line) || !reader.read(include.position))
+			return false;
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Game Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Parses the [roots] entries and all entries they #include (recursively),
+// adding the results to [parsed]. Entries are parsed concurrently, one level
+// of #includes at a time, with [create] used to create the ParsedEntry for
+// each. If a [cache] is given, entries found in it aren't parsed again and
+// newly parsed entries are added to it.
+// [type_name] is the type of definitions being parsed, for log messages
+// -----------------------------------------------------------------------------
+void game::parseDefinitionEntries(
+	const vector<ArchiveEntry*>& roots,
+	const ParsedEntryFactory&    create,
+	DefinitionCache*             cache,
+	ParsedEntries&               parsed,
+	string_view                  type_name)
+{
+	struct ParseJob
+	{
+		ArchiveEntry*           entry = nullptr;
+		MemChunk                data;
+		uint64_t                hash   = 0;
+		bool                    cached = false;
+		unique_ptr<ParsedEntry> result;
+	};
+
+	vector<ArchiveEntry*> to_parse;
+	for (auto entry : roots)
+		if (parsed.find(entry) == parsed.end() && !VECTOR_EXISTS(to_parse, entry))
+			to_parse.push_back(entry);
+
+	while (!to_parse.empty())
+	{
+		// Get entry data (entries can only be accessed on this thread)
+		vector<ParseJob> jobs(to_parse.size());
+		for (unsigned a = 0; a < to_parse.size(); a++)
+		{
+			jobs[a].entry = to_parse[a];
+			to_parse[a]->shareData(jobs[a].data);
+		}
+
+		// Parse entries (or read them from the cache)
+		app::threadPool().parallelFor(
+			jobs.size(),
+			[&](size_t index)
+			{
+				auto& job  = jobs[index];
+				job.result = create();
+
+				if (cache)
+				{
+					job.hash = misc::contentHash(std::as_const(job.data).data(), job.data.size());
+
+					MemChunk cached;
+					if (cache->get(job.hash, job.data.size(), cached))
+					{
+						DefinitionCache::Reader reader(cached);
+						if (job.result->read(reader, job.entry))
+						{
+							job.cached = true;
+							return;
+						}
+
+						job.result = create();
+					}
+				}
+
+				job.result->parse(job.data, job.entry);
+			},
+			1);
+
+		// Update cache
+		if (cache)
+		{
+			for (auto& job : jobs)
+			{
+				if (job.cached)
+					cache->keep(job.hash, job.data.size());
+				else
+				{
+					DefinitionCache::Writer writer;
+					job.result->write(writer);
+					cache->put(job.hash, job.data.size(), writer.data());
+				}
+			}
+		}
+
+		// Add results
+		for (auto& job : jobs)
+			parsed[job.entry] = std::move(job.result);
+
+		// Resolve #includes, any not yet parsed will be parsed next
+		to_parse.clear();
+		for (auto& job : jobs)
+		{
+			auto& result = *parsed[job.entry];
+			result.include_entries.clear();
+			for (const auto& include : result.includes)
+			{
+				auto inc_entry = job.entry->relativeEntry(include.path);
+				result.include_entries.push_back(inc_entry);
+
+				// Check #include path could be resolved
+				if (!inc_entry)
+				{
+					log::warning(
+						"Warning parsing {} entry {}: Unable to find #included entry \"{}\" at line {}, skipping",
+						type_name,
+						job.entry->name(),
+						include.path,
+						include.line);
+				}
+				else if (parsed.find(inc_entry) == parsed.end() && !VECTOR_EXISTS(to_parse, inc_entry))
+					to_parse.push_back(inc_entry);
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Calls [func] for each parsed item in [root] and the entries it #includes
+// (recursively), in the order they appear, ie. as if all #includes were
+// replaced with the contents of the included entry. Circular #includes are
+// skipped. Stops and returns false if [func] returns false.
+// [parsed] must contain the results of parseDefinitionEntries for [root]
+// -----------------------------------------------------------------------------
+bool game::forEachParsedItem(
+	ParsedEntries&        parsed,
+	ArchiveEntry*         root,
+	const ParsedItemFunc& func,
+	string_view           type_name)
+{
+	vector<ArchiveEntry*> entry_stack;
+
+	std::function<bool(ArchiveEntry*)> process_entry = [&](ArchiveEntry* entry)
+	{
+		auto i = parsed.find(entry);
+		if (i == parsed.end())
+			return true;
+
+		auto& result = *i->second;
+		entry_stack.push_back(entry);
+
+		unsigned include = 0;
+		for (unsigned item = 0; item <= result.itemCount(); item++)
+		{
+			// Process any #includes before this item
+			for (; include < result.includes.size() && result.includes[include].position <= item; include++)
+			{
+				auto inc_entry = include < result.include_entries.size() ? result.include_entries[include] :
+																		   nullptr;
+				if (!inc_entry)
+					continue;
+
+				if (VECTOR_EXISTS(entry_stack, inc_entry))
+				{
+					log::warning(
+						"Warning parsing {} entry {}: Detected circular #include \"{}\" on line {}, skipping",
+						type_name,
+						entry->name(),
+						result.includes[include].path,
+						result.includes[include].line);
+					continue;
+				}
+
+				if (!process_entry(inc_entry))
+				{
+					entry_stack.pop_back();
+					return false;
+				}
+			}
+
+			// Process item
+			if (item < result.itemCount() && !func(result, item))
+			{
+				entry_stack.pop_back();
+				return false;
+			}
+		}
+
+		entry_stack.pop_back();
+		return true;
+	};
+
+	return process_entry(root);
+}
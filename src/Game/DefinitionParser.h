@@ -0,0 +1,119 @@
+#pragma once
+
+namespace slade
+{
+class Archive;
+class ArchiveEntry;
+
+namespace game
+{
+	// A persistent cache of parsed definition entries (DECORATE, ZScript etc.)
+	// from an archive, keyed by entry content hash so that unchanged entries
+	// don't need to be parsed again the next time the archive is opened
+	class DefinitionCache
+	{
+	public:
+		DefinitionCache(string_view type, uint32_t version, string_view archive_path);
+		~DefinitionCache() = default;
+
+		bool get(uint64_t hash, uint32_t size, MemChunk& data) const;
+		void keep(uint64_t hash, uint32_t size);
+		void put(uint64_t hash, uint32_t size, string_view data);
+		bool save();
+
+		static unique_ptr<DefinitionCache> forArchive(string_view type, uint32_t version, const Archive* archive);
+
+		// Simple binary writer/reader for cached data
+		class Writer
+		{
+		public:
+			const string& data() const { return data_; }
+
+			void write(uint32_t value) { data_.append(reinterpret_cast<const char*>(&value), 4); }
+			void write(string_view str)
+			{
+				write(static_cast<uint32_t>(str.size()));
+				data_.append(str);
+			}
+
+		private:
+			string data_;
+		};
+
+		class Reader
+		{
+		public:
+			Reader(const MemChunk& mc) : data_{ mc.data() }, size_{ mc.size() } {}
+
+			bool read(uint32_t& value);
+			bool read(string& str);
+
+		private:
+			const uint8_t* data_;
+			uint32_t       size_;
+			uint32_t       pos_ = 0;
+		};
+
+	private:
+		typedef std::pair<uint64_t, uint32_t> Key; // Hash, entry size
+
+		struct Item
+		{
+			MemChunk data;
+			bool     used = false;
+		};
+
+		string                          path_;
+		uint32_t                        version_ = 0;
+		std::map<Key, unique_ptr<Item>> items_;
+		bool                            modified_ = false;
+
+		bool load();
+	};
+
+	// An #include directive in a parsed definitions entry
+	struct ParsedInclude
+	{
+		string   path;
+		unsigned line     = 0;
+		unsigned position = 0; // Index of the parsed item the #include comes before
+	};
+
+	// The parsed contents of a single definitions entry, not including the
+	// contents of any entries it #includes
+	class ParsedEntry
+	{
+	public:
+		ParsedEntry()          = default;
+		virtual ~ParsedEntry() = default;
+
+		vector<ParsedInclude> includes;
+		vector<ArchiveEntry*> include_entries; // Resolved entry for each #include (or nullptr)
+
+		virtual unsigned itemCount() const                                          = 0;
+		virtual bool     parse(const MemChunk& data, ArchiveEntry* entry)           = 0;
+		virtual void     write(DefinitionCache::Writer& writer) const               = 0;
+		virtual bool     read(DefinitionCache::Reader& reader, ArchiveEntry* entry) = 0;
+
+	protected:
+		void writeIncludes(DefinitionCache::Writer& writer) const;
+		bool readIncludes(DefinitionCache::Reader& reader);
+	};
+
+	typedef std::map<ArchiveEntry*, unique_ptr<ParsedEntry>> ParsedEntries;
+	typedef std::function<unique_ptr<ParsedEntry>()>         ParsedEntryFactory;
+	typedef std::function<bool(ParsedEntry&, unsigned)>      ParsedItemFunc;
+
+	void parseDefinitionEntries(
+		const vector<ArchiveEntry*>& roots,
+		const ParsedEntryFactory&    create,
+		DefinitionCache*             cache,
+		ParsedEntries&               parsed,
+		string_view                  type_name);
+	bool forEachParsedItem(
+		ParsedEntries&        parsed,
+		ArchiveEntry*         root,
+		const ParsedItemFunc& func,
+		string_view           type_name);
+} // namespace game
+} // namespace slade
@@ -34,6 +34,7 @@
 #include "App.h"
 #include "Archive/Archive.h"
 #include "Archive/ArchiveManager.h"
+#include "DefinitionParser.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
 
@@ -64,6 +65,21 @@ bool dump_parsed_states    = false;
 bool dump_parsed_functions = false;
 
 string db_comment = "//$";
+
+// Increase this if the ZScriptEntry cache format changes
+const uint32_t zscript_cache_version = 1;
+
+// The statements/blocks parsed from a single ZScript entry
+class ZScriptEntry : public game::ParsedEntry
+{
+public:
+	vector<ParsedStatement> statements;
+
+	unsigned itemCount() const override { return statements.size(); }
+	bool     parse(const MemChunk& data, ArchiveEntry* entry) override;
+	void     write(game::DefinitionCache::Writer& writer) const override;
+	bool     read(game::DefinitionCache::Reader& reader, ArchiveEntry* entry) override;
+};
 } // namespace slade::zscript
 
 
@@ -186,17 +202,20 @@ bool checkKeywordValueStatement(const vector<string>& tokens, unsigned index, st
 }
 
 // -----------------------------------------------------------------------------
-// Parses all statements/blocks in [entry], adding them to [parsed]
+// Parses all statements/blocks in [data], adding them to [parsed].
+// Any #include directives are added to [includes] rather than parsed
 // -----------------------------------------------------------------------------
-void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed, vector<ArchiveEntry*>& entry_stack)
+void parseBlocks(
+	const MemChunk&              data,
+	ArchiveEntry*                entry,
+	vector<ParsedStatement>&     parsed,
+	vector<game::ParsedInclude>& includes)
 {
 	Tokenizer tz;
 	tz.setSpecialCharacters(Tokenizer::DEFAULT_SPECIAL_CHARACTERS + "()+-[]&!?.");
 	tz.enableDecorate(true);
 	tz.setCommentTypes(Tokenizer::CommentTypes::CPPStyle | Tokenizer::CommentTypes::CStyle);
-	tz.openMem(entry->data(), "ZScript");
-
-	entry_stack.push_back(entry);
+	tz.openMem(data, "ZScript");
 
 	while (!tz.atEnd())
 	{
@@ -205,29 +224,11 @@ void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed, vector<Ar
 		{
 			if (tz.checkNC("#include"))
 			{
-				auto inc_entry = entry->relativeEntry(tz.next().text);
-
-				// Check #include path could be resolved
-				if (!inc_entry)
-				{
-					log::warning(
-						"Warning parsing ZScript entry {}: "
-						"Unable to find #included entry \"{}\" at line {}, skipping",
-						entry->name(),
-						tz.current().text,
-						tz.current().line_no);
-				}
-				else if (VECTOR_EXISTS(entry_stack, inc_entry))
-				{
-					log::warning(
-						"Warning parsing ZScript entry {}: "
-						"Detected circular #include \"{}\" on line {}, skipping",
-						entry->name(),
-						tz.current().text,
-						tz.current().line_no);
-				}
-				else
-					parseBlocks(inc_entry, parsed, entry_stack);
+				game::ParsedInclude include;
+				include.path     = tz.next().text;
+				include.line     = tz.current().line_no;
+				include.position = parsed.size();
+				includes.push_back(include);
 			}
 
 			tz.advToNextLine();
@@ -247,12 +248,67 @@ void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed, vector<Ar
 		if (!parsed.back().parse(tz))
 			parsed.pop_back();
 	}
+}
+
+// -----------------------------------------------------------------------------
+// Parses the ZScript [entries] and any entries they #include (concurrently),
+// adding the results to [parsed]
+// -----------------------------------------------------------------------------
+void parseEntries(const vector<ArchiveEntry*>& entries, game::ParsedEntries& parsed)
+{
+	if (entries.empty())
+		return;
+
+	auto cache = game::DefinitionCache::forArchive("zscript", zscript_cache_version, entries[0]->parent());
+	game::parseDefinitionEntries(
+		entries, []() { return std::make_unique<ZScriptEntry>(); }, cache.get(), parsed, "ZScript");
+	if (cache)
+		cache->save();
+
+	// Set entry types
+	for (auto& parsed_entry : parsed)
+		if (etype_zscript && parsed_entry.first->type() != etype_zscript)
+			parsed_entry.first->setType(etype_zscript);
+}
 
-	// Set entry type
-	if (etype_zscript && entry->type() != etype_zscript)
-		entry->setType(etype_zscript);
+// -----------------------------------------------------------------------------
+// Writes [statement] (and its block) to [writer]
+// -----------------------------------------------------------------------------
+void writeStatement(game::DefinitionCache::Writer& writer, const ParsedStatement& statement)
+{
+	writer.write(statement.line);
+	writer.write(static_cast<uint32_t>(statement.tokens.size()));
+	for (const auto& token : statement.tokens)
+		writer.write(token);
+	writer.write(static_cast<uint32_t>(statement.block.size()));
+	for (const auto& child : statement.block)
+		writeStatement(writer, child);
+}
+
+// -----------------------------------------------------------------------------
+// Reads a statement written by writeStatement from [reader] into [statement]
+// -----------------------------------------------------------------------------
+bool readStatement(game::DefinitionCache::Reader& reader, ParsedStatement& statement, ArchiveEntry* entry)
+{
+	uint32_t count;
+	statement.entry = entry;
+	if (!reader.read(statement.line) || !reader.read(count))
+		return false;
+
+	statement.tokens.resize(count);
+	for (auto& token : statement.tokens)
+		if (!reader.read(token))
+			return false;
+
+	if (!reader.read(count))
+		return false;
+
+	statement.block.resize(count);
+	for (auto& child : statement.block)
+		if (!readStatement(reader, child, entry))
+			return false;
 
-	entry_stack.pop_back();
+	return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -948,76 +1004,27 @@ void Definitions::clear()
 }
 
 // -----------------------------------------------------------------------------
-// Parses ZScript in [entry]
+// Parses ZScript in [entry] (and any entries it #includes)
 // -----------------------------------------------------------------------------
 bool Definitions::parseZScript(ArchiveEntry* entry)
 {
 	// Parse into tree of expressions and blocks
-	auto                    start = app::runTimer();
-	vector<ParsedStatement> parsed;
-	vector<ArchiveEntry*>   entry_stack;
-	parseBlocks(entry, parsed, entry_stack);
+	auto                start = app::runTimer();
+	game::ParsedEntries parsed;
+	parseEntries({ entry }, parsed);
 	log::debug(2, "parseBlocks: {}ms", app::runTimer() - start);
 	start = app::runTimer();
 
-	for (auto& block : parsed)
-	{
-		if (block.tokens.empty())
-			continue;
-
-		if (dump_parsed_blocks)
-			block.dump();
-
-		// Class
-		if (strutil::equalCI(block.tokens[0], "class"))
-		{
-			Class nc(Class::Type::Class);
-
-			if (!nc.parse(block, classes_))
-				return false;
-
-			classes_.push_back(nc);
-		}
-
-		// Struct
-		else if (strutil::equalCI(block.tokens[0], "struct"))
-		{
-			Class nc(Class::Type::Struct);
-
-			if (!nc.parse(block, classes_))
-				return false;
-
-			classes_.push_back(nc);
-		}
-
-		// Extend Class
-		else if (
-			block.tokens.size() > 2 && strutil::equalCI(block.tokens[0], "extend")
-			&& strutil::equalCI(block.tokens[1], "class"))
-		{
-			for (auto& c : classes_)
-				if (strutil::equalCI(c.name(), block.tokens[2]))
-				{
-					c.extend(block);
-					break;
-				}
-		}
-
-		// Enum
-		else if (strutil::equalCI(block.tokens[0], "enum"))
-		{
-			Enumerator e;
-
-			if (!e.parse(block))
-				return false;
-
-			enumerators_.push_back(e);
-		}
-	}
+	auto ok = game::forEachParsedItem(
+		parsed,
+		entry,
+		[this](game::ParsedEntry& parsed_entry, unsigned index)
+		{ return parseStatement(static_cast<ZScriptEntry&>(parsed_entry).statements[index]); },
+		"ZScript");
 
 	log::debug(2, "ZScript: {}ms", app::runTimer() - start);
 
-	return true;
+	return ok;
 }
 
 // -----------------------------------------------------------------------------
@@ -1040,15 +1047,84 @@ bool Definitions::parseZScript(Archive* archive)
 	if (etype_zscript == EntryType::unknownType())
 		etype_zscript = nullptr;
 
-	// Parse ZScript entries
+	// Parse ZScript entries (and their #includes) concurrently
+	game::ParsedEntries parsed;
+	parseEntries(zscript_enries, parsed);
+
+	// Process parsed ZScript entries
 	bool ok = true;
 	for (auto entry : zscript_enries)
-		if (!parseZScript(entry))
+	{
+		auto parse_statement = [this](game::ParsedEntry& parsed_entry, unsigned index)
+		{ return parseStatement(static_cast<ZScriptEntry&>(parsed_entry).statements[index]); };
+
+		if (!game::forEachParsedItem(parsed, entry, parse_statement, "ZScript"))
 			ok = false;
+	}
 
 	return ok;
 }
 
+// -----------------------------------------------------------------------------
+// Processes the parsed top-level statement/block [block]
+// -----------------------------------------------------------------------------
+bool Definitions::parseStatement(ParsedStatement& block)
+{
+	if (block.tokens.empty())
+		return true;
+
+	if (dump_parsed_blocks)
+		block.dump();
+
+	// Class
+	if (strutil::equalCI(block.tokens[0], "class"))
+	{
+		Class nc(Class::Type::Class);
+
+		if (!nc.parse(block, classes_))
+			return false;
+
+		classes_.push_back(nc);
+	}
+
+	// Struct
+	else if (strutil::equalCI(block.tokens[0], "struct"))
+	{
+		Class nc(Class::Type::Struct);
+
+		if (!nc.parse(block, classes_))
+			return false;
+
+		classes_.push_back(nc);
+	}
+
+	// Extend Class
+	else if (
+		block.tokens.size() > 2 && strutil::equalCI(block.tokens[0], "extend")
+		&& strutil::equalCI(block.tokens[1], "class"))
+	{
+		for (auto& c : classes_)
+			if (strutil::equalCI(c.name(), block.tokens[2]))
+			{
+				c.extend(block);
+				break;
+			}
+	}
+
+	// Enum
+	else if (strutil::equalCI(block.tokens[0], "enum"))
+	{
+		Enumerator e;
+
+		if (!e.parse(block))
+			return false;
+
+		enumerators_.push_back(e);
+	}
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Exports all classes to ThingTypes in [types] and [parsed] (from a
 // Game::Configuration object)
@@ -1188,6 +1264,55 @@ void ParsedStatement::dump(int indent)
 }
 
 
+// -----------------------------------------------------------------------------
+//
+// ZScriptEntry Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Parses all statements/blocks in [data] (from [entry])
+// -----------------------------------------------------------------------------
+bool ZScriptEntry::parse(const MemChunk& data, ArchiveEntry* entry)
+{
+	parseBlocks(data, entry, statements, includes);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the parsed statements to [writer]
+// -----------------------------------------------------------------------------
+void ZScriptEntry::write(game::DefinitionCache::Writer& writer) const
+{
+	writeIncludes(writer);
+
+	writer.write(static_cast<uint32_t>(statements.size()));
+	for (const auto& statement : statements)
+		writeStatement(writer, statement);
+}
+
+// -----------------------------------------------------------------------------
+// Reads parsed statements written by ZScriptEntry::write from [reader]
+// -----------------------------------------------------------------------------
+bool ZScriptEntry::read(game::DefinitionCache::Reader& reader, ArchiveEntry* entry)
+{
+	if (!readIncludes(reader))
+		return false;
+
+	uint32_t count;
+	if (!reader.read(count))
+		return false;
+
+	statements.resize(count);
+	for (auto& statement : statements)
+		if (!readStatement(reader, statement, entry))
+			return false;
+
+	return true;
+}
+
+
 
 
 
@@ -1243,13 +1368,15 @@ CONSOLE_COMMAND(test_parseblocks, 1, false)
 	if (!entry)
 		return;
 
-	auto                    start = app::runTimer();
-	vector<ParsedStatement> parsed;
-	vector<ArchiveEntry*>   entry_stack;
+	auto                        start = app::runTimer();
+	auto&                       data  = entry->data();
+	vector<ParsedStatement>     parsed;
+	vector<game::ParsedInclude> includes;
 	for (auto a = 0; a < num; ++a)
 	{
-		parseBlocks(entry, parsed, entry_stack);
+		parseBlocks(data, entry, parsed, includes);
 		parsed.clear();
+		includes.clear();
 	}
 	log::console(fmt::format("Took {}ms", app::runTimer() - start));
 }
@@ -196,6 +196,8 @@ namespace zscript
 		vector<Enumerator> enumerators_;
 		vector<Variable>   variables_;
 		vector<Function>   functions_; // needed? dunno if global functions are a thing
+
+		bool parseStatement(ParsedStatement& block);
 	};
 } // namespace zscript
 } // namespace slade
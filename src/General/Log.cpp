@@ -34,6 +34,8 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fstream>
+#include <iostream>
+#include <mutex>
 
 using namespace slade;
 
@@ -47,6 +49,7 @@ namespace slade::log
 {
 vector<Message> log;
 std::ofstream   log_file;
+std::mutex      log_mutex; // Messages can be logged from worker threads
 } // namespace slade::log
 CVAR(Int, log_verbosity, 1, CVar::Flag::Save)
 
@@ -158,11 +161,26 @@ void log::init()
 }
 
 // -----------------------------------------------------------------------------
-// Returns the log message history
+// Returns a copy of the log message history, starting from message [start].
+// (messages can be logged from worker threads, so the history can't be
+// accessed directly)
 // -----------------------------------------------------------------------------
-const vector<log::Message>& log::history()
+vector<log::Message> log::history(size_t start)
 {
-	return log;
+	std::lock_guard<std::mutex> lock(log_mutex);
+	if (start >= log.size())
+		return {};
+
+	return vector<Message>(log.begin() + start, log.end());
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of messages in the log message history
+// -----------------------------------------------------------------------------
+size_t log::historySize()
+{
+	std::lock_guard<std::mutex> lock(log_mutex);
+	return log.size();
 }
 
 // -----------------------------------------------------------------------------
@@ -188,12 +206,17 @@ void log::setVerbosity(int verbosity)
 void log::message(MessageType type, string_view text)
 {
 	// Add log message
-	auto t = std::time(nullptr);
+	std::lock_guard<std::mutex> lock(log_mutex);
+	auto                        t = std::time(nullptr);
 	log.emplace_back(text, type, *std::localtime(&t));
 
 	// Write to log file
 	if (log_file.is_open() && type != MessageType::Console)
 		sf::err() << log.back().formattedMessageLine() << "\n";
+
+	// Echo to stdout in batch mode, since there is no console window
+	if (app::isBatchMode() && type != MessageType::Console)
+		std::cout << log.back().formattedMessageLine() << std::endl;
 }
 
 void log::message(MessageType type, int level, string_view text, fmt::format_args args)
@@ -209,12 +232,13 @@ void log::message(MessageType type, string_view text, fmt::format_args args)
 // -----------------------------------------------------------------------------
 // Returns a list of log messages of [type] that have been recorded since [time]
 // -----------------------------------------------------------------------------
-vector<log::Message*> log::since(time_t time, MessageType type)
+vector<log::Message> log::since(time_t time, MessageType type)
 {
-	vector<Message*> list;
+	std::lock_guard<std::mutex> lock(log_mutex);
+	vector<Message>             list;
 	for (auto& msg : log)
 		if (mktime(&msg.timestamp) >= time && (type == MessageType::Any || msg.type == type))
-			list.push_back(&msg);
+			list.push_back(msg);
 	return list;
 }
 
@@ -257,10 +281,15 @@ void log::message(MessageType type, int level, string_view text)
 		return;
 
 	// Add log message
-	auto t = std::time(nullptr);
+	std::lock_guard<std::mutex> lock(log_mutex);
+	auto                        t = std::time(nullptr);
 	log.emplace_back(text, type, *std::localtime(&t));
 
 	// Write to log file
 	if (log_file.is_open() && type != MessageType::Console)
 		sf::err() << log.back().formattedMessageLine() << "\n";
+
+	// Echo to stdout in batch mode, since there is no console window
+	if (app::isBatchMode() && type != MessageType::Console)
+		std::cout << log.back().formattedMessageLine() << std::endl;
 }
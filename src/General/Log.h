@@ -29,15 +29,16 @@ namespace log
 		string formattedMessageLine() const;
 	};
 
-	const vector<Message>& history();
-	int                    verbosity();
-	void                   setVerbosity(int verbosity);
-	void                   init();
-	void                   message(MessageType type, int level, string_view text);
-	void                   message(MessageType type, string_view text);
-	void                   message(MessageType type, int level, string_view text, fmt::format_args args);
-	void                   message(MessageType type, string_view text, fmt::format_args args);
-	vector<Message*>       since(time_t time, MessageType type = MessageType::Any);
+	vector<Message> history(size_t start = 0);
+	size_t          historySize();
+	int             verbosity();
+	void            setVerbosity(int verbosity);
+	void            init();
+	void            message(MessageType type, int level, string_view text);
+	void            message(MessageType type, string_view text);
+	void            message(MessageType type, int level, string_view text, fmt::format_args args);
+	void            message(MessageType type, string_view text, fmt::format_args args);
+	vector<Message> since(time_t time, MessageType type = MessageType::Any);
 
 
 	// Message shortcuts by type
@@ -506,6 +506,116 @@ uint32_t misc::crc(const uint8_t* buf, uint32_t len)
 }
 
 
+// 64-bit content hash (XXH64)
+
+namespace
+{
+const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t xxhRotl(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t xxhRead64(const uint8_t* buf)
+{
+	uint64_t value = 0;
+	for (int a = 7; a >= 0; a--)
+		value = (value << 8) | buf[a];
+	return value;
+}
+
+uint32_t xxhRead32(const uint8_t* buf)
+{
+	return buf[0] | (buf[1] << 8) | (buf[2] << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+}
+
+uint64_t xxhRound(uint64_t acc, uint64_t input)
+{
+	acc += input * XXH_PRIME64_2;
+	acc = xxhRotl(acc, 31);
+	return acc * XXH_PRIME64_1;
+}
+
+uint64_t xxhMergeRound(uint64_t acc, uint64_t value)
+{
+	acc ^= xxhRound(0, value);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Returns a 64-bit hash of the bytes in [buf] (of [len] bytes), suitable for
+// identifying data by its content. This is XXH64 (with a seed of 0)
+// -----------------------------------------------------------------------------
+uint64_t misc::contentHash(const uint8_t* buf, uint32_t len)
+{
+	auto     end = buf + len;
+	uint64_t hash;
+
+	if (len >= 32)
+	{
+		uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = XXH_PRIME64_2;
+		uint64_t v3 = 0;
+		uint64_t v4 = 0 - XXH_PRIME64_1;
+
+		auto limit = end - 32;
+		do
+		{
+			v1 = xxhRound(v1, xxhRead64(buf));
+			v2 = xxhRound(v2, xxhRead64(buf + 8));
+			v3 = xxhRound(v3, xxhRead64(buf + 16));
+			v4 = xxhRound(v4, xxhRead64(buf + 24));
+			buf += 32;
+		} while (buf <= limit);
+
+		hash = xxhRotl(v1, 1) + xxhRotl(v2, 7) + xxhRotl(v3, 12) + xxhRotl(v4, 18);
+		hash = xxhMergeRound(hash, v1);
+		hash = xxhMergeRound(hash, v2);
+		hash = xxhMergeRound(hash, v3);
+		hash = xxhMergeRound(hash, v4);
+	}
+	else
+		hash = XXH_PRIME64_5;
+
+	hash += len;
+
+	// Remaining bytes
+	while (buf + 8 <= end)
+	{
+		hash ^= xxhRound(0, xxhRead64(buf));
+		hash = xxhRotl(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		buf += 8;
+	}
+	if (buf + 4 <= end)
+	{
+		hash ^= static_cast<uint64_t>(xxhRead32(buf)) * XXH_PRIME64_1;
+		hash = xxhRotl(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		buf += 4;
+	}
+	while (buf < end)
+	{
+		hash ^= (*buf) * XXH_PRIME64_5;
+		hash = xxhRotl(hash, 11) * XXH_PRIME64_1;
+		buf++;
+	}
+
+	// Avalanche
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+
 // -----------------------------------------------------------------------------
 // Find the given name in a texture lump and returns a point2_t which contains
 // the dimensions.
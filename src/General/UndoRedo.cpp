@@ -31,6 +31,8 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "General/UndoRedo.h"
+#include "App.h"
+#include "Utility/FileUtils.h"
 
 using namespace slade;
 
@@ -40,9 +42,39 @@ using namespace slade;
 // Variables
 //
 // -----------------------------------------------------------------------------
+CVAR(Int, undo_memory_budget, 256, CVar::Flag::Save) // MB, 0 = unlimited
 namespace
 {
-UndoManager* current_undo_manager = nullptr;
+UndoManager*         current_undo_manager = nullptr;
+vector<UndoManager*> all_undo_managers;
+unsigned             next_spill_file = 0;
+uint64_t             total_mem_usage = 0; // Memory used by all undo levels in all undo managers
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Reads the next size-prefixed undo step data from [mc] into [step_data]
+// -----------------------------------------------------------------------------
+bool readStepData(MemChunk& mc, MemChunk& step_data)
+{
+	uint32_t size = 0;
+	if (!mc.read(&size, 4) || mc.currentPos() + size > mc.size())
+		return false;
+
+	step_data.clear();
+	if (size > 0)
+		step_data.importMem(mc.data() + mc.currentPos(), size);
+	mc.seek(size);
+
+	return true;
+}
 } // namespace
 
 
@@ -58,6 +90,18 @@ UndoManager* current_undo_manager = nullptr;
 // -----------------------------------------------------------------------------
 UndoLevel::UndoLevel(string_view name) : name_{ name }, timestamp_{ wxDateTime::Now() } {}
 
+// -----------------------------------------------------------------------------
+// UndoLevel class destructor
+// -----------------------------------------------------------------------------
+UndoLevel::~UndoLevel()
+{
+	// Remove temp file if spilled
+	if (spilled())
+		fileutil::removeFile(spill_file_);
+
+	total_mem_usage -= mem_usage_;
+}
+
 // -----------------------------------------------------------------------------
 // Returns a string representation of the time at which the undo level was
 // recorded
@@ -78,6 +122,9 @@ string UndoLevel::timeStamp(bool date, bool time) const
 bool UndoLevel::doUndo()
 {
 	log::info(3, "Performing undo \"{}\" ({} steps)", name_, undo_steps_.size());
+	if (spilled() && !readFile())
+		return false;
+
 	bool ok = true;
 	for (int a = (int)undo_steps_.size() - 1; a >= 0; a--)
 	{
@@ -85,6 +132,9 @@ bool UndoLevel::doUndo()
 			ok = false;
 	}
 
+	// Steps swap their data with the current state, so the usage can change
+	updateMemUsage();
+
 	return ok;
 }
 
@@ -94,6 +144,9 @@ bool UndoLevel::doUndo()
 bool UndoLevel::doRedo()
 {
 	log::info(3, "Performing redo \"{}\" ({} steps)", name_, undo_steps_.size());
+	if (spilled() && !readFile())
+		return false;
+
 	bool ok = true;
 	for (auto& undo_step : undo_steps_)
 	{
@@ -101,22 +154,101 @@ bool UndoLevel::doRedo()
 			ok = false;
 	}
 
+	updateMemUsage();
+
 	return ok;
 }
 
 // -----------------------------------------------------------------------------
-// Reads the undo level from a file
+// Notifies all undo steps in this level that it has finished recording
 // -----------------------------------------------------------------------------
-bool UndoLevel::readFile(string_view filename) const
+void UndoLevel::recordEnded()
 {
+	for (auto& undo_step : undo_steps_)
+		undo_step->recordEnded();
+
+	updateMemUsage();
+}
+
+// -----------------------------------------------------------------------------
+// Writes the data of all undo steps in this level to [filename], freeing it
+// from memory until it is read back via readFile. Returns false if nothing was
+// written (no steps in the level support it, or there was an error)
+// -----------------------------------------------------------------------------
+bool UndoLevel::writeFile(string_view filename)
+{
+	if (spilled())
+		return true;
+
+	// Write each step's data, prefixed with its size
+	MemChunk mc;
+	MemChunk step_data;
+	unsigned written   = 0;
+	uint64_t data_size = 0;
+	for (auto& undo_step : undo_steps_)
+	{
+		step_data.clear();
+		if (!undo_step->writeFile(step_data))
+			break;
+
+		uint32_t size = step_data.size();
+		mc.write(&size, 4);
+		if (size > 0)
+			mc.write(step_data.data(), size);
+		data_size += size;
+		++written;
+	}
+
+	// Nothing to do if none of the steps have data that can be written out
+	if (written == undo_steps_.size() && data_size == 0)
+		return false;
+
+	if (written < undo_steps_.size() || !mc.exportFile(filename))
+	{
+		// Give the steps that were written their data back
+		mc.seekFromStart(0);
+		for (unsigned a = 0; a < written; ++a)
+			if (readStepData(mc, step_data))
+				undo_steps_[a]->readFile(step_data);
+
+		log::error("Unable to write undo level \"{}\" to {}", name_, filename);
+		return false;
+	}
+
+	spill_file_ = filename;
+	updateMemUsage();
 	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Writes the undo level to a file
+// Reads the data of all undo steps in this level back from the file it was
+// written to via writeFile
 // -----------------------------------------------------------------------------
-bool UndoLevel::writeFile(string_view filename) const
+bool UndoLevel::readFile()
 {
+	if (!spilled())
+		return true;
+
+	MemChunk mc;
+	if (!mc.importFile(spill_file_))
+	{
+		log::error("Unable to read undo level \"{}\" from {}", name_, spill_file_);
+		return false;
+	}
+
+	MemChunk step_data;
+	for (auto& undo_step : undo_steps_)
+	{
+		if (!readStepData(mc, step_data) || !undo_step->readFile(step_data))
+		{
+			log::error("Undo level \"{}\" data in {} is invalid", name_, spill_file_);
+			return false;
+		}
+	}
+
+	fileutil::removeFile(spill_file_);
+	spill_file_.clear();
+	updateMemUsage();
 	return true;
 }
 
@@ -127,13 +259,33 @@ void UndoLevel::createMerged(vector<unique_ptr<UndoLevel>>& levels)
 {
 	for (auto& level : levels)
 	{
+		level->readFile();
 		for (auto& undo_step : level->undo_steps_)
 		{
 			auto ptr = undo_step.release();
 			undo_steps_.emplace_back(ptr);
 		}
 		level->undo_steps_.clear();
+		level->updateMemUsage();
 	}
+
+	updateMemUsage();
+}
+
+// -----------------------------------------------------------------------------
+// Recalculates the approximate memory used by all undo steps in this level.
+// This can be slow for large levels, so is only done when the steps' data
+// changes (when recording ends, on undo/redo, or when the level is written out
+// or read back)
+// -----------------------------------------------------------------------------
+void UndoLevel::updateMemUsage()
+{
+	unsigned usage = 0;
+	for (const auto& undo_step : undo_steps_)
+		usage += undo_step->memUsage();
+
+	total_mem_usage = total_mem_usage - mem_usage_ + usage;
+	mem_usage_      = usage;
 }
 
 
@@ -144,6 +296,25 @@ void UndoLevel::createMerged(vector<unique_ptr<UndoLevel>>& levels)
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// UndoManager class constructor
+// -----------------------------------------------------------------------------
+UndoManager::UndoManager(SLADEMap* map) : map_{ map }
+{
+	all_undo_managers.push_back(this);
+}
+
+// -----------------------------------------------------------------------------
+// UndoManager class destructor
+// -----------------------------------------------------------------------------
+UndoManager::~UndoManager()
+{
+	if (current_undo_manager == this)
+		current_undo_manager = nullptr;
+
+	all_undo_managers.erase(std::remove(all_undo_managers.begin(), all_undo_managers.end(), this), all_undo_managers.end());
+}
+
 // -----------------------------------------------------------------------------
 // Begins 'recording' a new undo level
 // -----------------------------------------------------------------------------
@@ -191,6 +362,7 @@ void UndoManager::endRecord(bool success)
 
 	// Add current level to levels
 	// log::info(1, "Recording undo level \"%s\" succeeded", current_level->getName());
+	current_level_->recordEnded();
 	undo_levels_.push_back(std::move(current_level_));
 	current_level_.reset(nullptr);
 	current_level_index_ = undo_levels_.size() - 1;
@@ -198,6 +370,9 @@ void UndoManager::endRecord(bool success)
 	// Clear current undo manager
 	current_undo_manager = nullptr;
 
+	// Keep total undo memory within budget
+	undoredo::enforceMemoryBudget();
+
 	signals_.level_recorded();
 }
 
@@ -379,3 +554,39 @@ SLADEMap* undoredo::currentMap()
 	else
 		return nullptr;
 }
+
+// -----------------------------------------------------------------------------
+// If the memory used by all undo levels (across all undo managers) is over the
+// undo_memory_budget cvar, writes the oldest levels out to temp files until it
+// is within budget. Levels next to each manager's current position (the next
+// to be undone or redone) are always kept in memory
+// -----------------------------------------------------------------------------
+void undoredo::enforceMemoryBudget()
+{
+	uint64_t budget = static_cast<uint64_t>(undo_memory_budget) * 1024 * 1024;
+	if (undo_memory_budget <= 0 || total_mem_usage <= budget)
+		return;
+
+	// Get levels that can be written out
+	vector<UndoLevel*> levels;
+	for (auto manager : all_undo_managers)
+		for (unsigned a = 0; a < manager->nUndoLevels(); ++a)
+		{
+			auto level = manager->undoLevel(a);
+			int  index = a;
+			if (!level->spilled() && index != manager->currentIndex() && index != manager->currentIndex() + 1)
+				levels.push_back(level);
+		}
+
+	// Write out oldest levels first
+	std::stable_sort(levels.begin(), levels.end(), UndoLevel::olderThan);
+	for (auto level : levels)
+	{
+		if (total_mem_usage <= budget)
+			break;
+
+		level->writeFile(app::path(fmt::format("undo_{}.tmp", next_spill_file++), app::Dir::Temp));
+	}
+
+	log::info(2, "Undo memory usage over budget, now {}kb", total_mem_usage / 1024);
+}
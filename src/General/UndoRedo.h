@@ -10,39 +10,61 @@ public:
 
 	virtual bool doUndo() { return true; }
 	virtual bool doRedo() { return true; }
+
+	// Write the step's data to [mc] and free it from memory, or read it back
+	// (used to move older undo levels out of memory)
 	virtual bool writeFile(MemChunk& mc) { return true; }
 	virtual bool readFile(MemChunk& mc) { return true; }
+
 	virtual bool isOk() { return true; }
+
+	// Called when the undo level containing the step has finished recording
+	virtual void recordEnded() {}
+
+	// Approximate memory used by the step's undo data (in bytes)
+	virtual unsigned memUsage() const { return 0; }
 };
 
 class UndoLevel
 {
 public:
 	UndoLevel(string_view name);
-	~UndoLevel() = default;
+	~UndoLevel();
 
-	string name() const { return name_; }
-	bool   doUndo();
-	bool   doRedo();
-	void   addStep(unique_ptr<UndoStep> step) { undo_steps_.push_back(std::move(step)); }
-	string timeStamp(bool date, bool time) const;
+	string   name() const { return name_; }
+	bool     doUndo();
+	bool     doRedo();
+	void     addStep(unique_ptr<UndoStep> step) { undo_steps_.push_back(std::move(step)); }
+	string   timeStamp(bool date, bool time) const;
+	unsigned memUsage() const { return mem_usage_; }
+	bool     spilled() const { return !spill_file_.empty(); }
+	void     recordEnded();
 
-	bool writeFile(string_view filename) const;
-	bool readFile(string_view filename) const;
+	bool writeFile(string_view filename);
+	bool readFile();
 	void createMerged(vector<unique_ptr<UndoLevel>>& levels);
 
+	static bool olderThan(const UndoLevel* left, const UndoLevel* right)
+	{
+		return left->timestamp_.IsEarlierThan(right->timestamp_);
+	}
+
 private:
 	string                       name_;
 	vector<unique_ptr<UndoStep>> undo_steps_;
 	wxDateTime                   timestamp_;
+	string                       spill_file_;    // Temp file the step data was written to (if any)
+	unsigned                     mem_usage_ = 0; // Cached total of the steps' memUsage
+
+	void updateMemUsage();
 };
 
 class SLADEMap;
 class UndoManager
 {
 public:
-	UndoManager(SLADEMap* map = nullptr) : map_{ map } {}
-	~UndoManager() = default;
+	UndoManager(SLADEMap* map = nullptr);
+	~UndoManager();
 
 	SLADEMap*  map() const { return map_; }
 	void       putAllLevels(vector<string>& list);
@@ -86,5 +108,6 @@ namespace undoredo
 	bool         currentlyRecording();
 	UndoManager* currentManager();
 	SLADEMap*    currentMap();
+	void         enforceMemoryBudget();
 } // namespace undoredo
 } // namespace slade
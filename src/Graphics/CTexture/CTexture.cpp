@@ -812,6 +812,29 @@ bool CTexture::convertRegular()
 // [parent] primarily, and the palette [pal]
 // -----------------------------------------------------------------------------
 bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_rgba)
+{
+	return composeImage(
+		image,
+		[this, parent, pal](unsigned index, SImage& p_img)
+		{
+			if (extended_)
+				return loadPatchImage(index, p_img, parent, pal);
+			else
+				return misc::loadImageFromEntry(&p_img, patches_[index]->patchEntry(parent));
+		},
+		pal,
+		force_rgba);
+}
+
+// -----------------------------------------------------------------------------
+// Draws the texture to [image], getting the image for each patch from
+// [patch_image] (see toImage). If [force_rgba] is true, the image is converted
+// to RGBA.
+//
+// This doesn't access any resources itself, so it can be used on a copy of the
+// texture on another thread as long as [patch_image] doesn't either
+// -----------------------------------------------------------------------------
+bool CTexture::composeImage(SImage& image, const PatchImageFunc& patch_image, Palette* pal, bool force_rgba)
 {
 	// Init image
 	image.clear();
@@ -823,7 +846,7 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 	dp.src_alpha = false;
 	if (defined_)
 	{
-		if (!loadPatchImage(0, p_img, parent, pal))
+		if (!patch_image(0, p_img))
 			return false;
 		size_.x = p_img.width();
 		size_.y = p_img.height();
@@ -842,7 +865,7 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 			auto* patch = dynamic_cast<CTPatchEx*>(patches_[a].get());
 
 			// Load patch entry
-			if (!loadPatchImage(a, p_img, parent, pal))
+			if (!patch_image(a, p_img))
 				continue;
 
 			// Handle offsets
@@ -915,10 +938,10 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 		// Normal texture
 
 		// Add each patch to image
-		for (auto& patch : patches_)
+		for (unsigned a = 0; a < patches_.size(); a++)
 		{
-			if (misc::loadImageFromEntry(&p_img, patch->patchEntry(parent)))
-				image.drawImage(p_img, patch->xOffset(), patch->yOffset(), dp, pal, pal);
+			if (patch_image(a, p_img))
+				image.drawImage(p_img, patches_[a]->xOffset(), patches_[a]->yOffset(), dp, pal, pal);
 		}
 	}
 
@@ -926,59 +949,81 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 }
 
 // -----------------------------------------------------------------------------
-// Loads the image for the patch at [pindex] into [image].
-// Can deal with textures-as-patches
+// Returns the texture to use as the image for the patch at [pindex], if it is
+// a texture-as-patch (extended textures only), or nullptr otherwise
 // -----------------------------------------------------------------------------
-bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, Palette* pal)
+CTexture* CTexture::patchTexture(unsigned pindex, Archive* parent) const
 {
 	// Check patch index
 	if (pindex >= patches_.size())
-		return false;
+		return nullptr;
 
 	auto* patch = patches_[pindex].get();
 
-	// If the texture is extended, search for textures-as-patches first
+	// Only extended textures can use textures-as-patches
 	// (as long as the patch name is different from this texture's name)
-	if (extended_ && !(strutil::equalCI(patch->name(), name_)))
+	if (!extended_ || strutil::equalCI(patch->name(), name_))
+		return nullptr;
+
+	// Search the texture list we're in first
+	if (in_list_)
 	{
-		// Search the texture list we're in first
-		if (in_list_)
+		for (unsigned a = 0; a < in_list_->size(); a++)
 		{
-			for (unsigned a = 0; a < in_list_->size(); a++)
-			{
-				auto* tex = in_list_->texture(a);
+			auto* tex = in_list_->texture(a);
 
-				// Don't look past this texture in the list
-				if (tex->name() == name_)
-					break;
+			// Don't look past this texture in the list
+			if (tex->name() == name_)
+				break;
 
-				// Check for name match
-				if (strutil::equalCI(tex->name(), patch->name()))
-				{
-					// Load texture to image
-					return tex->toImage(image, parent, pal);
-				}
-			}
+			// Check for name match
+			if (strutil::equalCI(tex->name(), patch->name()))
+				return tex;
 		}
-
-		// Otherwise, try the resource manager
-		// TODO: Something has to be ignored here. The entire archive or just the current list?
-		auto* tex = app::resources().getTexture(patch->name(), "", parent);
-		if (tex)
-			return tex->toImage(image, parent, pal);
 	}
 
-	// Get patch entry
-	auto* entry = patch->patchEntry(parent);
+	// Otherwise, try the resource manager
+	// TODO: Something has to be ignored here. The entire archive or just the current list?
+	return app::resources().getTexture(patch->name(), "", parent);
+}
 
-	// Load entry to image if valid
-	if (entry)
-		return misc::loadImageFromEntry(&image, entry);
+// -----------------------------------------------------------------------------
+// Returns the entry to load the image for the patch at [pindex] from, or
+// nullptr if none was found. Doesn't check for textures-as-patches
+// (see patchTexture)
+// -----------------------------------------------------------------------------
+ArchiveEntry* CTexture::patchImageEntry(unsigned pindex, Archive* parent) const
+{
+	// Check patch index
+	if (pindex >= patches_.size())
+		return nullptr;
+
+	auto* patch = patches_[pindex].get();
+
+	// Get patch entry
+	if (auto* entry = patch->patchEntry(parent))
+		return entry;
 
 	// Maybe it's a texture?
-	entry = app::resources().getTextureEntry(patch->name(), "", parent);
+	return app::resources().getTextureEntry(patch->name(), "", parent);
+}
 
-	if (entry)
+// -----------------------------------------------------------------------------
+// Loads the image for the patch at [pindex] into [image].
+// Can deal with textures-as-patches
+// -----------------------------------------------------------------------------
+bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, Palette* pal)
+{
+	// Check patch index
+	if (pindex >= patches_.size())
+		return false;
+
+	// Load texture-as-patch to image if any
+	if (auto* tex = patchTexture(pindex, parent))
+		return tex->toImage(image, parent, pal);
+
+	// Otherwise load entry to image if valid
+	if (auto* entry = patchImageEntry(pindex, parent))
 		return misc::loadImageFromEntry(&image, entry);
 
 	return false;
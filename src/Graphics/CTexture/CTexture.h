@@ -175,8 +175,15 @@ public:
 
 	bool convertExtended();
 	bool convertRegular();
-	bool loadPatchImage(unsigned pindex, SImage& image, Archive* parent = nullptr, Palette* pal = nullptr);
-	bool toImage(SImage& image, Archive* parent = nullptr, Palette* pal = nullptr, bool force_rgba = false);
+	CTexture*     patchTexture(unsigned pindex, Archive* parent = nullptr) const;
+	ArchiveEntry* patchImageEntry(unsigned pindex, Archive* parent = nullptr) const;
+	bool          loadPatchImage(unsigned pindex, SImage& image, Archive* parent = nullptr, Palette* pal = nullptr);
+	bool          toImage(SImage& image, Archive* parent = nullptr, Palette* pal = nullptr, bool force_rgba = false);
+
+	// Composites the texture using [patch_image] to get the image for each patch
+	// (by index), rather than looking up patches in resources
+	typedef std::function<bool(unsigned, SImage&)> PatchImageFunc;
+	bool composeImage(SImage& image, const PatchImageFunc& patch_image, Palette* pal = nullptr, bool force_rgba = false);
 
 	// Signals
 	struct Signals
@@ -37,6 +37,7 @@
 #include "Utility/CIEDeltaEquations.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
+#include <array>
 
 using namespace slade;
 
@@ -56,6 +57,105 @@ CVAR(Float, col_match_l, 1.0, CVar::Flag::Save)
 EXTERN_CVAR(Float, col_greyscale_r)
 EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
+EXTERN_CVAR(Float, col_cie_kl)
+EXTERN_CVAR(Float, col_cie_k1)
+EXTERN_CVAR(Float, col_cie_k2)
+EXTERN_CVAR(Float, col_cie_kc)
+EXTERN_CVAR(Float, col_cie_kh)
+EXTERN_CVAR(Float, col_cie_tristim_x)
+EXTERN_CVAR(Float, col_cie_tristim_z)
+
+
+// -----------------------------------------------------------------------------
+//
+// Palette::MatchCache Struct
+//
+// -----------------------------------------------------------------------------
+
+// Caches nearestColour results for each colour matching method.
+//
+// Results are stored in a lookup table covering the full RGB cube, split into
+// blocks of 8x8x8 colours that are only allocated when a colour within them is
+// looked up. For the RGB-based methods each block also keeps a list of the
+// only palette colours that can possibly be nearest to any colour within it,
+// so a lookup that isn't cached yet only has to check a handful of colours.
+//
+// Each table also records the colour matching settings (cvars) it was filled
+// with, and is cleared if they change
+struct Palette::MatchCache
+{
+	static constexpr unsigned block_bits  = 3;
+	static constexpr unsigned block_size  = 1 << block_bits;
+	static constexpr unsigned grid_size   = 256 / block_size;
+	static constexpr unsigned num_methods = 6; // Old, RGB, HSL, C76, C94, C2K
+
+	using Settings = std::array<double, 7>;
+
+	struct Block
+	{
+		std::array<short, block_size * block_size * block_size> nearest;
+		vector<short>                                           candidates; // Empty = all colours
+	};
+
+	struct Table
+	{
+		Settings                  settings{};
+		vector<unique_ptr<Block>> blocks;
+	};
+
+	std::array<Table, num_methods> tables;
+};
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Be nice if there was an easier way to convert from int -> enum class,
+// but then that's kind of the point of them I guess
+vector<Palette::ColourMatch> cm_convert = {
+	Palette::ColourMatch::Default, Palette::ColourMatch::Old, Palette::ColourMatch::RGB,
+	Palette::ColourMatch::HSL,     Palette::ColourMatch::C76, Palette::ColourMatch::C94,
+	Palette::ColourMatch::C2K,     Palette::ColourMatch::Stop,
+};
+
+// -----------------------------------------------------------------------------
+// Returns the MatchCache table index for colour matching method [match]
+// -----------------------------------------------------------------------------
+unsigned matchCacheTable(Palette::ColourMatch match)
+{
+	switch (match)
+	{
+	case Palette::ColourMatch::RGB: return 1;
+	case Palette::ColourMatch::HSL: return 2;
+	case Palette::ColourMatch::C76: return 3;
+	case Palette::ColourMatch::C94: return 4;
+	case Palette::ColourMatch::C2K: return 5;
+	default: return 0; // Anything else is handled as 'Old' by Palette::colourDiff
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the current values of the settings that affect colour matching
+// method [match]
+// -----------------------------------------------------------------------------
+std::array<double, 7> colourMatchSettings(Palette::ColourMatch match)
+{
+	switch (match)
+	{
+	case Palette::ColourMatch::RGB: return { col_match_r, col_match_g, col_match_b };
+	case Palette::ColourMatch::HSL: return { col_match_h, col_match_s, col_match_l };
+	case Palette::ColourMatch::C76: return { col_cie_tristim_x, col_cie_tristim_z };
+	case Palette::ColourMatch::C94:
+	case Palette::ColourMatch::C2K:
+		return { col_cie_tristim_x, col_cie_tristim_z, col_cie_kl, col_cie_k1, col_cie_k2, col_cie_kc, col_cie_kh };
+	default: return {};
+	}
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -80,6 +180,28 @@ Palette::Palette(unsigned size) : colours_{ size }, colours_hsl_{ size }, colour
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Palette class destructor
+// -----------------------------------------------------------------------------
+Palette::~Palette() = default;
+
+// -----------------------------------------------------------------------------
+// Palette assignment operator
+// -----------------------------------------------------------------------------
+Palette& Palette::operator=(const Palette& pal)
+{
+	if (&pal == this)
+		return *this;
+
+	colours_     = pal.colours_;
+	colours_hsl_ = pal.colours_hsl_;
+	colours_lab_ = pal.colours_lab_;
+	index_trans_ = pal.index_trans_;
+	clearMatchCache();
+
+	return *this;
+}
+
 // -----------------------------------------------------------------------------
 // Reads colour information from raw data (MemChunk)
 // -----------------------------------------------------------------------------
@@ -109,6 +231,8 @@ bool Palette::loadMem(MemChunk& mc)
 		if (++c == 256)
 			break;
 	}
+
+	clearMatchCache();
 	mc.seek(0, SEEK_SET);
 
 	return true;
@@ -137,6 +261,8 @@ bool Palette::loadMem(const uint8_t* data, uint32_t size)
 			break;
 	}
 
+	clearMatchCache();
+
 	return true;
 }
 
@@ -426,6 +552,9 @@ bool Palette::loadFile(string_view filename, Format format)
 // -----------------------------------------------------------------------------
 void Palette::setColour(uint8_t index, const ColRGBA& col)
 {
+	if (!colours_[index].equals(col))
+		clearMatchCache();
+
 	colours_[index].set(col);
 	colours_[index].index = index;
 	colours_lab_[index]   = colours_[index].asLAB();
@@ -437,6 +566,7 @@ void Palette::setColour(uint8_t index, const ColRGBA& col)
 // -----------------------------------------------------------------------------
 void Palette::setColourR(uint8_t index, uint8_t val)
 {
+	clearMatchCache();
 	colours_[index].r   = val;
 	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
@@ -447,6 +577,7 @@ void Palette::setColourR(uint8_t index, uint8_t val)
 // -----------------------------------------------------------------------------
 void Palette::setColourG(uint8_t index, uint8_t val)
 {
+	clearMatchCache();
 	colours_[index].g   = val;
 	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
@@ -457,6 +588,7 @@ void Palette::setColourG(uint8_t index, uint8_t val)
 // -----------------------------------------------------------------------------
 void Palette::setColourB(uint8_t index, uint8_t val)
 {
+	clearMatchCache();
 	colours_[index].b   = val;
 	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
@@ -495,6 +627,8 @@ void Palette::setGradient(uint8_t startIndex, uint8_t endIndex, const ColRGBA& s
 			a + startIndex);
 		colours_[a + startIndex].set(gradCol);
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -572,42 +706,144 @@ double Palette::colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB&
 }
 
 // -----------------------------------------------------------------------------
-// Returns the index of the closest colour in the palette to [colour]
+// Returns the index of the closest colour in the palette to [colour].
+// Results are cached per colour matching method until the palette (or any
+// relevant colour matching setting) is changed
 // -----------------------------------------------------------------------------
 short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
 {
-	double min_d = 999999;
-	short  index = 0;
-	ColHSL chsl  = colour.asHSL();
-	ColLAB clab  = colour.asLAB();
-
-	// Be nice if there was an easier way to convert from int -> enum class,
-	// but then that's kind of the point of them I guess
-	static vector<ColourMatch> cm_convert = {
-		ColourMatch::Default, ColourMatch::Old, ColourMatch::RGB, ColourMatch::HSL,
-		ColourMatch::C76,     ColourMatch::C94, ColourMatch::C2K, ColourMatch::Stop,
-	};
 	if (match == ColourMatch::Default)
 		match = cm_convert[col_match];
 
-	double delta;
-	for (short a = 0; a < 256; a++)
+	// Init cache if needed
+	if (!match_cache_)
+		match_cache_ = std::make_unique<MatchCache>();
+
+	// Get cache table for the matching method, clear it if any settings
+	// affecting the method have changed since it was filled
+	auto& table    = match_cache_->tables[matchCacheTable(match)];
+	auto  settings = colourMatchSettings(match);
+	if (table.blocks.empty() || table.settings != settings)
 	{
-		delta = colourDiff(colour, chsl, clab, a, match);
+		table.settings = settings;
+		table.blocks.clear();
+		table.blocks.resize(MatchCache::grid_size * MatchCache::grid_size * MatchCache::grid_size);
+	}
 
-		// Exact match?
-		if (delta == 0.0)
-			return a;
-		else if (delta < min_d)
+	// Get the block containing the colour
+	constexpr auto bb      = MatchCache::block_bits;
+	constexpr auto mask    = MatchCache::block_size - 1;
+	constexpr auto gs      = MatchCache::grid_size;
+	auto           block_i = ((colour.r >> bb) * gs + (colour.g >> bb)) * gs + (colour.b >> bb);
+	auto&          block   = table.blocks[block_i];
+	if (!block)
+	{
+		block = std::make_unique<MatchCache::Block>();
+		block->nearest.fill(-1);
+
+		// Determine nearest colour candidates for the block
+		ColRGBA bmin(colour.r & ~mask, colour.g & ~mask, colour.b & ~mask);
+		ColRGBA bmax(bmin.r + mask, bmin.g + mask, bmin.b + mask);
+		blockCandidates(bmin, bmax, match, block->candidates);
+	}
+
+	// Find the nearest colour if it isn't already cached
+	auto  colour_i = ((colour.r & mask) << (bb * 2)) | ((colour.g & mask) << bb) | (colour.b & mask);
+	auto& index    = block->nearest[colour_i];
+	if (index < 0)
+		index = findNearestColour(colour, match, block->candidates);
+
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+// Finds the index of the closest colour in the palette to [colour], using the
+// colour matching method specified in [match]. Only palette colours in
+// [candidates] are checked, unless it is empty.
+// Gives the same result as checking each palette colour in order and taking
+// the first with the smallest difference
+// -----------------------------------------------------------------------------
+short Palette::findNearestColour(const ColRGBA& colour, ColourMatch match, const vector<short>& candidates)
+{
+	// Only convert to HSL/LAB if needed (the conversions are quite slow)
+	ColHSL chsl;
+	ColLAB clab;
+	if (match == ColourMatch::HSL)
+		chsl = colour.asHSL();
+	else if (match == ColourMatch::C76 || match == ColourMatch::C94 || match == ColourMatch::C2K)
+		clab = colour.asLAB();
+
+	double min_d = 999999;
+	short  index = 0;
+	auto   check = [&](short a)
+	{
+		double delta = colourDiff(colour, chsl, clab, a, match);
+		if (delta < min_d || (delta == min_d && a < index))
 		{
 			min_d = delta;
 			index = a;
 		}
-	}
+	};
+
+	if (candidates.empty())
+		for (short a = 0; a < static_cast<short>(colours_.size()); a++)
+			check(a);
+	else
+		for (auto a : candidates)
+			check(a);
 
 	return index;
 }
 
+// -----------------------------------------------------------------------------
+// Adds to [list] all palette colours that could be the nearest colour to any
+// colour within the RGB box [bmin]-[bmax], using the colour matching method
+// specified in [match].
+// Only possible for RGB-based matching methods, [list] is left empty otherwise
+// -----------------------------------------------------------------------------
+void Palette::blockCandidates(const ColRGBA& bmin, const ColRGBA& bmax, ColourMatch match, vector<short>& list)
+{
+	if (match == ColourMatch::HSL || match == ColourMatch::C76 || match == ColourMatch::C94
+		|| match == ColourMatch::C2K)
+		return;
+
+	// Get the smallest and largest possible difference between each palette
+	// colour and any colour in the box. For RGB-based methods these are the
+	// differences to the closest and furthest colour in the box on each axis
+	ColHSL         chsl;
+	ColLAB         clab;
+	vector<double> diff_min(colours_.size());
+	double         max_d = 999999;
+	for (unsigned a = 0; a < colours_.size(); a++)
+	{
+		const auto& col = colours_[a];
+		ColRGBA     nearest(
+			std::clamp(col.r, bmin.r, bmax.r), std::clamp(col.g, bmin.g, bmax.g), std::clamp(col.b, bmin.b, bmax.b));
+		ColRGBA furthest(
+			col.r - bmin.r > bmax.r - col.r ? bmin.r : bmax.r,
+			col.g - bmin.g > bmax.g - col.g ? bmin.g : bmax.g,
+			col.b - bmin.b > bmax.b - col.b ? bmin.b : bmax.b);
+
+		diff_min[a] = colourDiff(nearest, chsl, clab, a, match);
+		max_d       = std::min(max_d, colourDiff(furthest, chsl, clab, a, match));
+	}
+
+	// Any colour that can't be closer than the nearest colour's furthest
+	// difference can't be the nearest for any colour in the box
+	for (unsigned a = 0; a < colours_.size(); a++)
+		if (diff_min[a] <= max_d)
+			list.push_back(a);
+}
+
+// -----------------------------------------------------------------------------
+// Clears all cached nearestColour results, must be called whenever any palette
+// colour is changed
+// -----------------------------------------------------------------------------
+void Palette::clearMatchCache()
+{
+	match_cache_.reset();
+}
+
 // -----------------------------------------------------------------------------
 // Returns the number of unique colors in a palette
 // -----------------------------------------------------------------------------
@@ -776,6 +1012,8 @@ void Palette::saturate(float amount, int start, int end)
 		colours_[i]     = colours_hsl_[i].asRGB();
 		colours_lab_[i] = colours_[i].asLAB();
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -804,6 +1042,8 @@ void Palette::illuminate(float amount, int start, int end)
 		colours_[i]     = colours_hsl_[i].asRGB();
 		colours_lab_[i] = colours_[i].asLAB();
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -832,6 +1072,8 @@ void Palette::shift(float amount, int start, int end)
 		colours_[i]     = colours_hsl_[i].asRGB();
 		colours_lab_[i] = colours_[i].asLAB();
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -853,4 +1095,51 @@ void Palette::invert(int start, int end)
 		colours_[i].b = 255 - colours_[i].b;
 		setColour(i, colours_[i]); // Just to update the HSL values
 	}
+
+	clearMatchCache();
+}
+
+
+// Testing
+
+#include "App.h"
+#include "General/Console.h"
+#include <random>
+
+// -----------------------------------------------------------------------------
+// Benchmarks finding the nearest palette colour for each pixel of a synthetic
+// 1024x1024 truecolour image, using colour matching method [method] (the
+// default method if not given)
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_palette_match, 0, false)
+{
+	auto match = Palette::ColourMatch::Default;
+	if (!args.empty())
+		match = static_cast<Palette::ColourMatch>(
+			std::clamp(strutil::asInt(args[0]), 0, static_cast<int>(Palette::ColourMatch::Stop) - 1));
+
+	// Palette with random colours
+	std::mt19937 rng(1234);
+	Palette      pal;
+	for (unsigned a = 0; a < 256; a++)
+		pal.setColour(a, ColRGBA(rng() % 256, rng() % 256, rng() % 256));
+
+	// Image - gradients with some noise
+	vector<ColRGBA> pixels(1024 * 1024);
+	for (unsigned a = 0; a < pixels.size(); a++)
+	{
+		unsigned x = a % 1024;
+		unsigned y = a / 1024;
+		pixels[a].set((x / 4 + rng() % 16) % 256, (y / 4 + rng() % 16) % 256, ((x + y) / 8 + rng() % 16) % 256);
+	}
+
+	// Match with empty cache, then again with all colours cached
+	for (auto pass : { "uncached", "cached" })
+	{
+		long checksum = 0;
+		auto time     = app::runTimer();
+		for (const auto& pixel : pixels)
+			checksum += pal.nearestColour(pixel, match);
+		log::info("Matching {} pixels ({}) took {}ms (checksum {})", pixels.size(), pass, app::runTimer() - time, checksum);
+	}
 }
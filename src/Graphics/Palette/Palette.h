@@ -30,7 +30,9 @@ public:
 
 	Palette(unsigned size = 256);
 	Palette(const Palette& pal) : Palette(pal.colours_.size()) { copyPalette(&pal); }
-	~Palette() = default;
+	~Palette();
+
+	Palette& operator=(const Palette& pal);
 
 	const vector<ColRGBA>& colours() const { return colours_; }
 	ColRGBA                colour(uint8_t index) const { return colours_[index]; }
@@ -69,11 +71,18 @@ public:
 	void idtint(int r, int g, int b, int shift, int steps);
 
 private:
-	vector<ColRGBA> colours_;
-	vector<ColHSL>  colours_hsl_;
-	vector<ColLAB>  colours_lab_;
-	short           index_trans_;
+	// Cached nearestColour results, see Palette.cpp
+	struct MatchCache;
+
+	vector<ColRGBA>        colours_;
+	vector<ColHSL>         colours_hsl_;
+	vector<ColLAB>         colours_lab_;
+	short                  index_trans_;
+	unique_ptr<MatchCache> match_cache_;
 
 	double colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB& lab, int index, ColourMatch match);
+	short  findNearestColour(const ColRGBA& colour, ColourMatch match, const vector<short>& candidates);
+	void   blockCandidates(const ColRGBA& bmin, const ColRGBA& bmax, ColourMatch match, vector<short>& list);
+	void   clearMatchCache();
 };
 } // namespace slade
@@ -439,7 +439,7 @@ void SImage::fillAlpha(uint8_t alpha)
 	{
 		// RGBA format, set alpha values to given one
 		for (int a = 3; a < width_ * height_ * 4; a += 4)
-			data_[a] = alpha;
+			data_.data()[a] = alpha;
 	}
 	else if (type_ == Type::PalMask)
 	{
@@ -549,7 +549,7 @@ void SImage::shrinkPalette(Palette* pal)
 
 	// Remap image to new palette indices
 	for (int c = 0; c < width_ * height_; ++c)
-		data_[c] = remap[data_[c]];
+		data_.data()[c] = remap[data_[c]];
 
 	pal->copyPalette(&newpal);
 }
@@ -667,7 +667,7 @@ bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
 		// Get values from alpha channel
 		int c = 0;
 		for (int a = 3; a < width_ * height_ * 4; a += 4)
-			mask_[c++] = rgba_data[a];
+			mask_.data()[c++] = rgba_data[a];
 	}
 
 	// Load given palette
@@ -685,7 +685,7 @@ bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
 		col.r    = rgba_data[i++];
 		col.g    = rgba_data[i++];
 		col.b    = rgba_data[i++];
-		data_[a] = palette_.nearestColour(col);
+		data_.data()[a] = palette_.nearestColour(col);
 		i++; // Skip alpha
 	}
 
@@ -725,7 +725,7 @@ bool SImage::convertAlphaMap(AlphaSource alpha_source, Palette* pal)
 			alpha = rgba[c + 3];
 
 		// Set pixel
-		data_[a] = alpha;
+		data_.data()[a] = alpha;
 
 		// Next RGBA pixel
 		c += 4;
@@ -753,9 +753,9 @@ bool SImage::maskFromColour(ColRGBA colour, Palette* pal)
 		for (int a = 0; a < width_ * height_; a++)
 		{
 			if (pal->colour(data_[a]).equals(colour))
-				mask_[a] = 0;
+				mask_.data()[a] = 0;
 			else
-				mask_[a] = 255;
+				mask_.data()[a] = 255;
 		}
 	}
 	else if (type_ == Type::RGBA)
@@ -767,9 +767,9 @@ bool SImage::maskFromColour(ColRGBA colour, Palette* pal)
 			ColRGBA pix_col(data_[c], data_[c + 1], data_[c + 2], 255);
 
 			if (pix_col.equals(colour))
-				data_[c + 3] = 0;
+				data_.data()[c + 3] = 0;
 			else
-				data_[c + 3] = 255;
+				data_.data()[c + 3] = 255;
 
 			// Skip to next pixel
 			c += 4;
@@ -800,8 +800,8 @@ bool SImage::maskFromBrightness(Palette* pal)
 		for (int a = 0; a < width_ * height_; a++)
 		{
 			// Set mask from pixel colour brightness value
-			ColRGBA col = pal->colour(data_[a]);
-			mask_[a]    = ((double)col.r * 0.3) + ((double)col.g * 0.59) + ((double)col.b * 0.11);
+			ColRGBA col     = pal->colour(data_[a]);
+			mask_.data()[a] = ((double)col.r * 0.3) + ((double)col.g * 0.59) + ((double)col.b * 0.11);
 		}
 	}
 	else if (type_ == Type::RGBA)
@@ -811,7 +811,7 @@ bool SImage::maskFromBrightness(Palette* pal)
 		for (int a = 0; a < width_ * height_; a++)
 		{
 			// Set alpha from pixel colour brightness value
-			data_[c + 3] = (double)data_[c] * 0.3 + (double)data_[c + 1] * 0.59 + (double)data_[c + 2] * 0.11;
+			data_.data()[c + 3] = (double)data_[c] * 0.3 + (double)data_[c + 1] * 0.59 + (double)data_[c + 2] * 0.11;
 			// Skip alpha
 			c += 4;
 		}
@@ -837,9 +837,9 @@ bool SImage::cutoffMask(uint8_t threshold)
 		for (int a = 0; a < width_ * height_; a++)
 		{
 			if (mask_[a] > threshold)
-				mask_[a] = 255;
+				mask_.data()[a] = 255;
 			else
-				mask_[a] = 0;
+				mask_.data()[a] = 0;
 		}
 	}
 	else if (type_ == Type::RGBA)
@@ -849,9 +849,9 @@ bool SImage::cutoffMask(uint8_t threshold)
 		for (int a = 3; a < width_ * height_ * 4; a += 4)
 		{
 			if (data_[a] > threshold)
-				data_[a] = 255;
+				data_.data()[a] = 255;
 			else
-				data_[a] = 0;
+				data_.data()[a] = 0;
 		}
 	}
 	else if (type_ == Type::AlphaMap)
@@ -860,9 +860,9 @@ bool SImage::cutoffMask(uint8_t threshold)
 		for (int a = 0; a < width_ * height_; a++)
 		{
 			if (data_[a] > threshold)
-				data_[a] = 255;
+				data_.data()[a] = 255;
 			else
-				data_[a] = 0;
+				data_.data()[a] = 0;
 		}
 	}
 	else
@@ -896,14 +896,14 @@ bool SImage::setPixel(int x, int y, ColRGBA colour, Palette* pal)
 		// Get color index to use (the ColRGBA's index if defined, nearest colour otherwise)
 		uint8_t index = (colour.index == -1) ? pal->nearestColour(colour) : colour.index;
 
-		data_[y * width_ + x] = index;
+		data_.data()[y * width_ + x] = index;
 		if (mask_.hasData())
-			mask_[y * width_ + x] = colour.a;
+			mask_.data()[y * width_ + x] = colour.a;
 	}
 	else if (type_ == Type::AlphaMap)
 	{
 		// Just use colour alpha
-		data_[y * width_ + x] = colour.a;
+		data_.data()[y * width_ + x] = colour.a;
 	}
 
 	// Announce
@@ -936,16 +936,16 @@ bool SImage::setPixel(int x, int y, uint8_t pal_index, uint8_t alpha)
 	else if (type_ == Type::PalMask)
 	{
 		// Set the pixel
-		data_[y * width_ + x] = pal_index;
+		data_.data()[y * width_ + x] = pal_index;
 		if (mask_.hasData())
-			mask_[y * width_ + x] = alpha;
+			mask_.data()[y * width_ + x] = alpha;
 	}
 
 	// Alpha map
 	else if (type_ == Type::AlphaMap)
 	{
 		// Set the pixel
-		data_[y * width_ + x] = alpha;
+		data_.data()[y * width_ + x] = alpha;
 	}
 
 	// Invalid type
@@ -1298,6 +1298,10 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 	if (has_palette_ || !pal)
 		pal = &palette_;
 
+	// Compile the translation for the palette, so each pixel is just a lookup
+	Translation::LUT lut;
+	tr->compile(lut, pal);
+
 	uint8_t* newdata = nullptr;
 	if (truecolor && type_ == Type::PalMask)
 	{
@@ -1314,32 +1318,37 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 		if (mask_.hasData() && mask_[p] == 0)
 			continue;
 
-		ColRGBA col;
+		uint8_t index;
+		uint8_t alpha;
 		int     q = p * bpp;
 		if (type_ == Type::PalMask)
-			col.set(pal->colour(data_[p]));
-		else if (type_ == Type::RGBA)
 		{
-			col.set(data_[q], data_[q + 1], data_[q + 2], data_[q + 3]);
+			index = data_[p];
+			alpha = pal->colour(index).a;
+		}
+		else
+		{
+			ColRGBA col(data_[q], data_[q + 1], data_[q + 2], data_[q + 3]);
 
 			// skip colours that don't match exactly to the palette
-			col.index = pal->nearestColour(col);
-			if (!col.equals(pal->colour(col.index)))
+			index = pal->nearestColour(col);
+			if (!col.equals(pal->colour(index)))
 				continue;
-		}
 
-		col = tr->translate(col, pal);
+			alpha = col.a;
+		}
 
+		const auto& col = lut.colours[index];
 		if (truecolor)
 		{
 			q              = p * 4;
 			newdata[q + 0] = col.r;
 			newdata[q + 1] = col.g;
 			newdata[q + 2] = col.b;
-			newdata[q + 3] = mask_.hasData() ? mask_[p] : col.a;
+			newdata[q + 3] = mask_.hasData() ? mask_[p] : (lut.keep_alpha[index] ? alpha : col.a);
 		}
 		else
-			data_[p] = col.index;
+			data_.data()[p] = col.index;
 	}
 
 	if (truecolor && type_ == Type::PalMask)
@@ -1399,8 +1408,8 @@ bool SImage::drawPixel(int x, int y, ColRGBA colour, DrawProps& properties, Pale
 			colour.write(data_.data() + p);
 		else
 		{
-			data_[p] = pal->nearestColour(colour);
-			mask_[p] = colour.a;
+			data_.data()[p] = pal->nearestColour(colour);
+			mask_.data()[p] = colour.a;
 		}
 
 		return true;
@@ -1468,13 +1477,13 @@ bool SImage::drawPixel(int x, int y, ColRGBA colour, DrawProps& properties, Pale
 	// Apply new colour
 	if (type_ == Type::PalMask)
 	{
-		data_[p] = pal->nearestColour(d_colour);
-		mask_[p] = d_colour.a;
+		data_.data()[p] = pal->nearestColour(d_colour);
+		mask_.data()[p] = d_colour.a;
 	}
 	else if (type_ == Type::RGBA)
 		d_colour.write(data_.data() + p);
 	else if (type_ == Type::AlphaMap)
-		data_[p] = d_colour.a;
+		data_.data()[p] = d_colour.a;
 
 	return true;
 }
@@ -1598,7 +1607,7 @@ bool SImage::colourise(ColRGBA colour, Palette* pal, int start, int stop)
 		if (type_ == Type::RGBA)
 			col.write(data_.data() + a);
 		else
-			data_[a] = pal->nearestColour(col);
+			data_.data()[a] = pal->nearestColour(col);
 	}
 
 	return true;
@@ -1649,7 +1658,7 @@ bool SImage::tint(ColRGBA colour, float amount, Palette* pal, int start, int sto
 		if (type_ == Type::RGBA)
 			col.write(data_.data() + a);
 		else
-			data_[a] = pal->nearestColour(col);
+			data_.data()[a] = pal->nearestColour(col);
 	}
 
 	return true;
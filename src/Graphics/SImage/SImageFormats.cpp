@@ -100,11 +100,11 @@ bool SImage::loadFont0(const uint8_t* gfx_data, int size)
 	size_t p = 0;
 	for (size_t i = 0; i < datasize; ++i)
 	{
-		data_[p] = r[i];
+		data_.data()[p] = r[i];
 
 		// Index 0 is transparent
 		if (data_[p] == 0)
-			mask_[p] = 0;
+			mask_.data()[p] = 0;
 
 		// Move to next column
 		p += width_;
@@ -196,7 +196,7 @@ bool SImage::loadFont1(const uint8_t* gfx_data, int size)
 	// Add transparency to mask
 	for (size_t i = 0; i < (unsigned)(width_ * height_); ++i)
 		if (data_[i] == 0)
-			mask_[i] = 0x00;
+			mask_.data()[i] = 0x00;
 
 	// Announce change and return success
 	signals_.image_changed();
@@ -373,7 +373,7 @@ bool SImage::loadFont2(const uint8_t* gfx_data, int size)
 	mask_.fillData(0xFF);
 	for (size_t i = 0; i < (unsigned)(width_ * height_); ++i)
 		if (data_[i] == 0)
-			mask_[i] = 0;
+			mask_.data()[i] = 0;
 
 	// Announce change and return success
 	signals_.image_changed();
@@ -563,8 +563,8 @@ bool SImage::loadBMF(const uint8_t* gfx_data, int size)
 					if ((mc->cdata + pixela < eod) && (mc->cdata + pixela < mf.chars[i + 1].cdata - 6)
 						&& mc->cdata[pixela] && pixelb < pixels)
 					{
-						data_[pixelb] = mc->cdata[pixela];
-						mask_[pixelb] = 0xFF;
+						data_.data()[pixelb] = mc->cdata[pixela];
+						mask_.data()[pixelb] = 0xFF;
 					}
 				}
 			}
@@ -615,7 +615,7 @@ bool SImage::loadFontM(const uint8_t* gfx_data, int size)
 	for (size_t i = 0; i < (unsigned)size; ++i)
 	{
 		for (size_t p = 0; p < 8; ++p)
-			mask_[(i * 8) + p] = ((gfx_data[i] >> (7 - p)) & 1) * 255;
+			mask_.data()[(i * 8) + p] = ((gfx_data[i] >> (7 - p)) & 1) * 255;
 	}
 	// Announce change and return success
 	signals_.image_changed();
@@ -683,10 +683,10 @@ bool SImage::loadWolfFont(const uint8_t* gfx_data, int size)
 			// Compute source and destination offsets
 			size_t s = o + i;
 			size_t d = ((i / w) * width_) + (i % w) + p;
-			data_[d] = gfx_data[s];
+			data_.data()[d] = gfx_data[s];
 			// Index 0 is transparent
 			if (data_[d] == 0)
-				mask_[d] = 0;
+				mask_.data()[d] = 0;
 		}
 	}
 	// Announce change and return success
@@ -761,7 +761,7 @@ bool SImage::loadJediFNT(const uint8_t* gfx_data, int size)
 	// Make index 0 transparent
 	for (int i = 0; i < width_ * height_; ++i)
 		if (data_[i] == 0)
-			mask_[i] = 0;
+			mask_.data()[i] = 0;
 
 	// Convert from column-major to row-major
 	rotate(90);
@@ -820,10 +820,10 @@ bool SImage::loadJediFONT(const uint8_t* gfx_data, int size)
 		{
 			switch (bpc)
 			{
-			case 1: mask_[(i * width_) + p] = ((gfx_data[o + i] >> (7 - p)) & 1) * 255; break;
-			case 2: mask_[(i * width_) + p] = ((memory::readB16(gfx_data, o + (i * 2)) >> (15 - p)) & 1) * 255; break;
-			case 3: mask_[(i * width_) + p] = ((memory::readB24(gfx_data, o + (i * 3)) >> (23 - p)) & 1) * 255; break;
-			case 4: mask_[(i * width_) + p] = ((memory::readB32(gfx_data, o + (i * 4)) >> (31 - p)) & 1) * 255; break;
+			case 1: mask_.data()[(i * width_) + p] = ((gfx_data[o + i] >> (7 - p)) & 1) * 255; break;
+			case 2: mask_.data()[(i * width_) + p] = ((memory::readB16(gfx_data, o + (i * 2)) >> (15 - p)) & 1) * 255; break;
+			case 3: mask_.data()[(i * width_) + p] = ((memory::readB24(gfx_data, o + (i * 3)) >> (23 - p)) & 1) * 255; break;
+			case 4: mask_.data()[(i * width_) + p] = ((memory::readB32(gfx_data, o + (i * 4)) >> (31 - p)) & 1) * 255; break;
 			default:
 				clearData();
 				global::error = "Jedi FONT: Weird word width";
@@ -912,8 +912,8 @@ bool SImage::loadJaguarSprite(const uint8_t* header, int hdr_size, const uint8_t
 			for (int p = 0; p < len; ++p)
 			{
 				size_t pos = w + width_ * (top + p);
-				data_[pos] = gfx_data[pixel_p + p];
-				mask_[pos] = 0xFF;
+				data_.data()[pos] = gfx_data[pixel_p + p];
+				mask_.data()[pos] = 0xFF;
 			}
 			post_p += 4;
 		}
@@ -634,6 +634,32 @@ ColRGBA Translation::translate(ColRGBA col, Palette* pal)
 	return colour;
 }
 
+// -----------------------------------------------------------------------------
+// Compiles the translation for [pal] into [lut], so it can be applied to each
+// palette index by a simple lookup rather than calling translate for every
+// pixel of an image
+// -----------------------------------------------------------------------------
+void Translation::compile(LUT& lut, Palette* pal)
+{
+	if (pal == nullptr)
+		pal = maineditor::currentPalette();
+
+	for (unsigned i = 0; i < 256; i++)
+	{
+		// Translated colour values don't depend on alpha, but some ranges keep
+		// the original alpha while others replace it. Translate the colour as
+		// both opaque and transparent to find out which applies here
+		auto col         = pal->colour(i);
+		col.a            = 255;
+		auto opaque      = translate(col, pal);
+		col.a            = 0;
+		auto transparent = translate(col, pal);
+
+		lut.colours[i]    = opaque;
+		lut.keep_alpha[i] = opaque.a != transparent.a;
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Adds a new translation range of [type] at [pos] in the list, with the range
 // spanning from [range_start] to [range_end]
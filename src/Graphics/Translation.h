@@ -259,6 +259,13 @@ class Palette;
 class Translation
 {
 public:
+	// A translation compiled for a specific palette (see compile)
+	struct LUT
+	{
+		ColRGBA colours[256];    // Translated colour of each palette index
+		bool    keep_alpha[256]; // True if the original alpha is kept for the index
+	};
+
 	Translation()  = default;
 	~Translation() = default;
 
@@ -281,6 +288,7 @@ public:
 	void setDesaturationAmount(uint8_t amount) { desat_amount_ = amount; }
 
 	ColRGBA translate(ColRGBA col, Palette* pal = nullptr);
+	void    compile(LUT& lut, Palette* pal = nullptr);
 
 	TransRange* addRange(TransRange::Type type, int pos = -1, int range_start = 0, int range_end = 0);
 	void        removeRange(int pos);
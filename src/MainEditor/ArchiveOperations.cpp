@@ -57,9 +57,9 @@ using namespace slade;
 // Variables
 //
 // -----------------------------------------------------------------------------
-typedef std::map<wxString, int>                   StrIntMap;
-typedef std::map<wxString, vector<ArchiveEntry*>> PathMap;
-typedef std::map<int, vector<ArchiveEntry*>>      CRCMap;
+typedef std::map<wxString, int>                                        StrIntMap;
+typedef std::map<wxString, vector<ArchiveEntry*>>                      PathMap;
+typedef std::map<std::pair<uint64_t, uint32_t>, vector<ArchiveEntry*>> ContentHashMap;
 
 
 // -----------------------------------------------------------------------------
@@ -264,11 +264,12 @@ void archiveoperations::removeEntriesUnchangedFromIWAD(Archive* archive)
 
 	// Init search options
 	Archive::SearchOptions search;
-	ArchiveEntry*          other = nullptr;
 	wxString               dups  = "";
 	size_t                 count = 0;
 
-	// Go through list
+	// Find counterparts in the IWAD with the same name, namespace and size
+	vector<ArchiveEntry*> compare_entries;
+	vector<ArchiveEntry*> others;
 	for (auto& entry : entries)
 	{
 		// Skip directory entries
@@ -282,15 +283,28 @@ void archiveoperations::removeEntriesUnchangedFromIWAD(Archive* archive)
 		// Now, let's look for a counterpart in the IWAD
 		search.match_namespace = archive->detectNamespace(entry);
 		search.match_name      = entry->name();
-		other                  = bra->findLast(search);
+		auto other             = bra->findLast(search);
 
-		// If there is one, and it is identical, remove it
-		if (other != nullptr && (other->data().crc() == entry->data().crc()))
+		// Entries can only be identical if they are the same size
+		if (other != nullptr && other->size() == entry->size())
+		{
+			compare_entries.push_back(entry);
+			others.push_back(other);
+		}
+	}
+
+	// Hash entry data (in parallel)
+	ArchiveEntry::computeContentHashes(compare_entries);
+	ArchiveEntry::computeContentHashes(others);
+
+	// Remove entries identical to their IWAD counterpart
+	for (unsigned a = 0; a < compare_entries.size(); a++)
+	{
+		if (compare_entries[a]->contentHash() == others[a]->contentHash())
 		{
 			++count;
-			dups += wxString::Format("%s\n", search.match_name);
-			archive->removeEntry(entry);
-			entry = nullptr;
+			dups += wxString::Format("%s\n", compare_entries[a]->name());
+			archive->removeEntry(compare_entries[a]);
 		}
 	}
 
@@ -320,14 +334,15 @@ void archiveoperations::removeEntriesUnchangedFromIWAD(Archive* archive)
 // -----------------------------------------------------------------------------
 bool archiveoperations::checkDuplicateEntryContent(Archive* archive)
 {
-	CRCMap map_entries;
+	ContentHashMap map_entries;
 
 	// Get list of all entries in archive
 	vector<ArchiveEntry*> entries;
 	archive->putEntryTreeAsList(entries);
 	wxString dups = "";
 
-	// Go through list
+	// Get entries to check
+	vector<ArchiveEntry*> check_entries;
 	for (auto& entry : entries)
 	{
 		// Skip directory entries
@@ -338,10 +353,14 @@ bool archiveoperations::checkDuplicateEntryContent(Archive* archive)
 		if (entry->type() == EntryType::mapMarkerType() || entry->size() == 0)
 			continue;
 
-		// Enqueue entries
-		map_entries[entry->data().crc()].push_back(entry);
+		check_entries.push_back(entry);
 	}
 
+	// Hash entry data (in parallel) and group entries by hash and size
+	ArchiveEntry::computeContentHashes(check_entries);
+	for (auto entry : check_entries)
+		map_entries[{ entry->contentHash(), entry->size() }].push_back(entry);
+
 	// Now iterate through the dupes to list the name of the duplicated entries
 	auto i = map_entries.begin();
 	while (i != map_entries.end())
@@ -350,7 +369,7 @@ bool archiveoperations::checkDuplicateEntryContent(Archive* archive)
 		{
 			wxString name = i->second[0]->path(true);
 			name.Remove(0, 1);
-			dups += wxString::Format("\n%s\t(%8x) duplicated by", name, i->first);
+			dups += wxString::Format("\n%s\t(%016llx) duplicated by", name, (unsigned long long)i->first.first);
 			auto j = i->second.begin() + 1;
 			while (j != i->second.end())
 			{
@@ -1010,28 +1010,30 @@ bool conversion::addImfHeader(MemChunk& in, MemChunk& out)
 		newsize += 4;
 
 	out.reSize(newsize, false);
-	out[0] = 'A';
-	out[1] = 'D';
-	out[2] = 'L';
-	out[3] = 'I';
-	out[4] = 'B';
-	out[5] = 1;
-	out[6] = 0;
-	out[7] = 0;
-	out[8] = 1;
+	auto data = out.data();
+
+	data[0] = 'A';
+	data[1] = 'D';
+	data[2] = 'L';
+	data[3] = 'I';
+	data[4] = 'B';
+	data[5] = 1;
+	data[6] = 0;
+	data[7] = 0;
+	data[8] = 1;
 	if (in[0] | in[1])
 	{
-		out[9]  = in[0];
-		out[10] = in[1];
-		out[11] = 0;
-		out[12] = 0;
+		data[9]  = in[0];
+		data[10] = in[1];
+		data[11] = 0;
+		data[12] = 0;
 	}
 	else
 	{
-		out[9]  = 0;
-		out[10] = 0;
-		out[11] = 0;
-		out[12] = 0;
+		data[9]  = 0;
+		data[10] = 0;
+		data[11] = 0;
+		data[12] = 0;
 	}
 	out.seek(13, SEEK_SET);
 	in.seek(start, SEEK_SET);
@@ -1039,7 +1041,7 @@ bool conversion::addImfHeader(MemChunk& in, MemChunk& out)
 	// return in.readMC(out, size);
 	for (size_t i = 0; ((i + start < in.size()) && (13 + i < newsize)); ++i)
 	{
-		out[13 + i] = in[i + start];
+		data[13 + i] = in[i + start];
 	}
 	return true;
 }
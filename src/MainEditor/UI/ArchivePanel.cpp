@@ -76,6 +76,7 @@
 #include "UI/Dialogs/TranslationEditorDialog.h"
 #include "UI/Lists/ArchiveEntryTree.h"
 #include "UI/WxUtils.h"
+#include "Utility/Compression.h"
 #include "Utility/SFileDialog.h"
 #include "Utility/StringUtils.h"
 
@@ -4218,6 +4219,15 @@ void ArchivePanel::onBtnClearFilter(wxCommandEvent& e)
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// Returns the entry the undo step applies to, or null if it no longer exists
+// -----------------------------------------------------------------------------
+ArchiveEntry* EntryDataUS::entry() const
+{
+	auto dir = archive_->dirAtPath(path_.ToStdString());
+	return dir ? dir->entryAt(index_) : nullptr;
+}
+
 // -----------------------------------------------------------------------------
 // Swaps data between the entry and the undo step
 // -----------------------------------------------------------------------------
@@ -4225,42 +4235,123 @@ bool EntryDataUS::swapData()
 {
 	// log::info(1, "Entry data swap...");
 
-	// Get parent dir
-	auto dir = archive_->dirAtPath(path_.ToStdString());
-	if (dir)
+	// Get entry
+	auto entry = this->entry();
+	if (!entry)
+		return false;
+
+	// Backup data
+	MemChunk temp_data;
+	temp_data.importMem(entry->rawData(), entry->size());
+	// log::info(1, "Backup current data, size %d", entry->getSize());
+
+	// Get data to restore
+	MemChunk restore_data;
+	if (!getData(restore_data))
 	{
-		// Get entry
-		auto entry = dir->entryAt(index_);
-		if (!entry)
-			return false;
+		log::warning("Can't restore data for entry {}", path_.ToStdString());
+		return false;
+	}
 
-		// Backup data
-		MemChunk temp_data;
-		temp_data.importMem(entry->rawData(), entry->size());
-		// log::info(1, "Backup current data, size %d", entry->getSize());
+	// Restore entry data
+	if (restore_data.size() == 0)
+	{
+		entry->clearData();
+		// log::info(1, "Clear entry data");
+	}
+	else
+	{
+		entry->importMemChunk(restore_data);
+		// log::info(1, "Restored entry data, size %d", data.getSize());
+	}
 
-		// Restore entry data
-		if (data_.size() == 0)
-		{
-			entry->clearData();
-			// log::info(1, "Clear entry data");
-		}
-		else
-		{
-			entry->importMemChunk(data_);
-			// log::info(1, "Restored entry data, size %d", data.getSize());
-		}
+	// Store previous entry data
+	setData(temp_data);
 
-		// Store previous entry data
-		if (temp_data.size() > 0)
-			data_.importMem(temp_data.data(), temp_data.size());
-		else
-			data_.clear();
+	return true;
+}
 
-		return true;
+// -----------------------------------------------------------------------------
+// Called when the undo level has finished recording. Compresses the copy of the
+// previous entry data (this isn't done when recording starts so that the
+// operation being recorded isn't slowed down)
+// -----------------------------------------------------------------------------
+void EntryDataUS::recordEnded()
+{
+	if (compressed_ || data_.size() == 0)
+		return;
+
+	MemChunk data;
+	data.importMem(data_);
+	setData(data);
+}
+
+// -----------------------------------------------------------------------------
+// Writes the undo step's data to [mc] and frees it from memory
+// -----------------------------------------------------------------------------
+bool EntryDataUS::writeFile(MemChunk& mc)
+{
+	uint8_t  compressed = compressed_ ? 1 : 0;
+	uint32_t size       = size_;
+	if (!mc.write(&compressed, 1) || !mc.write(&size, 4))
+		return false;
+	if (data_.size() > 0 && !mc.write(std::as_const(data_).data(), data_.size()))
+		return false;
+
+	data_.clear();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the undo step's data back from [mc] (written by writeFile)
+// -----------------------------------------------------------------------------
+bool EntryDataUS::readFile(MemChunk& mc)
+{
+	uint8_t compressed;
+	mc.seekFromStart(0);
+	if (!mc.read(&compressed, 1) || !mc.read(&size_, 4))
+		return false;
+
+	compressed_ = compressed > 0;
+
+	data_.clear();
+	auto size = mc.size() - mc.currentPos();
+	return size == 0 || data_.importMem(std::as_const(mc).data() + mc.currentPos(), size);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the undo step's data to a zlib-compressed copy of [data], or an
+// uncompressed copy if it doesn't compress
+// -----------------------------------------------------------------------------
+void EntryDataUS::setData(const MemChunk& data)
+{
+	MemChunk in, compressed;
+	in.setView(data.data(), data.size());
+	compressed_ = data.size() > 0 && compression::zlibDeflate(in, compressed, 1) && compressed.size() < data.size();
+	size_       = data.size();
+
+	data_.clear();
+	if (compressed_)
+		data_.importMem(compressed);
+	else if (data.size() > 0)
+		data_.importMem(data);
+}
+
+// -----------------------------------------------------------------------------
+// Writes the (uncompressed) undo step data to [data].
+// Returns false if it couldn't be decompressed
+// -----------------------------------------------------------------------------
+bool EntryDataUS::getData(MemChunk& data) const
+{
+	if (!compressed_)
+	{
+		data.clear();
+		return data_.size() == 0 || data.importMem(data_);
 	}
 
-	return false;
+	MemChunk compressed;
+	compressed.setView(std::as_const(data_).data(), data_.size());
+	return compression::zlibInflate(compressed, data, size_) && data.size() == size_;
 }
 
 
@@ -172,6 +172,8 @@ private:
 	wxPanel* createEntryListPanel(wxWindow* parent);
 };
 
+// UndoStep for when an entry's data is changed. Once the undo level has been
+// recorded the data is kept compressed
 class EntryDataUS : public UndoStep
 {
 public:
@@ -180,14 +182,27 @@ public:
 		data_.importMem(entry->rawData(), entry->size());
 	}
 
-	bool swapData();
-	bool doUndo() override { return swapData(); }
-	bool doRedo() override { return swapData(); }
+	bool     swapData();
+	bool     doUndo() override { return swapData(); }
+	bool     doRedo() override { return swapData(); }
+	void     recordEnded() override;
+	bool     writeFile(MemChunk& mc) override;
+	bool     readFile(MemChunk& mc) override;
+	unsigned memUsage() const override { return sizeof(EntryDataUS) + data_.size(); }
 
 private:
+	// Entry data to swap in, zlib-compressed if compressed_ is true. This is a
+	// full copy rather than a delta against the current entry data, since the
+	// entry can be modified outside of the undo system (eg. saving a map)
 	MemChunk data_;
+	bool     compressed_ = false;
+	uint32_t size_       = 0; // Uncompressed size of the data
 	wxString path_;
 	int      index_   = -1;
 	Archive* archive_ = nullptr;
+
+	ArchiveEntry* entry() const;
+	void          setData(const MemChunk& data);
+	bool          getData(MemChunk& data) const;
 };
 } // namespace slade
@@ -1107,7 +1107,7 @@ bool PaletteEntryPanel::generateColormaps()
 			rgba[1] = rgb.g;
 			rgba[2] = rgb.b;
 			imc.write(&rgba, 4);
-			mc[(256 * l) + c] = palettes_[0]->nearestColour(rgb);
+			mc.data()[(256 * l) + c] = palettes_[0]->nearestColour(rgb);
 		}
 	}
 #if 0
@@ -32,8 +32,8 @@
 #include "Main.h"
 #include "MapBackupManager.h"
 #include "App.h"
-#include "Archive/Formats/ZipArchive.h"
-#include "General/Misc.h"
+#include "Archive/ArchiveEntry.h"
+#include "MapBackupStore.h"
 #include "MapEditor.h"
 #include "UI/MapBackupPanel.h"
 #include "UI/SDialog.h"
@@ -78,13 +78,10 @@ bool MapBackupManager::writeBackup(
 	if (!wxDirExists(backup_dir))
 		wxMkdir(backup_dir);
 
-	// Open or create backup zip
-	shared_ptr<Archive> backup = std::make_shared<ZipArchive>();
-	string              fname{ archive_name };
-	std::replace(fname.begin(), fname.end(), '.', '_');
-	auto backup_file = fmt::format("{}/{}_backup.zip", backup_dir, fname);
-	if (!backup->open(backup_file))
-		backup->setFilename(backup_file);
+	// Open backup store
+	MapBackupStore store(archive_name);
+	if (!store.open())
+		return false;
 
 	// Filter ignored entries
 	vector<ArchiveEntry*> backup_entries;
@@ -105,61 +102,24 @@ bool MapBackupManager::writeBackup(
 			backup_entries.push_back(entry.get());
 	}
 
+	// Hash map data (in parallel, comparisons with the store are done by hash)
+	ArchiveEntry::computeContentHashes(backup_entries);
+
 	// Compare with last backup (if any)
-	auto map_dir = backup->dirAtPath(map_name);
-	if (map_dir && map_dir->numSubdirs() > 0)
+	if (store.isLastBackup(map_name, backup_entries))
 	{
-		auto last_backup = map_dir->subdirAt(map_dir->numSubdirs() - 1);
-		bool same        = true;
-		if (last_backup->numEntries() != backup_entries.size())
-			same = false;
-		else
-		{
-			for (unsigned a = 0; a < last_backup->numEntries(); a++)
-			{
-				auto e1 = backup_entries[a];
-				auto e2 = last_backup->entryAt(a);
-				if (e1->size() != e2->size())
-				{
-					same = false;
-					break;
-				}
-
-				uint32_t crc1 = misc::crc(e1->rawData(), e1->size());
-				uint32_t crc2 = misc::crc(e2->rawData(), e2->size());
-				if (crc1 != crc2)
-				{
-					same = false;
-					break;
-				}
-			}
-		}
-
-		if (same)
-		{
-			log::info(2, "Same data as previous backup - ignoring");
-			return true;
-		}
+		log::info(2, "Same data as previous backup - ignoring");
+		return true;
 	}
 
 	// Add map data to backup
 	auto timestamp = wxDateTime::Now().FormatISOCombined('_').ToStdString();
 	strutil::replaceIP(timestamp, ":", "");
-	auto dir = fmt::format("{}/{}", map_name, timestamp);
-	for (auto& entry : backup_entries)
-		backup->addEntry(std::make_shared<ArchiveEntry>(*entry), dir);
+	if (!store.addBackup(map_name, timestamp, backup_entries))
+		return false;
 
 	// Check for max backups & remove old ones if over
-	map_dir = backup->dirAtPath(map_name);
-	while ((int)map_dir->numSubdirs() > max_map_backups)
-		backup->removeDir(map_dir->subdirAt(0)->name(), map_dir);
-
-	// Save backup file
-	Archive::save_backup = false;
-	bool ok              = backup->save();
-	Archive::save_backup = true;
-
-	return ok;
+	return store.removeOldBackups(map_name, max_map_backups);
 }
 
 // -----------------------------------------------------------------------------
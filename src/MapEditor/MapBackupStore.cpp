@@ -0,0 +1,587 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapBackupStore.cpp
+// Description: MapBackupStore class - an append-only, content-addressed store
+//              of map backups for an archive
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapBackupStore.h"
+#include "App.h"
+#include "Archive/Formats/ZipArchive.h"
+#include "Utility/FileUtils.h"
+#include "Utility/StringUtils.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// The index file is made up of lines of tab-separated fields:
+// data   <data file name>
+// blob   <hash> <size> <offset>       - Lump data stored in the data file
+// backup <timestamp> <count> <map>    - A backup, followed by [count] lump lines
+// lump   <hash> <size> <name>         - A lump in the backup
+// remove <timestamp> <map>            - Removes the (oldest) matching backup
+const string index_header = "# SLADE map backup index";
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the store Lump info for [entry]
+// -----------------------------------------------------------------------------
+MapBackupStore::Lump entryLump(ArchiveEntry* entry)
+{
+	return { entry->name(), entry->contentHash(), entry->size() };
+}
+
+// -----------------------------------------------------------------------------
+// Parses a hex string [str] to a 64-bit [hash].
+// Returns false if it isn't a valid hex number
+// -----------------------------------------------------------------------------
+bool parseHash(string_view str, uint64_t& hash)
+{
+	if (str.empty() || str.size() > 16)
+		return false;
+
+	hash = 0;
+	for (auto chr : str)
+	{
+		int digit;
+		if (chr >= '0' && chr <= '9')
+			digit = chr - '0';
+		else if (chr >= 'a' && chr <= 'f')
+			digit = chr - 'a' + 10;
+		else if (chr >= 'A' && chr <= 'F')
+			digit = chr - 'A' + 10;
+		else
+			return false;
+
+		hash = (hash << 4) | digit;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index line for lump data with [hash] and [size] at [offset] in
+// the data file
+// -----------------------------------------------------------------------------
+string blobLine(uint64_t hash, uint32_t size, uint32_t offset)
+{
+	return fmt::format("blob\t{:016x}\t{}\t{}\n", hash, size, offset);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index lines for [backup]
+// -----------------------------------------------------------------------------
+string backupLines(const MapBackupStore::Backup& backup)
+{
+	auto lines = fmt::format("backup\t{}\t{}\t{}\n", backup.timestamp, backup.lumps.size(), backup.map_name);
+	for (auto& lump : backup.lumps)
+		lines += fmt::format("lump\t{:016x}\t{}\t{}\n", lump.hash, lump.size, lump.name);
+
+	return lines;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapBackupStore Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapBackupStore class constructor
+// -----------------------------------------------------------------------------
+MapBackupStore::MapBackupStore(string_view archive_name)
+{
+	string fname{ archive_name };
+	std::replace(fname.begin(), fname.end(), '.', '_');
+	path_      = fmt::format("{}/{}_backup", app::path("backups", app::Dir::User), fname);
+	data_file_ = fmt::format("{}_backup.dat", fname);
+}
+
+// -----------------------------------------------------------------------------
+// Opens the store, reading its index. If the store doesn't exist yet but there
+// is a backup zip from an older version of SLADE, its backups are imported.
+// Returns false if the index couldn't be read
+// -----------------------------------------------------------------------------
+bool MapBackupStore::open()
+{
+	blobs_.clear();
+	backups_.clear();
+
+	if (fileutil::fileExists(path_ + ".idx"))
+		return readIndex();
+
+	if (fileutil::fileExists(path_ + ".zip"))
+		return importLegacyBackups();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns all backups of [map_name], from oldest to newest
+// -----------------------------------------------------------------------------
+vector<const MapBackupStore::Backup*> MapBackupStore::backups(string_view map_name) const
+{
+	vector<const Backup*> list;
+	for (auto& backup : backups_)
+		if (strutil::equalCI(backup.map_name, map_name))
+			list.push_back(&backup);
+
+	return list;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the most recent backup of [map_name], or nullptr if there are none
+// -----------------------------------------------------------------------------
+const MapBackupStore::Backup* MapBackupStore::lastBackup(string_view map_name) const
+{
+	for (auto backup = backups_.rbegin(); backup != backups_.rend(); ++backup)
+		if (strutil::equalCI(backup->map_name, map_name))
+			return &(*backup);
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the most recent backup of [map_name] has the same lumps
+// (names and data) as [entries]
+// -----------------------------------------------------------------------------
+bool MapBackupStore::isLastBackup(string_view map_name, const vector<ArchiveEntry*>& entries) const
+{
+	auto last = lastBackup(map_name);
+	if (!last || last->lumps.size() != entries.size())
+		return false;
+
+	for (unsigned a = 0; a < entries.size(); a++)
+	{
+		// Check size first to avoid hashing if possible
+		if (last->lumps[a].size != entries[a]->size() || last->lumps[a] != entryLump(entries[a]))
+			return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the data for [lump] into [data].
+// Returns false if the data isn't in the store or couldn't be read
+// -----------------------------------------------------------------------------
+bool MapBackupStore::readLump(const Lump& lump, MemChunk& data) const
+{
+	auto blob = blobs_.find({ lump.hash, lump.size });
+	if (blob == blobs_.end())
+		return false;
+
+	data.clear();
+	if (lump.size == 0)
+		return true;
+
+	SFile file(dataPath());
+	return file.isOpen() && file.seekFromStart(blob->second) && file.read(data, lump.size);
+}
+
+// -----------------------------------------------------------------------------
+// Adds a backup of [map_name] at [timestamp], with the lumps in [entries].
+// Only data for lumps that aren't already in the store is written
+// -----------------------------------------------------------------------------
+bool MapBackupStore::addBackup(string_view map_name, string_view timestamp, const vector<ArchiveEntry*>& entries)
+{
+	Backup backup{ string{ map_name }, string{ timestamp }, {} };
+	string lines;
+
+	// Append lump data that isn't already stored to the data file (new lumps
+	// are only added to the store once the index has been written)
+	SFile                       data;
+	uint32_t                    offset = 0;
+	std::map<BlobKey, uint32_t> new_blobs;
+	for (auto* entry : entries)
+	{
+		auto    lump = entryLump(entry);
+		BlobKey key{ lump.hash, lump.size };
+		if (blobs_.find(key) == blobs_.end() && new_blobs.find(key) == new_blobs.end())
+		{
+			if (!data.isOpen())
+			{
+				if (!data.open(dataPath(), SFile::Mode::Append))
+				{
+					log::error("Unable to open map backup data file \"{}\"", dataPath());
+					return false;
+				}
+
+				offset = data.size();
+			}
+
+			// Offsets in the data file are 32bit
+			if (static_cast<uint64_t>(offset) + lump.size > std::numeric_limits<uint32_t>::max())
+			{
+				log::error("Map backup data file \"{}\" is too large (over 4GB)", dataPath());
+				return false;
+			}
+
+			if (lump.size > 0 && !data.write(entry->rawData(), lump.size))
+			{
+				log::error("Unable to write to map backup data file \"{}\"", dataPath());
+				return false;
+			}
+
+			new_blobs[key] = offset;
+			lines += blobLine(lump.hash, lump.size, offset);
+			offset += lump.size;
+		}
+
+		backup.lumps.push_back(std::move(lump));
+	}
+	data.close();
+
+	// Add it to the index (after the data is written, so an interrupted write
+	// can't leave the index referring to missing data)
+	lines += backupLines(backup);
+	if (!appendIndex(lines))
+		return false;
+
+	blobs_.insert(new_blobs.begin(), new_blobs.end());
+	backups_.push_back(std::move(backup));
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the oldest backups of [map_name] until there are at most
+// [max_backups] of it. The store is compacted if most of its data is then no
+// longer used by any backup
+// -----------------------------------------------------------------------------
+bool MapBackupStore::removeOldBackups(string_view map_name, unsigned max_backups)
+{
+	auto map_backups = backups(map_name);
+	if (map_backups.size() <= max_backups)
+		return true;
+
+	// Add removals to index
+	auto   num_remove = map_backups.size() - max_backups;
+	string lines;
+	for (unsigned a = 0; a < num_remove; a++)
+		lines += fmt::format("remove\t{}\t{}\n", map_backups[a]->timestamp, map_backups[a]->map_name);
+	if (!appendIndex(lines))
+		return false;
+
+	// Remove from list (oldest first)
+	for (auto backup = backups_.begin(); backup != backups_.end() && num_remove > 0;)
+	{
+		if (strutil::equalCI(backup->map_name, map_name))
+		{
+			backup = backups_.erase(backup);
+			--num_remove;
+		}
+		else
+			++backup;
+	}
+
+	// Check how much stored data is still used
+	std::set<BlobKey> used;
+	uint64_t          used_size = 0;
+	for (auto& backup : backups_)
+		for (auto& lump : backup.lumps)
+			if (used.insert({ lump.hash, lump.size }).second)
+				used_size += lump.size;
+
+	// Compact if over half of the data file is unused
+	SFile data(dataPath());
+	if (data.size() > used_size * 2)
+		return compact();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Rewrites the store with only the lump data used by its current backups.
+//
+// The data is written to a new data file and a new index pointing to it then
+// replaces the old one, so the store stays valid if this is interrupted
+// -----------------------------------------------------------------------------
+bool MapBackupStore::compact()
+{
+	// Alternate between two data file names
+	auto fname     = strutil::afterLast(path_, '/');
+	auto data_file = fmt::format("{}.dat", fname);
+	if (data_file == data_file_)
+		data_file = fmt::format("{}_1.dat", fname);
+	auto data_path = fmt::format("{}/{}", strutil::beforeLast(path_, '/'), data_file);
+
+	SFile old_data(dataPath());
+	SFile new_data(data_path, SFile::Mode::Write);
+	if (!old_data.isOpen() || !new_data.isOpen())
+	{
+		log::error("Unable to compact map backups: can't open data files");
+		return false;
+	}
+
+	// Copy used lump data to the new data file
+	auto                        index = fmt::format("{}\ndata\t{}\n", index_header, data_file);
+	std::map<BlobKey, uint32_t> blobs;
+	MemChunk                    lump_data;
+	uint32_t                    offset = 0;
+	for (auto& backup : backups_)
+	{
+		for (auto& lump : backup.lumps)
+		{
+			BlobKey key{ lump.hash, lump.size };
+			if (blobs.find(key) != blobs.end())
+				continue;
+
+			if (lump.size > 0)
+			{
+				if (!old_data.seekFromStart(blobs_[key]) || !old_data.read(lump_data, lump.size)
+					|| !new_data.write(lump_data.data(), lump.size))
+				{
+					log::error("Unable to compact map backups: error copying data");
+					return false;
+				}
+			}
+
+			blobs[key] = offset;
+			index += blobLine(lump.hash, lump.size, offset);
+			offset += lump.size;
+		}
+	}
+	old_data.close();
+	new_data.close();
+
+	for (auto& backup : backups_)
+		index += backupLines(backup);
+
+	// Write the new index and replace the old one with it
+	auto index_path = path_ + ".idx";
+	{
+		SFile file(index_path + ".tmp", SFile::Mode::Write);
+		if (!file.isOpen() || !file.writeStr(index))
+		{
+			log::error("Unable to compact map backups: can't write index");
+			return false;
+		}
+	}
+	if (!wxRenameFile(index_path + ".tmp", index_path, true))
+	{
+		log::error("Unable to compact map backups: can't replace index");
+		return false;
+	}
+
+	// Remove the old data file
+	auto old_path = dataPath();
+	data_file_    = data_file;
+	blobs_        = std::move(blobs);
+	fileutil::removeFile(old_path);
+
+	log::info(2, "Compacted map backups {}", path_);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the full path to the current data file
+// -----------------------------------------------------------------------------
+string MapBackupStore::dataPath() const
+{
+	return fmt::format("{}/{}", strutil::beforeLast(path_, '/'), data_file_);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the store index file.
+// Any stored lumps or backups that are incomplete (eg. if writing them was
+// interrupted) are ignored
+// -----------------------------------------------------------------------------
+bool MapBackupStore::readIndex()
+{
+	string index;
+	if (!fileutil::readFileToString(path_ + ".idx", index))
+		return false;
+
+	std::map<BlobKey, uint32_t> blobs;
+	unsigned                    num_lumps     = 0;
+	bool                        reading_lumps = false;
+
+	// Removes the last backup read if it didn't have all its lumps
+	auto end_backup = [&]()
+	{
+		if (reading_lumps && backups_.back().lumps.size() != num_lumps)
+			backups_.pop_back();
+		reading_lumps = false;
+	};
+
+	for (auto line : strutil::splitV(index, '\n'))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		auto fields = strutil::splitV(line, '\t');
+		if (fields.size() < 2)
+			continue;
+
+		// Lump in current backup
+		if (fields[0] == "lump")
+		{
+			Lump lump;
+			if (reading_lumps && fields.size() == 4 && parseHash(fields[1], lump.hash)
+				&& strutil::toUInt(fields[2], lump.size))
+			{
+				lump.name = fields[3];
+				backups_.back().lumps.push_back(lump);
+			}
+			continue;
+		}
+
+		end_backup();
+
+		// Data file
+		if (fields[0] == "data")
+			data_file_ = fields[1];
+
+		// Stored lump data
+		else if (fields[0] == "blob" && fields.size() == 4)
+		{
+			uint64_t hash;
+			unsigned size, offset;
+			if (parseHash(fields[1], hash) && strutil::toUInt(fields[2], size) && strutil::toUInt(fields[3], offset))
+				blobs[{ hash, size }] = offset;
+		}
+
+		// Backup
+		else if (fields[0] == "backup" && fields.size() == 4)
+		{
+			if (strutil::toUInt(fields[2], num_lumps))
+			{
+				backups_.push_back({ string{ fields[3] }, string{ fields[1] }, {} });
+				reading_lumps = true;
+			}
+		}
+
+		// Removed backup
+		else if (fields[0] == "remove" && fields.size() == 3)
+		{
+			for (auto backup = backups_.begin(); backup != backups_.end(); ++backup)
+				if (backup->timestamp == fields[1] && backup->map_name == fields[2])
+				{
+					backups_.erase(backup);
+					break;
+				}
+		}
+	}
+	end_backup();
+
+	// Ignore any stored lumps past the end of the data file
+	uint64_t data_size = SFile(dataPath()).size();
+	for (auto& blob : blobs)
+		if (static_cast<uint64_t>(blob.second) + blob.first.second <= data_size)
+			blobs_.insert(blob);
+
+	// Ignore any backups with missing lump data
+	backups_.erase(
+		std::remove_if(
+			backups_.begin(),
+			backups_.end(),
+			[this](const Backup& backup)
+			{
+				for (auto& lump : backup.lumps)
+					if (blobs_.find({ lump.hash, lump.size }) == blobs_.end())
+						return true;
+				return false;
+			}),
+		backups_.end());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Imports all backups from the backup zip used by older versions of SLADE
+// -----------------------------------------------------------------------------
+bool MapBackupStore::importLegacyBackups()
+{
+	ZipArchive zip;
+	if (!zip.open(path_ + ".zip"))
+	{
+		log::warning("Unable to open map backup file \"{}.zip\" to import", path_);
+		return true;
+	}
+
+	log::info("Importing map backups from {}.zip", path_);
+
+	// Backups are in <map>/<timestamp> directories
+	for (auto& map_dir : zip.rootDir()->subdirs())
+	{
+		for (auto& backup_dir : map_dir->subdirs())
+		{
+			vector<ArchiveEntry*> entries;
+			for (unsigned a = 0; a < backup_dir->numEntries(); a++)
+				entries.push_back(backup_dir->entryAt(a));
+
+			if (!addBackup(map_dir->name(), backup_dir->name(), entries))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Appends [lines] to the index file, creating it if needed
+// -----------------------------------------------------------------------------
+bool MapBackupStore::appendIndex(const string& lines) const
+{
+	auto path   = path_ + ".idx";
+	auto header = !fileutil::fileExists(path);
+
+	SFile file(path, SFile::Mode::Append);
+	if (!file.isOpen()
+		|| (header && !file.writeStr(fmt::format("{}\ndata\t{}\n", index_header, data_file_)))
+		|| !file.writeStr(lines))
+	{
+		log::error("Unable to write to map backup index \"{}.idx\"", path_);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+namespace slade
+{
+class ArchiveEntry;
+
+// An append-only, content-addressed store of map backups for an archive.
+//
+// The data of each unique lump (identified by its content hash and size) is
+// stored once in a data file, and an index file records where each lump's data
+// is along with the list of lumps in each backup. Writing a backup only appends
+// any lumps that aren't already stored and a few lines to the index, and
+// listing backups only needs to read the index
+class MapBackupStore
+{
+public:
+	struct Lump
+	{
+		string   name;
+		uint64_t hash = 0;
+		uint32_t size = 0;
+
+		bool operator==(const Lump& rhs) const { return hash == rhs.hash && size == rhs.size && name == rhs.name; }
+		bool operator!=(const Lump& rhs) const { return !(*this == rhs); }
+	};
+
+	struct Backup
+	{
+		string       map_name;
+		string       timestamp;
+		vector<Lump> lumps;
+	};
+
+	MapBackupStore(string_view archive_name);
+	~MapBackupStore() = default;
+
+	bool open();
+
+	vector<const Backup*> backups(string_view map_name) const;
+	const Backup*         lastBackup(string_view map_name) const;
+	bool                  isLastBackup(string_view map_name, const vector<ArchiveEntry*>& entries) const;
+	bool readLump(const Lump& lump, MemChunk& data) const;
+
+	bool addBackup(string_view map_name, string_view timestamp, const vector<ArchiveEntry*>& entries);
+	bool removeOldBackups(string_view map_name, unsigned max_backups);
+	bool compact();
+
+private:
+	typedef std::pair<uint64_t, uint32_t> BlobKey; // Hash, size
+
+	string                      path_;      // Path to the store files, minus extension
+	string                      data_file_; // Name of the data file (changes when compacted)
+	std::map<BlobKey, uint32_t> blobs_;     // Offset of each stored lump's data in the data file
+	vector<Backup>              backups_;
+
+	string dataPath() const;
+	bool   readIndex();
+	bool   importLegacyBackups();
+	bool   appendIndex(const string& lines) const;
+};
+} // namespace slade
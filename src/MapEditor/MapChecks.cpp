@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapChecks.h"
+#include "App.h"
 #include "Game/Configuration.h"
 #include "Game/ThingType.h"
 #include "General/SAction.h"
@@ -42,6 +43,7 @@
 #include "UI/Dialogs/ThingTypeBrowser.h"
 #include "Utility/MathStuff.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 
 using namespace slade;
 
@@ -78,6 +80,133 @@ std::map<MapCheck::StandardCheck, StandardCheckInfo> std_checks = {
 } // namespace
 
 
+// -----------------------------------------------------------------------------
+//
+// BBoxGrid Class
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A uniform grid of bounding boxes, used by the checks below to quickly find
+// objects that may overlap each other rather than testing every pair.
+// Read-only once built, so can be queried from multiple threads
+class BBoxGrid
+{
+public:
+	BBoxGrid(const vector<BBox>& boxes)
+	{
+		if (boxes.empty())
+			return;
+
+		// Get the extent of all boxes
+		extent_ = boxes[0];
+		for (auto& box : boxes)
+			extent_.extend(box);
+
+		// Pick a cell size giving roughly one box per cell on average (within
+		// sensible limits)
+		auto width  = std::max(extent_.width(), 1.);
+		auto height = std::max(extent_.height(), 1.);
+		cell_size_  = std::sqrt(width * height / boxes.size());
+		cell_size_  = std::max({ cell_size_, 32., width / 1024., height / 1024. });
+		cols_       = static_cast<int>(width / cell_size_) + 1;
+		rows_       = static_cast<int>(height / cell_size_) + 1;
+
+		// Get the cells each box covers and count boxes in each cell
+		ranges_.resize(boxes.size());
+		cell_start_.assign(cols_ * rows_ + 1, 0);
+		for (unsigned a = 0; a < boxes.size(); a++)
+		{
+			ranges_[a] = cellRange(boxes[a]);
+			forEachCell(ranges_[a], [this](int cell) { cell_start_[cell + 1]++; });
+		}
+
+		// Fill cells (all box indices are stored in one list, grouped by cell)
+		for (unsigned a = 1; a < cell_start_.size(); a++)
+			cell_start_[a] += cell_start_[a - 1];
+		cell_boxes_.resize(cell_start_.back());
+		auto next = cell_start_;
+		for (unsigned a = 0; a < boxes.size(); a++)
+			forEachCell(ranges_[a], [&](int cell) { cell_boxes_[next[cell]++] = a; });
+	}
+
+	// Calls [func] with the index of every box sharing a grid cell with [box].
+	// Each box is only given once
+	template<typename F> void forEachNear(const BBox& box, F&& func) const
+	{
+		if (ranges_.empty())
+			return;
+
+		auto range = cellRange(box);
+		for (int y = range.y1; y <= range.y2; y++)
+			for (int x = range.x1; x <= range.x2; x++)
+			{
+				auto cell = y * cols_ + x;
+				for (auto i = cell_start_[cell]; i < cell_start_[cell + 1]; i++)
+				{
+					// Boxes spanning multiple cells are only given in the first
+					// cell they share with [box]
+					auto  index = cell_boxes_[i];
+					auto& other = ranges_[index];
+					if (x == std::max(range.x1, other.x1) && y == std::max(range.y1, other.y1))
+						func(index);
+				}
+			}
+	}
+
+private:
+	struct CellRange
+	{
+		int x1, y1, x2, y2;
+	};
+
+	BBox             extent_;
+	double           cell_size_ = 1.;
+	int              cols_      = 0;
+	int              rows_      = 0;
+	vector<CellRange> ranges_;     // Cells covered by each box
+	vector<unsigned>  cell_start_; // Start of each cell in cell_boxes_
+	vector<unsigned>  cell_boxes_;
+
+	int cellX(double x) const
+	{
+		return std::clamp(static_cast<int>((x - extent_.min.x) / cell_size_), 0, cols_ - 1);
+	}
+	int cellY(double y) const
+	{
+		return std::clamp(static_cast<int>((y - extent_.min.y) / cell_size_), 0, rows_ - 1);
+	}
+
+	CellRange cellRange(const BBox& box) const
+	{
+		return { cellX(std::min(box.min.x, box.max.x)),
+				 cellY(std::min(box.min.y, box.max.y)),
+				 cellX(std::max(box.min.x, box.max.x)),
+				 cellY(std::max(box.min.y, box.max.y)) };
+	}
+
+	template<typename F> void forEachCell(const CellRange& range, F&& func) const
+	{
+		for (int y = range.y1; y <= range.y2; y++)
+			for (int x = range.x1; x <= range.x2; x++)
+				func(y * cols_ + x);
+	}
+};
+
+// -----------------------------------------------------------------------------
+// Returns the bounding box of [line]
+// -----------------------------------------------------------------------------
+BBox lineBBox(const MapLine* line)
+{
+	auto  seg = line->seg();
+	BBox  bbox;
+	bbox.min = { std::min(seg.x1(), seg.x2()), std::min(seg.y1(), seg.y2()) };
+	bbox.max = { std::max(seg.x1(), seg.x2()), std::max(seg.y1(), seg.y2()) };
+	return bbox;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 // MissingTextureCheck Class
 //
@@ -493,30 +622,41 @@ class LinesIntersectCheck : public MapCheck
 public:
 	LinesIntersectCheck(SLADEMap* map) : MapCheck(map) {}
 
-	void checkIntersections(vector<MapLine*> lines)
+	void checkIntersections(const vector<MapLine*>& lines)
 	{
-		Vec2d    pos;
-		MapLine* line1;
-		MapLine* line2;
-
 		// Clear existing intersections
 		intersections_.clear();
 
-		// Go through lines
+		// Build grid of line bounding boxes
+		vector<BBox> boxes(lines.size());
 		for (unsigned a = 0; a < lines.size(); a++)
-		{
-			line1 = lines[a];
-
-			// Go through uncompared lines
-			for (unsigned b = a + 1; b < lines.size(); b++)
+			boxes[a] = lineBBox(lines[a]);
+		BBoxGrid grid(boxes);
+
+		// Go through lines, checking each against any uncompared lines near it
+		vector<vector<Intersection>> found(lines.size());
+		app::threadPool().parallelFor(
+			lines.size(),
+			[&](size_t a)
 			{
-				line2 = lines[b];
+				vector<std::pair<unsigned, Vec2d>> hits;
+				Vec2d                              pos;
+				grid.forEachNear(
+					boxes[a],
+					[&](unsigned b)
+					{
+						if (b > a && lines[a]->intersects(lines[b], pos))
+							hits.emplace_back(b, pos);
+					});
 
-				// Check intersection
-				if (line1->intersects(line2, pos))
-					intersections_.emplace_back(line1, line2, pos.x, pos.y);
-			}
-		}
+				// Keep the same order as comparing every pair would
+				std::sort(hits.begin(), hits.end(), [](auto& l, auto& r) { return l.first < r.first; });
+				for (auto& hit : hits)
+					found[a].emplace_back(lines[a], lines[hit.first], hit.second.x, hit.second.y);
+			});
+
+		for (auto& list : found)
+			intersections_.insert(intersections_.end(), list.begin(), list.end());
 	}
 
 	void doCheck() override
@@ -530,6 +670,8 @@ public:
 		checkIntersections(all_lines);
 	}
 
+	bool canRunAsync() const override { return true; }
+
 	unsigned nProblems() override { return intersections_.size(); }
 
 	string problemDesc(unsigned index) override
@@ -642,24 +784,33 @@ public:
 
 	void doCheck() override
 	{
-		// Go through lines
+		// Group lines by their (unordered) vertex pair, any lines sharing both
+		// vertices will end up in the same group
+		std::map<std::pair<MapVertex*, MapVertex*>, vector<unsigned>> groups;
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
-			auto line1 = map_->line(a);
-
-			// Go through uncompared lines
-			for (unsigned b = a + 1; b < map_->nLines(); b++)
-			{
-				auto line2 = map_->line(b);
+			auto line = map_->line(a);
+			auto v1   = std::min(line->v1(), line->v2());
+			auto v2   = std::max(line->v1(), line->v2());
+			groups[{ v1, v2 }].push_back(a);
+		}
 
-				// Check for overlap (both vertices shared)
-				if ((line1->v1() == line2->v1() && line1->v2() == line2->v2())
-					|| (line1->v2() == line2->v1() && line1->v1() == line2->v2()))
-					overlaps_.emplace_back(line1, line2);
-			}
+		// Add each pair of lines within a group as an overlap
+		vector<std::pair<unsigned, unsigned>> pairs;
+		for (auto& group : groups)
+		{
+			auto& lines = group.second;
+			for (unsigned a = 0; a < lines.size(); a++)
+				for (unsigned b = a + 1; b < lines.size(); b++)
+					pairs.emplace_back(lines[a], lines[b]);
 		}
+		std::sort(pairs.begin(), pairs.end());
+		for (auto& pair : pairs)
+			overlaps_.emplace_back(map_->line(pair.first), map_->line(pair.second));
 	}
 
+	bool canRunAsync() const override { return true; }
+
 	unsigned nProblems() override { return overlaps_.size(); }
 
 	string problemDesc(unsigned index) override
@@ -745,156 +896,123 @@ class ThingsOverlapCheck : public MapCheck
 public:
 	ThingsOverlapCheck(SLADEMap* map) : MapCheck(map) {}
 
-	void doCheck() override
+	// Gets the config-dependent info needed for each thing. This is done
+	// before the check itself since the game configuration isn't safe to
+	// access from multiple threads
+	void prepare() override
 	{
-		double r1, r2;
+		auto map_format = map_->currentFormat();
+		bool udmf_zdoom =
+			(map_format == MapFormat::UDMF && strutil::equalCI(game::configuration().udmfNamespace(), "zdoom"));
+		bool udmf_eternity =
+			(map_format == MapFormat::UDMF && strutil::equalCI(game::configuration().udmfNamespace(), "eternity"));
+		int min_skill = udmf_zdoom || udmf_eternity ? 1 : 2;
+		int max_skill = udmf_zdoom ? 17 : 5;
+		int max_class = udmf_zdoom ? 17 : 4;
 
-		// Go through things
+		things_.clear();
+		things_.resize(map_->nThings());
 		for (unsigned a = 0; a < map_->nThings(); a++)
 		{
-			auto  thing1 = map_->thing(a);
-			auto& tt1    = game::configuration().thingType(thing1->type());
-			r1           = tt1.radius() - 1;
+			auto  thing = map_->thing(a);
+			auto& tt    = game::configuration().thingType(thing->type());
+			auto& info  = things_[a];
 
 			// Ignore if no radius
-			if (r1 < 0 || !tt1.solid())
+			info.radius = tt.radius() - 1;
+			info.check  = info.radius >= 0 && tt.solid();
+			if (!info.check)
 				continue;
 
-			// Go through uncompared things
-			auto map_format = map_->currentFormat();
-			bool udmf_zdoom =
-				(map_format == MapFormat::UDMF && strutil::equalCI(game::configuration().udmfNamespace(), "zdoom"));
-			bool udmf_eternity =
-				(map_format == MapFormat::UDMF && strutil::equalCI(game::configuration().udmfNamespace(), "eternity"));
-			int min_skill = udmf_zdoom || udmf_eternity ? 1 : 2;
-			int max_skill = udmf_zdoom ? 17 : 5;
-			int max_class = udmf_zdoom ? 17 : 4;
-
-			for (unsigned b = a + 1; b < map_->nThings(); b++)
-			{
-				auto  thing2 = map_->thing(b);
-				auto& tt2    = game::configuration().thingType(thing2->type());
-				r2           = tt2.radius() - 1;
+			// Skill levels
+			for (int s = min_skill; s < max_skill; ++s)
+				if (game::configuration().thingBasicFlagSet(fmt::format("skill{}", s), thing, map_format))
+					info.skills |= 1 << s;
 
-				// Ignore if no radius
-				if (r2 < 0 || !tt2.solid())
-					continue;
+			// Game modes
+			info.single = game::configuration().thingBasicFlagSet("single", thing, map_format);
+			info.coop   = game::configuration().thingBasicFlagSet("coop", thing, map_format);
+			info.dm     = game::configuration().thingBasicFlagSet("dm", thing, map_format);
 
-				// Check flags
-				// Case #1: different skill levels
-				bool shareflag = false;
-				for (int s = min_skill; s < max_skill; ++s)
-				{
-					auto skill = fmt::format("skill{}", s);
-					if (game::configuration().thingBasicFlagSet(skill, thing1, map_format)
-						&& game::configuration().thingBasicFlagSet(skill, thing2, map_format))
-					{
-						shareflag = true;
-						s         = max_skill;
-					}
-				}
-				if (!shareflag)
-					continue;
+			// Player starts
+			// P1 are automatically S and C; P2+ are automatically C;
+			// Deathmatch starts are automatically D, and team start are T.
+			if (tt.flags() & game::ThingType::Flags::CoOpStart)
+			{
+				info.coop_start = true;
+				info.coop       = true;
+				info.dm = info.team = false;
+				info.single         = thing->type() == 1;
+			}
+			else if (tt.flags() & game::ThingType::Flags::DMStart)
+			{
+				info.single = info.coop = info.team = false;
+				info.dm                             = true;
+			}
+			else if (tt.flags() & game::ThingType::Flags::TeamStart)
+			{
+				info.single = info.coop = info.dm = false;
+				info.team                         = true;
+			}
 
-				// Booleans for single, coop, deathmatch, and teamgame status for each thing
-				bool s1, s2, c1, c2, d1, d2, t1, t2;
-				s1 = game::configuration().thingBasicFlagSet("single", thing1, map_format);
-				s2 = game::configuration().thingBasicFlagSet("single", thing2, map_format);
-				c1 = game::configuration().thingBasicFlagSet("coop", thing1, map_format);
-				c2 = game::configuration().thingBasicFlagSet("coop", thing2, map_format);
-				d1 = game::configuration().thingBasicFlagSet("dm", thing1, map_format);
-				d2 = game::configuration().thingBasicFlagSet("dm", thing2, map_format);
-				t1 = t2 = false;
-
-				// Player starts
-				// P1 are automatically S and C; P2+ are automatically C;
-				// Deathmatch starts are automatically D, and team start are T.
-				if (tt1.flags() & game::ThingType::Flags::CoOpStart)
-				{
-					c1 = true;
-					d1 = t1 = false;
-					if (thing1->type() == 1)
-						s1 = true;
-					else
-						s1 = false;
-				}
-				else if (tt1.flags() & game::ThingType::Flags::DMStart)
-				{
-					s1 = c1 = t1 = false;
-					d1           = true;
-				}
-				else if (tt1.flags() & game::ThingType::Flags::TeamStart)
-				{
-					s1 = c1 = d1 = false;
-					t1           = true;
-				}
-				if (tt2.flags() & game::ThingType::Flags::CoOpStart)
-				{
-					c2 = true;
-					d2 = t2 = false;
-					if (thing2->type() == 1)
-						s2 = true;
-					else
-						s2 = false;
-				}
-				else if (tt2.flags() & game::ThingType::Flags::DMStart)
-				{
-					s2 = c2 = t2 = false;
-					d2           = true;
-				}
-				else if (tt2.flags() & game::ThingType::Flags::TeamStart)
-				{
-					s2 = c2 = d2 = false;
-					t2           = true;
-				}
+			// Classes
+			for (int c = 1; c < max_class; ++c)
+				if (game::configuration().thingBasicFlagSet(fmt::format("class{}", c), thing, map_format))
+					info.classes |= 1 << c;
 
-				// Case #2: different game modes (single, coop, dm)
-				shareflag = false;
-				if ((c1 && c2) || (d1 && d2) || (t1 && t2))
-				{
-					shareflag = true;
-				}
-				if (!shareflag && s1 && s2)
-				{
-					// Case #3: things flagged for single player with different class filters
-					for (int c = 1; c < max_class; ++c)
-					{
-						auto pclass = fmt::format("class{}", c);
-						if (game::configuration().thingBasicFlagSet(pclass, thing1, map_format)
-							&& game::configuration().thingBasicFlagSet(pclass, thing2, map_format))
-						{
-							shareflag = true;
-							c         = max_class;
-						}
-					}
-				}
-				if (!shareflag)
-					continue;
+			info.arg0 = thing->arg(0);
+		}
 
-				// Also check player start spots in Hexen-style hubs
-				shareflag = false;
-				if (tt1.flags() & game::ThingType::Flags::CoOpStart && tt2.flags() & game::ThingType::Flags::CoOpStart)
-				{
-					if (thing1->arg(0) == thing2->arg(0))
-						shareflag = true;
-				}
-				if (!shareflag)
-					continue;
+		prepared_ = true;
+	}
 
-				// Check x non-overlap
-				if (thing2->xPos() + r2 < thing1->xPos() - r1 || thing2->xPos() - r2 > thing1->xPos() + r1)
-					continue;
+	void doCheck() override
+	{
+		if (!prepared_)
+			prepare();
+		prepared_ = false;
 
-				// Check y non-overlap
-				if (thing2->yPos() + r2 < thing1->yPos() - r1 || thing2->yPos() - r2 > thing1->yPos() + r1)
-					continue;
+		// Build grid of thing bounding boxes (only things that need checking)
+		vector<unsigned> check_things;
+		vector<BBox>     boxes;
+		for (unsigned a = 0; a < things_.size(); a++)
+		{
+			if (!things_[a].check)
+				continue;
 
-				// Overlap detected
-				overlaps_.emplace_back(thing1, thing2);
-			}
+			auto  pos = map_->thing(a)->position();
+			auto  r   = things_[a].radius;
+			BBox  bbox;
+			bbox.min = { pos.x - r, pos.y - r };
+			bbox.max = { pos.x + r, pos.y + r };
+			check_things.push_back(a);
+			boxes.push_back(bbox);
 		}
+		BBoxGrid grid(boxes);
+
+		// Go through things, checking each against any uncompared things near it
+		vector<vector<unsigned>> found(check_things.size());
+		app::threadPool().parallelFor(
+			check_things.size(),
+			[&](size_t a)
+			{
+				grid.forEachNear(
+					boxes[a],
+					[&](unsigned b)
+					{
+						if (b > a && thingsOverlap(check_things[a], check_things[b]))
+							found[a].push_back(check_things[b]);
+					});
+				std::sort(found[a].begin(), found[a].end());
+			});
+
+		for (unsigned a = 0; a < found.size(); a++)
+			for (auto b : found[a])
+				overlaps_.emplace_back(map_->thing(check_things[a]), map_->thing(b));
 	}
 
+	bool canRunAsync() const override { return true; }
+
 	unsigned nProblems() override { return overlaps_.size(); }
 
 	string problemDesc(unsigned index) override
@@ -965,6 +1083,59 @@ public:
 	}
 
 private:
+	// Thing info relevant to the check
+	struct ThingInfo
+	{
+		double   radius     = 0;
+		bool     check      = false;
+		unsigned skills     = 0;
+		unsigned classes    = 0;
+		bool     single     = false;
+		bool     coop       = false;
+		bool     dm         = false;
+		bool     team       = false;
+		bool     coop_start = false;
+		int      arg0       = 0;
+	};
+	vector<ThingInfo> things_;
+	bool              prepared_ = false;
+
+	// Returns true if the things at [index1] and [index2] overlap
+	bool thingsOverlap(unsigned index1, unsigned index2) const
+	{
+		auto& info1 = things_[index1];
+		auto& info2 = things_[index2];
+
+		// Case #1: different skill levels
+		if (!(info1.skills & info2.skills))
+			return false;
+
+		// Case #2: different game modes (single, coop, dm)
+		bool shareflag = (info1.coop && info2.coop) || (info1.dm && info2.dm) || (info1.team && info2.team);
+
+		// Case #3: things flagged for single player with different class filters
+		if (!shareflag && info1.single && info2.single)
+			shareflag = info1.classes & info2.classes;
+		if (!shareflag)
+			return false;
+
+		// Also check player start spots in Hexen-style hubs
+		if (!(info1.coop_start && info2.coop_start && info1.arg0 == info2.arg0))
+			return false;
+
+		// Check x/y non-overlap
+		auto pos1 = map_->thing(index1)->position();
+		auto pos2 = map_->thing(index2)->position();
+		auto r1   = info1.radius;
+		auto r2   = info2.radius;
+		if (pos2.x + r2 < pos1.x - r1 || pos2.x - r2 > pos1.x + r1)
+			return false;
+		if (pos2.y + r2 < pos1.y - r1 || pos2.y - r2 > pos1.y + r1)
+			return false;
+
+		return true;
+	}
+
 	struct Overlap
 	{
 		MapThing* thing1;
@@ -1347,53 +1518,88 @@ class StuckThingsCheck : public MapCheck
 public:
 	StuckThingsCheck(SLADEMap* map) : MapCheck(map) {}
 
-	void doCheck() override
+	// Gets the lines and thing radii to check. This is done before the check
+	// itself since the game configuration isn't safe to access from multiple
+	// threads
+	void prepare() override
 	{
-		double radius;
-
 		// Get list of lines to check
-		vector<MapLine*> check_lines;
-		MapLine*         line;
+		check_lines_.clear();
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
-			line = map_->line(a);
+			auto line = map_->line(a);
 
 			// Skip if line is 2-sided and not blocking
 			if (line->s2() && !game::configuration().lineBasicFlagSet("blocking", line, map_->currentFormat()))
 				continue;
 
-			check_lines.push_back(line);
+			check_lines_.push_back(line);
 		}
 
-		// Go through things
+		// Get radius of each solid thing
+		check_things_.clear();
 		for (unsigned a = 0; a < map_->nThings(); a++)
 		{
 			auto  thing = map_->thing(a);
 			auto& tt    = game::configuration().thingType(thing->type());
 
 			// Skip if not a solid thing
-			if (!tt.solid())
-				continue;
+			if (tt.solid())
+				check_things_.emplace_back(thing, tt.radius() - 1);
+		}
 
-			radius = tt.radius() - 1;
-			Rectf bbox(thing->xPos(), thing->yPos(), radius * 2, radius * 2, 1);
+		prepared_ = true;
+	}
 
-			// Go through lines
-			for (auto& check_line : check_lines)
+	void doCheck() override
+	{
+		if (!prepared_)
+			prepare();
+		prepared_ = false;
+
+		// Build grid of line bounding boxes
+		vector<BBox> boxes(check_lines_.size());
+		for (unsigned a = 0; a < check_lines_.size(); a++)
+			boxes[a] = lineBBox(check_lines_[a]);
+		BBoxGrid grid(boxes);
+
+		// Go through things, finding the first line (if any) each is stuck in
+		vector<unsigned> stuck_line(check_things_.size());
+		app::threadPool().parallelFor(
+			check_things_.size(),
+			[&](size_t a)
 			{
-				line = check_line;
+				auto  thing  = check_things_[a].first;
+				auto  radius = check_things_[a].second;
+				Rectf bbox(thing->xPos(), thing->yPos(), radius * 2, radius * 2, 1);
+
+				BBox area;
+				area.min = { thing->xPos() - std::abs(radius), thing->yPos() - std::abs(radius) };
+				area.max = { thing->xPos() + std::abs(radius), thing->yPos() + std::abs(radius) };
+
+				auto first = static_cast<unsigned>(check_lines_.size());
+				grid.forEachNear(
+					area,
+					[&](unsigned b)
+					{
+						if (b < first && math::boxLineIntersect(bbox, check_lines_[b]->seg()))
+							first = b;
+					});
+				stuck_line[a] = first;
+			});
 
-				// Check intersection
-				if (math::boxLineIntersect(bbox, line->seg()))
-				{
-					things_.push_back(thing);
-					lines_.push_back(line);
-					break;
-				}
+		for (unsigned a = 0; a < check_things_.size(); a++)
+		{
+			if (stuck_line[a] < check_lines_.size())
+			{
+				things_.push_back(check_things_[a].first);
+				lines_.push_back(check_lines_[stuck_line[a]]);
 			}
 		}
 	}
 
+	bool canRunAsync() const override { return true; }
+
 	unsigned nProblems() override { return things_.size(); }
 
 	string problemDesc(unsigned index) override
@@ -1455,6 +1661,10 @@ public:
 private:
 	vector<MapLine*>  lines_;
 	vector<MapThing*> things_;
+
+	vector<MapLine*>                    check_lines_;
+	vector<std::pair<MapThing*, double>> check_things_; // Solid things and their radius
+	bool                                prepared_ = false;
 };
 
 
@@ -2017,3 +2227,59 @@ string MapCheck::standardCheckId(StandardCheck type)
 {
 	return std_checks[type].id;
 }
+
+// -----------------------------------------------------------------------------
+// Runs all [checks], writing the time each took (in ms) to [times].
+// Checks that support it are run concurrently, and the rest are run one at a
+// time afterwards. [progress] (if given) is called with the progress text of
+// each check before it is run
+// -----------------------------------------------------------------------------
+void MapCheck::runChecks(
+	const vector<MapCheck*>&                 checks,
+	vector<long>&                            times,
+	const std::function<void(const string&)>& progress)
+{
+	times.assign(checks.size(), 0);
+
+	// Prepare checks that can run concurrently
+	vector<unsigned> async_checks;
+	for (unsigned a = 0; a < checks.size(); a++)
+	{
+		if (!checks[a]->canRunAsync())
+			continue;
+
+		if (progress)
+			progress(checks[a]->progressText());
+
+		auto start = app::runTimer();
+		checks[a]->prepare();
+		times[a] = app::runTimer() - start;
+		async_checks.push_back(a);
+	}
+
+	// Run them
+	app::threadPool().parallelFor(
+		async_checks.size(),
+		[&](size_t a)
+		{
+			auto index = async_checks[a];
+			auto start = app::runTimer();
+			checks[index]->doCheck();
+			times[index] += app::runTimer() - start;
+		},
+		1);
+
+	// Run remaining checks
+	for (unsigned a = 0; a < checks.size(); a++)
+	{
+		if (checks[a]->canRunAsync())
+			continue;
+
+		if (progress)
+			progress(checks[a]->progressText());
+
+		auto start = app::runTimer();
+		checks[a]->doCheck();
+		times[a] = app::runTimer() - start;
+	}
+}
@@ -42,11 +42,22 @@ public:
 	virtual string     progressText() { return "Checking..."; }
 	virtual string     fixText(unsigned fix_type, unsigned index) { return ""; }
 
+	// Checks that can run alongside other checks do any work that isn't
+	// thread-safe (eg. game configuration lookups) in prepare, which is always
+	// called from the main thread before doCheck
+	virtual bool canRunAsync() const { return false; }
+	virtual void prepare() {}
+
 	static unique_ptr<MapCheck> standardCheck(StandardCheck type, SLADEMap* map, MapTextureManager* texman = nullptr);
 	static unique_ptr<MapCheck> standardCheck(string_view type_id, SLADEMap* map, MapTextureManager* texman = nullptr);
 	static string               standardCheckDesc(StandardCheck type);
 	static string               standardCheckId(StandardCheck type);
 
+	static void runChecks(
+		const vector<MapCheck*>&                 checks,
+		vector<long>&                            times,
+		const std::function<void(const string&)>& progress = {});
+
 protected:
 	SLADEMap* map_;
 };
@@ -50,6 +50,7 @@
 #include "UI/MapCanvas.h"
 #include "UI/MapEditorWindow.h"
 #include "UndoSteps.h"
+#include "Utility/MathStuff.h"
 #include "Utility/StringUtils.h"
 
 using namespace slade;
@@ -306,6 +307,10 @@ bool MapEditContext::update(long frametime)
 	// Get frame time multiplier
 	double mult = (double)frametime / 10.0f;
 
+	// Refresh renderer textures if any have finished loading in the background
+	if (mapeditor::textureManager().updateLoading())
+		renderer_.refreshTextures();
+
 	// 3d mode
 	if (edit_mode_ == Mode::Visual && !overlayActive())
 	{
@@ -2449,12 +2454,15 @@ CONSOLE_COMMAND(m_check, 0, true)
 	}
 
 	// Run checks
+	vector<MapCheck*> run_checks;
 	for (auto& check : checks)
-	{
-		// Run
-		log::console(check->progressText());
-		check->doCheck();
+		run_checks.push_back(check.get());
+	vector<long> times;
+	MapCheck::runChecks(run_checks, times, [](const string& text) { log::console(text); });
 
+	// List results
+	for (auto& check : checks)
+	{
 		// Check if no problems found
 		if (check->nProblems() == 0)
 			log::console(check->problemDesc(0));
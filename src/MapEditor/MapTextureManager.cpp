@@ -35,11 +35,14 @@
 #include "App.h"
 #include "Archive/ArchiveEntry.h"
 #include "Archive/ArchiveManager.h"
+#include "Archive/EntryType/EntryType.h"
 #include "Game/Configuration.h"
 #include "General/Misc.h"
 #include "General/ResourceManager.h"
 #include "Graphics/CTexture/CTexture.h"
+#include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
+#include "Graphics/Translation.h"
 #include "MainEditor/MainEditor.h"
 #include "MainEditor/UI/MainWindow.h"
 #include "MapEditContext.h"
@@ -47,6 +50,8 @@
 #include "OpenGL/OpenGL.h"
 #include "UI/Controls/PaletteChooser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
+#include <queue>
 
 using namespace slade;
 
@@ -61,6 +66,360 @@ namespace
 MapTextureManager::Texture tex_invalid;
 }
 CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
+CVAR(Bool, map_tex_async, true, CVar::Flag::Save)
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTextureManager::LoadJob Struct
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// An image to be loaded (and composited, translated etc.) for a texture, flat
+// or sprite. Everything [load] needs is copied when the job is created on the
+// main thread, so it can be run on a background thread without accessing any
+// resources or archive entries
+// -----------------------------------------------------------------------------
+struct MapTextureManager::LoadJob
+{
+	enum class State
+	{
+		Queued,
+		Loading,
+		Finished,
+		Failed,
+		Cancelled
+	};
+
+	std::function<bool(LoadJob&)> load;
+	std::atomic<State>            state{ State::Queued };
+	unsigned                      frame = 0; // Frame the image was last requested in (queue priority)
+	unsigned                      order = 0; // Order it was requested in within that frame
+
+	// Load state/results
+	Palette palette; // Copy of the resource palette, to load with
+	SImage  image;
+	bool    world_panning = false;
+	Vec2d   scale         = { 1., 1. };
+	bool    image_palette = false; // Create the GL texture using the image's palette rather than the resource palette
+};
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTextureManager::LoadQueue Struct
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Queue of images waiting to be loaded on the thread pool, ordered by when they
+// were last requested. Anything requested while drawing the latest frame is
+// currently on screen, so is loaded first (in the order it was drawn), and
+// anything that is no longer being requested (eg. after moving the view) drops
+// behind it.
+//
+// Re-requesting a queued job adds a new item for it with the updated priority
+// rather than reordering the queue; items that no longer match their job's
+// current priority are skipped when popped
+// -----------------------------------------------------------------------------
+struct MapTextureManager::LoadQueue
+{
+	struct Item
+	{
+		unsigned            frame;
+		unsigned            order;
+		shared_ptr<LoadJob> job;
+
+		bool operator<(const Item& rhs) const
+		{
+			return frame != rhs.frame ? frame < rhs.frame : order > rhs.order;
+		}
+	};
+
+	std::mutex                mutex;
+	std::condition_variable   cv_loaded;
+	std::priority_queue<Item> queue;
+	std::atomic<unsigned>     pending{ 0 };
+	std::atomic<unsigned>     finished{ 0 };
+
+	// Adds [job] to the queue with the given priority
+	void add(const shared_ptr<LoadJob>& job, unsigned frame, unsigned order)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job->frame = frame;
+		job->order = order;
+		queue.push({ frame, order, job });
+		++pending;
+	}
+
+	// Moves [job] up to the given priority if it is still queued and hasn't
+	// already been requested in [frame]
+	void prioritise(const shared_ptr<LoadJob>& job, unsigned frame, unsigned order)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (job->state != LoadJob::State::Queued || job->frame == frame)
+			return;
+
+		job->frame = frame;
+		job->order = order;
+		queue.push({ frame, order, job });
+	}
+
+	// Takes [job] from the queue if it hasn't started loading yet.
+	// Returns false if it has already been taken
+	bool take(LoadJob& job)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (job.state != LoadJob::State::Queued)
+			return false;
+
+		job.state = LoadJob::State::Loading;
+		return true;
+	}
+
+	// Runs [job], which must have been taken from the queue (or never added to
+	// it if [queued] is false)
+	void run(LoadJob& job, bool queued = true)
+	{
+		auto loaded = job.load(job);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job.state = loaded ? LoadJob::State::Finished : LoadJob::State::Failed;
+		}
+		cv_loaded.notify_all();
+
+		if (queued)
+		{
+			--pending;
+			++finished;
+		}
+	}
+
+	// Waits for [job] to finish if it is currently being loaded on another thread
+	void wait(LoadJob& job)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv_loaded.wait(lock, [&job]() { return job.state != LoadJob::State::Loading; });
+	}
+
+	// Loads the highest priority image in the queue (if any)
+	void runNext()
+	{
+		shared_ptr<LoadJob> job;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			while (!queue.empty())
+			{
+				auto item = queue.top();
+				queue.pop();
+
+				// Skip outdated items
+				if (item.job->state != LoadJob::State::Queued || item.job->frame != item.frame
+					|| item.job->order != item.order)
+					continue;
+
+				job        = item.job;
+				job->state = LoadJob::State::Loading;
+				break;
+			}
+		}
+
+		if (job)
+			run(*job);
+	}
+
+	// Cancels all jobs that haven't started loading yet
+	void cancel()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!queue.empty())
+		{
+			auto& job = queue.top().job;
+			if (job->state == LoadJob::State::Queued)
+			{
+				job->state = LoadJob::State::Cancelled;
+				--pending;
+			}
+			queue.pop();
+		}
+	}
+};
+
+
+// -----------------------------------------------------------------------------
+//
+// Background Loading Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+using LoadJob = MapTextureManager::LoadJob;
+
+// -----------------------------------------------------------------------------
+// A snapshot of an image entry's data (or an image loaded up front), that can
+// be loaded later on any thread regardless of what happens to the entry
+// -----------------------------------------------------------------------------
+class ImageSource
+{
+public:
+	ImageSource(ArchiveEntry* entry)
+	{
+		if (!entry)
+			return;
+
+		// Detect entry type if it isn't already
+		if (entry->type() == EntryType::unknownType())
+			EntryType::detectEntryType(*entry);
+
+		// Check for format "image" property
+		auto type = entry->type();
+		if (!type->extraProps().contains("image"))
+			return;
+
+		// Fonts and Jaguar Doom formats are loaded manually (and may need other
+		// entries), so just load them now (see misc::loadImageFromEntry)
+		auto& format = type->formatId();
+		if (strutil::startsWith(format, "font_") || strutil::startsWith(format, "img_jaguar"))
+		{
+			loaded_ = misc::loadImageFromEntry(&image_, entry);
+			valid_  = loaded_;
+			return;
+		}
+
+		format_hint_ = type->extraProps().getOr<string>("image_format", {});
+		raw_         = format == "img_raw";
+		valid_       = entry->shareData(data_);
+	}
+
+	// Loads a texture-as-patch now
+	ImageSource(CTexture& tex, Archive* parent, Palette* pal) : loaded_{ tex.toImage(image_, parent, pal) }
+	{
+		valid_ = loaded_;
+	}
+
+	// Loads the source image into [image], as misc::loadImageFromEntry would
+	bool load(SImage& image)
+	{
+		if (!valid_)
+			return false;
+
+		if (loaded_)
+			return image.copyImage(&image_);
+
+		// Firstly try SIFormat system
+		if (image.open(data_, 0, format_hint_))
+			return true;
+
+		// Raw images are a special case (not reliably possible to detect just from data)
+		if (raw_ && SIFormat::rawFormat()->isThisFormat(data_))
+			return SIFormat::rawFormat()->loadImage(image, data_);
+
+		// Lastly, try detecting/loading via FreeImage
+		else if (SIFormat::generalFormat()->isThisFormat(data_))
+			return SIFormat::generalFormat()->loadImage(image, data_);
+
+		return false;
+	}
+
+private:
+	MemChunk data_;
+	string   format_hint_;
+	bool     raw_    = false;
+	SImage   image_;
+	bool     loaded_ = false;
+	bool     valid_  = false;
+};
+
+// -----------------------------------------------------------------------------
+// Creates a job to load the image in [entry]
+// -----------------------------------------------------------------------------
+shared_ptr<LoadJob> imageLoadJob(ArchiveEntry* entry)
+{
+	auto job    = std::make_shared<LoadJob>();
+	auto source = std::make_shared<ImageSource>(entry);
+	job->load   = [source](LoadJob& job) { return source->load(job.image); };
+
+	return job;
+}
+
+// -----------------------------------------------------------------------------
+// Creates a job to load the high-res image in [entry], scaled to the size of
+// the image in [ref_entry] (if given)
+// -----------------------------------------------------------------------------
+shared_ptr<LoadJob> hiresLoadJob(ArchiveEntry* entry, ArchiveEntry* ref_entry)
+{
+	auto job    = std::make_shared<LoadJob>();
+	auto source = std::make_shared<ImageSource>(entry);
+	auto ref    = ref_entry ? std::make_shared<ImageSource>(ref_entry) : nullptr;
+	job->load   = [source, ref](LoadJob& job)
+	{
+		if (!source->load(job.image))
+			return false;
+
+		SImage ref_image;
+		if (ref && ref->load(ref_image))
+		{
+			auto w            = static_cast<double>(job.image.width());
+			auto h            = static_cast<double>(job.image.height());
+			job.world_panning = true;
+			job.scale         = { ref_image.width() / w, ref_image.height() / h };
+		}
+
+		return true;
+	};
+
+	return job;
+}
+
+// -----------------------------------------------------------------------------
+// Creates a job to composite [ctex] to an image. The texture is copied and its
+// patches are looked up (in [archive] primarily) now, any textures-as-patches
+// are also loaded now (with [pal])
+// -----------------------------------------------------------------------------
+shared_ptr<LoadJob> compositeLoadJob(CTexture& ctex, Archive* archive, Palette* pal)
+{
+	auto tex = std::make_shared<CTexture>();
+	tex->copyTexture(ctex);
+
+	// Get patch images
+	auto patches = std::make_shared<vector<unique_ptr<ImageSource>>>();
+	for (unsigned a = 0; a < ctex.nPatches(); a++)
+	{
+		if (!ctex.isExtended())
+			patches->push_back(std::make_unique<ImageSource>(ctex.patch(a)->patchEntry(archive)));
+		else if (auto* ptex = ctex.patchTexture(a, archive))
+			patches->push_back(std::make_unique<ImageSource>(*ptex, archive, pal));
+		else
+			patches->push_back(std::make_unique<ImageSource>(ctex.patchImageEntry(a, archive)));
+	}
+
+	auto job  = std::make_shared<LoadJob>();
+	job->load = [tex, patches](LoadJob& job)
+	{
+		auto patch_image = [&patches](unsigned index, SImage& image) { return (*patches)[index]->load(image); };
+		if (!tex->composeImage(job.image, patch_image, &job.palette, true))
+			return false;
+
+		double sx = tex->scaleX();
+		if (sx == 0.0)
+			sx = 1.0;
+		double sy = tex->scaleY();
+		if (sy == 0.0)
+			sy = 1.0;
+
+		job.world_panning = tex->worldPanning();
+		job.scale         = { 1.0 / sx, 1.0 / sy };
+
+		return true;
+	};
+
+	return job;
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -73,7 +432,22 @@ CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
 // -----------------------------------------------------------------------------
 // MapTextureManager class constructor
 // -----------------------------------------------------------------------------
-MapTextureManager::MapTextureManager(shared_ptr<Archive> archive) : archive_{ archive }, palette_{ new Palette() } {}
+MapTextureManager::MapTextureManager(shared_ptr<Archive> archive) :
+	archive_{ archive },
+	palette_{ new Palette() },
+	load_queue_{ std::make_shared<LoadQueue>() }
+{
+}
+
+// -----------------------------------------------------------------------------
+// MapTextureManager class destructor
+// -----------------------------------------------------------------------------
+MapTextureManager::~MapTextureManager()
+{
+	// Any queued loads still on the thread pool keep the queue alive, so just
+	// make sure they don't do anything
+	load_queue_->cancel();
+}
 
 // -----------------------------------------------------------------------------
 // Initialises the texture manager
@@ -142,69 +516,33 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 		mtex.gl_id = 0;
 	}
 
-	// Texture not found or unloaded, look for it
-
-	// Look for composite textures first
-	auto  archive = archive_.lock().get();
-	auto* ctex    = app::resources().getTexture(name, "WallTexture", archive);
-	if (!ctex)
-		ctex = app::resources().getTexture(name, "", archive);
-	if (ctex)
+	// Texture not found or unloaded, look for it (unless it's already loading)
+	if (!mtex.load_job)
 	{
-		SImage image;
-		if (ctex->toImage(image, archive, palette_.get(), true))
+		// Look for composite textures first
+		auto  archive = archive_.lock().get();
+		auto* ctex    = app::resources().getTexture(name, "WallTexture", archive);
+		if (!ctex)
+			ctex = app::resources().getTexture(name, "", archive);
+		if (ctex)
+			startLoad(mtex, compositeLoadJob(*ctex, archive, palette_.get()));
+
+		// No composite match, look for stand-alone textures
+		else
 		{
-			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-
-			double sx = ctex->scaleX();
-			if (sx == 0.0)
-				sx = 1.0;
-			double sy = ctex->scaleY();
-			if (sy == 0.0)
-				sy = 1.0;
+			// HIRES
+			if (auto* etex = app::resources().getHiresEntry(name, archive))
+				startLoad(mtex, hiresLoadJob(etex, app::resources().getTextureEntry(name, "textures", archive)));
 
-			mtex.world_panning = ctex->worldPanning();
-			mtex.scale         = { 1.0 / sx, 1.0 / sy };
+			// TEXTURES
+			else if ((etex = app::resources().getTextureEntry(name, "textures", archive)))
+				startLoad(mtex, imageLoadJob(etex));
 		}
 	}
 
-	// No composite match, look for stand-alone textures
-	else
-	{
-		// HIRES
-		if (auto* etex = app::resources().getHiresEntry(name, archive))
-		{
-			SImage image;
-			if (misc::loadImageFromEntry(&image, etex))
-			{
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-
-				if (auto* ref = app::resources().getTextureEntry(name, "textures", archive))
-				{
-					SImage imgref;
-					if (misc::loadImageFromEntry(&imgref, ref))
-					{
-						int w, h, sw, sh;
-						w                  = image.width();
-						h                  = image.height();
-						sw                 = imgref.width();
-						sh                 = imgref.height();
-						mtex.world_panning = true;
-						mtex.scale         = { (double)sw / (double)w, (double)sh / (double)h };
-					}
-				}
-			}
-		}
-
-		// TEXTURES
-		else
-		{
-			SImage image;
-			etex = app::resources().getTextureEntry(name, "textures", archive);
-			if (misc::loadImageFromEntry(&image, etex))
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-		}
-	}
+	// Use the placeholder until the image is loaded
+	if (mtex.load_job && !finishLoad(mtex, filter))
+		return loadingTexture(false);
 
 	// Not found
 	if (!mtex.gl_id)
@@ -259,65 +597,32 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 		return texture(name, false);
 	}
 
-	// Try composite flat texture
-	if (mixed)
+	// Flat not found or unloaded, look for it (unless it's already loading)
+	if (!mtex.load_job)
 	{
-		if (auto * ctex = app::resources().getTexture(name, "Flat", archive))
-		{
-			SImage image;
-			if (ctex->toImage(image, archive, palette_.get(), true))
-			{
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-
-				double sx = ctex->scaleX();
-				if (sx == 0.0)
-					sx = 1.0;
-				double sy = ctex->scaleY();
-				if (sy == 0.0)
-					sy = 1.0;
+		// Try composite flat texture
+		auto* ctex = mixed ? app::resources().getTexture(name, "Flat", archive) : nullptr;
+		if (ctex)
+			startLoad(mtex, compositeLoadJob(*ctex, archive, palette_.get()));
 
-				mtex.world_panning = ctex->worldPanning();
-				mtex.scale         = { 1.0 / sx, 1.0 / sy };
-
-				return mtex;
-			}
-		}
-	}
-
-	// Try to search for an actual flat
-	if (!mtex.gl_id)
-	{
-		auto* entry = app::resources().getFlatEntry(name, archive);
-		auto* hires_entry = app::resources().getHiresEntry(name, archive);
-		auto* image_entry = hires_entry;
-		auto* scale_entry = entry;
-		
-		// No high-res texture found
-		if (!image_entry)
-		{
-			image_entry = entry;
-			scale_entry = nullptr;
-		}
-		
-		// Load the image
-		SImage image;
-		if (misc::loadImageFromEntry(&image, image_entry))
-			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-		
-		// Get high-res texture scale
-		if (scale_entry)
+		// Try to search for an actual flat
+		else
 		{
-			SImage lores_image;
-			if (misc::loadImageFromEntry(&lores_image, scale_entry))
-			{
-				double scale_x = static_cast<double>(lores_image.width()) / static_cast<double>(image.width());
-				double scale_y = static_cast<double>(lores_image.height()) / static_cast<double>(image.height());
-				mtex.world_panning = true;
-				mtex.scale = { scale_x, scale_y };
-			}
+			auto* entry       = app::resources().getFlatEntry(name, archive);
+			auto* hires_entry = app::resources().getHiresEntry(name, archive);
+
+			// Use high-res texture (scaled to the flat) if found
+			if (hires_entry)
+				startLoad(mtex, hiresLoadJob(hires_entry, entry));
+			else if (entry)
+				startLoad(mtex, imageLoadJob(entry));
 		}
 	}
 
+	// Use the placeholder until the image is loaded
+	if (mtex.load_job && !finishLoad(mtex, filter))
+		return loadingTexture(false);
+
 	// Not found
 	if (!mtex.gl_id)
 	{
@@ -376,66 +681,98 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		}
 	}
 
-	// Sprite not found, look for it
-	bool   found  = false;
-	bool   mirror = false;
-	SImage image;
-	auto   archive = archive_.lock().get();
-	auto   entry   = app::resources().getPatchEntry(name, "sprites", archive);
-	if (!entry)
-		entry = app::resources().getPatchEntry(name, "", archive);
-	if (!entry && name.length() == 8)
-	{
-		string newname{ name };
-		newname[4] = name[6];
-		newname[5] = name[7];
-		newname[6] = name[4];
-		newname[7] = name[5];
-		entry      = app::resources().getPatchEntry(newname, "sprites", archive);
-		if (entry)
-			mirror = true;
-	}
-	if (entry)
-	{
-		found = true;
-		misc::loadImageFromEntry(&image, entry);
-	}
-	else // Try composite textures then
-	{
-		auto ctex = app::resources().getTexture(name, "", archive);
-		if (ctex && ctex->toImage(image, archive, palette_.get(), true))
-			found = true;
-	}
-
-	// We have a valid image either from an entry or a composite texture.
-	if (found)
+	// Sprite not found or unloaded, look for it (unless it's already loading)
+	if (!mtex.load_job)
 	{
-		auto pal = palette_.get();
+		bool   mirror  = false;
+		auto   archive = archive_.lock().get();
+		auto   entry   = app::resources().getPatchEntry(name, "sprites", archive);
+		if (!entry)
+			entry = app::resources().getPatchEntry(name, "", archive);
+		if (!entry && name.length() == 8)
+		{
+			string newname{ name };
+			newname[4] = name[6];
+			newname[5] = name[7];
+			newname[6] = name[4];
+			newname[7] = name[5];
+			entry      = app::resources().getPatchEntry(newname, "sprites", archive);
+			if (entry)
+				mirror = true;
+		}
 
-		// Apply translation
-		if (!translation.empty())
-			image.applyTranslation(translation, pal, true);
+		// Load from the entry, or try composite textures then
+		shared_ptr<LoadJob> job;
+		if (entry)
+			job = imageLoadJob(entry);
+		else if (auto ctex = app::resources().getTexture(name, "", archive))
+			job = compositeLoadJob(*ctex, archive, palette_.get());
 
-		// Apply palette override
-		if (!palette.empty())
+		// We have a valid image either from an entry or a composite texture.
+		if (job)
 		{
-			auto newpal = app::resources().getPaletteEntry(palette, archive);
-			if (newpal && newpal->size() == 768)
+			// Get translation
+			shared_ptr<Translation> trans;
+			if (!translation.empty())
 			{
-				pal = image.palette();
-				pal->loadMem(newpal->data());
+				trans = std::make_shared<Translation>();
+				trans->parse(translation);
 			}
+
+			// Get palette override
+			shared_ptr<Palette> newpal;
+			if (!palette.empty())
+			{
+				auto pal_entry = app::resources().getPaletteEntry(palette, archive);
+				if (pal_entry && pal_entry->size() == 768)
+				{
+					newpal = std::make_shared<Palette>();
+					newpal->loadMem(pal_entry->data());
+				}
+			}
+
+			job->load = [load = std::move(job->load), trans, newpal, mirror](LoadJob& job)
+			{
+				if (!load(job))
+					return false;
+
+				// Sprites aren't scaled
+				job.world_panning = false;
+				job.scale         = { 1., 1. };
+
+				// Apply translation
+				if (trans)
+					job.image.applyTranslation(trans.get(), &job.palette, true);
+
+				// Apply palette override
+				if (newpal)
+				{
+					job.image.palette()->copyPalette(newpal.get());
+					job.image_palette = true;
+				}
+
+				// Apply mirroring
+				if (mirror)
+					job.image.mirror(false);
+
+				return true;
+			};
+
+			startLoad(mtex, job);
 		}
+	}
 
-		// Apply mirroring
-		if (mirror)
-			image.mirror(false);
+	// Turn into GL texture once loaded
+	if (mtex.load_job)
+	{
+		if (!finishLoad(mtex, filter, false))
+			return loadingTexture(true);
 
-		// Turn into GL texture
-		mtex.gl_id = gl::Texture::createFromImage(image, pal, filter, false);
-		return mtex;
+		if (mtex.gl_id)
+			return mtex;
 	}
-	else if (name.back() == '?')
+
+	if (name.back() == '?')
 	{
 		name.remove_suffix(1);
 		auto stex = &sprite(fmt::format("{}0", name), translation, palette);
@@ -491,6 +828,136 @@ int MapTextureManager::verticalOffset(string_view name) const
 	return 0;
 }
 
+// -----------------------------------------------------------------------------
+// Begins drawing a frame of the map. Any textures that aren't loaded yet will
+// be loaded in the background (if enabled) until endFrame is called, and in
+// the meantime a placeholder is returned for them
+// -----------------------------------------------------------------------------
+void MapTextureManager::beginFrame()
+{
+	async_          = map_tex_async && app::threadPool().numThreads() > 0;
+	frame_requests_ = 0;
+	++frame_;
+}
+
+// -----------------------------------------------------------------------------
+// Ends drawing a frame of the map, textures are loaded immediately again
+// -----------------------------------------------------------------------------
+void MapTextureManager::endFrame()
+{
+	async_ = false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if any textures loading in the background have finished since
+// this was last called, and anything using them (ie. the renderer) should be
+// refreshed.
+// To avoid refreshing constantly while lots of textures are being loaded, this
+// only happens once all queued textures are loaded, or at most every 250ms
+// -----------------------------------------------------------------------------
+bool MapTextureManager::updateLoading()
+{
+	unsigned finished = load_queue_->finished;
+	if (finished == loads_finished_)
+		return false;
+
+	auto time = app::runTimer();
+	if (load_queue_->pending > 0 && time - last_load_check_ < 250)
+		return false;
+
+	loads_finished_  = finished;
+	last_load_check_ = time;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Starts loading the image for [mtex] via [job]. If background loading is
+// active the job is queued on the thread pool, otherwise it is run immediately
+// -----------------------------------------------------------------------------
+void MapTextureManager::startLoad(Texture& mtex, shared_ptr<LoadJob> job)
+{
+	job->palette.copyPalette(palette_.get());
+	mtex.load_job = job;
+
+	if (async_)
+	{
+		load_queue_->add(job, frame_, frame_requests_++);
+		app::threadPool().enqueue([queue = load_queue_]() { queue->runNext(); });
+	}
+	else
+	{
+		job->state = LoadJob::State::Loading;
+		load_queue_->run(*job, false);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Checks the image load for [mtex] and creates its GL texture (with [filter]
+// and [tiling]) if it has finished. If the load is still queued it is moved up
+// to the current frame's priority, or run immediately if background loading
+// isn't active.
+// Returns false if the image is still loading
+// -----------------------------------------------------------------------------
+bool MapTextureManager::finishLoad(Texture& mtex, gl::TexFilter filter, bool tiling)
+{
+	auto& job = *mtex.load_job;
+
+	if (job.state == LoadJob::State::Queued)
+	{
+		if (async_)
+		{
+			load_queue_->prioritise(mtex.load_job, frame_, frame_requests_++);
+			return false;
+		}
+
+		if (load_queue_->take(job))
+			load_queue_->run(job);
+	}
+
+	if (job.state == LoadJob::State::Loading)
+	{
+		if (async_)
+			return false;
+
+		load_queue_->wait(job);
+	}
+
+	// Load failed, leave the job so it isn't attempted again
+	if (job.state != LoadJob::State::Finished)
+		return true;
+
+	// Create GL texture
+	auto pal           = job.image_palette ? job.image.palette() : palette_.get();
+	mtex.gl_id         = gl::Texture::createFromImage(job.image, pal, filter, tiling);
+	mtex.world_panning = job.world_panning;
+	mtex.scale         = job.scale;
+	mtex.load_job.reset();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the placeholder texture to use while a texture is loading
+// (a plain grey texture, or a transparent one for [sprite]s)
+// -----------------------------------------------------------------------------
+const MapTextureManager::Texture& MapTextureManager::loadingTexture(bool sprite)
+{
+	auto& tex = sprite ? sprite_loading_ : tex_loading_;
+
+	if (!tex.gl_id)
+	{
+		vector<uint8_t> data(64 * 64 * 4, sprite ? 0 : 128);
+		if (!sprite)
+			for (unsigned a = 3; a < data.size(); a += 4)
+				data[a] = 255;
+
+		tex.gl_id = gl::Texture::createFromData(data.data(), 64, 64, gl::TexFilter::Nearest);
+	}
+
+	return tex;
+}
+
 // -----------------------------------------------------------------------------
 // Loads all editor images (thing icons, etc) from the program resource archive
 // -----------------------------------------------------------------------------
@@ -549,7 +1016,8 @@ const MapTextureManager::Texture& MapTextureManager::editorImage(string_view nam
 // -----------------------------------------------------------------------------
 void MapTextureManager::refreshResources()
 {
-	// Just clear all cached textures
+	// Just clear all cached textures (and cancel any queued loads for them)
+	load_queue_->cancel();
 	textures_.clear();
 	flats_.clear();
 	sprites_.clear();
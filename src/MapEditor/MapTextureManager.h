@@ -21,11 +21,13 @@ public:
 		HiRes
 	};
 
+	struct LoadJob;
 	struct Texture
 	{
-		unsigned gl_id         = 0;
-		bool     world_panning = false;
-		Vec2d    scale         = { 1., 1. };
+		unsigned            gl_id         = 0;
+		bool                world_panning = false;
+		Vec2d               scale         = { 1., 1. };
+		shared_ptr<LoadJob> load_job; // Image load in progress (or failed), if any
 		~Texture() { gl::Texture::clear(gl_id); }
 	};
 	typedef std::map<string, Texture> MapTexHashMap;
@@ -57,7 +59,7 @@ public:
 	};
 
 	MapTextureManager(shared_ptr<Archive> archive = nullptr);
-	~MapTextureManager() = default;
+	~MapTextureManager();
 
 	void init();
 	void setArchive(shared_ptr<Archive> archive);
@@ -71,6 +73,11 @@ public:
 	const Texture& editorImage(string_view name);
 	int            verticalOffset(string_view name) const;
 
+	// Background loading
+	void beginFrame();
+	void endFrame();
+	bool updateLoading();
+
 	vector<TexInfo>& allTexturesInfo() { return tex_info_; }
 	vector<TexInfo>& allFlatsInfo() { return flat_info_; }
 
@@ -85,10 +92,25 @@ private:
 	vector<TexInfo>     tex_info_;
 	vector<TexInfo>     flat_info_;
 
+	// Background loading
+	struct LoadQueue;
+	shared_ptr<LoadQueue> load_queue_;
+	bool                  async_           = false;
+	unsigned              frame_           = 0;
+	unsigned              frame_requests_  = 0;
+	unsigned              loads_finished_  = 0;
+	long                  last_load_check_ = 0;
+	Texture               tex_loading_;
+	Texture               sprite_loading_;
+
 	// Signal connections
 	sigslot::scoped_connection sc_resources_updated_;
 	sigslot::scoped_connection sc_palette_changed_;
 
 	void importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path) const;
+
+	void           startLoad(Texture& mtex, shared_ptr<LoadJob> job);
+	bool           finishLoad(Texture& mtex, gl::TexFilter filter, bool tiling = true);
+	const Texture& loadingTexture(bool sprite);
 };
 } // namespace slade
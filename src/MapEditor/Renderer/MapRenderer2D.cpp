@@ -2109,8 +2109,6 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 	using game::Feature;
 	using game::UDMFFeature;
 
-	bool vbo_updated = false;
-
 	if (flat_ignore_light)
 		glColor4f(flat_brightness, flat_brightness, flat_brightness, alpha);
 
@@ -2131,23 +2129,9 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		last_flat_type_ = type;
 	}
 
-	// First, check if any polygon vertex data has changed (in this case we need to refresh the entire vbo)
-	for (unsigned a = 0; a < map_->nSectors(); a++)
-	{
-		auto poly = map_->sector(a)->polygon();
-		if (poly && poly->vboUpdate() > 1)
-		{
-			updateFlatsVBO();
-			vbo_updated = true;
-		}
-	}
-
-	// Create VBO if necessary
-	if (!vbo_updated && vbo_flats_ == 0)
-	{
-		updateFlatsVBO();
-		vbo_updated = true;
-	}
+	// First, update VBO data for any sectors with changed polygons (creating the
+	// VBO if necessary)
+	updateChangedFlatsVBO();
 
 	// Setup opengl state
 	if (texture)
@@ -3127,19 +3111,23 @@ void MapRenderer2D::updateFlatsVBO()
 		totalsize += poly->vboDataSize();
 	}
 
-	// Allocate buffer data
+	// Allocate buffer data, with some extra space at the end for sector polygons
+	// that grow when edited (see updateChangedFlatsVBO)
+	vbo_flats_size_ = totalsize + totalsize / 4 + 4096;
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_flats_);
-	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vbo_flats_size_, nullptr, GL_DYNAMIC_DRAW);
 
 	// Write polygon data to VBO
 	unsigned offset = 0;
-	unsigned index  = 0;
+	vbo_flats_ranges_.resize(map_->nSectors());
 	for (unsigned a = 0; a < map_->nSectors(); a++)
 	{
-		auto poly = map_->sector(a)->polygon();
-		offset    = poly->writeToVBO(offset, index);
-		index += poly->totalVertices();
+		auto sector          = map_->sector(a);
+		auto poly            = sector->polygon();
+		vbo_flats_ranges_[a] = { sector, offset, poly->vboDataSize() };
+		offset               = poly->writeToVBO(offset, offset / 20);
 	}
+	vbo_flats_end_ = offset;
 
 	// Clean up
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -3147,6 +3135,70 @@ void MapRenderer2D::updateFlatsVBO()
 	flats_updated_ = app::runTimer();
 }
 
+// -----------------------------------------------------------------------------
+// Updates the map flats VBO data for sectors whose polygons have changed.
+// A changed polygon is written over its previous data if it fits, otherwise it
+// is moved to the free space at the end of the VBO. The whole VBO is only
+// rebuilt if sectors were added/removed or it runs out of free space
+// -----------------------------------------------------------------------------
+void MapRenderer2D::updateChangedFlatsVBO()
+{
+	if (!flats_use_vbo)
+		return;
+
+	// Rebuild if the VBO doesn't exist yet or sectors have changed
+	auto n_sectors = map_->nSectors();
+	if (vbo_flats_ == 0 || vbo_flats_ranges_.size() != n_sectors)
+	{
+		updateFlatsVBO();
+		return;
+	}
+
+	bool bound = false;
+	for (unsigned a = 0; a < n_sectors; a++)
+	{
+		auto  sector = map_->sector(a);
+		auto& range  = vbo_flats_ranges_[a];
+		if (range.sector != sector)
+		{
+			updateFlatsVBO();
+			return;
+		}
+
+		// Check if the polygon changed (this also rebuilds it if the sector
+		// geometry changed)
+		auto poly = sector->polygon();
+		if (poly->vboUpdate() < 2)
+			continue;
+
+		// Move to the end of the VBO if it doesn't fit in its current range
+		auto size = poly->vboDataSize();
+		if (size > range.capacity)
+		{
+			if (vbo_flats_end_ + size > vbo_flats_size_)
+			{
+				updateFlatsVBO();
+				return;
+			}
+
+			range.offset   = vbo_flats_end_;
+			range.capacity = size;
+			vbo_flats_end_ += size;
+		}
+
+		// Write polygon data
+		if (!bound)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo_flats_);
+			bound = true;
+		}
+		poly->writeToVBO(range.offset, range.offset / 20);
+	}
+
+	if (bound)
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 // -----------------------------------------------------------------------------
 // Updates map object visibility info depending on the current view
 // -----------------------------------------------------------------------------
@@ -121,6 +121,7 @@ public:
 	void updateVerticesVBO();
 	void updateLinesVBO(bool show_direction, float base_alpha);
 	void updateFlatsVBO();
+	void updateChangedFlatsVBO();
 
 	// Misc
 	void setScale(double scale)
@@ -133,6 +134,7 @@ public:
 	double scaledRadius(int radius) const;
 	bool   visOK() const;
 	void   clearTextureCache() { tex_flats_.clear(); }
+	void   clearSpriteCache() { thing_sprites_.clear(); }
 
 private:
 	SLADEMap* map_ = nullptr;
@@ -146,6 +148,17 @@ private:
 	unsigned vbo_lines_    = 0;
 	unsigned vbo_flats_    = 0;
 
+	// The range of the flats VBO each sector's polygon data is in
+	struct FlatVBORange
+	{
+		MapSector* sector   = nullptr;
+		unsigned   offset   = 0; // In bytes
+		unsigned   capacity = 0; // Size of polygon data (in bytes) that can fit in the range
+	};
+	vector<FlatVBORange> vbo_flats_ranges_;
+	unsigned             vbo_flats_size_ = 0; // Allocated size of the flats VBO
+	unsigned             vbo_flats_end_  = 0; // End of the last range in the flats VBO
+
 	// Display lists
 	unsigned list_vertices_ = 0;
 	unsigned list_lines_    = 0;
@@ -72,6 +72,7 @@ CVAR(Bool, mlook_invert_y, false, CVar::Flag::Save)
 CVAR(Float, camera_3d_sensitivity_x, 1.0f, CVar::Flag::Save)
 CVAR(Float, camera_3d_sensitivity_y, 1.0f, CVar::Flag::Save)
 CVAR(Int, render_fov, 90, CVar::Flag::Save)
+CVAR(Bool, render_3d_portal_cull, true, CVar::Flag::Save)
 
 
 // -----------------------------------------------------------------------------
@@ -93,7 +94,7 @@ EXTERN_CVAR(Bool, use_zeth_icons)
 // -----------------------------------------------------------------------------
 // MapRenderer3D class constructor
 // -----------------------------------------------------------------------------
-MapRenderer3D::MapRenderer3D(SLADEMap* map) : map_{ map }
+MapRenderer3D::MapRenderer3D(SLADEMap* map) : map_{ map }, vis_{ map }
 {
 	// Build skybox circle
 	buildSkyCircle();
@@ -220,6 +221,8 @@ void MapRenderer3D::clearData()
 	things_.clear();
 	floors_.clear();
 	ceilings_.clear();
+	vis_.clear();
+	thing_pick_margin_ = 0.;
 
 	// Clear everything else
 	refresh();
@@ -2164,6 +2167,12 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
 		things_[index].sprite = mapeditor::textureManager().editorImage("thing/unknown").gl_id;
 	}
 
+	// Keep track of the widest sprite, for picking via the map BVH
+	double halfwidth = things_[index].flags & ICON ? render_thing_icon_size * 0.5 :
+													 gl::Texture::info(things_[index].sprite).size.x * 0.5;
+	if (halfwidth > thing_pick_margin_)
+		thing_pick_margin_ = halfwidth;
+
 	// Determine z position
 	if (things_[index].type->zHeightAbsolute())
 		things_[index].z = thing->zPos();
@@ -2247,6 +2256,11 @@ void MapRenderer3D::renderThings()
 				break;
 		}
 
+		// Skip if in a sector that isn't visible
+		if (things_[a].sector && things_[a].sector->index() < dist_sectors_.size()
+			&& dist_sectors_[things_[a].sector->index()] < 0)
+			continue;
+
 		// Skip if not shown
 		if (!things_[a].type->decoration() && render_3d_things == 2)
 			continue;
@@ -2666,6 +2680,21 @@ void MapRenderer3D::quickVisDiscard()
 		else
 			lines_[map_->side(a)->parentLine()->index()].visible = true;
 	}
+
+	// Hide any sectors and lines that can't be seen from the camera through
+	// the map's portals (only the area in front of the camera is checked
+	// unless looking steeply up or down, same as above)
+	if (!render_3d_portal_cull)
+		return;
+	double fov = cam_pitch_ > -0.9 && cam_pitch_ < 0.9 ? math::PI : math::PI * 2;
+	if (!vis_.update(cam_position_, cam_direction_, fov, render_max_dist))
+		return;
+	for (unsigned a = 0; a < map_->nSectors(); a++)
+		if (!vis_.sectorVisible(a))
+			dist_sectors_[a] = -1.0f;
+	for (unsigned a = 0; a < map_->nLines(); a++)
+		if (!vis_.lineVisible(a))
+			lines_[a].visible = false;
 }
 
 // -----------------------------------------------------------------------------
@@ -2841,28 +2870,33 @@ mapeditor::Item MapRenderer3D::determineHilight()
 
 	// Check for required map structures
 	if (!map_ || lines_.size() != map_->nLines() || floors_.size() != map_->nSectors()
-		|| things_.size() != map_->nThings())
+		|| things_.size() != map_->nThings() || dist_sectors_.size() != map_->nSectors())
 		return current;
 
+	// Objects along the view ray are found via the map's BVH, nearest first
+	auto&  bvh = map_->mapData().bvh();
+	double hit_dist;
+
 	// Check lines
-	double height, dist;
-	for (unsigned a = 0; a < map_->nLines(); a++)
+	auto check_line = [&](MapObject* object)
 	{
+		auto line = dynamic_cast<MapLine*>(object);
+		auto a    = line->index();
+
 		// Ignore if not visible
 		if (!lines_[a].visible)
-			continue;
-
-		auto line = map_->line(a);
+			return -1.;
 
 		// Find (2d) distance to line
-		dist = math::distanceRayLine(
+		double dist = math::distanceRayLine(
 			cam_position_.get2d(), (cam_position_ + cam_dir3d_).get2d(), line->start(), line->end());
 
 		// Ignore if no intersection or something was closer
 		if (dist < 0 || dist >= min_dist)
-			continue;
+			return -1.;
 
 		// Find quad intersect if any
+		bool hit          = false;
 		auto intersection = cam_position_ + cam_dir3d_ * dist;
 		for (auto& quad : lines_[a].quads)
 		{
@@ -2901,30 +2935,39 @@ mapeditor::Item MapRenderer3D::determineHilight()
 					current.type = mapeditor::ItemType::WallMiddle;
 
 				min_dist = dist;
+				hit      = true;
 			}
 		}
-	}
+
+		return hit ? dist : -1.;
+	};
+	bvh.castRay(MapObject::Type::Line, cam_position_, cam_dir3d_, min_dist, check_line, hit_dist);
 
 	// Check sectors
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	auto check_sector = [&](MapObject* object)
 	{
+		auto sector = dynamic_cast<MapSector*>(object);
+		auto a      = sector->index();
+		bool hit    = false;
+
 		// Ignore if not visible
 		if (dist_sectors_[a] < 0)
-			continue;
+			return -1.;
 
 		// Check distance to floor plane
-		dist = math::distanceRayPlane(cam_position_, cam_dir3d_, floors_[a].plane);
+		double dist = math::distanceRayPlane(cam_position_, cam_dir3d_, floors_[a].plane);
 		if (dist >= 0 && dist < min_dist)
 		{
 			// Check if on the correct side of the plane
 			if (cam_position_.z > floors_[a].plane.heightAt(cam_position_.x, cam_position_.y))
 			{
 				// Check if intersection is within sector
-				if (map_->sector(a)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
+				if (sector->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
 				{
 					current.index = a;
 					current.type  = mapeditor::ItemType::Floor;
 					min_dist      = dist;
+					hit           = true;
 				}
 			}
 		}
@@ -2937,15 +2980,19 @@ mapeditor::Item MapRenderer3D::determineHilight()
 			if (cam_position_.z < ceilings_[a].plane.heightAt(cam_position_.x, cam_position_.y))
 			{
 				// Check if intersection is within sector
-				if (map_->sector(a)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
+				if (sector->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
 				{
 					current.index = a;
 					current.type  = mapeditor::ItemType::Ceiling;
 					min_dist      = dist;
+					hit           = true;
 				}
 			}
 		}
-	}
+
+		return hit ? min_dist : -1.;
+	};
+	bvh.castRay(MapObject::Type::Sector, cam_position_, cam_dir3d_, min_dist, check_sector, hit_dist);
 
 	// Update item distance
 	if (min_dist >= 9999999 || min_dist < 0)
@@ -2956,28 +3003,29 @@ mapeditor::Item MapRenderer3D::determineHilight()
 	// Check things (if visible)
 	if (render_3d_things == 0)
 		return current;
-	double halfwidth, theight;
-	for (unsigned a = 0; a < map_->nThings(); a++)
+	auto check_thing = [&](MapObject* object)
 	{
+		auto thing = dynamic_cast<MapThing*>(object);
+		auto a     = thing->index();
+
 		// Ignore if no sprite
 		if (!things_[a].sprite)
-			continue;
+			return -1.;
 
 		// Ignore if not visible
-		auto thing = map_->thing(a);
 		if (math::lineSide(thing->position(), strafe) > 0)
-			continue;
+			return -1.;
 
 		// Ignore if not shown
 		if (!things_[a].type->decoration() && render_3d_things == 2)
-			continue;
+			return -1.;
 
 		// Find distance to thing sprite
-		auto& tex_info = gl::Texture::info(things_[a].sprite);
-		halfwidth      = tex_info.size.x * 0.5;
+		auto&  tex_info  = gl::Texture::info(things_[a].sprite);
+		double halfwidth = tex_info.size.x * 0.5;
 		if (things_[a].flags & ICON)
 			halfwidth = render_thing_icon_size * 0.5;
-		dist = math::distanceRayLine(
+		double dist = math::distanceRayLine(
 			cam_position_.get2d(),
 			(cam_position_ + cam_dir3d_).get2d(),
 			thing->position() - cam_strafe_.get2d() * halfwidth,
@@ -2985,11 +3033,11 @@ mapeditor::Item MapRenderer3D::determineHilight()
 
 		// Ignore if no intersection or something was closer
 		if (dist < 0 || dist >= min_dist)
-			continue;
+			return -1.;
 
 		// Check intersection height
-		theight = tex_info.size.y;
-		height  = cam_position_.z + cam_dir3d_.z * dist;
+		double theight = tex_info.size.y;
+		double height  = cam_position_.z + cam_dir3d_.z * dist;
 		if (things_[a].flags & ICON)
 			theight = render_thing_icon_size;
 		if (height >= things_[a].z && height <= things_[a].z + theight)
@@ -2997,8 +3045,13 @@ mapeditor::Item MapRenderer3D::determineHilight()
 			current.index = a;
 			current.type  = mapeditor::ItemType::Thing;
 			min_dist      = dist;
+			return dist;
 		}
-	}
+
+		return -1.;
+	};
+	bvh.castRay(
+		MapObject::Type::Thing, cam_position_, cam_dir3d_, min_dist, check_thing, hit_dist, thing_pick_margin_);
 
 	// Update item distance
 	if (min_dist >= 9999999 || min_dist < 0)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MapEditor/Edit/Edit3D.h"
+#include "SLADEMap/MapVisibility.h"
 #include "SLADEMap/SLADEMap.h"
 
 namespace slade
@@ -197,6 +198,7 @@ private:
 
 	// Visibility
 	vector<float> dist_sectors_;
+	MapVisibility vis_;
 
 	// Camera
 	Vec3d  cam_position_;
@@ -208,6 +210,9 @@ private:
 	double gravity_   = 0.5;
 	int    item_dist_ = 0;
 
+	// Picking
+	double thing_pick_margin_ = 0.; // Largest sprite half-width of any thing
+
 	// Map Structures
 	vector<Line>  lines_;
 	Quad**        quads_ = nullptr;
@@ -38,6 +38,8 @@
 #include "General/ColourConfiguration.h"
 #include "MapEditor/Edit/LineDraw.h"
 #include "MapEditor/MapEditContext.h"
+#include "MapEditor/MapEditor.h"
+#include "MapEditor/MapTextureManager.h"
 #include "OpenGL/Drawing.h"
 #include "OpenGL/OpenGL.h"
 #include "Overlays/MCOverlay.h"
@@ -105,6 +107,17 @@ void Renderer::forceUpdate()
 	renderer_3d_.clearData();
 }
 
+// -----------------------------------------------------------------------------
+// Refreshes textures/sprites used by the 2d and 3d renderers, without
+// rebuilding any other cached data
+// -----------------------------------------------------------------------------
+void Renderer::refreshTextures()
+{
+	renderer_2d_.clearTextureCache();
+	renderer_2d_.clearSpriteCache();
+	renderer_3d_.refreshTextures();
+}
+
 // -----------------------------------------------------------------------------
 // Scrolls the view to be centered on map coordinates [x,y]
 // -----------------------------------------------------------------------------
@@ -1235,10 +1248,13 @@ void Renderer::draw()
 	glDisable(GL_TEXTURE_2D);
 
 	// Draw 2d or 3d map depending on mode
+	// (any textures not loaded yet are loaded in the background while drawing)
+	mapeditor::textureManager().beginFrame();
 	if (context_.editMode() == Mode::Visual)
 		drawMap3d();
 	else
 		drawMap2d();
+	mapeditor::textureManager().endFrame();
 
 	// Draw info overlay
 	glDisable(GL_CULL_FACE);
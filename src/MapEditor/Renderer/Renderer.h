@@ -22,6 +22,7 @@ namespace mapeditor
 		RenderView&    view() { return view_; }
 
 		void forceUpdate();
+		void refreshTextures();
 
 		// View manipulation
 		void   setView(double map_x, double map_y);
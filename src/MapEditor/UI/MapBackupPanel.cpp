@@ -33,7 +33,6 @@
 #include "MapBackupPanel.h"
 #include "App.h"
 #include "Archive/Formats/WadArchive.h"
-#include "Archive/Formats/ZipArchive.h"
 #include "UI/Canvas/MapPreviewCanvas.h"
 #include "UI/Lists/ListView.h"
 #include "UI/WxUtils.h"
@@ -51,7 +50,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 // MapBackupPanel class constructor
 // -----------------------------------------------------------------------------
-MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel{ parent, -1 }, archive_backups_{ new ZipArchive() }
+MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel{ parent, -1 }
 {
 	// Setup Sizer
 	auto sizer = new wxBoxSizer(wxHORIZONTAL);
@@ -70,20 +69,19 @@ MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel{ parent, -1 }, archiv
 }
 
 // -----------------------------------------------------------------------------
-// Opens the map backup file for [map_name] in [archive_name] and populates the
-// list
+// Opens the map backup store for [archive_name] and populates the list with
+// the backups of [map_name]
 // -----------------------------------------------------------------------------
 bool MapBackupPanel::loadBackups(wxString archive_name, const wxString& map_name)
 {
-	// Open backup file
-	archive_name.Replace(".", "_");
-	auto backup_file = app::path("backups", app::Dir::User) + "/" + archive_name.ToStdString() + "_backup.zip";
-	if (!archive_backups_->open(backup_file))
+	// Open backup store
+	backup_store_ = std::make_unique<MapBackupStore>(archive_name.ToStdString());
+	if (!backup_store_->open())
 		return false;
 
-	// Get backup dir for map
-	dir_current_ = archive_backups_->dirAtPath(map_name.ToStdString());
-	if (dir_current_ == archive_backups_->rootDir().get() || !dir_current_)
+	// Get backups of map
+	backups_ = backup_store_->backups(map_name.ToStdString());
+	if (backups_.empty())
 		return false;
 
 	// Populate backups list
@@ -92,9 +90,9 @@ bool MapBackupPanel::loadBackups(wxString archive_name, const wxString& map_name
 	list_backups_->AppendColumn("Time");
 
 	int index = 0;
-	for (int a = dir_current_->numSubdirs() - 1; a >= 0; a--)
+	for (int a = backups_.size() - 1; a >= 0; a--)
 	{
-		wxString      timestamp = dir_current_->subdirAt(a)->name();
+		wxString      timestamp = backups_[a]->timestamp;
 		wxArrayString cols;
 
 		// Date
@@ -129,9 +127,19 @@ void MapBackupPanel::updateMapPreview()
 
 	// Load map data to temporary wad
 	archive_mapdata_ = std::make_unique<WadArchive>();
-	auto dir         = dir_current_->subdirAt(selection);
-	for (unsigned a = 0; a < dir->numEntries(); a++)
-		archive_mapdata_->addEntry(std::make_shared<ArchiveEntry>(*dir->entryAt(a)), "");
+	MemChunk data;
+	for (auto& lump : backups_[selection]->lumps)
+	{
+		if (!backup_store_->readLump(lump, data))
+		{
+			log::warning("Unable to read lump {} from map backup", lump.name);
+			continue;
+		}
+
+		auto entry = std::make_shared<ArchiveEntry>(lump.name);
+		entry->importMemChunk(data);
+		archive_mapdata_->addEntry(entry, "");
+	}
 
 	// Open map preview
 	auto maps = archive_mapdata_->detectMaps();
@@ -1,11 +1,11 @@
 #pragma once
 
+#include "MapEditor/MapBackupStore.h"
+
 namespace slade
 {
 class MapPreviewCanvas;
 class Archive;
-class ZipArchive;
-class ArchiveDir;
 class ListView;
 
 class MapBackupPanel : public wxPanel
@@ -20,10 +20,10 @@ public:
 	void updateMapPreview();
 
 private:
-	MapPreviewCanvas*      canvas_map_   = nullptr;
-	ListView*              list_backups_ = nullptr;
-	unique_ptr<ZipArchive> archive_backups_;
-	unique_ptr<Archive>    archive_mapdata_;
-	ArchiveDir*            dir_current_ = nullptr;
+	MapPreviewCanvas*                     canvas_map_   = nullptr;
+	ListView*                             list_backups_ = nullptr;
+	unique_ptr<MapBackupStore>            backup_store_;
+	vector<const MapBackupStore::Backup*> backups_;
+	unique_ptr<Archive>                   archive_mapdata_;
 };
 } // namespace slade
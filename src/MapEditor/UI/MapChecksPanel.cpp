@@ -33,6 +33,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapChecksPanel.h"
+#include "App.h"
 #include "MapEditor/MapChecks.h"
 #include "MapEditor/MapEditContext.h"
 #include "MapEditor/MapEditor.h"
@@ -323,39 +324,51 @@ void MapChecksPanel::onBtnCheck(wxCommandEvent& e)
 	active_checks_.clear();
 
 	// Setup checks
+	vector<MapCheck::StandardCheck> check_types;
 	for (auto a = 0u; a < std_checks.size(); ++a)
 	{
 		if (clb_active_checks_->IsChecked(a))
 		{
-			active_checks_.emplace_back(
-				MapCheck::standardCheck(static_cast<MapCheck::StandardCheck>(a), map_, &mapeditor::textureManager()));
+			auto type = static_cast<MapCheck::StandardCheck>(a);
+			active_checks_.emplace_back(MapCheck::standardCheck(type, map_, &mapeditor::textureManager()));
+			check_types.push_back(type);
 		}
 	}
 
 	// Run checks
+	vector<MapCheck*> checks;
 	for (auto& check : active_checks_)
+		checks.push_back(check.get());
+	vector<long> times;
+	auto         start = app::runTimer();
+	MapCheck::runChecks(checks, times, [this](const string& text) { updateStatusText(text); });
+	auto total_time = app::runTimer() - start;
+
+	// Add results to list
+	wxString timing;
+	for (unsigned a = 0; a < checks.size(); a++)
 	{
-		// Check
-		updateStatusText(check->progressText());
-		check->doCheck();
-
-		// Add results to list
-		for (unsigned b = 0; b < check->nProblems(); b++)
+		for (unsigned b = 0; b < checks[a]->nProblems(); b++)
 		{
-			lb_errors_->Append(check->problemDesc(b));
-			check_items_.emplace_back(check.get(), b);
+			lb_errors_->Append(checks[a]->problemDesc(b));
+			check_items_.emplace_back(checks[a], b);
 		}
+
+		auto desc = MapCheck::standardCheckDesc(check_types[a]);
+		log::info(2, "Map check \"{}\" took {}ms ({} problems)", desc, times[a], checks[a]->nProblems());
+		timing += wxString::Format("%s: %ldms\n", desc, times[a]);
 	}
+	label_status_->SetToolTip(timing.Trim());
 
 	lb_errors_->Show(true);
 
 	if (lb_errors_->GetCount() > 0)
 	{
-		updateStatusText(wxString::Format("%d problems found", lb_errors_->GetCount()));
+		updateStatusText(wxString::Format("%d problems found (%ldms)", lb_errors_->GetCount(), total_time));
 		btn_export_->Enable(true);
 	}
 	else
-		updateStatusText("No problems found");
+		updateStatusText(wxString::Format("No problems found (%ldms)", total_time));
 }
 
 // -----------------------------------------------------------------------------
@@ -605,7 +605,9 @@ bool MapEditorWindow::openMap(Archive::MapDesc map)
 		if (map.archive)
 		{
 			WadArchive temp;
-			temp.open(head->data());
+			MemChunk   wad_data;
+			head->shareData(wad_data);
+			temp.open(wad_data);
 			for (unsigned a = 0; a < temp.numEntries(); a++)
 				map_data_.emplace_back(new ArchiveEntry(*(temp.entryAt(a))));
 		}
@@ -693,7 +695,9 @@ void MapEditorWindow::loadMapScripts(Archive::MapDesc map)
 	if (map.archive)
 	{
 		auto wad = new WadArchive();
-		wad->open(head->data());
+		MemChunk wad_data;
+		head->shareData(wad_data);
+		wad->open(wad_data);
 		auto maps = wad->detectMaps();
 		if (!maps.empty())
 		{
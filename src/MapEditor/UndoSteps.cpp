@@ -6,6 +6,38 @@
 using namespace slade;
 using namespace mapeditor;
 
+
+namespace
+{
+// Resets the geometry of [line] and its sectors
+void updateLineGeometry(MapLine* line)
+{
+	line->resetInternals();
+	for (auto sector : { line->frontSector(), line->backSector() })
+		if (sector)
+		{
+			sector->resetPolygon();
+			sector->updateBBox();
+		}
+}
+
+// Returns the approximate memory used by [backup]
+unsigned backupMemUsage(const MapObject::Backup& backup)
+{
+	unsigned total = sizeof(MapObject::Backup);
+	for (const auto* props : { &backup.properties, &backup.props_internal })
+		for (const auto& prop : props->properties())
+		{
+			total += sizeof(prop) + prop.name.capacity();
+			if (auto str = std::get_if<string>(&prop.value))
+				total += str->capacity();
+		}
+
+	return total;
+}
+} // namespace
+
+
 PropertyChangeUS::PropertyChangeUS(MapObject* object) : backup_{ new MapObject::Backup() }
 {
 	object->backupTo(backup_.get());
@@ -19,6 +51,11 @@ void PropertyChangeUS::doSwap(MapObject* obj)
 	backup_.swap(temp);
 }
 
+unsigned PropertyChangeUS::memUsage() const
+{
+	return sizeof(PropertyChangeUS) + backupMemUsage(*backup_);
+}
+
 bool PropertyChangeUS::doUndo()
 {
 	auto obj = undoredo::currentMap()->mapData().getObjectById(backup_->id);
@@ -40,182 +77,77 @@ bool PropertyChangeUS::doRedo()
 
 MapObjectCreateDeleteUS::MapObjectCreateDeleteUS()
 {
-	auto map = undoredo::currentMap();
-	map->mapData().putObjectIdList(MapObject::Type::Vertex, vertices_);
-	map->mapData().putObjectIdList(MapObject::Type::Line, lines_);
-	map->mapData().putObjectIdList(MapObject::Type::Side, sides_);
-	map->mapData().putObjectIdList(MapObject::Type::Sector, sectors_);
-	map->mapData().putObjectIdList(MapObject::Type::Thing, things_);
+	// Record changes to the object lists until checkChanges
+	undoredo::currentMap()->mapData().beginIdListRecord();
 }
 
-void MapObjectCreateDeleteUS::swapLists()
+void MapObjectCreateDeleteUS::applyChanges(bool undo) const
 {
-	// Backup
-	vector<unsigned> vertices;
-	vector<unsigned> lines;
-	vector<unsigned> sides;
-	vector<unsigned> sectors;
-	vector<unsigned> things;
-	auto             map = undoredo::currentMap();
-	if (isValid(vertices_))
-		map->mapData().putObjectIdList(MapObject::Type::Vertex, vertices);
-	if (isValid(lines_))
-		map->mapData().putObjectIdList(MapObject::Type::Line, lines);
-	if (isValid(sides_))
-		map->mapData().putObjectIdList(MapObject::Type::Side, sides);
-	if (isValid(sectors_))
-		map->mapData().putObjectIdList(MapObject::Type::Sector, sectors);
-	if (isValid(things_))
-		map->mapData().putObjectIdList(MapObject::Type::Thing, things);
-
-	// Restore
-	if (isValid(vertices_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Vertex, vertices_);
-		vertices_ = vertices;
-		map->updateGeometryInfo(0);
-	}
-	if (isValid(lines_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Line, lines_);
-		lines_ = lines;
-		map->updateGeometryInfo(0);
-	}
-	if (isValid(sides_))
+	auto& map_data = undoredo::currentMap()->mapData();
+	for (const auto& type_changes : changes_)
 	{
-		map->restoreObjectIdList(MapObject::Type::Side, sides_);
-		sides_ = sides;
-	}
-	if (isValid(sectors_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Sector, sectors_);
-		sectors_ = sectors;
-	}
-	if (isValid(things_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Thing, things_);
-		things_ = things;
+		map_data.applyIdListChanges(type_changes.type, type_changes.changes, undo);
+
+		// Update geometry around any created/deleted vertices and lines
+		if (type_changes.type != MapObject::Type::Vertex && type_changes.type != MapObject::Type::Line)
+			continue;
+		for (auto ids : { &type_changes.changes.ids_before, &type_changes.changes.ids_after })
+			for (auto id : *ids)
+			{
+				if (id == 0)
+					continue;
+
+				auto object = map_data.getObjectById(id);
+				if (type_changes.type == MapObject::Type::Line)
+					updateLineGeometry(dynamic_cast<MapLine*>(object));
+				else
+					for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+						updateLineGeometry(line);
+			}
 	}
 }
 
 bool MapObjectCreateDeleteUS::doUndo()
 {
-	swapLists();
+	applyChanges(true);
 	return true;
 }
 
 bool MapObjectCreateDeleteUS::doRedo()
 {
-	swapLists();
+	applyChanges(false);
 	return true;
 }
 
 void MapObjectCreateDeleteUS::checkChanges()
 {
-	auto map = undoredo::currentMap();
-
-	// Check vertices changed
-	bool vertices_changed = false;
-	if (map->nVertices() != vertices_.size())
-		vertices_changed = true;
-	else
-		for (unsigned a = 0; a < map->nVertices(); a++)
-			if (map->vertex(a)->objId() != vertices_[a])
-			{
-				vertices_changed = true;
-				break;
-			}
-	if (!vertices_changed)
-	{
-		// No change, clear
-		vertices_.clear();
-		vertices_.push_back(0);
-		log::info(3, "MapObjectCreateDeleteUS: No vertices added/deleted");
-	}
-
-	// Check lines changed
-	bool lines_changed = false;
-	if (map->nLines() != lines_.size())
-		lines_changed = true;
-	else
-		for (unsigned a = 0; a < map->nLines(); a++)
-			if (map->line(a)->objId() != lines_[a])
-			{
-				lines_changed = true;
-				break;
-			}
-	if (!lines_changed)
+	auto& map_data = undoredo::currentMap()->mapData();
+
+	changes_.clear();
+	for (const auto& [type, name] : { std::pair{ MapObject::Type::Vertex, "vertices" },
+									  std::pair{ MapObject::Type::Line, "lines" },
+									  std::pair{ MapObject::Type::Side, "sides" },
+									  std::pair{ MapObject::Type::Sector, "sectors" },
+									  std::pair{ MapObject::Type::Thing, "things" } })
 	{
-		// No change, clear
-		lines_.clear();
-		lines_.push_back(0);
-		log::info(3, "MapObjectCreateDeleteUS: No lines added/deleted");
+		TypeChanges type_changes{ type, {} };
+		map_data.putIdListChanges(type, type_changes.changes);
+		if (type_changes.changes.empty())
+			log::info(3, "MapObjectCreateDeleteUS: No {} added/deleted", name);
+		else
+			changes_.push_back(std::move(type_changes));
 	}
 
-	// Check sides changed
-	bool sides_changed = false;
-	if (map->nSides() != sides_.size())
-		sides_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSides(); a++)
-			if (map->side(a)->objId() != sides_[a])
-			{
-				sides_changed = true;
-				break;
-			}
-	if (!sides_changed)
-	{
-		// No change, clear
-		sides_.clear();
-		sides_.push_back(0);
-		log::info(3, "MapObjectCreateDeleteUS: No sides added/deleted");
-	}
-
-	// Check sectors changed
-	bool sectors_changed = false;
-	if (map->nSectors() != sectors_.size())
-		sectors_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSectors(); a++)
-			if (map->sector(a)->objId() != sectors_[a])
-			{
-				sectors_changed = true;
-				break;
-			}
-	if (!sectors_changed)
-	{
-		// No change, clear
-		sectors_.clear();
-		sectors_.push_back(0);
-		log::info(3, "MapObjectCreateDeleteUS: No sectors added/deleted");
-	}
-
-	// Check things changed
-	bool things_changed = false;
-	if (map->nThings() != things_.size())
-		things_changed = true;
-	else
-		for (unsigned a = 0; a < map->nThings(); a++)
-			if (map->thing(a)->objId() != things_[a])
-			{
-				things_changed = true;
-				break;
-			}
-	if (!things_changed)
-	{
-		// No change, clear
-		things_.clear();
-		things_.push_back(0);
-		log::info(3, "MapObjectCreateDeleteUS: No things added/deleted");
-	}
+	map_data.endIdListRecord();
 }
 
-bool MapObjectCreateDeleteUS::isOk()
+unsigned MapObjectCreateDeleteUS::memUsage() const
 {
-	// Check for any changes at all
-	return !(
-		vertices_.size() == 1 && vertices_[0] == 0 && lines_.size() == 1 && lines_[0] == 0 && sides_.size() == 1
-		&& sides_[0] == 0 && sectors_.size() == 1 && sectors_[0] == 0 && things_.size() == 1 && things_[0] == 0);
+	unsigned total = sizeof(MapObjectCreateDeleteUS);
+	for (const auto& type_changes : changes_)
+		total += sizeof(TypeChanges) + type_changes.changes.positions.capacity() * sizeof(unsigned) * 3;
+
+	return total;
 }
 
 
@@ -275,3 +207,12 @@ bool MultiMapObjectPropertyChangeUS::doRedo()
 
 	return true;
 }
+
+unsigned MultiMapObjectPropertyChangeUS::memUsage() const
+{
+	unsigned total = sizeof(MultiMapObjectPropertyChangeUS);
+	for (const auto& backup : backups_)
+		total += backupMemUsage(*backup);
+
+	return total;
+}
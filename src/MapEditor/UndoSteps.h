@@ -1,7 +1,7 @@
 #pragma once
 
 #include "General/UndoRedo.h"
-#include "SLADEMap/MapObject/MapObject.h"
+#include "SLADEMap/MapObjectCollection.h"
 
 namespace slade::mapeditor
 {
@@ -12,34 +12,38 @@ public:
 	PropertyChangeUS(MapObject* object);
 	~PropertyChangeUS() = default;
 
-	void doSwap(MapObject* obj);
-	bool doUndo() override;
-	bool doRedo() override;
+	void     doSwap(MapObject* obj);
+	bool     doUndo() override;
+	bool     doRedo() override;
+	unsigned memUsage() const override;
 
 private:
 	unique_ptr<MapObject::Backup> backup_;
 };
 
-// UndoStep for when a MapObject is either created or deleted
+// UndoStep for when a MapObject is either created or deleted.
+// Only the changed positions in each object list are kept, so undo/redo only
+// touches the created/deleted objects rather than the whole map
 class MapObjectCreateDeleteUS : public UndoStep
 {
 public:
 	MapObjectCreateDeleteUS();
 	~MapObjectCreateDeleteUS() = default;
 
-	bool isValid(vector<unsigned>& list) const { return !(list.size() == 1 && list[0] == 0); }
-	void swapLists();
-	bool doUndo() override;
-	bool doRedo() override;
-	void checkChanges();
-	bool isOk() override;
+	void     applyChanges(bool undo) const;
+	bool     doUndo() override;
+	bool     doRedo() override;
+	void     checkChanges();
+	bool     isOk() override { return !changes_.empty(); }
+	unsigned memUsage() const override;
 
 private:
-	vector<unsigned> vertices_;
-	vector<unsigned> lines_;
-	vector<unsigned> sides_;
-	vector<unsigned> sectors_;
-	vector<unsigned> things_;
+	struct TypeChanges
+	{
+		MapObject::Type                    type;
+		MapObjectCollection::IdListChanges changes;
+	};
+	vector<TypeChanges> changes_;
 };
 
 // UndoStep for when multiple MapObjects have properties changed
@@ -49,10 +53,11 @@ public:
 	MultiMapObjectPropertyChangeUS();
 	~MultiMapObjectPropertyChangeUS() = default;
 
-	void doSwap(MapObject* obj, unsigned index);
-	bool doUndo() override;
-	bool doRedo() override;
-	bool isOk() override { return !backups_.empty(); }
+	void     doSwap(MapObject* obj, unsigned index);
+	bool     doUndo() override;
+	bool     doRedo() override;
+	bool     isOk() override { return !backups_.empty(); }
+	unsigned memUsage() const override;
 
 private:
 	vector<unique_ptr<MapObject::Backup>> backups_;
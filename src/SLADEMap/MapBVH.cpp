@@ -0,0 +1,591 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapBVH.cpp
+// Description: MapBVH class - a bounding volume hierarchy over map lines,
+//              sectors and things, used to quickly find the objects along a
+//              ray (eg. for 3d mode picking or line of sight checks)
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapBVH.h"
+#include "Game/Configuration.h"
+#include "Game/ThingType.h"
+#include "MapObject/MapLine.h"
+#include "MapObject/MapSector.h"
+#include "MapObject/MapSide.h"
+#include "MapObject/MapThing.h"
+#include "MapObject/MapVertex.h"
+#include "MapObjectCollection.h"
+#include "Utility/MathStuff.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr unsigned max_leaf_objects = 4;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Checks if the 2d ray from [origin] in [dir] hits [bbox] (expanded by
+// [margin]) before [max_dist]. If it does, [entry] is set to the distance along
+// the ray it enters the box (0 if it starts within it)
+// -----------------------------------------------------------------------------
+bool rayHitsBox(const BBox& bbox, double margin, Vec2d origin, Vec2d dir, double max_dist, double& entry)
+{
+	double t_min = 0.;
+	double t_max = max_dist;
+
+	auto check_axis = [&](double box_min, double box_max, double o, double d)
+	{
+		box_min -= margin;
+		box_max += margin;
+
+		// Ray parallel to this axis, must start within the box on it
+		if (std::fabs(d) < 1e-12)
+			return o >= box_min && o <= box_max;
+
+		double t1 = (box_min - o) / d;
+		double t2 = (box_max - o) / d;
+		if (t1 > t2)
+			std::swap(t1, t2);
+		t_min = std::max(t_min, t1);
+		t_max = std::min(t_max, t2);
+
+		return t_min <= t_max;
+	};
+
+	if (!check_axis(bbox.min.x, bbox.max.x, origin.x, dir.x) || !check_axis(bbox.min.y, bbox.max.y, origin.y, dir.y))
+		return false;
+
+	entry = t_min;
+	return true;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapBVH Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears all trees, they will be rebuilt on the next query
+// -----------------------------------------------------------------------------
+void MapBVH::clear()
+{
+	tree_lines_   = {};
+	tree_sectors_ = {};
+	tree_things_  = {};
+	object_slot_.clear();
+	object_updated_.clear();
+	updated_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Flags the tree for objects of [type] as needing to be rebuilt. Must be called
+// whenever an object is added to or removed from the map
+// -----------------------------------------------------------------------------
+void MapBVH::invalidate(MapObject::Type type)
+{
+	if (auto tree = objectTree(type))
+		tree->built = false;
+}
+
+// -----------------------------------------------------------------------------
+// Flags [object] (and anything whose bounds depend on it) as needing to be
+// refitted. Must be called whenever an object is modified
+// -----------------------------------------------------------------------------
+void MapBVH::objectUpdated(MapObject* object)
+{
+	// Nothing to update if nothing has been built yet
+	if (!object || object->objId() == 0)
+		return;
+	if (!tree_lines_.built && !tree_sectors_.built && !tree_things_.built)
+		return;
+
+	flagUpdated(object);
+}
+
+// -----------------------------------------------------------------------------
+// Finds the nearest object of [type] hit by the ray from [origin] in
+// [direction], within [max_dist] (unlimited if <= 0). Distances are in
+// multiples of [direction].
+//
+// [hit] is called for each object whose bounds (expanded by [margin]) the ray
+// passes through, nearest first, and should return the distance the object is
+// hit at, or a negative value if it isn't. Objects further than the nearest
+// hit so far are skipped.
+//
+// Returns the hit object (with its distance in [hit_dist]), or null if none
+// -----------------------------------------------------------------------------
+MapObject* MapBVH::castRay(
+	MapObject::Type type,
+	const Vec3d&    origin,
+	const Vec3d&    direction,
+	double          max_dist,
+	const HitFunc&  hit,
+	double&         hit_dist,
+	double          margin) const
+{
+	hit_dist  = -1.;
+	auto tree = objectTree(type);
+	if (!tree)
+		return nullptr;
+
+	// Build/update tree if needed
+	if (!tree->built)
+		build(*tree, type);
+	update();
+	if (tree->nodes.empty())
+		return nullptr;
+
+	// Go through nodes the ray passes through, nearest first
+	auto       origin_2d = origin.get2d();
+	auto       dir_2d    = direction.get2d();
+	double     nearest   = max_dist > 0. ? max_dist : std::numeric_limits<double>::max();
+	double     entry;
+	MapObject* nearest_object = nullptr;
+
+	vector<std::pair<int, double>> to_check; // Node index, entry distance
+	if (rayHitsBox(tree->nodes[0].bbox, margin, origin_2d, dir_2d, nearest, entry))
+		to_check.emplace_back(0, entry);
+	while (!to_check.empty())
+	{
+		auto [index, node_entry] = to_check.back();
+		to_check.pop_back();
+		if (node_entry >= nearest)
+			continue;
+
+		// Leaf, check objects
+		const auto& node = tree->nodes[index];
+		if (node.count > 0)
+		{
+			for (unsigned a = node.first; a < node.first + node.count; ++a)
+			{
+				double dist = hit(tree->objects[a]);
+				if (dist >= 0. && dist < nearest)
+				{
+					nearest        = dist;
+					nearest_object = tree->objects[a];
+				}
+			}
+			continue;
+		}
+
+		// Add children (nearest last so it's checked first)
+		double left_entry, right_entry;
+		bool   left  = rayHitsBox(tree->nodes[node.left].bbox, margin, origin_2d, dir_2d, nearest, left_entry);
+		bool   right = rayHitsBox(tree->nodes[node.right].bbox, margin, origin_2d, dir_2d, nearest, right_entry);
+		if (left && right && left_entry < right_entry)
+		{
+			to_check.emplace_back(node.right, right_entry);
+			to_check.emplace_back(node.left, left_entry);
+		}
+		else
+		{
+			if (left)
+				to_check.emplace_back(node.left, left_entry);
+			if (right)
+				to_check.emplace_back(node.right, right_entry);
+		}
+	}
+
+	if (nearest_object)
+		hit_dist = nearest;
+
+	return nearest_object;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if there is a clear line of sight between [from] and [to], ie.
+// no one-sided line or solid part of a two-sided line is in the way.
+// Both points are expected to be within the map, floors/ceilings are only
+// checked where the sight line crosses a line
+// -----------------------------------------------------------------------------
+bool MapBVH::lineOfSight(const Vec3d& from, const Vec3d& to) const
+{
+	auto dir = to - from;
+	auto hit = [&](MapObject* object)
+	{
+		auto   line = dynamic_cast<MapLine*>(object);
+		double dist = math::distanceRayLine(from.get2d(), to.get2d(), line->start(), line->end());
+		if (dist < 0. || dist > 1.)
+			return -1.;
+
+		// One-sided lines always block
+		auto front = line->frontSector();
+		auto back  = line->backSector();
+		if (!front || !back)
+			return dist;
+
+		// Check the sight line passes through the gap between the floors and
+		// ceilings at the crossing point
+		auto   point   = (from + dir * dist).get2d();
+		double height  = from.z + dir.z * dist;
+		double floor   = std::max(front->floor().plane.heightAt(point), back->floor().plane.heightAt(point));
+		double ceiling = std::min(front->ceiling().plane.heightAt(point), back->ceiling().plane.heightAt(point));
+		return height < floor || height > ceiling ? dist : -1.;
+	};
+
+	double dist;
+	return castRay(MapObject::Type::Line, from, dir, 1., hit, dist) == nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the tree for objects of [type], or null if they aren't in the BVH
+// -----------------------------------------------------------------------------
+MapBVH::Tree* MapBVH::objectTree(MapObject::Type type) const
+{
+	switch (type)
+	{
+	case MapObject::Type::Line: return &tree_lines_;
+	case MapObject::Type::Sector: return &tree_sectors_;
+	case MapObject::Type::Thing: return &tree_things_;
+	default: return nullptr;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// (Re)builds [tree] from all objects of [type] currently in the map
+// -----------------------------------------------------------------------------
+void MapBVH::build(Tree& tree, MapObject::Type type) const
+{
+	// Get objects and their bounds
+	vector<BuildItem> items;
+	auto              add = [&items](MapObject* object)
+	{
+		auto bbox = objectBounds(object);
+		items.push_back({ object, bbox, { (bbox.min.x + bbox.max.x) * 0.5, (bbox.min.y + bbox.max.y) * 0.5 } });
+	};
+	switch (type)
+	{
+	case MapObject::Type::Line:
+		for (auto line : objects_.lines())
+			add(line);
+		break;
+	case MapObject::Type::Sector:
+		for (auto sector : objects_.sectors())
+			add(sector);
+		break;
+	case MapObject::Type::Thing:
+		for (auto thing : objects_.things())
+			add(thing);
+		break;
+	default: break;
+	}
+
+	// Build nodes
+	tree       = {};
+	tree.built = true;
+	if (items.empty())
+		return;
+	tree.leaf.resize(items.size());
+	tree.nodes.reserve(items.size() / max_leaf_objects * 2 + 1);
+	buildNode(tree, items, 0, items.size(), -1);
+
+	// Set objects in leaf order
+	tree.objects.reserve(items.size());
+	tree.bounds.reserve(items.size());
+	for (unsigned a = 0; a < items.size(); ++a)
+	{
+		auto object = items[a].object;
+		tree.objects.push_back(object);
+		tree.bounds.push_back(items[a].bbox);
+
+		if (object->objId() >= object_slot_.size())
+			object_slot_.resize(object->objId() + 1);
+		object_slot_[object->objId()] = a;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Builds a node in [tree] containing [count] [items] from [first], splitting it
+// into child nodes if there are too many. Returns the index of the node
+// -----------------------------------------------------------------------------
+int MapBVH::buildNode(Tree& tree, vector<BuildItem>& items, unsigned first, unsigned count, int parent) const
+{
+	int index = tree.nodes.size();
+	tree.nodes.emplace_back();
+	tree.nodes[index].parent = parent;
+
+	// Get bounds of items and their centres
+	BBox bbox    = items[first].bbox;
+	BBox centres = { items[first].centre, items[first].centre };
+	for (unsigned a = first + 1; a < first + count; ++a)
+	{
+		bbox.extend(items[a].bbox);
+		centres.min.set(std::min(centres.min.x, items[a].centre.x), std::min(centres.min.y, items[a].centre.y));
+		centres.max.set(std::max(centres.max.x, items[a].centre.x), std::max(centres.max.y, items[a].centre.y));
+	}
+	tree.nodes[index].bbox = bbox;
+
+	// Leaf
+	if (count <= max_leaf_objects)
+	{
+		tree.nodes[index].first = first;
+		tree.nodes[index].count = count;
+		for (unsigned a = first; a < first + count; ++a)
+			tree.leaf[a] = index;
+		return index;
+	}
+
+	// Split items in half along the longest axis of their centres
+	bool split_x = centres.width() >= centres.height();
+	auto mid     = items.begin() + first + count / 2;
+	std::nth_element(
+		items.begin() + first,
+		mid,
+		items.begin() + first + count,
+		[split_x](const BuildItem& lhs, const BuildItem& rhs)
+		{ return split_x ? lhs.centre.x < rhs.centre.x : lhs.centre.y < rhs.centre.y; });
+
+	int left                = buildNode(tree, items, first, count / 2, index);
+	int right               = buildNode(tree, items, first + count / 2, count - count / 2, index);
+	tree.nodes[index].left  = left;
+	tree.nodes[index].right = right;
+
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+// Refits all objects flagged as updated since the last query
+// -----------------------------------------------------------------------------
+void MapBVH::update() const
+{
+	// Objects depending on an updated object can be added to the list while
+	// going through it, so don't use an iterator here
+	for (unsigned a = 0; a < updated_.size(); ++a)
+	{
+		auto object                       = updated_[a];
+		object_updated_[object->objId()] = 0;
+
+		// Flag dependent objects
+		switch (object->objType())
+		{
+		case MapObject::Type::Vertex:
+			for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+				flagUpdated(line);
+			break;
+		case MapObject::Type::Line:
+			if (auto sector = dynamic_cast<MapLine*>(object)->frontSector())
+				flagUpdated(sector);
+			if (auto sector = dynamic_cast<MapLine*>(object)->backSector())
+				flagUpdated(sector);
+			break;
+		case MapObject::Type::Side:
+			if (auto sector = dynamic_cast<MapSide*>(object)->sector())
+				flagUpdated(sector);
+			break;
+		default: break;
+		}
+
+		refit(object);
+	}
+
+	updated_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Updates the bounds of [object] and the tree nodes containing it
+// -----------------------------------------------------------------------------
+void MapBVH::refit(MapObject* object) const
+{
+	auto tree = objectTree(object->objType());
+	if (!tree || !tree->built || object->objId() >= object_slot_.size())
+		return;
+
+	// Check object is in the tree
+	auto slot = object_slot_[object->objId()];
+	if (slot >= tree->objects.size() || tree->objects[slot] != object)
+		return;
+
+	tree->bounds[slot] = objectBounds(object);
+
+	// Update node bounds up to the root
+	for (int index = tree->leaf[slot]; index >= 0; index = tree->nodes[index].parent)
+	{
+		auto& node = tree->nodes[index];
+		if (node.count > 0)
+		{
+			node.bbox = tree->bounds[node.first];
+			for (unsigned a = node.first + 1; a < node.first + node.count; ++a)
+				node.bbox.extend(tree->bounds[a]);
+		}
+		else
+		{
+			node.bbox = tree->nodes[node.left].bbox;
+			node.bbox.extend(tree->nodes[node.right].bbox);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds [object] to the list of objects to refit, if it isn't already
+// -----------------------------------------------------------------------------
+void MapBVH::flagUpdated(MapObject* object) const
+{
+	if (object->objId() >= object_updated_.size())
+		object_updated_.resize(object->objId() + 1);
+
+	if (!object_updated_[object->objId()])
+	{
+		object_updated_[object->objId()] = 1;
+		updated_.push_back(object);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the 2d bounds of [object]
+// -----------------------------------------------------------------------------
+BBox MapBVH::objectBounds(MapObject* object)
+{
+	BBox bbox;
+	switch (object->objType())
+	{
+	case MapObject::Type::Line:
+	{
+		auto line = dynamic_cast<MapLine*>(object);
+		bbox.min.set(std::min(line->x1(), line->x2()), std::min(line->y1(), line->y2()));
+		bbox.max.set(std::max(line->x1(), line->x2()), std::max(line->y1(), line->y2()));
+		break;
+	}
+	case MapObject::Type::Sector: bbox = dynamic_cast<MapSector*>(object)->boundingBox(); break;
+	case MapObject::Type::Thing:
+	{
+		auto   thing  = dynamic_cast<MapThing*>(object);
+		double radius = std::max(game::configuration().thingType(thing->type()).radius(), 1);
+		bbox.min.set(thing->xPos() - radius, thing->yPos() - radius);
+		bbox.max.set(thing->xPos() + radius, thing->yPos() + radius);
+		break;
+	}
+	default: break;
+	}
+
+	return bbox;
+}
+
+
+// Testing
+
+#include "App.h"
+#include "General/Console.h"
+#include "Utility/StringUtils.h"
+#include <random>
+
+// -----------------------------------------------------------------------------
+// Benchmarks line of sight checks on a synthetic map of [count] random short
+// one-sided lines (100000 by default), with and without the BVH, and checks
+// that both give the same results
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_map_bvh, 0, false)
+{
+	int count = 100000;
+	if (!args.empty())
+		count = strutil::asInt(args[0]);
+	if (count < 1)
+		return;
+
+	// Build map
+	std::mt19937                     rng(1234);
+	double                           size = std::sqrt(count) * 128.;
+	std::uniform_real_distribution<> coord(0., size);
+	std::uniform_real_distribution<> offset(-32., 32.);
+	MapObjectCollection              map;
+	for (int a = 0; a < count; ++a)
+	{
+		Vec2d start{ coord(rng), coord(rng) };
+		auto  v1 = map.addVertex(std::make_unique<MapVertex>(start));
+		auto  v2 = map.addVertex(std::make_unique<MapVertex>(Vec2d{ start.x + offset(rng), start.y + offset(rng) }));
+		map.addLine(std::make_unique<MapLine>(v1, v2));
+	}
+
+	// Generate sight lines
+	vector<std::pair<Vec3d, Vec3d>> sight_lines(10000);
+	std::uniform_real_distribution<> length(-512., 512.);
+	for (auto& sight_line : sight_lines)
+	{
+		sight_line.first.set(coord(rng), coord(rng), 0.);
+		sight_line.second.set(sight_line.first.x + length(rng), sight_line.first.y + length(rng), 0.);
+	}
+
+	// With BVH (build it first so that isn't included in the timing)
+	auto time = app::runTimer();
+	map.bvh().lineOfSight(sight_lines[0].first, sight_lines[0].second);
+	log::info("Building BVH for {} lines took {}ms", map.lines().size(), app::runTimer() - time);
+	vector<bool> results_bvh;
+	time = app::runTimer();
+	for (const auto& sight_line : sight_lines)
+		results_bvh.push_back(map.bvh().lineOfSight(sight_line.first, sight_line.second));
+	log::info("{} line of sight checks with BVH took {}ms", sight_lines.size(), app::runTimer() - time);
+
+	// Without BVH
+	vector<bool> results_linear;
+	time = app::runTimer();
+	for (const auto& sight_line : sight_lines)
+	{
+		bool clear = true;
+		for (auto line : map.lines())
+		{
+			double dist = math::distanceRayLine(
+				sight_line.first.get2d(), sight_line.second.get2d(), line->start(), line->end());
+			if (dist >= 0. && dist < 1.)
+			{
+				clear = false;
+				break;
+			}
+		}
+		results_linear.push_back(clear);
+	}
+	log::info("{} line of sight checks without BVH took {}ms", sight_lines.size(), app::runTimer() - time);
+
+	// Compare
+	unsigned mismatches = 0;
+	for (unsigned a = 0; a < results_bvh.size(); ++a)
+		if (results_bvh[a] != results_linear[a])
+			++mismatches;
+	if (mismatches > 0)
+		log::warning("{} line of sight results differ between BVH and linear", mismatches);
+	else
+		log::info("BVH and linear line of sight results match");
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MapObject/MapObject.h"
+
+namespace slade
+{
+class MapObjectCollection;
+
+// A bounding volume hierarchy over the 2d bounds of map lines, sectors and
+// things, used to quickly find the objects along a ray (eg. for picking in the
+// 3d view, or line of sight checks).
+//
+// Only 2d bounds are used since heights can change without the map geometry
+// changing - callers check heights when testing each object the ray reaches.
+// Each object type has its own tree, which is built on first use and rebuilt
+// when objects of that type are added or removed. Modified objects are flagged
+// via objectUpdated and their bounds are refitted before the next query
+class MapBVH
+{
+public:
+	// Returns the distance along the ray (in multiples of the ray direction)
+	// that [object] is hit at, or a negative value if it isn't hit
+	typedef std::function<double(MapObject* object)> HitFunc;
+
+	MapBVH(const MapObjectCollection& objects) : objects_{ objects } {}
+
+	void clear();
+	void invalidate(MapObject::Type type);
+	void objectUpdated(MapObject* object);
+
+	MapObject* castRay(
+		MapObject::Type type,
+		const Vec3d&    origin,
+		const Vec3d&    direction,
+		double          max_dist,
+		const HitFunc&  hit,
+		double&         hit_dist,
+		double          margin = 0.) const;
+	bool lineOfSight(const Vec3d& from, const Vec3d& to) const;
+
+private:
+	struct Node
+	{
+		BBox     bbox;
+		int      parent = -1;
+		int      left   = -1; // Child nodes (if not a leaf)
+		int      right  = -1;
+		unsigned first  = 0; // Range of objects in the node (if a leaf)
+		unsigned count  = 0;
+	};
+
+	struct BuildItem
+	{
+		MapObject* object;
+		BBox       bbox;
+		Vec2d      centre;
+	};
+
+	struct Tree
+	{
+		vector<Node>       nodes;
+		vector<MapObject*> objects; // Ordered by leaf node
+		vector<BBox>       bounds;  // Bounds of each object
+		vector<int>        leaf;    // Leaf node each object is in
+		bool               built = false;
+	};
+
+	const MapObjectCollection& objects_;
+	mutable Tree               tree_lines_;
+	mutable Tree               tree_sectors_;
+	mutable Tree               tree_things_;
+	mutable vector<unsigned>   object_slot_;    // Index of each object (by id) in its tree
+	mutable vector<uint8_t>    object_updated_; // Whether each object (by id) needs refitting
+	mutable vector<MapObject*> updated_;
+
+	Tree* objectTree(MapObject::Type type) const;
+	void  build(Tree& tree, MapObject::Type type) const;
+	int   buildNode(Tree& tree, vector<BuildItem>& items, unsigned first, unsigned count, int parent) const;
+	void  update() const;
+	void  refit(MapObject* object) const;
+	void  flagUpdated(MapObject* object) const;
+
+	static BBox objectBounds(MapObject* object);
+};
+} // namespace slade
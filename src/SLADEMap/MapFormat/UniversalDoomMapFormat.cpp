@@ -41,10 +41,303 @@
 #include "SLADEMap/SLADEMap.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// UDMFReader Class
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A minimal reader for UDMF TEXTMAP syntax, which reads names and values
+// directly from the text data as it goes rather than tokenizing everything
+// up-front. As with the generic Parser, names and unquoted values are read as
+// lowercase
+class UDMFReader
+{
+public:
+	UDMFReader(const MemChunk& data) :
+		data_{ reinterpret_cast<const char*>(data.data()) },
+		size_{ data.size() }
+	{
+	}
+
+	unsigned position() const { return position_; }
+	void     seek(unsigned position) { position_ = position; }
+
+	// Skips whitespace and comments, returns false if the end of the data was
+	// reached
+	bool next()
+	{
+		while (position_ < size_)
+		{
+			auto c = data_[position_];
+
+			// Whitespace
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v')
+				++position_;
+
+			// Line comment (// or ##)
+			else if ((c == '/' || c == '#') && position_ + 1 < size_ && data_[position_ + 1] == c)
+			{
+				while (position_ < size_ && data_[position_] != '\n')
+					++position_;
+			}
+
+			// Block comment
+			else if (c == '/' && position_ + 1 < size_ && data_[position_ + 1] == '*')
+			{
+				position_ += 2;
+				while (position_ + 1 < size_ && !(data_[position_] == '*' && data_[position_ + 1] == '/'))
+					++position_;
+				position_ += 2;
+			}
+
+			else
+				return true;
+		}
+
+		return false;
+	}
+
+	// Reads a name (block type or property key) to [name]
+	bool readName(string& name)
+	{
+		auto token = readToken();
+		if (token.empty())
+			return error("Expected a name");
+
+		name.assign(token);
+		strutil::lowerIP(name);
+		return true;
+	}
+
+	// Reads [c] if it is the next character. If it isn't and [required] is
+	// true, an error is logged
+	bool readChar(char c, bool required = true)
+	{
+		if (next() && data_[position_] == c)
+		{
+			++position_;
+			return true;
+		}
+
+		if (required)
+			error(fmt::format("Expected \"{}\"", c));
+
+		return false;
+	}
+
+	// Reads a property value to [value]
+	bool readValue(Property& value)
+	{
+		if (!next())
+			return error("Expected a value");
+
+		// Quoted string
+		if (data_[position_] == '"')
+		{
+			string str;
+			++position_;
+			while (position_ < size_ && data_[position_] != '"')
+			{
+				// Escape backslash
+				if (data_[position_] == '\\' && position_ + 1 < size_)
+					++position_;
+
+				str += data_[position_++];
+			}
+			if (position_ >= size_)
+				return error("Unterminated string");
+
+			++position_;
+			value = std::move(str);
+			return true;
+		}
+
+		auto token = readToken();
+		if (token.empty())
+			return error("Expected a value");
+
+		// Integer
+		if (isInteger(token))
+			value = strutil::asInt(token[0] == '+' ? token.substr(1) : token);
+
+		// Hex
+		else if (token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X') && isHex(token.substr(2)))
+			value = strutil::asInt(token.substr(2), 16);
+
+		// Floating point
+		else if (isFloat(token))
+			value = strutil::asDouble(token);
+
+		// Boolean or other keyword
+		else
+		{
+			auto keyword = strutil::lower(token);
+			if (keyword == "true")
+				value = true;
+			else if (keyword == "false")
+				value = false;
+			else
+				value = std::move(keyword);
+		}
+
+		return true;
+	}
+
+	// Reads the properties of the current block (after the opening '{') to
+	// [props], up to and including the closing '}'
+	bool readBlock(vector<Named<Property>>& props)
+	{
+		props.clear();
+		while (!readChar('}', false))
+		{
+			if (!readName(name_) || !readChar('=') || !readValue(value_) || !readChar(';'))
+				return false;
+
+			props.emplace_back(name_, value_);
+		}
+
+		return true;
+	}
+
+	// Skips to the end of the current block (after the opening '{')
+	bool skipBlock()
+	{
+		while (next())
+		{
+			auto c = data_[position_];
+			if (c == '}')
+			{
+				++position_;
+				return true;
+			}
+
+			if (c == '"')
+			{
+				// Skip string
+				if (!readValue(value_))
+					return false;
+			}
+			else if (c == '{')
+				return error("Unexpected \"{\"");
+			else
+				++position_;
+		}
+
+		return error("Unexpected end of data");
+	}
+
+private:
+	const char* data_;
+	unsigned    size_;
+	unsigned    position_ = 0;
+	string      name_;
+	Property    value_;
+
+	// Reads a token up to the next whitespace or special character
+	string_view readToken()
+	{
+		if (!next())
+			return {};
+
+		auto start = position_;
+		while (position_ < size_)
+		{
+			auto c = data_[position_];
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v' || c == ';' || c == '='
+				|| c == '{' || c == '}' || c == '"' || c == ',' || c == '/')
+				break;
+
+			++position_;
+		}
+
+		return { data_ + start, position_ - start };
+	}
+
+	// Logs an error at the current position, always returns false
+	bool error(string_view message) const
+	{
+		auto line = std::count(data_, data_ + std::min(position_, size_), '\n') + 1;
+		log::error("Error reading TEXTMAP (line {}): {}", line, message);
+		return false;
+	}
+
+	static bool isDigits(string_view str)
+	{
+		if (str.empty())
+			return false;
+
+		for (auto c : str)
+			if (c < '0' || c > '9')
+				return false;
+
+		return true;
+	}
+
+	static bool isInteger(string_view str)
+	{
+		if (!str.empty() && (str[0] == '+' || str[0] == '-'))
+			str.remove_prefix(1);
+
+		return isDigits(str);
+	}
+
+	static bool isHex(string_view str)
+	{
+		for (auto c : str)
+			if (!isxdigit(static_cast<unsigned char>(c)))
+				return false;
+
+		return true;
+	}
+
+	static bool isFloat(string_view str)
+	{
+		if (!str.empty() && (str[0] == '+' || str[0] == '-'))
+			str.remove_prefix(1);
+
+		// Exponent
+		auto exp = str.find_first_of("eE");
+		if (exp != string_view::npos)
+		{
+			auto exp_str = str.substr(exp + 1);
+			if (!exp_str.empty() && (exp_str[0] == '+' || exp_str[0] == '-'))
+				exp_str.remove_prefix(1);
+			if (!isDigits(exp_str))
+				return false;
+			str = str.substr(0, exp);
+		}
+
+		// Digits with an optional decimal point (at least one digit after it)
+		auto point = str.find('.');
+		if (point == string_view::npos)
+			return isDigits(str);
+
+		return (point == 0 || isDigits(str.substr(0, point))) && isDigits(str.substr(point + 1));
+	}
+};
+
+// -----------------------------------------------------------------------------
+// Returns the value of the first property in [props] named [name], or nullptr
+// if there are none
+// -----------------------------------------------------------------------------
+const Property* findProp(const vector<Named<Property>>& props, string_view name)
+{
+	for (const auto& prop : props)
+		if (prop.name == name)
+			return &prop.value;
+
+	return nullptr;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // UniversalDoomMapFormat Class Functions
@@ -66,11 +359,202 @@ bool UniversalDoomMapFormat::readMap(Archive::MapDesc map, MapObjectCollection&
 	if (!textmap)
 		return false;
 
+	// Read TEXTMAP, falling back to the generic parser if it isn't strictly
+	// valid UDMF (the parser is more lenient)
+	if (readTextmap(textmap->data(), map_data, map_extra_props))
+		return true;
+
+	log::warning("Unable to read TEXTMAP directly, trying generic parser");
+	map_data.clear();
+	map_extra_props.clear();
+	return readTextmapTree(textmap->data(), map_data, map_extra_props);
+}
+
+// -----------------------------------------------------------------------------
+// Reads UDMF TEXTMAP [data] directly into [map_data], without building a
+// parse tree first.
+//
+// Objects are created in the order required (sectors before sides, vertices
+// and sides before lines) regardless of the order they are defined in, so any
+// sidedef and linedef blocks are skipped over on the first pass and read
+// afterwards
+// -----------------------------------------------------------------------------
+bool UniversalDoomMapFormat::readTextmap(
+	const MemChunk&      data,
+	MapObjectCollection& map_data,
+	PropertyList&        map_extra_props)
+{
+	ui::setSplashProgressMessage("Reading TEXTMAP");
+	ui::setSplashProgress(0.0f);
+
+	UDMFReader              reader(data);
+	vector<Named<Property>> props;
+	vector<unsigned>        blocks_sides;
+	vector<unsigned>        blocks_lines;
+	unsigned                n_vertices = 0;
+	unsigned                n_sectors  = 0;
+	unsigned                n_things   = 0;
+	string                  name;
+	Property                value;
+	while (reader.next())
+	{
+		ui::setSplashProgress((float)reader.position() / data.size() * 0.6f);
+
+		if (!reader.readName(name))
+			return false;
+
+		// Global assignment
+		if (reader.readChar('=', false))
+		{
+			if (!reader.readValue(value) || !reader.readChar(';'))
+				return false;
+
+			if (name == "namespace")
+				udmf_namespace_ = property::asString(value);
+			else
+				map_extra_props[name] = value;
+
+			continue;
+		}
+
+		// Block
+		if (!reader.readChar('{'))
+			return false;
+
+		// Side/Line definition (read later, see above)
+		if (name == "sidedef" || name == "linedef")
+		{
+			if (name == "sidedef")
+				blocks_sides.push_back(reader.position());
+			else
+				blocks_lines.push_back(reader.position());
+
+			if (!reader.skipBlock())
+				return false;
+		}
+
+		// Vertex definition
+		else if (name == "vertex")
+		{
+			if (!reader.readBlock(props))
+				return false;
+
+			auto prop_x = findProp(props, MapVertex::PROP_X);
+			auto prop_y = findProp(props, MapVertex::PROP_Y);
+			if (prop_x && prop_y)
+				map_data.addVertex(std::make_unique<MapVertex>(
+					Vec2d{ property::asFloat(*prop_x), property::asFloat(*prop_y) }, props));
+			else
+				log::warning("Invalid UDMF vertex definition {}, not added", n_vertices);
+
+			n_vertices++;
+		}
+
+		// Sector definition
+		else if (name == "sector")
+		{
+			if (!reader.readBlock(props))
+				return false;
+
+			auto prop_ftex = findProp(props, MapSector::PROP_TEXFLOOR);
+			auto prop_ctex = findProp(props, MapSector::PROP_TEXCEILING);
+			if (prop_ftex && prop_ctex)
+				map_data.addSector(std::make_unique<MapSector>(
+					property::asString(*prop_ftex), property::asString(*prop_ctex), props));
+			else
+				log::warning("Invalid UDMF sector definition {}, not added", n_sectors);
+
+			n_sectors++;
+		}
+
+		// Thing definition
+		else if (name == "thing")
+		{
+			if (!reader.readBlock(props))
+				return false;
+
+			auto prop_x    = findProp(props, MapThing::PROP_X);
+			auto prop_y    = findProp(props, MapThing::PROP_Y);
+			auto prop_type = findProp(props, MapThing::PROP_TYPE);
+			if (prop_x && prop_y && prop_type)
+				map_data.addThing(std::make_unique<MapThing>(
+					Vec3d{ property::asFloat(*prop_x), property::asFloat(*prop_y), 0. },
+					property::asInt(*prop_type),
+					props));
+			else
+				log::warning("Invalid UDMF thing definition {}, not added", n_things);
+
+			n_things++;
+		}
+
+		// Unknown
+		else if (!reader.skipBlock())
+			return false;
+	}
+
+	// Read sides
+	for (unsigned a = 0; a < blocks_sides.size(); a++)
+	{
+		ui::setSplashProgress(0.6f + ((float)a / blocks_sides.size()) * 0.2f);
+
+		reader.seek(blocks_sides[a]);
+		if (!reader.readBlock(props))
+			return false;
+
+		auto prop_sector = findProp(props, MapSide::PROP_SECTOR);
+		auto sector      = prop_sector ? map_data.sectors().at(property::asInt(*prop_sector)) : nullptr;
+		if (sector)
+			map_data.addSide(std::make_unique<MapSide>(sector, props));
+		else
+			log::warning("Invalid UDMF side definition {}, not added", a);
+	}
+
+	// Read lines
+	for (unsigned a = 0; a < blocks_lines.size(); a++)
+	{
+		ui::setSplashProgress(0.8f + ((float)a / blocks_lines.size()) * 0.2f);
+
+		reader.seek(blocks_lines[a]);
+		if (!reader.readBlock(props))
+			return false;
+
+		auto prop_v1 = findProp(props, MapLine::PROP_V1);
+		auto prop_v2 = findProp(props, MapLine::PROP_V2);
+		auto prop_s1 = findProp(props, MapLine::PROP_S1);
+		auto prop_s2 = findProp(props, MapLine::PROP_S2);
+		auto v1      = prop_v1 ? map_data.vertices().at(property::asInt(*prop_v1)) : nullptr;
+		auto v2      = prop_v2 ? map_data.vertices().at(property::asInt(*prop_v2)) : nullptr;
+		if (!v1 || !v2 || !prop_s1)
+		{
+			log::warning("Invalid UDMF line definition {}, not added", a);
+			continue;
+		}
+
+		auto s1 = map_data.sides().at(property::asInt(*prop_s1));
+		auto s2 = prop_s2 ? map_data.sides().at(property::asInt(*prop_s2)) : nullptr;
+		map_data.addLine(std::make_unique<MapLine>(v1, v2, s1, s2, props));
+	}
+
+	ui::setSplashProgressMessage("Init map data");
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads UDMF TEXTMAP [data] into [map_data] via the generic Parser.
+// This is slower than readTextmap and uses a lot more memory for large maps,
+// but accepts some non-standard syntax
+// -----------------------------------------------------------------------------
+bool UniversalDoomMapFormat::readTextmapTree(
+	MemChunk&            data,
+	MapObjectCollection& map_data,
+	PropertyList&        map_extra_props)
+{
 	// --- Parse UDMF text ---
 	ui::setSplashProgressMessage("Parsing TEXTMAP");
 	ui::setSplashProgress(-100.0f);
 	Parser parser;
-	if (!parser.parseText(textmap->data()))
+	if (!parser.parseText(data))
 		return false;
 
 	// --- Process parsed data ---
@@ -229,98 +713,66 @@ vector<unique_ptr<ArchiveEntry>> UniversalDoomMapFormat::writeMap(
 	vector<unique_ptr<ArchiveEntry>> entries;
 	entries.push_back(std::make_unique<ArchiveEntry>("TEXTMAP"));
 
-	// Open temp text file
-	wxFile tempfile(app::path("sladetemp.txt", app::Dir::Temp), wxFile::write);
-
-	// Write map namespace
-	tempfile.Write("// Written by SLADE3\n");
-	tempfile.Write(fmt::format("namespace=\"{}\";\n", udmf_namespace_));
-
-	// Write map-scope props
-	tempfile.Write(map_extra_props.toString(true));
-	tempfile.Write("\n");
-
-	// sf::Clock clock;
-
-	// Locale for float number format
-	setlocale(LC_NUMERIC, "C");
-
-	// Write things
-	string object_def;
+	// Get all objects in the order they are written
+	vector<MapObject*> objects;
+	objects.reserve(
+		map_data.things().size() + map_data.lines().size() + map_data.sides().size() + map_data.vertices().size()
+		+ map_data.sectors().size());
 	for (const auto& thing : map_data.things())
-	{
-		// Cleanup properties
-		if (!thing->props().empty())
-		{
-			thing->props().remove("flags");
-			game::configuration().cleanObjectUDMFProps(thing);
-		}
-
-		thing->writeUDMF(object_def);
-		tempfile.Write(object_def);
-	}
-	// log::info(1, "Writing things took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Write lines
-	// clock.restart();
+		objects.push_back(thing);
 	for (const auto& line : map_data.lines())
-	{
-		// Cleanup properties
-		if (!line->props().empty())
-		{
-			line->props().remove("flags");
-			game::configuration().cleanObjectUDMFProps(line);
-		}
-
-		line->writeUDMF(object_def);
-		tempfile.Write(object_def);
-	}
-	// log::info(1, "Writing lines took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Write sides
-	// clock.restart();
+		objects.push_back(line);
 	for (const auto& side : map_data.sides())
-	{
-		// Cleanup properties
-		if (!side->props().empty())
-			game::configuration().cleanObjectUDMFProps(side);
-
-		side->writeUDMF(object_def);
-		tempfile.Write(object_def);
-	}
-	// log::info(1, "Writing sides took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Write vertices
-	// clock.restart();
+		objects.push_back(side);
 	for (const auto& vertex : map_data.vertices())
-	{
-		// Cleanup properties
-		if (!vertex->props().empty())
-			game::configuration().cleanObjectUDMFProps(vertex);
-
-		vertex->writeUDMF(object_def);
-		tempfile.Write(object_def);
-	}
-	// log::info(1, "Writing vertices took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Write sectors
-	// clock.restart();
+		objects.push_back(vertex);
 	for (const auto& sector : map_data.sectors())
-	{
-		// Cleanup properties
-		if (!sector->props().empty())
-			game::configuration().cleanObjectUDMFProps(sector);
-
-		sector->writeUDMF(object_def);
-		tempfile.Write(object_def);
-	}
-	// log::info(1, "Writing sectors took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Close file
-	tempfile.Close();
-
-	// Load file to entry
-	entries[0]->importFile(app::path("sladetemp.txt", app::Dir::Temp));
+		objects.push_back(sector);
+
+	// Write object definitions, in batches spread across threads. Numbers are
+	// formatted via fmt, which doesn't depend on the current locale
+	const size_t   batch_size = 1024;
+	vector<string> batches((objects.size() + batch_size - 1) / batch_size);
+	app::threadPool().parallelFor(
+		batches.size(),
+		[&](size_t batch)
+		{
+			string object_def;
+			auto   end = std::min(objects.size(), (batch + 1) * batch_size);
+			for (auto a = batch * batch_size; a < end; a++)
+			{
+				auto object = objects[a];
+
+				// Cleanup properties
+				if (!object->props().empty())
+				{
+					if (object->objType() == MapObject::Type::Thing || object->objType() == MapObject::Type::Line)
+						object->props().remove("flags");
+					game::configuration().cleanObjectUDMFProps(object);
+				}
+
+				object->writeUDMF(object_def);
+				batches[batch] += object_def;
+			}
+		},
+		1);
+
+	// Map namespace and map-scope props
+	string header = "// Written by SLADE3\n";
+	header += fmt::format("namespace=\"{}\";\n", udmf_namespace_);
+	header += map_extra_props.toString(true);
+	header += "\n";
+
+	// Write everything to the entry
+	size_t size = header.size();
+	for (const auto& batch : batches)
+		size += batch.size();
+	MemChunk textmap(size);
+	textmap.write(header.data(), header.size());
+	for (const auto& batch : batches)
+		textmap.write(batch.data(), batch.size());
+	textmap.makeShareable(); // Entry takes the data rather than copying it
+	entries[0]->importMemChunk(textmap);
 
 	return entries;
 }
@@ -417,3 +869,53 @@ unique_ptr<MapThing> UniversalDoomMapFormat::createThing(ParseTreeNode* def) con
 	return std::make_unique<MapThing>(
 		Vec3d{ prop_x->floatValue(), prop_y->floatValue(), 0. }, prop_type->intValue(), def);
 }
+
+
+// Testing
+
+#include "General/Console.h"
+#include "MainEditor/MainEditor.h"
+
+// -----------------------------------------------------------------------------
+// Benchmarks reading a UDMF TEXTMAP entry (the selected entry, or the entry at
+// the path given in the current archive) via both the direct reader and the
+// generic parser
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_udmf_read, 0, false)
+{
+	ArchiveEntry* entry = nullptr;
+	if (!args.empty() && maineditor::currentArchive())
+		entry = maineditor::currentArchive()->entryAtPath(args[0]);
+	if (!entry)
+		entry = maineditor::currentEntry();
+	if (!entry)
+	{
+		log::console("Select a TEXTMAP entry or enter a valid entry path");
+		return;
+	}
+
+	UniversalDoomMapFormat udmf;
+	auto&                  data = entry->data();
+	for (auto direct : { false, true })
+	{
+		MapObjectCollection map_data;
+		PropertyList        extra_props;
+
+		auto start = app::runTimer();
+		auto ok    = direct ? udmf.readTextmap(data, map_data, extra_props) :
+							  udmf.readTextmapTree(data, map_data, extra_props);
+		auto time  = app::runTimer() - start;
+
+		log::console(fmt::format(
+			"Reading {} ({}) {} in {}ms: {} vertices, {} lines, {} sides, {} sectors, {} things",
+			entry->name(),
+			direct ? "direct" : "parse tree",
+			ok ? "succeeded" : "failed",
+			time,
+			map_data.vertices().size(),
+			map_data.lines().size(),
+			map_data.sides().size(),
+			map_data.sectors().size(),
+			map_data.things().size()));
+	}
+}
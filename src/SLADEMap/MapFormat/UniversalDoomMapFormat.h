@@ -19,6 +19,9 @@ public:
 	vector<unique_ptr<ArchiveEntry>> writeMap(const MapObjectCollection& map_data, const PropertyList& map_extra_props)
 		override;
 
+	bool readTextmap(const MemChunk& data, MapObjectCollection& map_data, PropertyList& map_extra_props);
+	bool readTextmapTree(MemChunk& data, MapObjectCollection& map_data, PropertyList& map_extra_props);
+
 	string udmfNamespace() const override { return udmf_namespace_; }
 	void   setUDMFNamespace(string_view ns) override { udmf_namespace_ = ns; }
 
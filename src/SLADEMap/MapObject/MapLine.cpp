@@ -101,32 +101,41 @@ MapLine::MapLine(MapVertex* v1, MapVertex* v2, MapSide* s1, MapSide* s2, ParseTr
 	for (unsigned a = 0; a < udmf_def->nChildren(); a++)
 	{
 		prop = udmf_def->childPTN(a);
-
-		// Skip required properties
-		if (prop->nameIsCI(PROP_V1) || prop->nameIsCI(PROP_V2) || prop->nameIsCI(PROP_S1) || prop->nameIsCI(PROP_S2))
-			continue;
-
-		if (prop->nameIsCI(PROP_SPECIAL))
-			special_ = prop->intValue();
-		else if (prop->nameIsCI(PROP_ID))
-			id_ = prop->intValue();
-		else if (prop->nameIsCI(PROP_FLAGS))
-			flags_ = prop->intValue();
-		else if (prop->nameIsCI(PROP_ARG0))
-			args_[0] = prop->intValue();
-		else if (prop->nameIsCI(PROP_ARG1))
-			args_[1] = prop->intValue();
-		else if (prop->nameIsCI(PROP_ARG2))
-			args_[2] = prop->intValue();
-		else if (prop->nameIsCI(PROP_ARG3))
-			args_[3] = prop->intValue();
-		else if (prop->nameIsCI(PROP_ARG4))
-			args_[4] = prop->intValue();
-		else
-			properties_[prop->name()] = prop->value();
+		readUDMFProperty(prop->name(), prop->value());
 	}
 }
 
+// -----------------------------------------------------------------------------
+// MapLine class constructor from UDMF properties
+// -----------------------------------------------------------------------------
+MapLine::MapLine(
+	MapVertex*                     v1,
+	MapVertex*                     v2,
+	MapSide*                       s1,
+	MapSide*                       s2,
+	const vector<Named<Property>>& udmf_props) :
+	MapObject(Type::Line),
+	vertex1_{ v1 },
+	vertex2_{ v2 },
+	side1_{ s1 },
+	side2_{ s2 }
+{
+	// Connect to vertices
+	if (v1)
+		v1->connectLine(this);
+	if (v2)
+		v2->connectLine(this);
+
+	// Connect to sides
+	if (s1)
+		s1->parent_ = this;
+	if (s2)
+		s2->parent_ = this;
+
+	for (const auto& prop : udmf_props)
+		readUDMFProperty(prop.name, prop.value);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the sector on the front side of the line (if any)
 // -----------------------------------------------------------------------------
@@ -1013,3 +1022,33 @@ void MapLine::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Sets UDMF property [name] to [value]
+// -----------------------------------------------------------------------------
+void MapLine::readUDMFProperty(string_view name, const Property& value)
+{
+	// Skip required properties
+	if (strutil::equalCI(name, PROP_V1) || strutil::equalCI(name, PROP_V2) || strutil::equalCI(name, PROP_S1)
+		|| strutil::equalCI(name, PROP_S2))
+		return;
+
+	if (strutil::equalCI(name, PROP_SPECIAL))
+		special_ = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ID))
+		id_ = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_FLAGS))
+		flags_ = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ARG0))
+		args_[0] = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ARG1))
+		args_[1] = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ARG2))
+		args_[2] = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ARG3))
+		args_[3] = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ARG4))
+		args_[4] = property::asInt(value);
+	else
+		properties_[name] = value;
+}
@@ -42,6 +42,7 @@ public:
 		int        flags   = 0,
 		ArgSet     args    = {});
 	MapLine(MapVertex* v1, MapVertex* v2, MapSide* s1, MapSide* s2, ParseTreeNode* udmf_def);
+	MapLine(MapVertex* v1, MapVertex* v2, MapSide* s1, MapSide* s2, const vector<Named<Property>>& udmf_props);
 	~MapLine() = default;
 
 	bool isOk() const { return vertex1_ && vertex2_; }
@@ -138,5 +139,7 @@ private:
 	double ca_     = 0.; // Used for intersection calculations
 	double sa_     = 0.; // ^^
 	Vec2d  front_vec_;
+
+	void readUDMFProperty(string_view name, const Property& value);
 };
 } // namespace slade
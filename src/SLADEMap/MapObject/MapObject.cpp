@@ -103,6 +103,10 @@ void MapObject::setModified()
 		backupTo(obj_backup_.get());
 	}
 
+	// Object position/bounds may change, needs re-indexing
+	if (parent_map_ && obj_id_ > 0)
+		parent_map_->objectUpdated(this);
+
 	modified_time_ = app::runTimer();
 }
 
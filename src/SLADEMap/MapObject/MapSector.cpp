@@ -84,24 +84,23 @@ MapSector::MapSector(string_view f_tex, string_view c_tex, ParseTreeNode* udmf_d
 	for (unsigned a = 0; a < udmf_def->nChildren(); a++)
 	{
 		prop = udmf_def->childPTN(a);
+		readUDMFProperty(prop->name(), prop->value());
+	}
+}
 
-		// Skip required properties
-		if (prop->nameIsCI(PROP_TEXFLOOR) || prop->nameIsCI(PROP_TEXCEILING))
-			continue;
+// -----------------------------------------------------------------------------
+// MapSector class constructor from UDMF properties
+// -----------------------------------------------------------------------------
+MapSector::MapSector(string_view f_tex, string_view c_tex, const vector<Named<Property>>& udmf_props) :
+	MapObject(Type::Sector),
+	floor_{ f_tex },
+	ceiling_{ c_tex }
+{
+	// Set UDMF defaults
+	light_ = 160;
 
-		if (prop->nameIsCI(PROP_HEIGHTFLOOR))
-			setFloorHeight(prop->intValue());
-		else if (prop->nameIsCI(PROP_HEIGHTCEILING))
-			setCeilingHeight(prop->intValue());
-		else if (prop->nameIsCI(PROP_LIGHTLEVEL))
-			light_ = prop->intValue();
-		else if (prop->nameIsCI(PROP_SPECIAL))
-			special_ = prop->intValue();
-		else if (prop->nameIsCI(PROP_ID))
-			id_ = prop->intValue();
-		else
-			properties_[prop->name()] = prop->value();
-	}
+	for (const auto& prop : udmf_props)
+		readUDMFProperty(prop.name, prop.value);
 }
 
 // -----------------------------------------------------------------------------
@@ -988,3 +987,26 @@ void MapSector::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Sets UDMF property [name] to [value]
+// -----------------------------------------------------------------------------
+void MapSector::readUDMFProperty(string_view name, const Property& value)
+{
+	// Skip required properties
+	if (strutil::equalCI(name, PROP_TEXFLOOR) || strutil::equalCI(name, PROP_TEXCEILING))
+		return;
+
+	if (strutil::equalCI(name, PROP_HEIGHTFLOOR))
+		setFloorHeight(property::asInt(value));
+	else if (strutil::equalCI(name, PROP_HEIGHTCEILING))
+		setCeilingHeight(property::asInt(value));
+	else if (strutil::equalCI(name, PROP_LIGHTLEVEL))
+		light_ = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_SPECIAL))
+		special_ = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_ID))
+		id_ = property::asInt(value);
+	else
+		properties_[name] = value;
+}
@@ -50,6 +50,7 @@ public:
 		short       special  = 0,
 		short       id       = 0);
 	MapSector(string_view f_tex, string_view c_tex, ParseTreeNode* udmf_def);
+	MapSector(string_view f_tex, string_view c_tex, const vector<Named<Property>>& udmf_props);
 	~MapSector() = default;
 
 	void copy(MapObject* obj) override;
@@ -136,6 +137,7 @@ private:
 	Vec2d            text_point_;
 
 	void setGeometryUpdated();
+	void readUDMFProperty(string_view name, const Property& value);
 };
 
 // Note: these MUST be inline, or the linker will complain
@@ -79,28 +79,24 @@ MapSide::MapSide(MapSector* sector, ParseTreeNode* udmf_def) : MapObject{ Type::
 	for (unsigned a = 0; a < udmf_def->nChildren(); a++)
 	{
 		prop = udmf_def->childPTN(a);
-
-		// Skip required properties
-		if (prop->nameIsCI(PROP_SECTOR))
-			continue;
-
-		if (prop->nameIsCI(PROP_TEXUPPER))
-			tex_upper_ = prop->stringValue();
-		else if (prop->nameIsCI(PROP_TEXMIDDLE))
-			tex_middle_ = prop->stringValue();
-		else if (prop->nameIsCI(PROP_TEXLOWER))
-			tex_lower_ = prop->stringValue();
-		else if (prop->nameIsCI(PROP_OFFSETX))
-			tex_offset_.x = prop->intValue();
-		else if (prop->nameIsCI(PROP_OFFSETY))
-			tex_offset_.y = prop->intValue();
-		else
-			properties_[prop->name()] = prop->value();
-		// log::info(1, "Property %s type %s (%s)", prop->getName(), prop->getValue().typeString(),
-		// prop->getValue().getStringValue());
+		readUDMFProperty(prop->name(), prop->value());
 	}
 }
 
+// -----------------------------------------------------------------------------
+// MapSide class constructor from UDMF properties
+// -----------------------------------------------------------------------------
+MapSide::MapSide(MapSector* sector, const vector<Named<Property>>& udmf_props) :
+	MapObject{ Type::Side },
+	sector_{ sector }
+{
+	if (sector)
+		sector->connectSide(this);
+
+	for (const auto& prop : udmf_props)
+		readUDMFProperty(prop.name, prop.value);
+}
+
 // -----------------------------------------------------------------------------
 // Copies another MapSide object [c]
 // -----------------------------------------------------------------------------
@@ -401,3 +397,26 @@ void MapSide::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Sets UDMF property [name] to [value]
+// -----------------------------------------------------------------------------
+void MapSide::readUDMFProperty(string_view name, const Property& value)
+{
+	// Skip required properties
+	if (strutil::equalCI(name, PROP_SECTOR))
+		return;
+
+	if (strutil::equalCI(name, PROP_TEXUPPER))
+		tex_upper_ = property::asString(value);
+	else if (strutil::equalCI(name, PROP_TEXMIDDLE))
+		tex_middle_ = property::asString(value);
+	else if (strutil::equalCI(name, PROP_TEXLOWER))
+		tex_lower_ = property::asString(value);
+	else if (strutil::equalCI(name, PROP_OFFSETX))
+		tex_offset_.x = property::asInt(value);
+	else if (strutil::equalCI(name, PROP_OFFSETY))
+		tex_offset_.y = property::asInt(value);
+	else
+		properties_[name] = value;
+}
@@ -28,6 +28,7 @@ public:
 		string_view tex_lower  = TEX_NONE,
 		Vec2i       tex_offset = { 0, 0 });
 	MapSide(MapSector* sector, ParseTreeNode* udmf_def);
+	MapSide(MapSector* sector, const vector<Named<Property>>& udmf_props);
 	~MapSide() = default;
 
 	void copy(MapObject* c) override;
@@ -71,5 +72,7 @@ private:
 	string     tex_middle_ = "-";
 	string     tex_lower_  = "-";
 	Vec2i      tex_offset_ = { 0, 0 };
+
+	void readUDMFProperty(string_view name, const Property& value);
 };
 } // namespace slade
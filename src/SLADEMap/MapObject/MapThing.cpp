@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapThing.h"
+#include "SLADEMap/SLADEMap.h"
 #include "Utility/Parser.h"
 
 using namespace slade;
@@ -73,37 +74,23 @@ MapThing::MapThing(const Vec3d& pos, short type, ParseTreeNode* def) :
 	for (unsigned a = 0; a < def->nChildren(); a++)
 	{
 		prop = def->childPTN(a);
-
-		// Skip required properties
-		if (prop->name() == PROP_X || prop->name() == PROP_Y || prop->name() == PROP_TYPE)
-			continue;
-
-		// Builtin properties
-		if (prop->name() == PROP_Z)
-			z_ = prop->floatValue();
-		else if (prop->name() == PROP_ANGLE)
-			angle_ = prop->intValue();
-		else if (prop->name() == PROP_FLAGS)
-			flags_ = prop->intValue();
-		else if (prop->name() == PROP_ARG0)
-			args_[0] = prop->intValue();
-		else if (prop->name() == PROP_ARG1)
-			args_[1] = prop->intValue();
-		else if (prop->name() == PROP_ARG2)
-			args_[2] = prop->intValue();
-		else if (prop->name() == PROP_ARG3)
-			args_[3] = prop->intValue();
-		else if (prop->name() == PROP_ARG4)
-			args_[4] = prop->intValue();
-		else if (prop->name() == PROP_ID)
-			id_ = prop->intValue();
-		else if (prop->name() == PROP_SPECIAL)
-			special_ = prop->intValue();
-		else
-			properties_[prop->name()] = prop->value();
+		readUDMFProperty(prop->name(), prop->value());
 	}
 }
 
+// -----------------------------------------------------------------------------
+// MapThing class constructor from UDMF properties
+// -----------------------------------------------------------------------------
+MapThing::MapThing(const Vec3d& pos, short type, const vector<Named<Property>>& udmf_props) :
+	MapObject(Type::Thing),
+	type_{ type },
+	position_{ pos.x, pos.y },
+	z_{ pos.z }
+{
+	for (const auto& prop : udmf_props)
+		readUDMFProperty(prop.name, prop.value);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the object point [point].
 // Currently for things this is always the thing position
@@ -252,6 +239,8 @@ void MapThing::move(Vec2d pos, bool modify)
 {
 	if (modify)
 		setModified();
+	else if (parent_map_)
+		parent_map_->objectUpdated(this);
 	position_ = pos;
 }
 
@@ -447,3 +436,37 @@ void MapThing::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Sets UDMF property [name] to [value]
+// -----------------------------------------------------------------------------
+void MapThing::readUDMFProperty(string_view name, const Property& value)
+{
+	// Skip required properties
+	if (name == PROP_X || name == PROP_Y || name == PROP_TYPE)
+		return;
+
+	// Builtin properties
+	if (name == PROP_Z)
+		z_ = property::asFloat(value);
+	else if (name == PROP_ANGLE)
+		angle_ = property::asInt(value);
+	else if (name == PROP_FLAGS)
+		flags_ = property::asInt(value);
+	else if (name == PROP_ARG0)
+		args_[0] = property::asInt(value);
+	else if (name == PROP_ARG1)
+		args_[1] = property::asInt(value);
+	else if (name == PROP_ARG2)
+		args_[2] = property::asInt(value);
+	else if (name == PROP_ARG3)
+		args_[3] = property::asInt(value);
+	else if (name == PROP_ARG4)
+		args_[4] = property::asInt(value);
+	else if (name == PROP_ID)
+		id_ = property::asInt(value);
+	else if (name == PROP_SPECIAL)
+		special_ = property::asInt(value);
+	else
+		properties_[name] = value;
+}
@@ -33,6 +33,7 @@ public:
 		int           id      = 0,
 		int           special = 0);
 	MapThing(const Vec3d& pos, short type, ParseTreeNode* def);
+	MapThing(const Vec3d& pos, short type, const vector<Named<Property>>& udmf_props);
 	~MapThing() = default;
 
 	double        xPos() const { return position_.x; }
@@ -93,5 +94,7 @@ private:
 	ArgSet args_    = {};
 	int    id_      = 0;
 	int    special_ = 0;
+
+	void readUDMFProperty(string_view name, const Property& value);
 };
 } // namespace slade
@@ -59,15 +59,21 @@ MapVertex::MapVertex(const Vec2d& pos, ParseTreeNode* udmf_def) : MapObject(Type
 	for (unsigned a = 0; a < udmf_def->nChildren(); a++)
 	{
 		prop = udmf_def->childPTN(a);
-
-		// Skip required properties
-		if (prop->name() == PROP_X || prop->name() == PROP_Y)
-			continue;
-
-		properties_[prop->name()] = prop->value();
+		readUDMFProperty(prop->name(), prop->value());
 	}
 }
 
+// -----------------------------------------------------------------------------
+// MapVertex class constructor from UDMF properties
+// -----------------------------------------------------------------------------
+MapVertex::MapVertex(const Vec2d& pos, const vector<Named<Property>>& udmf_props) :
+	MapObject(Type::Vertex),
+	position_{ pos }
+{
+	for (const auto& prop : udmf_props)
+		readUDMFProperty(prop.name, prop.value);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the object point [point].
 // Currently for vertices this is always the vertex position
@@ -241,3 +247,15 @@ void MapVertex::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Sets UDMF property [name] to [value]
+// -----------------------------------------------------------------------------
+void MapVertex::readUDMFProperty(string_view name, const Property& value)
+{
+	// Skip required properties
+	if (name == PROP_X || name == PROP_Y)
+		return;
+
+	properties_[name] = value;
+}
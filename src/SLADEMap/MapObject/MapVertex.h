@@ -17,6 +17,7 @@ public:
 
 	MapVertex(const Vec2d& pos);
 	MapVertex(const Vec2d& pos, ParseTreeNode* udmf_def);
+	MapVertex(const Vec2d& pos, const vector<Named<Property>>& udmf_props);
 	~MapVertex() = default;
 
 	double xPos() const { return position_.x; }
@@ -61,5 +62,7 @@ private:
 
 	// Internal info
 	vector<MapLine*> connected_lines_;
+
+	void readUDMFProperty(string_view name, const Property& value);
 };
 } // namespace slade
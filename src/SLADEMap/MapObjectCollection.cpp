@@ -43,10 +43,16 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 // MapObjectCollection class constructor
 // -----------------------------------------------------------------------------
-MapObjectCollection::MapObjectCollection(SLADEMap* parent_map) : parent_map_{ parent_map }
+MapObjectCollection::MapObjectCollection(SLADEMap* parent_map) : parent_map_{ parent_map }, spatial_index_{ *this }, bvh_{ *this }
 {
 	// Object id 0 is always null
 	objects_.emplace_back(nullptr, false);
+
+	// Use spatial index for position-based queries
+	vertices_.setSpatialIndex(&spatial_index_);
+	lines_.setSpatialIndex(&spatial_index_);
+	sectors_.setSpatialIndex(&spatial_index_);
+	things_.setSpatialIndex(&spatial_index_);
 }
 
 // -----------------------------------------------------------------------------
@@ -56,6 +62,8 @@ void MapObjectCollection::addMapObject(unique_ptr<MapObject> object)
 {
 	object->obj_id_     = objects_.size();
 	object->parent_map_ = parent_map_;
+	spatial_index_.objectUpdated(object.get());
+	bvh_.invalidate(object->objType());
 	objects_.emplace_back(std::move(object), true);
 }
 
@@ -65,7 +73,20 @@ void MapObjectCollection::addMapObject(unique_ptr<MapObject> object)
 // -----------------------------------------------------------------------------
 void MapObjectCollection::removeMapObject(MapObject* object)
 {
+	// Record the list positions that will change when the object is removed
+	// from its list (it's swapped with the last object)
+	if (id_list_recording_)
+	{
+		auto  type   = object->objType();
+		auto& record = id_list_records_[static_cast<int>(type)];
+		for (auto position : { object->index_, nObjects(type) - 1 })
+			if (position < record.size && record.ids.find(position) == record.ids.end())
+				record.ids[position] = objectAt(type, position)->obj_id_;
+	}
+
 	objects_[object->obj_id_].in_map = false;
+	spatial_index_.objectUpdated(object);
+	bvh_.invalidate(object->objType());
 }
 
 // -----------------------------------------------------------------------------
@@ -106,6 +127,10 @@ void MapObjectCollection::putObjectIdList(MapObject::Type type, vector<unsigned>
 // -----------------------------------------------------------------------------
 void MapObjectCollection::restoreObjectIdList(MapObject::Type type, vector<unsigned>& list)
 {
+	// Rebuild the spatial index and BVH from scratch next time they're used
+	spatial_index_.clear();
+	bvh_.clear();
+
 	if (type == MapObject::Type::Vertex)
 	{
 		// Clear
@@ -183,6 +208,143 @@ void MapObjectCollection::restoreObjectIdList(MapObject::Type type, vector<unsig
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Begins recording changes to the object lists (for undo/redo), see
+// endIdListRecord
+// -----------------------------------------------------------------------------
+void MapObjectCollection::beginIdListRecord()
+{
+	for (auto& record : id_list_records_)
+		record.ids.clear();
+	for (auto type : { MapObject::Type::Vertex,
+					   MapObject::Type::Line,
+					   MapObject::Type::Side,
+					   MapObject::Type::Sector,
+					   MapObject::Type::Thing })
+		id_list_records_[static_cast<int>(type)].size = nObjects(type);
+
+	id_list_recording_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Stops recording changes to the object lists
+// -----------------------------------------------------------------------------
+void MapObjectCollection::endIdListRecord()
+{
+	id_list_recording_ = false;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the changes to the list of [type] objects since beginIdListRecord to
+// [changes]
+// -----------------------------------------------------------------------------
+void MapObjectCollection::putIdListChanges(MapObject::Type type, IdListChanges& changes) const
+{
+	const auto& record  = id_list_records_[static_cast<int>(type)];
+	changes             = {};
+	changes.size_before = record.size;
+	changes.size_after  = nObjects(type);
+
+	// Positions vacated by removed objects
+	for (const auto& [position, id] : record.ids)
+	{
+		auto object = position < changes.size_after ? objectAt(type, position) : nullptr;
+		auto id_now = object ? object->obj_id_ : 0;
+		if (id_now != id)
+		{
+			changes.positions.push_back(position);
+			changes.ids_before.push_back(id);
+			changes.ids_after.push_back(id_now);
+		}
+	}
+
+	// Positions of added objects
+	for (auto position = changes.size_before; position < changes.size_after; ++position)
+	{
+		changes.positions.push_back(position);
+		changes.ids_before.push_back(0);
+		changes.ids_after.push_back(objectAt(type, position)->obj_id_);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Applies the recorded [changes] to the list of [type] objects, either
+// reverting them if [undo] is true or re-applying them otherwise
+// -----------------------------------------------------------------------------
+void MapObjectCollection::applyIdListChanges(MapObject::Type type, const IdListChanges& changes, bool undo)
+{
+	const auto& ids_from = undo ? changes.ids_after : changes.ids_before;
+	const auto& ids_to   = undo ? changes.ids_before : changes.ids_after;
+	auto        size     = undo ? changes.size_before : changes.size_after;
+
+	// Update 'in map' flags (objects that only moved position stay in)
+	for (auto id : ids_from)
+		if (id > 0)
+			objects_[id].in_map = false;
+	for (auto id : ids_to)
+		if (id > 0)
+			objects_[id].in_map = true;
+
+	// Update list
+	auto apply = [&](auto& list)
+	{
+		for (unsigned a = 0; a < changes.positions.size(); ++a)
+		{
+			auto id = ids_to[a];
+			list.set(changes.positions[a], id > 0 ? dynamic_cast<decltype(list[0])>(objects_[id].object.get()) : nullptr);
+		}
+		list.resize(size);
+	};
+	switch (type)
+	{
+	case MapObject::Type::Vertex: apply(vertices_); break;
+	case MapObject::Type::Line: apply(lines_); break;
+	case MapObject::Type::Side: apply(sides_); break;
+	case MapObject::Type::Sector: apply(sectors_); break;
+	case MapObject::Type::Thing: apply(things_); break;
+	default: return;
+	}
+
+	// Re-index only the objects that changed
+	for (auto ids : { &ids_from, &ids_to })
+		for (auto id : *ids)
+			if (id > 0)
+				spatial_index_.objectUpdated(objects_[id].object.get());
+	bvh_.invalidate(type);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the object of [type] at [index] in its list
+// -----------------------------------------------------------------------------
+MapObject* MapObjectCollection::objectAt(MapObject::Type type, unsigned index) const
+{
+	switch (type)
+	{
+	case MapObject::Type::Vertex: return vertices_.at(index);
+	case MapObject::Type::Line: return lines_.at(index);
+	case MapObject::Type::Side: return sides_.at(index);
+	case MapObject::Type::Sector: return sectors_.at(index);
+	case MapObject::Type::Thing: return things_.at(index);
+	default: return nullptr;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of objects of [type] in the map
+// -----------------------------------------------------------------------------
+unsigned MapObjectCollection::nObjects(MapObject::Type type) const
+{
+	switch (type)
+	{
+	case MapObject::Type::Vertex: return vertices_.size();
+	case MapObject::Type::Line: return lines_.size();
+	case MapObject::Type::Side: return sides_.size();
+	case MapObject::Type::Sector: return sectors_.size();
+	case MapObject::Type::Thing: return things_.size();
+	default: return 0;
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Refreshes all map object indices
 // -----------------------------------------------------------------------------
@@ -223,6 +385,9 @@ void MapObjectCollection::clear()
 
 	// Clear map objects
 	objects_.clear();
+	spatial_index_.clear();
+	bvh_.clear();
+	id_list_recording_ = false;
 
 	// Object id 0 is always null
 	objects_.emplace_back(nullptr, false);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "General/Defs.h"
+#include "MapBVH.h"
+#include "MapSpatialIndex.h"
 #include "MapObjectList/LineList.h"
 #include "MapObjectList/SectorList.h"
 #include "MapObjectList/SideList.h"
@@ -12,6 +14,20 @@ namespace slade
 class MapObjectCollection
 {
 public:
+	// Changes to the list of objects of a type, by list position (used for
+	// undo/redo). Only positions that changed are included, with an id of 0
+	// where a position was empty
+	struct IdListChanges
+	{
+		unsigned         size_before = 0;
+		unsigned         size_after  = 0;
+		vector<unsigned> positions;
+		vector<unsigned> ids_before;
+		vector<unsigned> ids_after;
+
+		bool empty() const { return size_before == size_after && positions.empty(); }
+	};
+
 	MapObjectCollection(SLADEMap* parent_map = nullptr);
 
 	SLADEMap*         parentMap() const { return parent_map_; }
@@ -26,6 +42,9 @@ public:
 	const SectorList& sectors() const { return sectors_; }
 	const ThingList&  things() const { return things_; }
 
+	const MapSpatialIndex& spatialIndex() const { return spatial_index_; }
+	const MapBVH&          bvh() const { return bvh_; }
+
 	void setParentMap(SLADEMap* map) { parent_map_ = map; }
 
 	// MapObject id stuff (used for undo/redo)
@@ -34,6 +53,15 @@ public:
 	MapObject* getObjectById(unsigned id) const { return objects_[id].object.get(); }
 	void       putObjectIdList(MapObject::Type type, vector<unsigned>& list) const;
 	void       restoreObjectIdList(MapObject::Type type, vector<unsigned>& list);
+	void       beginIdListRecord();
+	void       endIdListRecord();
+	void       putIdListChanges(MapObject::Type type, IdListChanges& changes) const;
+	void       applyIdListChanges(MapObject::Type type, const IdListChanges& changes, bool undo);
+	void       objectUpdated(MapObject* object)
+	{
+		spatial_index_.objectUpdated(object);
+		bvh_.objectUpdated(object);
+	}
 
 	void refreshIndices();
 	void clear();
@@ -93,5 +121,19 @@ private:
 	LineList                lines_;
 	SectorList              sectors_;
 	ThingList               things_;
+	MapSpatialIndex         spatial_index_;
+	MapBVH                  bvh_;
+
+	// Original ids at list positions vacated since beginIdListRecord
+	struct IdListRecord
+	{
+		unsigned                     size = 0;
+		std::map<unsigned, unsigned> ids; // Position -> original id
+	};
+	bool                        id_list_recording_ = false;
+	std::array<IdListRecord, 6> id_list_records_;  // By MapObject::Type
+
+	MapObject* objectAt(MapObject::Type type, unsigned index) const;
+	unsigned   nObjects(MapObject::Type type) const;
 };
 } // namespace slade
@@ -34,6 +34,7 @@
 #include "Main.h"
 #include "LineList.h"
 #include "Game/Configuration.h"
+#include "SLADEMap/MapSpatialIndex.h"
 #include "SLADEMap/SLADEMap.h"
 #include "Utility/MathStuff.h"
 
@@ -53,11 +54,18 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 MapLine* LineList::nearest(Vec2d point, double min) const
 {
+	// Get lines near the point from the spatial index if possible
+	vector<MapLine*> near_lines;
+	BBox             area;
+	area.min.set(point.x - min, point.y - min);
+	area.max.set(point.x + min, point.y + min);
+	const auto& check = spatial_index_ && spatial_index_->putLines(area, near_lines) ? near_lines : objects_;
+
 	// Go through lines
 	double   dist;
 	double   min_dist = min;
 	MapLine* nearest  = nullptr;
-	for (const auto& line : objects_)
+	for (const auto& line : check)
 	{
 		// Check with line bounding box first (since we have a minimum distance)
 		auto bbox = line->seg();
@@ -69,7 +77,7 @@ MapLine* LineList::nearest(Vec2d point, double min) const
 		dist = line->distanceTo(point);
 
 		// Check if it's nearer than the previous nearest
-		if (dist < min_dist && dist < min)
+		if ((dist < min_dist || (dist == min_dist && nearest && line->index() < nearest->index())) && dist < min)
 		{
 			nearest  = line;
 			min_dist = dist;
@@ -104,8 +112,15 @@ vector<Vec2d> LineList::cutPoints(const Seg2d& cutter) const
 	vector<Vec2d> intersect_points;
 	Vec2d         intersection;
 
+	// Only lines within the cutter's bounding box can intersect it
+	vector<MapLine*> near_lines;
+	BBox             area;
+	area.min.set(cutter.left(), cutter.top());
+	area.max.set(cutter.right(), cutter.bottom());
+	const auto& check = spatial_index_ && spatial_index_->putLines(area, near_lines) ? near_lines : objects_;
+
 	// Go through map lines
-	for (const auto& line : objects_)
+	for (const auto& line : check)
 	{
 		// Check for intersection
 		intersection = cutter.start();
@@ -3,6 +3,7 @@
 namespace slade
 {
 class MapObject;
+class MapSpatialIndex;
 
 template<class T> class MapObjectList
 {
@@ -56,6 +57,27 @@ public:
 		objects_.pop_back();
 		--count_;
 	}
+	virtual void set(unsigned index, T* object)
+	{
+		// Used to restore the list contents on undo/redo, [object] can be null
+		// for positions that will be cut off via resize afterwards
+		if (index >= objects_.size())
+		{
+			objects_.resize(index + 1, nullptr);
+			count_ = objects_.size();
+		}
+		objects_[index] = object;
+		if (object)
+			object->setIndex(index);
+	}
+	void resize(unsigned size)
+	{
+		objects_.resize(size, nullptr);
+		count_ = size;
+	}
+
+	// Spatial index to use for position-based queries (if any)
+	void setSpatialIndex(const MapSpatialIndex* index) { spatial_index_ = index; }
 
 	// Misc
 	void putModifiedObjects(long since, vector<MapObject*>& modified_objects) const
@@ -74,7 +96,8 @@ public:
 	}
 
 protected:
-	vector<T*> objects_;
-	unsigned   count_ = 0;
+	vector<T*>             objects_;
+	unsigned               count_         = 0;
+	const MapSpatialIndex* spatial_index_ = nullptr;
 };
 } // namespace slade
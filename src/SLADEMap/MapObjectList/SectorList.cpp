@@ -34,6 +34,7 @@
 #include "Main.h"
 #include "SectorList.h"
 #include "General/UI.h"
+#include "SLADEMap/MapSpatialIndex.h"
 #include "Utility/StringUtils.h"
 
 using namespace slade;
@@ -82,13 +83,44 @@ void SectorList::remove(unsigned index)
 	MapObjectList::remove(index);
 }
 
+// -----------------------------------------------------------------------------
+// Sets the sector at [index] to [sector] and updates texture usage
+// -----------------------------------------------------------------------------
+void SectorList::set(unsigned index, MapSector* sector)
+{
+	// Update texture counts
+	if (index < objects_.size() && objects_[index])
+	{
+		usage_tex_[strutil::upper(objects_[index]->floor().texture)] -= 1;
+		usage_tex_[strutil::upper(objects_[index]->ceiling().texture)] -= 1;
+	}
+	if (sector)
+	{
+		usage_tex_[strutil::upper(sector->floor().texture)] += 1;
+		usage_tex_[strutil::upper(sector->ceiling().texture)] += 1;
+	}
+
+	MapObjectList::set(index, sector);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the sector at the given [point], or null if not within a sector
 // -----------------------------------------------------------------------------
 MapSector* SectorList::atPos(Vec2d point) const
 {
+	// Get sectors that may contain the point from the spatial index if possible
+	// (sorted by index so the first matching sector is the same as without it)
+	vector<MapSector*> near_sectors;
+	bool               indexed = spatial_index_ && spatial_index_->putSectors(point, near_sectors);
+	if (indexed)
+		std::sort(
+			near_sectors.begin(),
+			near_sectors.end(),
+			[](const MapSector* left, const MapSector* right) { return left->index() < right->index(); });
+	const auto& check = indexed ? near_sectors : objects_;
+
 	// Go through sectors
-	for (const auto& sector : objects_)
+	for (const auto& sector : check)
 	{
 		// Check if point is within sector
 		if (sector->containsPoint(point))
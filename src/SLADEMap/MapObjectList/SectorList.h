@@ -12,6 +12,7 @@ public:
 	void clear() override;
 	void add(MapSector* sector) override;
 	void remove(unsigned index) override;
+	void set(unsigned index, MapSector* sector) override;
 
 	MapSector*         atPos(Vec2d point) const;
 	BBox               allSectorBounds() const;
@@ -83,6 +83,28 @@ void SideList::remove(unsigned index)
 	MapObjectList::remove(index);
 }
 
+// -----------------------------------------------------------------------------
+// Sets the side at [index] to [side] and updates texture usage
+// -----------------------------------------------------------------------------
+void SideList::set(unsigned index, MapSide* side)
+{
+	// Update texture counts
+	if (index < objects_.size() && objects_[index])
+	{
+		usage_tex_[strutil::upper(objects_[index]->tex_upper_)] -= 1;
+		usage_tex_[strutil::upper(objects_[index]->tex_middle_)] -= 1;
+		usage_tex_[strutil::upper(objects_[index]->tex_lower_)] -= 1;
+	}
+	if (side)
+	{
+		usage_tex_[strutil::upper(side->tex_upper_)] += 1;
+		usage_tex_[strutil::upper(side->tex_middle_)] += 1;
+		usage_tex_[strutil::upper(side->tex_lower_)] += 1;
+	}
+
+	MapObjectList::set(index, side);
+}
+
 // -----------------------------------------------------------------------------
 // Adjusts the usage count of [tex] by [adjust]
 // -----------------------------------------------------------------------------
@@ -12,6 +12,7 @@ public:
 	void clear() override;
 	void add(MapSide* side) override;
 	void remove(unsigned index) override;
+	void set(unsigned index, MapSide* side) override;
 
 	void clearTexUsage() const { usage_tex_.clear(); }
 	void updateTexUsage(string_view tex, int adjust) const;
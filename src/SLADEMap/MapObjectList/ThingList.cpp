@@ -34,6 +34,7 @@
 #include "Main.h"
 #include "ThingList.h"
 #include "Game/Configuration.h"
+#include "SLADEMap/MapSpatialIndex.h"
 #include "SLADEMap/SLADEMap.h"
 #include "Utility/MathStuff.h"
 
@@ -53,17 +54,25 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 MapThing* ThingList::nearest(Vec2d point, double min) const
 {
+	// Get things near the point from the spatial index if possible
+	// (see VertexList::nearest)
+	vector<MapThing*> near_things;
+	BBox              area;
+	area.min.set(point.x - min * 1.5, point.y - min * 1.5);
+	area.max.set(point.x + min * 1.5, point.y + min * 1.5);
+	const auto& check = spatial_index_ && spatial_index_->putThings(area, near_things) ? near_things : objects_;
+
 	// Go through things
 	double    dist;
 	double    min_dist = 999999999;
 	MapThing* nearest  = nullptr;
-	for (const auto& thing : objects_)
+	for (const auto& thing : check)
 	{
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(thing->position());
 
 		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
+		if (dist < min_dist || (dist == min_dist && nearest && thing->index() < nearest->index()))
 		{
 			nearest  = thing;
 			min_dist = dist;
@@ -33,6 +33,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "VertexList.h"
+#include "SLADEMap/MapSpatialIndex.h"
 #include "Utility/MathStuff.h"
 
 using namespace slade;
@@ -51,17 +52,27 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 MapVertex* VertexList::nearest(Vec2d point, double min) const
 {
+	// Get vertices near the point from the spatial index if possible.
+	// Anything outside [min] * 1.5 on either axis can't be the (taxicab)
+	// nearest vertex while also being within [min] (euclidean) of the point
+	vector<MapVertex*> near_vertices;
+	BBox               area;
+	area.min.set(point.x - min * 1.5, point.y - min * 1.5);
+	area.max.set(point.x + min * 1.5, point.y + min * 1.5);
+	const auto& check = spatial_index_ && spatial_index_->putVertices(area, near_vertices) ? near_vertices : objects_;
+
 	// Go through vertices
 	double     dist;
 	double     min_dist = 999999999;
 	MapVertex* nearest  = nullptr;
-	for (const auto& vertex : objects_)
+	for (const auto& vertex : check)
 	{
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(vertex->position());
 
 		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
+		// (lowest index wins if equal, the index doesn't return vertices in order)
+		if (dist < min_dist || (dist == min_dist && nearest && vertex->index() < nearest->index()))
 		{
 			nearest  = vertex;
 			min_dist = dist;
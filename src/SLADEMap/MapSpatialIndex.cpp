@@ -0,0 +1,545 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapSpatialIndex.cpp
+// Description: MapSpatialIndex class - a uniform grid index of map objects,
+//              used to speed up finding objects near a point or within an
+//              area (eg. for mouse hover highlighting in the map editor)
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapSpatialIndex.h"
+#include "MapObject/MapLine.h"
+#include "MapObject/MapSector.h"
+#include "MapObject/MapSide.h"
+#include "MapObjectCollection.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr double cell_size        = 256.; // Size of each grid cell in map units
+constexpr int    max_object_cells = 1024; // Objects spanning more cells than this aren't indexed by cell
+constexpr int    max_query_cells  = 4096; // Queries covering more cells than this aren't done via the index
+constexpr double max_cell_coord   = 1 << 30;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the grid cell coordinate containing map coordinate [value]
+// -----------------------------------------------------------------------------
+int cellCoord(double value)
+{
+	auto cell = std::floor(value / cell_size);
+	if (!(cell > -max_cell_coord)) // Also catches NaN
+		return (int)-max_cell_coord;
+	if (cell > max_cell_coord)
+		return (int)max_cell_coord;
+	return (int)cell;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the key for the grid cell at [x,y]
+// -----------------------------------------------------------------------------
+uint64_t cellKey(int x, int y)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+// -----------------------------------------------------------------------------
+// Returns a bounding box containing only [point]
+// -----------------------------------------------------------------------------
+BBox pointBBox(Vec2d point)
+{
+	BBox bbox;
+	bbox.min = point;
+	bbox.max = point;
+	return bbox;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the bounding box of [line]
+// -----------------------------------------------------------------------------
+BBox lineBBox(const MapLine* line)
+{
+	auto seg = line->seg();
+	BBox bbox;
+	bbox.min.set(seg.left(), seg.top());
+	bbox.max.set(seg.right(), seg.bottom());
+	return bbox;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapSpatialIndex Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears the index, it will be rebuilt on the next query
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::clear()
+{
+	built_ = false;
+	object_cells_.clear();
+	updated_.clear();
+	grid_vertices_ = {};
+	grid_lines_    = {};
+	grid_sectors_  = {};
+	grid_things_   = {};
+}
+
+// -----------------------------------------------------------------------------
+// Flags [object] as needing to be re-indexed. Must be called whenever an object
+// is added to or removed from the map, or modified
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::objectUpdated(MapObject* object)
+{
+	// Nothing to update if the index hasn't been built yet
+	if (!built_ || !object || object->objId() == 0)
+		return;
+
+	auto& cells = objectCells(object);
+	if (!cells.updated)
+	{
+		cells.updated = true;
+		updated_.push_back(object);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds all vertices that may be within [area] to [list].
+// Returns false if the index can't be used for [area]
+// -----------------------------------------------------------------------------
+bool MapSpatialIndex::putVertices(const BBox& area, vector<MapVertex*>& list) const
+{
+	return queryAs(grid_vertices_, area, list);
+}
+
+// -----------------------------------------------------------------------------
+// Adds all lines whose bounding box may intersect [area] to [list].
+// Returns false if the index can't be used for [area]
+// -----------------------------------------------------------------------------
+bool MapSpatialIndex::putLines(const BBox& area, vector<MapLine*>& list) const
+{
+	return queryAs(grid_lines_, area, list);
+}
+
+// -----------------------------------------------------------------------------
+// Adds all sectors whose bounding box may contain [point] to [list].
+// Returns false if the index can't be used
+// -----------------------------------------------------------------------------
+bool MapSpatialIndex::putSectors(Vec2d point, vector<MapSector*>& list) const
+{
+	return queryAs(grid_sectors_, pointBBox(point), list);
+}
+
+// -----------------------------------------------------------------------------
+// Adds all things that may be within [area] to [list].
+// Returns false if the index can't be used for [area]
+// -----------------------------------------------------------------------------
+bool MapSpatialIndex::putThings(const BBox& area, vector<MapThing*>& list) const
+{
+	return queryAs(grid_things_, area, list);
+}
+
+// -----------------------------------------------------------------------------
+// Builds the index from all objects currently in the map
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::build() const
+{
+	object_cells_.clear();
+	updated_.clear();
+	grid_vertices_ = {};
+	grid_lines_    = {};
+	grid_sectors_  = {};
+	grid_things_   = {};
+
+	for (auto vertex : objects_.vertices())
+		insert(grid_vertices_, vertex, pointBBox(vertex->position()));
+	for (auto line : objects_.lines())
+		insert(grid_lines_, line, lineBBox(line));
+	for (auto sector : objects_.sectors())
+		insert(grid_sectors_, sector, sector->boundingBox());
+	for (auto thing : objects_.things())
+		insert(grid_things_, thing, pointBBox(thing->position()));
+
+	built_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Re-indexes all objects flagged as updated since the last query
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::update() const
+{
+	if (!built_)
+	{
+		build();
+		return;
+	}
+
+	// Objects related to an updated object can be added to the list while
+	// going through it (eg. lines connected to a vertex), so don't use an
+	// iterator here
+	for (unsigned a = 0; a < updated_.size(); ++a)
+		updateObject(updated_[a]);
+
+	updated_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Re-indexes [object] and flags any other objects whose bounds depend on it as
+// updated
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::updateObject(MapObject* object) const
+{
+	auto& cells   = objectCells(object);
+	cells.updated = false;
+
+	// Flag dependent objects
+	auto flag = [this](MapObject* dependent)
+	{
+		if (!dependent || dependent->objId() == 0)
+			return;
+
+		auto& dependent_cells = objectCells(dependent);
+		if (!dependent_cells.updated)
+		{
+			dependent_cells.updated = true;
+			updated_.push_back(dependent);
+		}
+	};
+	switch (object->objType())
+	{
+	case MapObject::Type::Vertex:
+		for (auto line : dynamic_cast<MapVertex*>(object)->connectedLines())
+			flag(line);
+		break;
+	case MapObject::Type::Line:
+		flag(dynamic_cast<MapLine*>(object)->frontSector());
+		flag(dynamic_cast<MapLine*>(object)->backSector());
+		break;
+	case MapObject::Type::Side: flag(dynamic_cast<MapSide*>(object)->sector()); return;
+	default: break;
+	}
+
+	// Remove from the index
+	auto grid = objectGrid(object);
+	if (!grid)
+		return;
+	remove(*grid, object);
+
+	// Re-add if still in the map
+	switch (object->objType())
+	{
+	case MapObject::Type::Vertex:
+		if (auto vertex = dynamic_cast<MapVertex*>(object); objects_.vertices().at(vertex->index()) == vertex)
+			insert(*grid, vertex, pointBBox(vertex->position()));
+		break;
+	case MapObject::Type::Line:
+		if (auto line = dynamic_cast<MapLine*>(object); objects_.lines().at(line->index()) == line)
+			insert(*grid, line, lineBBox(line));
+		break;
+	case MapObject::Type::Sector:
+		if (auto sector = dynamic_cast<MapSector*>(object); objects_.sectors().at(sector->index()) == sector)
+			insert(*grid, sector, sector->boundingBox());
+		break;
+	case MapObject::Type::Thing:
+		if (auto thing = dynamic_cast<MapThing*>(object); objects_.things().at(thing->index()) == thing)
+			insert(*grid, thing, pointBBox(thing->position()));
+		break;
+	default: break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the grid cell info for [object]
+// -----------------------------------------------------------------------------
+MapSpatialIndex::ObjectCells& MapSpatialIndex::objectCells(const MapObject* object) const
+{
+	if (object->objId() >= object_cells_.size())
+		object_cells_.resize(object->objId() + 1);
+
+	return object_cells_[object->objId()];
+}
+
+// -----------------------------------------------------------------------------
+// Returns the grid [object] is indexed in (based on its type), or null if
+// objects of its type aren't indexed
+// -----------------------------------------------------------------------------
+MapSpatialIndex::Grid* MapSpatialIndex::objectGrid(const MapObject* object) const
+{
+	switch (object->objType())
+	{
+	case MapObject::Type::Vertex: return &grid_vertices_;
+	case MapObject::Type::Line: return &grid_lines_;
+	case MapObject::Type::Sector: return &grid_sectors_;
+	case MapObject::Type::Thing: return &grid_things_;
+	default: return nullptr;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds [object] to all cells in [grid] overlapping [bbox]
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::insert(Grid& grid, MapObject* object, const BBox& bbox) const
+{
+	if (object->objId() == 0)
+		return;
+
+	auto& cells     = objectCells(object);
+	cells.x1        = cellCoord(bbox.min.x);
+	cells.y1        = cellCoord(bbox.min.y);
+	cells.x2        = cellCoord(bbox.max.x);
+	cells.y2        = cellCoord(bbox.max.y);
+	cells.indexed   = true;
+	cells.oversized = (int64_t)(cells.x2 - cells.x1 + 1) * (cells.y2 - cells.y1 + 1) > max_object_cells;
+
+	if (cells.oversized)
+	{
+		grid.oversized.push_back(object);
+		return;
+	}
+
+	for (int x = cells.x1; x <= cells.x2; ++x)
+		for (int y = cells.y1; y <= cells.y2; ++y)
+			grid.cells[cellKey(x, y)].push_back(object);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [object] from all cells it is in in [grid]
+// -----------------------------------------------------------------------------
+void MapSpatialIndex::remove(Grid& grid, MapObject* object) const
+{
+	auto& cells = objectCells(object);
+	if (!cells.indexed)
+		return;
+
+	auto remove_from = [object](vector<MapObject*>& list)
+	{
+		for (unsigned a = 0; a < list.size(); ++a)
+			if (list[a] == object)
+			{
+				list[a] = list.back();
+				list.pop_back();
+				return;
+			}
+	};
+
+	if (cells.oversized)
+		remove_from(grid.oversized);
+	else
+	{
+		for (int x = cells.x1; x <= cells.x2; ++x)
+			for (int y = cells.y1; y <= cells.y2; ++y)
+			{
+				auto cell = grid.cells.find(cellKey(x, y));
+				if (cell == grid.cells.end())
+					continue;
+
+				remove_from(cell->second);
+				if (cell->second.empty())
+					grid.cells.erase(cell);
+			}
+	}
+
+	cells.indexed = false;
+}
+
+// -----------------------------------------------------------------------------
+// Adds all objects in [grid] in cells overlapping [area] to [list] (once
+// each). Returns false if [area] covers too many cells
+// -----------------------------------------------------------------------------
+bool MapSpatialIndex::query(Grid& grid, const BBox& area, vector<MapObject*>& list) const
+{
+	int x1 = cellCoord(area.min.x);
+	int y1 = cellCoord(area.min.y);
+	int x2 = cellCoord(area.max.x);
+	int y2 = cellCoord(area.max.y);
+	if ((int64_t)(x2 - x1 + 1) * (y2 - y1 + 1) > max_query_cells)
+		return false;
+
+	update();
+
+	// Objects can be in multiple cells, so keep track of which have been added
+	// to the list already via the query id
+	if (++query_id_ == 0)
+	{
+		for (auto& cells : object_cells_)
+			cells.query_id = 0;
+		query_id_ = 1;
+	}
+	auto add = [this, &list](MapObject* object)
+	{
+		auto& cells = object_cells_[object->objId()];
+		if (cells.query_id != query_id_)
+		{
+			cells.query_id = query_id_;
+			list.push_back(object);
+		}
+	};
+
+	for (auto object : grid.oversized)
+		add(object);
+
+	// Check either each cell in the area or each cell in the grid, whichever
+	// is fewer
+	if ((int64_t)(x2 - x1 + 1) * (y2 - y1 + 1) <= (int64_t)grid.cells.size())
+	{
+		for (int x = x1; x <= x2; ++x)
+			for (int y = y1; y <= y2; ++y)
+				if (auto cell = grid.cells.find(cellKey(x, y)); cell != grid.cells.end())
+					for (auto object : cell->second)
+						add(object);
+	}
+	else
+	{
+		for (const auto& cell : grid.cells)
+		{
+			int x = static_cast<int32_t>(cell.first >> 32);
+			int y = static_cast<int32_t>(cell.first & 0xFFFFFFFF);
+			if (x >= x1 && x <= x2 && y >= y1 && y <= y2)
+				for (auto object : cell.second)
+					add(object);
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Same as query, but adds the objects to a list of the specific object type [T]
+// -----------------------------------------------------------------------------
+template<class T> bool MapSpatialIndex::queryAs(Grid& grid, const BBox& area, vector<T*>& list) const
+{
+	vector<MapObject*> objects;
+	if (!query(grid, area, objects))
+		return false;
+
+	list.reserve(list.size() + objects.size());
+	for (auto object : objects)
+		list.push_back(static_cast<T*>(object));
+
+	return true;
+}
+
+
+// Testing
+
+#include "App.h"
+#include "General/Console.h"
+#include <random>
+
+// -----------------------------------------------------------------------------
+// Benchmarks nearest vertex/line/thing queries on a synthetic map with a
+// [size]x[size] grid of vertices (200 by default), with and without the
+// spatial index, and checks that both give the same results
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_map_index, 0, false)
+{
+	int size = 200;
+	if (!args.empty())
+		size = strutil::asInt(args[0]);
+	if (size < 2)
+		return;
+
+	// Build map - a grid of vertices 64 units apart, joined by horizontal lines,
+	// with a thing in the middle of each grid square
+	MapObjectCollection map;
+	vector<MapVertex*>  grid_vertices;
+	for (int y = 0; y < size; ++y)
+		for (int x = 0; x < size; ++x)
+			grid_vertices.push_back(map.addVertex(std::make_unique<MapVertex>(Vec2d{ x * 64., y * 64. })));
+	for (int y = 0; y < size; ++y)
+		for (int x = 0; x < size - 1; ++x)
+			map.addLine(std::make_unique<MapLine>(grid_vertices[y * size + x], grid_vertices[y * size + x + 1]));
+	for (int y = 0; y < size - 1; ++y)
+		for (int x = 0; x < size - 1; ++x)
+			map.addThing(std::make_unique<MapThing>(Vec3d{ x * 64. + 32., y * 64. + 32., 0. }));
+
+	// Generate query points
+	std::mt19937                     rng(1234);
+	std::uniform_real_distribution<> coord(-64., size * 64.);
+	vector<Vec2d>                    points(100000);
+	for (auto& point : points)
+		point.set(coord(rng), coord(rng));
+
+	// Runs all queries, returning the results
+	auto run_queries = [&](vector<MapObject*>& results)
+	{
+		results.clear();
+		for (const auto& point : points)
+		{
+			results.push_back(map.vertices().nearest(point, 32));
+			results.push_back(map.lines().nearest(point, 32));
+			results.push_back(map.things().nearest(point, 32));
+		}
+	};
+
+	// With index (build it first so that isn't included in the timing)
+	vector<MapObject*> results_index;
+	auto               time = app::runTimer();
+	map.vertices().nearest({ 0., 0. }, 32);
+	log::info("Building index for {} vertices took {}ms", map.vertices().size(), app::runTimer() - time);
+	time = app::runTimer();
+	run_queries(results_index);
+	log::info("{} queries with spatial index took {}ms", results_index.size(), app::runTimer() - time);
+
+	// Without index
+	vector<MapObject*> results_linear;
+	map.vertices().setSpatialIndex(nullptr);
+	map.lines().setSpatialIndex(nullptr);
+	map.things().setSpatialIndex(nullptr);
+	time = app::runTimer();
+	run_queries(results_linear);
+	log::info("{} queries without spatial index took {}ms", results_linear.size(), app::runTimer() - time);
+
+	// Compare
+	unsigned mismatches = 0;
+	for (unsigned a = 0; a < results_index.size(); ++a)
+		if (results_index[a] != results_linear[a])
+			++mismatches;
+	if (mismatches > 0)
+		log::warning("{} query results differ between indexed and linear", mismatches);
+	else
+		log::info("Indexed and linear query results match");
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <unordered_map>
+
+namespace slade
+{
+class MapObject;
+class MapObjectCollection;
+class MapVertex;
+class MapLine;
+class MapSector;
+class MapThing;
+
+// A uniform grid index of map object positions/bounds, used to quickly find
+// objects near a point or within an area.
+//
+// The index is built on first use and then kept up to date incrementally:
+// objects are flagged via objectUpdated whenever they are added, removed or
+// modified, and flagged objects are re-indexed before the next query
+class MapSpatialIndex
+{
+public:
+	MapSpatialIndex(const MapObjectCollection& objects) : objects_{ objects } {}
+
+	void clear();
+	void objectUpdated(MapObject* object);
+
+	// Queries
+	// These add all objects that may be within the given area to the list, or
+	// return false if the area is too large for the index to be useful (in
+	// which case all objects should be checked instead)
+	bool putVertices(const BBox& area, vector<MapVertex*>& list) const;
+	bool putLines(const BBox& area, vector<MapLine*>& list) const;
+	bool putSectors(Vec2d point, vector<MapSector*>& list) const;
+	bool putThings(const BBox& area, vector<MapThing*>& list) const;
+
+private:
+	// The grid cells an object is currently indexed in
+	struct ObjectCells
+	{
+		int      x1        = 0;
+		int      y1        = 0;
+		int      x2        = 0;
+		int      y2        = 0;
+		bool     indexed   = false;
+		bool     oversized = false; // Spans too many cells to index, always returned from queries
+		bool     updated   = false; // Needs re-indexing
+		unsigned query_id  = 0;     // Id of the last query the object was added to the results of
+	};
+
+	struct Grid
+	{
+		std::unordered_map<uint64_t, vector<MapObject*>> cells;
+		vector<MapObject*>                               oversized;
+	};
+
+	const MapObjectCollection&  objects_;
+	mutable bool                built_ = false;
+	mutable vector<ObjectCells> object_cells_; // Indexed by object id
+	mutable vector<MapObject*>  updated_;
+	mutable Grid                grid_vertices_;
+	mutable Grid                grid_lines_;
+	mutable Grid                grid_sectors_;
+	mutable Grid                grid_things_;
+	mutable unsigned            query_id_ = 0;
+
+	void         build() const;
+	void         update() const;
+	void         updateObject(MapObject* object) const;
+	ObjectCells& objectCells(const MapObject* object) const;
+	Grid*        objectGrid(const MapObject* object) const;
+	void         insert(Grid& grid, MapObject* object, const BBox& bbox) const;
+	void         remove(Grid& grid, MapObject* object) const;
+	bool         query(Grid& grid, const BBox& area, vector<MapObject*>& list) const;
+
+	template<class T> bool queryAs(Grid& grid, const BBox& area, vector<T*>& list) const;
+};
+} // namespace slade
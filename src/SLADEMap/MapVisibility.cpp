@@ -0,0 +1,485 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapVisibility.cpp
+// Description: MapVisibility class - determines the potentially visible sectors
+//              and lines of a map from a camera position, by flooding through
+//              the map's portals (open two-sided lines). Used to cull hidden
+//              parts of the map in the 3d view
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapVisibility.h"
+#include "App.h"
+#include "Game/Configuration.h"
+#include "SLADEMap.h"
+#include "Utility/MathStuff.h"
+#include "Utility/StringUtils.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr double two_pi         = math::PI * 2.;
+constexpr double min_span       = 1e-9; // Spans smaller than this (radians) are ignored
+constexpr double near_line_dist = 1.;   // Lines closer than this to the camera cover the whole view
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapVisibility Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears all cached portal info and the current visible set
+// -----------------------------------------------------------------------------
+void MapVisibility::clear()
+{
+	portals_.clear();
+	sectors_.clear();
+	visible_sectors_.clear();
+	visible_lines_.clear();
+	to_visit_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Determines the sectors and lines visible from [camera], looking in
+// [direction] with a horizontal field of view of [fov] radians (anything
+// >= 2pi sees all around). Lines further than [max_dist] from the camera are
+// not visible (if [max_dist] > 0).
+//
+// Returns false if visibility can't be determined (the camera isn't within a
+// sector), in which case everything should be considered visible
+// -----------------------------------------------------------------------------
+bool MapVisibility::update(const Vec3d& camera, Vec2d direction, double fov, double max_dist)
+{
+	reset();
+
+	// Find the sector the camera is in, and check it's between its floor and
+	// ceiling (if not, it can see over/under any walls)
+	cam_        = camera.get2d();
+	auto sector = map_->sectors().atPos(cam_);
+	if (!sector)
+		return false;
+	if (camera.z < sector->floor().plane.heightAt(cam_) || camera.z > sector->ceiling().plane.heightAt(cam_))
+		return false;
+
+	// Angles are measured from directly behind the camera, so the view window
+	// never wraps around
+	if (direction.x == 0. && direction.y == 0.)
+		fov = two_pi;
+	base_angle_ = std::atan2(direction.y, direction.x) + math::PI;
+	SpanList window;
+	if (fov >= two_pi)
+		window.push_back({ 0., two_pi });
+	else
+		window.push_back({ math::PI - fov * 0.5, math::PI + fov * 0.5 });
+
+	// Flood out from the camera sector
+	SpanList new_spans, line_spans;
+	to_visit_.push_back({ sector, std::move(window) });
+	while (!to_visit_.empty())
+	{
+		auto visit = std::move(to_visit_.back());
+		to_visit_.pop_back();
+
+		// Ignore any parts of the window that have already been flooded into
+		// the sector
+		auto& sector_vis = sectors_[visit.sector->index()];
+		subtractSpans(visit.window, sector_vis.covered, new_spans);
+		if (new_spans.empty())
+			continue;
+
+		addSpans(sector_vis.covered, new_spans);
+		if (!sector_vis.visible)
+		{
+			sector_vis.visible = true;
+			visible_sectors_.push_back(visit.sector->index());
+		}
+
+		// Check sector lines
+		for (auto side : visit.sector->connectedSides())
+		{
+			auto  line = side->parentLine();
+			auto& info = portal(line);
+
+			// Check distance
+			double dist = math::distanceToLine(cam_, Seg2d(info.start, info.end));
+			if (max_dist > 0 && dist > max_dist)
+				continue;
+
+			// Check line is within the window
+			SpanList clipped;
+			if (dist < near_line_dist)
+				clipped = new_spans;
+			else
+			{
+				lineSpans(info, line_spans);
+				intersectSpans(new_spans, line_spans, clipped);
+				if (clipped.empty())
+					continue;
+			}
+
+			if (!info.visible)
+			{
+				info.visible = true;
+				visible_lines_.push_back(line->index());
+			}
+
+			// Flood through to the sector on the other side if open
+			if (!info.open)
+				continue;
+			auto other = side == line->s1() ? line->backSector() : line->frontSector();
+			if (other)
+				to_visit_.push_back({ other, std::move(clipped) });
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Resets the visible set from the last update, and resizes the line and sector
+// info to match the map
+// -----------------------------------------------------------------------------
+void MapVisibility::reset()
+{
+	for (auto index : visible_sectors_)
+		if (index < sectors_.size())
+			sectors_[index] = {};
+	for (auto index : visible_lines_)
+		if (index < portals_.size())
+			portals_[index].visible = false;
+	visible_sectors_.clear();
+	visible_lines_.clear();
+	to_visit_.clear();
+
+	if (portals_.size() != map_->nLines())
+		portals_.resize(map_->nLines());
+	if (sectors_.size() != map_->nSectors())
+		sectors_.resize(map_->nSectors());
+}
+
+// -----------------------------------------------------------------------------
+// Returns the cached portal info for [line], updating it first if the line or
+// anything it depends on has been modified since it was cached
+// -----------------------------------------------------------------------------
+MapVisibility::Portal& MapVisibility::portal(MapLine* line)
+{
+	auto& info = portals_[line->index()];
+
+	// Check if update is needed
+	bool update = info.line != line || info.updated_time <= line->modifiedTime()
+				  || info.updated_time <= line->v1()->modifiedTime() || info.updated_time <= line->v2()->modifiedTime();
+	for (auto side : { line->s1(), line->s2() })
+		if (!update && side && side->sector())
+			update = info.updated_time <= side->modifiedTime() || info.updated_time <= side->sector()->modifiedTime();
+
+	if (update)
+	{
+		info.line         = line;
+		info.start        = line->start();
+		info.end          = line->end();
+		info.open         = portalOpen(line);
+		info.updated_time = app::runTimer();
+	}
+
+	return info;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the angle from the camera to [point], relative to the base angle
+// (in the range 0 - 2pi)
+// -----------------------------------------------------------------------------
+double MapVisibility::angleTo(Vec2d point) const
+{
+	double angle = std::atan2(point.y - cam_.y, point.x - cam_.x) - base_angle_;
+	angle        = std::fmod(angle, two_pi);
+	if (angle < 0.)
+		angle += two_pi;
+
+	return angle;
+}
+
+// -----------------------------------------------------------------------------
+// Sets [spans] to the angular span(s) covered by [portal] from the camera
+// -----------------------------------------------------------------------------
+void MapVisibility::lineSpans(const Portal& portal, SpanList& spans) const
+{
+	spans.clear();
+
+	// Get angles to each end of the line, the line covers the shorter arc
+	// between them (it can't cover more than pi unless the camera is on it)
+	double a1    = angleTo(portal.start);
+	double a2    = angleTo(portal.end);
+	double delta = a2 - a1;
+	if (delta > math::PI)
+		delta -= two_pi;
+	else if (delta < -math::PI)
+		delta += two_pi;
+	double start = delta >= 0. ? a1 : a2;
+	double end   = start + std::fabs(delta);
+
+	// Split if it wraps around
+	if (end > two_pi)
+	{
+		spans.push_back({ 0., end - two_pi });
+		spans.push_back({ start, two_pi });
+	}
+	else
+		spans.push_back({ start, end });
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [line] can be seen through, ie. it is two-sided and there is
+// a gap between the floors and ceilings of both sides somewhere along it
+// -----------------------------------------------------------------------------
+bool MapVisibility::portalOpen(MapLine* line)
+{
+	auto front = line->frontSector();
+	auto back  = line->backSector();
+	if (!front || !back)
+		return false;
+
+	// Upper textures between two sky ceilings aren't drawn
+	const auto& sky_flat = game::configuration().skyFlat();
+	if (strutil::equalCI(front->ceiling().texture, sky_flat) && strutil::equalCI(back->ceiling().texture, sky_flat))
+		return true;
+
+	// Check the gap at each end of the line (planes are linear, so if there is
+	// no gap at either end there is none along the whole line)
+	for (auto point : { line->start(), line->end() })
+	{
+		double floor   = std::max(front->floor().plane.heightAt(point), back->floor().plane.heightAt(point));
+		double ceiling = std::min(front->ceiling().plane.heightAt(point), back->ceiling().plane.heightAt(point));
+		if (ceiling > floor)
+			return true;
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Sets [result] to the parts of [from] that aren't in [remove]
+// -----------------------------------------------------------------------------
+void MapVisibility::subtractSpans(const SpanList& from, const SpanList& remove, SpanList& result)
+{
+	result.clear();
+
+	unsigned r = 0;
+	for (auto span : from)
+	{
+		// Skip removed spans entirely before this one
+		while (r < remove.size() && remove[r].end <= span.start)
+			++r;
+
+		// Cut out any removed spans overlapping this one
+		double   start = span.start;
+		unsigned i     = r;
+		while (i < remove.size() && remove[i].start < span.end)
+		{
+			if (remove[i].start - start > min_span)
+				result.push_back({ start, remove[i].start });
+			start = std::max(start, remove[i].end);
+			++i;
+		}
+
+		if (span.end - start > min_span)
+			result.push_back({ start, span.end });
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Sets [result] to the parts of [a] that are also in [b]
+// -----------------------------------------------------------------------------
+void MapVisibility::intersectSpans(const SpanList& a, const SpanList& b, SpanList& result)
+{
+	result.clear();
+
+	unsigned ia = 0, ib = 0;
+	while (ia < a.size() && ib < b.size())
+	{
+		double start = std::max(a[ia].start, b[ib].start);
+		double end   = std::min(a[ia].end, b[ib].end);
+		if (end - start > min_span)
+			result.push_back({ start, end });
+
+		// Move on from whichever span ends first
+		if (a[ia].end < b[ib].end)
+			++ia;
+		else
+			++ib;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds the spans in [add] to [to], merging any that overlap
+// -----------------------------------------------------------------------------
+void MapVisibility::addSpans(SpanList& to, const SpanList& add)
+{
+	if (to.empty())
+	{
+		to = add;
+		return;
+	}
+
+	SpanList merged;
+	merged.reserve(to.size() + add.size());
+	std::merge(
+		to.begin(),
+		to.end(),
+		add.begin(),
+		add.end(),
+		std::back_inserter(merged),
+		[](const Span& lhs, const Span& rhs) { return lhs.start < rhs.start; });
+
+	to.clear();
+	for (const auto& span : merged)
+	{
+		if (!to.empty() && span.start <= to.back().end)
+			to.back().end = std::max(to.back().end, span.end);
+		else
+			to.push_back(span);
+	}
+}
+
+
+// Testing
+
+#include "Archive/ArchiveManager.h"
+#include "General/Console.h"
+
+// -----------------------------------------------------------------------------
+// Benchmarks visibility checks on map [map] in archive [archive], from [count]
+// sectors spread across the map (100 by default), looking in 8 directions from
+// each
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_map_vis, 2, false)
+{
+	// Open archive
+	auto archive = app::archiveManager().openArchive(args[0], false, true);
+	if (!archive)
+	{
+		log::error("Unable to open archive \"{}\": {}", args[0], global::error);
+		return;
+	}
+
+	// Load map
+	SLADEMap map;
+	bool     found = false;
+	for (const auto& desc : archive->detectMaps())
+	{
+		if (!strutil::equalCI(desc.name, args[1]))
+			continue;
+
+		found = true;
+		if (!map.readMap(desc))
+		{
+			log::error("Unable to read map {}", desc.name);
+			return;
+		}
+		break;
+	}
+	if (!found)
+	{
+		log::error("No map {} found in \"{}\"", args[1], args[0]);
+		return;
+	}
+
+	unsigned count = args.size() > 2 ? strutil::asInt(args[2]) : 100;
+	if (count == 0 || map.nSectors() == 0)
+		return;
+	if (count > map.nSectors())
+		count = map.nSectors();
+
+	// Put a camera at eye height in each sector
+	vector<Vec3d> cameras;
+	for (unsigned a = 0; a < count; a++)
+	{
+		auto   sector  = map.sector(a * map.nSectors() / count);
+		auto   point   = sector->getPoint(MapObject::Point::Within);
+		double floor   = sector->floor().plane.heightAt(point);
+		double ceiling = sector->ceiling().plane.heightAt(point);
+		cameras.emplace_back(point.x, point.y, std::min(floor + 41., (floor + ceiling) * 0.5));
+	}
+
+	// First pass to cache portal info
+	MapVisibility vis(&map);
+	auto          time = app::runTimer();
+	for (const auto& camera : cameras)
+		vis.update(camera, { 1., 0. }, two_pi);
+	log::info("Initial pass took {}ms", app::runTimer() - time);
+
+	// Check visibility
+	unsigned views = 0, failed = 0;
+	size_t   n_sectors = 0, n_lines = 0;
+	time = app::runTimer();
+	for (const auto& camera : cameras)
+	{
+		for (int dir = 0; dir < 8; dir++)
+		{
+			double angle = dir * math::PI * 0.25;
+			if (!vis.update(camera, { std::cos(angle), std::sin(angle) }, math::PI))
+			{
+				failed++;
+				continue;
+			}
+
+			views++;
+			n_sectors += vis.visibleSectors().size();
+			n_lines += vis.visibleLines().size();
+		}
+	}
+	double ms = app::runTimer() - time;
+
+	if (views == 0)
+	{
+		log::info("No cameras were within a sector");
+		return;
+	}
+	log::info(
+		"{} views took {}ms ({:.3f}ms per view), {} cameras not within a sector",
+		views,
+		ms,
+		ms / views,
+		failed / 8);
+	log::info(
+		"Average visible: {} of {} sectors, {} of {} lines",
+		n_sectors / views,
+		map.nSectors(),
+		n_lines / views,
+		map.nLines());
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+namespace slade
+{
+class SLADEMap;
+class MapLine;
+class MapSector;
+
+// Determines the set of sectors and lines that can potentially be seen from a
+// camera position, by flooding out from the camera's sector through the open
+// two-sided lines (portals) of the map, narrowing the horizontal angular window
+// that can be seen through at each portal.
+//
+// The result is conservative: anything that could be visible from the camera
+// will be in the visible set, but some things hidden behind others (eg. within
+// non-convex sectors, or below/above partially open portals) may be as well.
+//
+// Cached portal info for each line is refreshed when the line is reached during
+// the flood and it (or anything it depends on) has been modified since, so
+// geometry edits only cause the affected portals to be updated
+class MapVisibility
+{
+public:
+	MapVisibility(SLADEMap* map) : map_{ map } {}
+	~MapVisibility() = default;
+
+	bool sectorVisible(unsigned index) const { return index < sectors_.size() && sectors_[index].visible; }
+	bool lineVisible(unsigned index) const { return index < portals_.size() && portals_[index].visible; }
+
+	const vector<unsigned>& visibleSectors() const { return visible_sectors_; }
+	const vector<unsigned>& visibleLines() const { return visible_lines_; }
+
+	void clear();
+	bool update(const Vec3d& camera, Vec2d direction, double fov, double max_dist = 0.);
+
+private:
+	// An angular span as seen from the camera (radians)
+	struct Span
+	{
+		double start;
+		double end;
+	};
+	typedef vector<Span> SpanList; // Sorted, non-overlapping
+
+	// Cached info for a line
+	struct Portal
+	{
+		MapLine* line = nullptr;
+		Vec2d    start;
+		Vec2d    end;
+		bool     open         = false; // Two-sided with a gap between floor and ceiling
+		long     updated_time = -1;
+		bool     visible      = false;
+	};
+
+	struct SectorVis
+	{
+		SpanList covered; // Parts of the view already flooded into the sector
+		bool     visible = false;
+	};
+
+	struct Visit
+	{
+		MapSector* sector;
+		SpanList   window;
+	};
+
+	SLADEMap*         map_;
+	vector<Portal>    portals_; // Indexed by line index
+	vector<SectorVis> sectors_; // Indexed by sector index
+	vector<unsigned>  visible_sectors_;
+	vector<unsigned>  visible_lines_;
+	vector<Visit>     to_visit_;
+
+	// Current camera
+	Vec2d  cam_;
+	double base_angle_ = 0.;
+
+	void    reset();
+	Portal& portal(MapLine* line);
+	double  angleTo(Vec2d point) const;
+	void    lineSpans(const Portal& portal, SpanList& spans) const;
+
+	static bool portalOpen(MapLine* line);
+	static void subtractSpans(const SpanList& from, const SpanList& remove, SpanList& result);
+	static void intersectSpans(const SpanList& a, const SpanList& b, SpanList& result);
+	static void addSpans(SpanList& to, const SpanList& add);
+};
+} // namespace slade
@@ -117,7 +117,9 @@ bool SLADEMap::readMap(const Archive::MapDesc& map)
 	auto       m_head = map.head.lock();
 	if (map.archive && m_head)
 	{
-		tempwad.open(m_head->data());
+		MemChunk wad_data;
+		m_head->shareData(wad_data);
+		tempwad.open(wad_data);
 		auto amaps = tempwad.detectMaps();
 		if (!amaps.empty())
 			omap = amaps[0];
@@ -38,6 +38,7 @@ public:
 
 	void setGeometryUpdated();
 	void setThingsUpdated();
+	void objectUpdated(MapObject* object) { data_.objectUpdated(object); }
 
 	// MapObject access
 	MapVertex*        vertex(unsigned index) const { return data_.vertices().at(index); }
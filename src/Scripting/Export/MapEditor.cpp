@@ -112,6 +112,11 @@ void registerSLADEMap(sol::state& lua)
 	lua_map["sidedefs"]      = sol::property([](SLADEMap& self) { return self.sides().all(); });
 	lua_map["sectors"]       = sol::property([](SLADEMap& self) { return self.sectors().all(); });
 	lua_map["things"]        = sol::property([](SLADEMap& self) { return self.things().all(); });
+
+	// Functions
+	// -------------------------------------------------------------------------
+	lua_map["LineOfSight"] = [](SLADEMap& self, double x1, double y1, double z1, double x2, double y2, double z2)
+	{ return self.mapData().bvh().lineOfSight({ x1, y1, z1 }, { x2, y2, z2 }); };
 }
 
 // -----------------------------------------------------------------------------
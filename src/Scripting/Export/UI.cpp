@@ -1,6 +1,7 @@
 
 #include "Main.h"
 #include "Export.h"
+#include "App.h"
 #include "Scripting/Lua.h"
 #include "UI/Dialogs/ExtMessageDialog.h"
 #include "UI/Dialogs/Preferences/ACSPrefsPanel.h"
@@ -39,6 +40,18 @@ namespace slade::lua
 // -----------------------------------------------------------------------------
 void messageBox(const string& title, const string& message, MessageBoxIcon icon = MessageBoxIcon::Info)
 {
+	// No UI in batch mode, just log the message
+	if (app::isBatchMode())
+	{
+		if (icon == MessageBoxIcon::Error)
+			log::error("{}: {}", title, message);
+		else if (icon == MessageBoxIcon::Warning)
+			log::warning("{}: {}", title, message);
+		else
+			log::info("{}: {}", title, message);
+		return;
+	}
+
 	long style = 4 | wxCENTRE;
 	switch (icon)
 	{
@@ -57,6 +70,12 @@ void messageBox(const string& title, const string& message, MessageBoxIcon icon
 // -----------------------------------------------------------------------------
 void messageBoxExtended(const string& title, const string& message, const string& extra)
 {
+	if (app::isBatchMode())
+	{
+		log::info("{}: {}\n{}", title, message, extra);
+		return;
+	}
+
 	ExtMessageDialog dlg(currentWindow(), title);
 	dlg.setMessage(message);
 	dlg.setExt(extra);
@@ -69,6 +88,9 @@ void messageBoxExtended(const string& title, const string& message, const string
 // -----------------------------------------------------------------------------
 string promptString(const string& title, const string& message, const string& default_value)
 {
+	if (app::isBatchMode())
+		return default_value;
+
 	return wxGetTextFromUser(message, title, default_value, currentWindow()).ToStdString();
 }
 
@@ -77,6 +99,9 @@ string promptString(const string& title, const string& message, const string& de
 // -----------------------------------------------------------------------------
 int promptNumber(const string& title, const string& message, int default_value, int min, int max)
 {
+	if (app::isBatchMode())
+		return default_value;
+
 	return (int)wxGetNumberFromUser(message, "", title, default_value, min, max);
 }
 
@@ -85,6 +110,9 @@ int promptNumber(const string& title, const string& message, int default_value,
 // -----------------------------------------------------------------------------
 bool promptYesNo(const string& title, const string& message)
 {
+	if (app::isBatchMode())
+		return false;
+
 	return (wxMessageBox(message, title, wxYES_NO | wxICON_QUESTION) == wxYES);
 }
 
@@ -93,6 +121,9 @@ bool promptYesNo(const string& title, const string& message)
 // -----------------------------------------------------------------------------
 string browseFile(string_view title, string_view extensions, string_view filename)
 {
+	if (app::isBatchMode())
+		return {};
+
 	filedialog::FDInfo inf;
 	filedialog::openFile(inf, title, extensions, currentWindow(), filename);
 	return inf.filenames.empty() ? "" : inf.filenames[0];
@@ -105,6 +136,8 @@ vector<string> browseFiles(string_view title, string_view extensions)
 {
 	filedialog::FDInfo inf;
 	vector<string>     filenames;
+	if (app::isBatchMode())
+		return filenames;
 	if (filedialog::openFiles(inf, title, extensions, currentWindow()))
 		for (const auto& file : inf.filenames)
 			filenames.push_back(file);
@@ -117,6 +150,8 @@ vector<string> browseFiles(string_view title, string_view extensions)
 string saveFile(string_view title, string_view extensions, string_view fn_default = {})
 {
 	filedialog::FDInfo inf;
+	if (app::isBatchMode())
+		return {};
 	if (filedialog::saveFile(inf, title, extensions, currentWindow(), fn_default))
 		return inf.filenames[0];
 
@@ -129,6 +164,8 @@ string saveFile(string_view title, string_view extensions, string_view fn_defaul
 std::tuple<string, string> saveFiles(string_view title, string_view extensions)
 {
 	filedialog::FDInfo inf;
+	if (app::isBatchMode())
+		return { {}, {} };
 	if (filedialog::saveFiles(inf, title, extensions, currentWindow()))
 		return std::make_tuple(inf.path, inf.extension);
 
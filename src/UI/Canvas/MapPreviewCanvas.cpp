@@ -111,7 +111,9 @@ bool MapPreviewCanvas::openMap(Archive::MapDesc map)
 
 		// Attempt to open entry as wad archive
 		temp_archive_ = std::make_unique<WadArchive>();
-		if (!temp_archive_->open(m_head->data()))
+		MemChunk wad_data;
+		m_head->shareData(wad_data);
+		if (!temp_archive_->open(wad_data))
 		{
 			temp_archive_.reset();
 			return false;
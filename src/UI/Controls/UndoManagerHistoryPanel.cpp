@@ -33,6 +33,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "UndoManagerHistoryPanel.h"
+#include "General/Misc.h"
 #include "General/UndoRedo.h"
 #include "UI/WxUtils.h"
 #include "Utility/Colour.h"
@@ -75,10 +76,16 @@ wxString UndoListView::itemText(long item, long column, long index) const
 			wxString name = manager_->undoLevel((unsigned)item)->name();
 			return wxString::Format("%lu. %s", item + 1, name);
 		}
-		else
+		else if (column == 1)
 		{
 			return manager_->undoLevel((unsigned)item)->timeStamp(false, true);
 		}
+		else
+		{
+			auto level = manager_->undoLevel((unsigned)item);
+			auto usage = misc::sizeAsString(level->memUsage());
+			return level->spilled() ? usage + " (on disk)" : usage;
+		}
 	}
 	else
 		return "Invalid Index";
@@ -166,6 +173,7 @@ UndoManagerHistoryPanel::UndoManagerHistoryPanel(wxWindow* parent, UndoManager*
 
 	list_levels_->AppendColumn("Action", wxLIST_FORMAT_LEFT, ui::scalePx(160));
 	list_levels_->AppendColumn("Time", wxLIST_FORMAT_RIGHT);
+	list_levels_->AppendColumn("Memory", wxLIST_FORMAT_RIGHT);
 	list_levels_->Bind(wxEVT_LIST_ITEM_RIGHT_CLICK, &UndoManagerHistoryPanel::onItemRightClick, this);
 	Bind(wxEVT_MENU, &UndoManagerHistoryPanel::onMenu, this);
 }
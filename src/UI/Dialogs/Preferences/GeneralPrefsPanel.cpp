@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "GeneralPrefsPanel.h"
+#include "UI/Controls/NumberTextCtrl.h"
 #include "UI/WxUtils.h"
 
 using namespace slade;
@@ -48,6 +49,7 @@ EXTERN_CVAR(Bool, update_check)
 EXTERN_CVAR(Bool, update_check_beta)
 EXTERN_CVAR(Bool, confirm_exit)
 EXTERN_CVAR(Bool, backup_archives)
+EXTERN_CVAR(Int, undo_memory_budget)
 
 
 // -----------------------------------------------------------------------------
@@ -72,10 +74,15 @@ GeneralPrefsPanel::GeneralPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 		  cb_update_check_beta_ = new wxCheckBox(this, -1, "Include beta versions when checking for updates"),
 #endif
 		  cb_confirm_exit_    = new wxCheckBox(this, -1, "Show confirmation dialog on exit"),
-		  cb_backup_archives_ = new wxCheckBox(this, -1, "Back up archives") }));
+		  cb_backup_archives_ = new wxCheckBox(this, -1, "Back up archives"),
+		  wxutil::createLabelHBox(
+			  this, "Undo memory budget (MB, 0 for unlimited):", text_undo_budget_ = new NumberTextCtrl(this)) }));
 
 	cb_wads_root_->SetToolTip(
 		"When opening a zip or folder archive, automatically open all wad entries in the root directory");
+	text_undo_budget_->SetToolTip(
+		"Total memory to use for undo history (across all open archives and maps) before older undo levels "
+		"are written out to temporary files");
 }
 
 // -----------------------------------------------------------------------------
@@ -92,6 +99,7 @@ void GeneralPrefsPanel::init()
 #endif
 	cb_confirm_exit_->SetValue(confirm_exit);
 	cb_backup_archives_->SetValue(backup_archives);
+	text_undo_budget_->setNumber(undo_memory_budget);
 }
 
 // -----------------------------------------------------------------------------
@@ -106,6 +114,7 @@ void GeneralPrefsPanel::applyPreferences()
 	update_check      = cb_update_check_->GetValue();
 	update_check_beta = cb_update_check_beta_->GetValue();
 #endif
-	confirm_exit    = cb_confirm_exit_->GetValue();
-	backup_archives = cb_backup_archives_->GetValue();
+	confirm_exit       = cb_confirm_exit_->GetValue();
+	backup_archives    = cb_backup_archives_->GetValue();
+	undo_memory_budget = std::max(text_undo_budget_->number(), 0);
 }
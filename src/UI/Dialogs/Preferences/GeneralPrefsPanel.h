@@ -4,6 +4,8 @@
 
 namespace slade
 {
+class NumberTextCtrl;
+
 class GeneralPrefsPanel : public PrefsPanelBase
 {
 public:
@@ -14,13 +16,14 @@ public:
 	void applyPreferences() override;
 
 private:
-	wxCheckBox* cb_gl_np2_            = nullptr;
-	wxCheckBox* cb_archive_load_      = nullptr;
-	wxCheckBox* cb_archive_close_tab_ = nullptr;
-	wxCheckBox* cb_wads_root_         = nullptr;
-	wxCheckBox* cb_update_check_      = nullptr;
-	wxCheckBox* cb_update_check_beta_ = nullptr;
-	wxCheckBox* cb_confirm_exit_      = nullptr;
-	wxCheckBox* cb_backup_archives_   = nullptr;
+	wxCheckBox*     cb_gl_np2_            = nullptr;
+	wxCheckBox*     cb_archive_load_      = nullptr;
+	wxCheckBox*     cb_archive_close_tab_ = nullptr;
+	wxCheckBox*     cb_wads_root_         = nullptr;
+	wxCheckBox*     cb_update_check_      = nullptr;
+	wxCheckBox*     cb_update_check_beta_ = nullptr;
+	wxCheckBox*     cb_confirm_exit_      = nullptr;
+	wxCheckBox*     cb_backup_archives_   = nullptr;
+	NumberTextCtrl* text_undo_budget_     = nullptr;
 };
 } // namespace slade
@@ -51,6 +51,7 @@ EXTERN_CVAR(Bool, camera_3d_show_distance)
 EXTERN_CVAR(Bool, mlook_invert_y)
 EXTERN_CVAR(Bool, render_shade_orthogonal_lines)
 EXTERN_CVAR(Int, render_fov)
+EXTERN_CVAR(Bool, render_3d_portal_cull)
 
 
 // -----------------------------------------------------------------------------
@@ -126,7 +127,8 @@ Map3DPrefsPanel::Map3DPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 		{ cb_render_sky_       = new wxCheckBox(this, -1, "Render sky preview"),
 		  cb_show_distance_    = new wxCheckBox(this, -1, "Show distance under crosshair"),
 		  cb_invert_y_         = new wxCheckBox(this, -1, "Invert mouse Y axis"),
-		  cb_shade_orthogonal_ = new wxCheckBox(this, -1, "Shade orthogonal lines") },
+		  cb_shade_orthogonal_ = new wxCheckBox(this, -1, "Shade orthogonal lines"),
+		  cb_portal_cull_      = new wxCheckBox(this, -1, "Don't render parts of the map hidden behind walls") },
 		wxSizerFlags(0).Expand());
 
 	// Bind events
@@ -173,6 +175,7 @@ void Map3DPrefsPanel::init()
 	cb_show_distance_->SetValue(camera_3d_show_distance);
 	cb_invert_y_->SetValue(mlook_invert_y);
 	cb_shade_orthogonal_->SetValue(render_shade_orthogonal_lines);
+	cb_portal_cull_->SetValue(render_3d_portal_cull);
 
 	updateDistanceControls();
 }
@@ -238,4 +241,5 @@ void Map3DPrefsPanel::applyPreferences()
 	mlook_invert_y                = cb_invert_y_->GetValue();
 	render_fov                    = slider_fov_->GetValue() * 10;
 	render_shade_orthogonal_lines = cb_shade_orthogonal_->GetValue();
+	render_3d_portal_cull         = cb_portal_cull_->GetValue();
 }
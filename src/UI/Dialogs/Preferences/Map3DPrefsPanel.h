@@ -29,6 +29,7 @@ private:
 	wxCheckBox*   cb_show_distance_        = nullptr;
 	wxCheckBox*   cb_invert_y_             = nullptr;
 	wxCheckBox*   cb_shade_orthogonal_     = nullptr;
+	wxCheckBox*   cb_portal_cull_          = nullptr;
 	wxSlider*     slider_fov_              = nullptr;
 	wxStaticText* label_fov_               = nullptr;
 };
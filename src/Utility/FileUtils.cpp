@@ -182,6 +182,16 @@ time_t fileutil::fileModifiedTime(string_view path)
 	return static_cast<time_t>(fs::last_write_time(path).time_since_epoch().count());
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if [path1] and [path2] are the same existing file, even if they
+// are written differently (eg. relative/absolute paths or symlinks)
+// -----------------------------------------------------------------------------
+bool fileutil::isSameFile(string_view path1, string_view path2)
+{
+	std::error_code ec;
+	return fs::equivalent(fs::path{ path1 }, fs::path{ path2 }, ec);
+}
+
 
 
 // -----------------------------------------------------------------------------
@@ -15,6 +15,7 @@ namespace fileutil
 	bool           createDir(string_view path);
 	vector<string> allFilesInDir(string_view path, bool include_subdirs = false, bool include_dir_paths = false);
 	time_t         fileModifiedTime(string_view path);
+	bool           isSameFile(string_view path1, string_view path2);
 } // namespace fileutil
 
 class SFile : public SeekableData
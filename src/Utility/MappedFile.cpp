@@ -0,0 +1,184 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MappedFile.cpp
+// Description: MappedFile class - a read-only, memory-mapped view of a file
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MappedFile.h"
+#include "FileUtils.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// All currently open MappedFiles
+vector<const MappedFile*> open_files;
+std::mutex                open_files_mutex;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Opens and maps the file at [path] into memory.
+// Returns false if the file couldn't be opened or is empty
+// -----------------------------------------------------------------------------
+bool MappedFile::open(string_view path)
+{
+	close();
+
+#ifndef _WIN32
+	// Open the file
+	auto fd = ::open(string{ path }.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	// Get size (can't map an empty file, and MemChunk sizes are 32bit)
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > std::numeric_limits<uint32_t>::max())
+	{
+		::close(fd);
+		return false;
+	}
+
+	// Map it (the file descriptor isn't needed once mapped)
+	auto mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mem == MAP_FAILED)
+	{
+		log::warning("Unable to memory map file {}", path);
+		return false;
+	}
+
+	data_   = static_cast<uint8_t*>(mem);
+	size_   = st.st_size;
+	mapped_ = true;
+#else
+	// On Windows a mapped file can't be replaced while it is mapped, which
+	// would prevent saving over it, so just read it into memory instead
+	SFile file(path);
+	if (!file.isOpen() || file.size() == 0)
+		return false;
+
+	data_ = new uint8_t[file.size()];
+	size_ = file.size();
+	if (!file.read(data_, size_))
+	{
+		close();
+		return false;
+	}
+#endif
+
+	path_ = path;
+
+	std::lock_guard<std::mutex> lock(open_files_mutex);
+	open_files.push_back(this);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Unmaps/frees the file data
+// -----------------------------------------------------------------------------
+void MappedFile::close()
+{
+	if (!data_)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(open_files_mutex);
+		open_files.erase(std::remove(open_files.begin(), open_files.end(), this), open_files.end());
+	}
+
+#ifndef _WIN32
+	if (mapped_)
+		munmap(data_, size_);
+	else
+		delete[] data_;
+#else
+	delete[] data_;
+#endif
+
+	data_   = nullptr;
+	size_   = 0;
+	mapped_ = false;
+	path_.clear();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Static Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns true if files are actually memory-mapped on this platform, rather
+// than read into memory
+// -----------------------------------------------------------------------------
+bool MappedFile::supported()
+{
+#ifndef _WIN32
+	return true;
+#else
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the file at [path] is currently open in any MappedFile (so
+// it shouldn't be written to directly)
+// -----------------------------------------------------------------------------
+bool MappedFile::isFileMapped(string_view path)
+{
+	std::lock_guard<std::mutex> lock(open_files_mutex);
+	for (auto file : open_files)
+		if (fileutil::isSameFile(file->path(), path))
+			return true;
+
+	return false;
+}
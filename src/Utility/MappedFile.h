@@ -0,0 +1,34 @@
+#pragma once
+
+namespace slade
+{
+// A read-only view of a file's contents in memory.
+// On platforms that support it the file is memory-mapped, otherwise it is
+// read into memory
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const string&  path() const { return path_; }
+	const uint8_t* data() const { return data_; }
+	uint32_t       size() const { return size_; }
+	bool           isOpen() const { return data_ != nullptr; }
+
+	bool open(string_view path);
+	void close();
+
+	static bool supported();
+	static bool isFileMapped(string_view path);
+
+private:
+	string   path_;
+	uint8_t* data_   = nullptr;
+	uint32_t size_   = 0;
+	bool     mapped_ = false;
+};
+} // namespace slade
@@ -72,7 +72,8 @@ MemChunk::MemChunk(const uint8_t* data, uint32_t size) : size_{ size }
 MemChunk::~MemChunk()
 {
 	// Free memory
-	delete[] data_;
+	if (!view_)
+		delete[] data_;
 }
 
 // -----------------------------------------------------------------------------
@@ -91,10 +92,13 @@ bool MemChunk::clear()
 {
 	if (hasData())
 	{
-		delete[] data_;
+		if (!view_)
+			delete[] data_;
 		data_    = nullptr;
 		size_    = 0;
 		cur_ptr_ = 0;
+		view_    = false;
+		view_owner_.reset();
 		return true;
 	}
 
@@ -114,6 +118,10 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 		return false;
 	}
 
+	// Make sure we own the data if it is to be preserved
+	if (preserve_data && !detach())
+		return false;
+
 	// Attempt to allocate memory for new size
 	auto ndata = allocData(new_size, false);
 	if (!ndata)
@@ -127,7 +135,7 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 	}
 	else if (data_ != nullptr)
 	{
-		memcpy(ndata, data_, size_ * sizeof(uint8_t));
+		memcpy(ndata, data_, std::min(size_, new_size) * sizeof(uint8_t));
 		delete[] data_;
 		data_ = ndata;
 	}
@@ -298,6 +306,93 @@ bool MemChunk::importMem(const uint8_t* start, uint32_t len)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Sets the MemChunk to be a read-only view of [size] bytes at [data], clearing
+// any currently existing data. The data is not copied until something attempts
+// to modify it (see detach).
+// If given, [owner] is kept alive for as long as the view exists
+// -----------------------------------------------------------------------------
+void MemChunk::setView(const uint8_t* data, uint32_t size, shared_ptr<const void> owner)
+{
+	clear();
+
+	if (!data || size == 0)
+		return;
+
+	data_       = const_cast<uint8_t*>(data);
+	size_       = size;
+	view_       = true;
+	view_owner_ = std::move(owner);
+}
+
+// -----------------------------------------------------------------------------
+// Same as exportMemChunk, except that if this MemChunk is a view, [mc] will be
+// set to a view of the same data rather than a copy of it
+// -----------------------------------------------------------------------------
+bool MemChunk::shareMemChunk(MemChunk& mc, uint32_t start, uint32_t size) const
+{
+	if (!view_)
+		return exportMemChunk(mc, start, size);
+
+	// Check parameters
+	if (start >= size_ || start + size > size_)
+		return false;
+
+	// Check size
+	if (size == 0)
+		size = size_ - start;
+
+	mc.setView(data_ + start, size, view_owner_);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// If the MemChunk owns its data, hands ownership of it over to a shared owner
+// and makes the MemChunk a view of it. Any MemChunks then set to views of it via
+// shareMemChunk will share the data rather than copying it, and (as with any
+// view) it is copied if any of them are modified
+// -----------------------------------------------------------------------------
+void MemChunk::makeShareable()
+{
+	if (view_ || !data_)
+		return;
+
+	view_owner_ = shared_ptr<const uint8_t>(data_, std::default_delete<uint8_t[]>());
+	view_       = true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a writable pointer to the data. If the MemChunk is a view, the data is
+// copied first (see detach) so that the viewed data isn't modified
+// -----------------------------------------------------------------------------
+uint8_t* MemChunk::data()
+{
+	detach();
+	return data_;
+}
+
+// -----------------------------------------------------------------------------
+// If the MemChunk is a view, copies the viewed data into memory owned by the
+// MemChunk so that it can be safely modified.
+// Returns false if the copy couldn't be allocated
+// -----------------------------------------------------------------------------
+bool MemChunk::detach()
+{
+	if (!view_)
+		return true;
+
+	auto ndata = allocData(size_, false);
+	if (!ndata)
+		return false;
+
+	memcpy(ndata, data_, size_);
+	data_ = ndata;
+	view_ = false;
+	view_owner_.reset();
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Writes the MemChunk data to a new file of [filename], starting from [start]
 // to [start+size].
@@ -366,6 +461,10 @@ bool MemChunk::write(unsigned offset, const void* data, unsigned size, bool expa
 	if (!data)
 		return false;
 
+	// Make sure we own the data
+	if (!detach())
+		return false;
+
 	// If we're trying to write past the end of the memory chunk,
 	// resize it so we can write at this point
 	// (or return false if expanding is disallowed)
@@ -415,6 +514,10 @@ bool MemChunk::write(const void* buffer, uint32_t count)
 	if (!buffer)
 		return false;
 
+	// Make sure we own the data
+	if (!detach())
+		return false;
+
 	// If we're trying to write past the end of the memory chunk,
 	// resize it so we can write at this point
 	if (cur_ptr_ + count > size_)
@@ -529,10 +632,10 @@ bool MemChunk::readMC(MemChunk& mc, uint32_t size)
 // Overwrites all data bytes with [val] (basically is memset).
 // Returns false if no data exists, true otherwise
 // -----------------------------------------------------------------------------
-bool MemChunk::fillData(uint8_t val) const
+bool MemChunk::fillData(uint8_t val)
 {
 	// Check data exists
-	if (!hasData())
+	if (!hasData() || !detach())
 		return false;
 
 	// Fill data with value
@@ -14,11 +14,12 @@ public:
 	MemChunk(const uint8_t* data, uint32_t size);
 	~MemChunk();
 
-	uint8_t& operator[](int a) const { return data_[a]; }
+	const uint8_t& operator[](int a) const { return data_[a]; }
 
 	// Accessors
 	const uint8_t* data() const { return data_; }
-	uint8_t*       data() { return data_; }
+	uint8_t*       data();
+	bool           isView() const { return view_; }
 
 	// SeekableData
 	unsigned size() const override { return size_; }
@@ -41,6 +42,12 @@ public:
 	bool importMem(const uint8_t* start, uint32_t len);
 	bool importMem(const MemChunk& other) { return importMem(other.data_, other.size_); }
 
+	// Data views
+	void setView(const uint8_t* data, uint32_t size, shared_ptr<const void> owner = nullptr);
+	bool shareMemChunk(MemChunk& mc, uint32_t start = 0, uint32_t size = 0) const;
+	void makeShareable();
+	bool detach();
+
 	// Data export
 	bool exportFile(string_view filename, uint32_t start = 0, uint32_t size = 0) const;
 	bool exportMemChunk(MemChunk& mc, uint32_t start = 0, uint32_t size = 0) const;
@@ -58,7 +65,7 @@ public:
 	bool readMC(MemChunk& mc, uint32_t size);
 
 	// Misc
-	bool     fillData(uint8_t val) const;
+	bool     fillData(uint8_t val);
 	uint32_t crc() const;
 
 	// Platform-independent functions to read values in little (L##) or big (B##) endian
@@ -80,6 +87,10 @@ protected:
 	uint32_t cur_ptr_ = 0;
 	uint32_t size_    = 0;
 
+	// View of data owned elsewhere (eg. a memory-mapped file), copied on write
+	bool                   view_ = false;
+	shared_ptr<const void> view_owner_;
+
 	uint8_t* allocData(uint32_t size, bool set_data = true);
 };
 } // namespace slade
@@ -0,0 +1,192 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2020 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ThreadPool.cpp
+// Description: ThreadPool class - a simple fixed-size pool of worker threads
+//              for running tasks and splitting loops across cores
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// ThreadPool class constructor. If [num_threads] is 0, one worker thread is
+// created per hardware thread (minus one for the calling thread)
+// -----------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned num_threads)
+{
+	if (num_threads == 0)
+	{
+		auto hw_threads = std::thread::hardware_concurrency();
+		num_threads     = hw_threads > 1 ? hw_threads - 1 : 0;
+	}
+
+	workers_.reserve(num_threads);
+	for (unsigned a = 0; a < num_threads; a++)
+		workers_.emplace_back([this]() { workerLoop(); });
+}
+
+// -----------------------------------------------------------------------------
+// ThreadPool class destructor
+// -----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+
+	for (auto& worker : workers_)
+		if (worker.joinable())
+			worker.join();
+}
+
+// -----------------------------------------------------------------------------
+// Runs [func] for each index from 0 to [count]-1, split into batches of
+// [batch_size] indices that are spread across the worker threads. The calling
+// thread also processes batches, and the function only returns once all
+// indices have been processed. If [batch_size] is 0 a suitable size is picked
+// based on [count] and the number of threads.
+//
+// [func] must be safe to call concurrently for different indices
+// -----------------------------------------------------------------------------
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func, size_t batch_size)
+{
+	if (count == 0)
+		return;
+
+	// Determine batch size (aim for a few batches per thread so uneven
+	// workloads are balanced out)
+	auto num_threads = numThreads() + 1;
+	if (batch_size == 0)
+		batch_size = std::max<size_t>(1, count / (num_threads * 4));
+	auto num_batches = (count + batch_size - 1) / batch_size;
+
+	// Just run on this thread if there's nothing to split
+	if (workers_.empty() || num_batches == 1)
+	{
+		for (size_t a = 0; a < count; a++)
+			func(a);
+		return;
+	}
+
+	// Shared state between the calling thread and workers
+	struct State
+	{
+		std::atomic<size_t>     next_batch{ 0 };
+		size_t                  batches_done = 0;
+		std::exception_ptr      error;
+		std::mutex              mutex;
+		std::condition_variable cv;
+	};
+	auto state = std::make_shared<State>();
+
+	// Processes batches until there are none left. Workers that start after all
+	// batches have been taken return immediately without touching [func]
+	auto run_batches = [state, &func, count, batch_size, num_batches]()
+	{
+		while (true)
+		{
+			auto batch = state->next_batch++;
+			if (batch >= num_batches)
+				return;
+
+			auto start = batch * batch_size;
+			auto end   = std::min(start + batch_size, count);
+			try
+			{
+				for (auto a = start; a < end; a++)
+					func(a);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (++state->batches_done == num_batches)
+				state->cv.notify_all();
+		}
+	};
+
+	// Queue helper tasks
+	auto num_helpers = std::min<size_t>(workers_.size(), num_batches - 1);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (size_t a = 0; a < num_helpers; a++)
+			tasks_.emplace_back(run_batches);
+	}
+	cv_.notify_all();
+
+	// Process batches on this thread too (this also means nested calls from
+	// within a worker can't deadlock waiting for a free worker)
+	run_batches();
+
+	// Wait for any batches still being processed on workers
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cv.wait(lock, [&]() { return state->batches_done == num_batches; });
+
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread main loop, runs queued tasks until the pool is stopped
+// -----------------------------------------------------------------------------
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+			if (stop_ && tasks_.empty())
+				return;
+
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+		}
+
+		task();
+	}
+}
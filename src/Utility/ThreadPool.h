@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace slade
+{
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned num_threads = 0);
+	~ThreadPool();
+
+	unsigned numThreads() const { return workers_.size(); }
+
+	// Queues [func] to be run on a worker thread, returns a future for its result
+	template<typename F> auto enqueue(F&& func) -> std::future<decltype(func())>
+	{
+		using Result = decltype(func());
+		auto task    = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+		auto result  = task->get_future();
+
+		// Run immediately if there are no workers
+		if (workers_.empty())
+		{
+			(*task)();
+			return result;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.emplace_back([task]() { (*task)(); });
+		}
+		cv_.notify_one();
+
+		return result;
+	}
+
+	void parallelFor(size_t count, const std::function<void(size_t)>& func, size_t batch_size = 0);
+
+private:
+	vector<std::thread>               workers_;
+	std::deque<std::function<void()>> tasks_;
+	std::mutex                        mutex_;
+	std::condition_variable           cv_;
+	bool                              stop_ = false;
+
+	void workerLoop();
+};
+} // namespace slade